@@ -0,0 +1,50 @@
+// Host benchmark for the JsEngine backends.
+//
+//   engine_bench [--engine NAME] [--iterations N]
+//
+// Runs the shared workloads from engine_benchmark.cpp through eval,
+// compile + loadBytecode and call on every engine built into this binary
+// (or only --engine), one table per engine. V8Bridge.runEngineBenchmark()
+// runs the same driver on device.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "engine_benchmark.h"
+#include "js_engine.h"
+
+int main(int argc, char** argv) {
+    std::string only;
+    int iterations = 20;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--engine" && hasValue) only = argv[++i];
+        else if (arg == "--iterations" && hasValue) iterations = std::max(1, atoi(argv[++i]));
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    bool allOk = true;
+    std::vector<std::string> engines = only.empty() ? availableJsEngines() : std::vector<std::string>{only};
+    for (const std::string& name : engines) {
+        std::unique_ptr<JsEngine> engine = createJsEngine(name);
+        if (!engine || !engine->initialize()) {
+            fprintf(stderr, "Engine %s is not available\n", name.c_str());
+            return 1;
+        }
+        std::vector<EngineBenchmarkResult> results = runEngineBenchmark(*engine, iterations);
+        for (const EngineBenchmarkResult& r : results) {
+            allOk &= r.ok;
+        }
+        printf("%s\n%s\n\n", formatEngineBenchmark(name, results).c_str(),
+               engine->stats().format(name).c_str());
+    }
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+// Host benchmark for fetch()-heavy scripts.
+//
+// Runs a script through the same polyfills, HttpCache and transports the
+// app uses, without a device or network:
+//
+//   fetch_bench --record exchanges.jsonl script.js      (live http:// + capture)
+//   fetch_bench --replay exchanges.jsonl --profile 4g --iterations 20 script.js
+//
+// Every iteration gets a fresh runtime and context. Results go to stdout,
+// ending with a single "RESULT key=value ..." line for regression scripts.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "http_cache.h"
+#include "http_polyfill.h"
+#include "http_transport.h"
+
+extern "C" {
+#include "quickjs/quickjs-libc.h"
+}
+
+namespace {
+
+struct Options {
+    std::string script;
+    std::string recordPath;
+    std::string replayPath;
+    std::string profile = "none";
+    std::string cacheDir;
+    int iterations = 10;
+    int warmup = 1;
+    bool coldCache = false;
+};
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [--record FILE | --replay FILE] [--profile NAME|LAT:DOWN[:UP]]\n"
+            "          [--iterations N] [--warmup N] [--cold-cache] [--cache-dir DIR] script.js\n"
+            "profiles: none, recorded, wifi, 4g, fast-3g, slow-3g\n",
+            argv0);
+}
+
+bool parseArgs(int argc, char** argv, Options* options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--record" && hasValue) {
+            options->recordPath = argv[++i];
+        } else if (arg == "--replay" && hasValue) {
+            options->replayPath = argv[++i];
+        } else if (arg == "--profile" && hasValue) {
+            options->profile = argv[++i];
+        } else if (arg == "--iterations" && hasValue) {
+            options->iterations = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--warmup" && hasValue) {
+            options->warmup = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--cache-dir" && hasValue) {
+            options->cacheDir = argv[++i];
+        } else if (arg == "--cold-cache") {
+            options->coldCache = true;
+        } else if (arg[0] != '-' && options->script.empty()) {
+            options->script = arg;
+        } else {
+            return false;
+        }
+    }
+    if (!options->recordPath.empty() && !options->replayPath.empty()) {
+        return false;
+    }
+    return !options->script.empty();
+}
+
+bool readFile(const std::string& path, std::string* out) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    char buf[16384];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        out->append(buf, n);
+    }
+    fclose(file);
+    return true;
+}
+
+void printException(JSContext* ctx) {
+    JSValue exception = JS_GetException(ctx);
+    const char* str = JS_ToCString(ctx, exception);
+    fprintf(stderr, "JavaScript Error: %s\n", str ? str : "Unknown error");
+    if (str) JS_FreeCString(ctx, str);
+    JS_FreeValue(ctx, exception);
+}
+
+// Evaluate the script and wait for the promise it returns (if any)
+bool runOnce(const std::string& name, const std::string& source) {
+    JSRuntime* rt = JS_NewRuntime();
+    js_std_init_handlers(rt);
+    JSContext* ctx = JS_NewContext(rt);
+    js_std_add_helpers(ctx, 0, nullptr);
+    addHttpPolyfills(ctx);
+
+    bool ok = true;
+    JSValue result = JS_Eval(ctx, source.c_str(), source.size(), name.c_str(), JS_EVAL_TYPE_GLOBAL);
+    if (!JS_IsException(result)) {
+        result = js_std_await(ctx, result);
+    }
+    if (JS_IsException(result)) {
+        printException(ctx);
+        ok = false;
+    }
+    JS_FreeValue(ctx, result);
+
+    js_std_free_handlers(rt);
+    JS_FreeContext(ctx);
+    JS_FreeRuntime(rt);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, &options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::string source;
+    if (!readFile(options.script, &source)) {
+        fprintf(stderr, "Cannot read %s\n", options.script.c_str());
+        return 1;
+    }
+
+    std::shared_ptr<ReplayTransport> replay;
+    std::shared_ptr<RecordingTransport> recorder;
+    if (!options.replayPath.empty()) {
+        NetworkProfile profile;
+        if (!NetworkProfile::parse(options.profile, &profile)) {
+            fprintf(stderr, "Unknown network profile: %s\n", options.profile.c_str());
+            return 2;
+        }
+        replay = std::make_shared<ReplayTransport>(profile);
+        if (replay->load(options.replayPath) <= 0) {
+            fprintf(stderr, "No exchanges loaded from %s\n", options.replayPath.c_str());
+            return 1;
+        }
+        HttpTransport::setCurrent(replay);
+    } else if (!options.recordPath.empty()) {
+        recorder = std::make_shared<RecordingTransport>(std::make_shared<SocketHttpTransport>(), options.recordPath);
+        if (!recorder->isOpen()) {
+            return 1;
+        }
+        HttpTransport::setCurrent(recorder);
+        // One pass is enough to capture; repeats would only duplicate exchanges
+        options.iterations = 1;
+        options.warmup = 0;
+    } else {
+        HttpTransport::setCurrent(std::make_shared<SocketHttpTransport>());
+    }
+
+    HttpCache& cache = HttpCache::instance();
+    cache.configure(options.cacheDir, 8 * 1024 * 1024, 32 * 1024 * 1024);
+    cache.clear();
+
+    for (int i = 0; i < options.warmup; i++) {
+        if (options.coldCache) cache.clear();
+        if (!runOnce(options.script, source)) {
+            return 1;
+        }
+    }
+    if (replay) {
+        replay->resetStats();
+    }
+    HttpCache::Stats cacheBefore = cache.stats();
+
+    std::vector<double> timesMs;
+    for (int i = 0; i < options.iterations; i++) {
+        if (options.coldCache) cache.clear();
+        auto start = std::chrono::steady_clock::now();
+        if (!runOnce(options.script, source)) {
+            return 1;
+        }
+        auto end = std::chrono::steady_clock::now();
+        timesMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::vector<double> sorted = timesMs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for (double t : timesMs) total += t;
+    double mean = total / timesMs.size();
+    double median = sorted[sorted.size() / 2];
+    double p90 = sorted[std::min(sorted.size() - 1, (size_t)(sorted.size() * 0.9))];
+
+    HttpCache::Stats cacheAfter = cache.stats();
+    uint64_t hits = cacheAfter.hits - cacheBefore.hits;
+    uint64_t misses = cacheAfter.misses - cacheBefore.misses;
+
+    printf("Script: %s\n", options.script.c_str());
+    printf("Transport: %s, profile: %s\n", HttpTransport::current()->name(), options.profile.c_str());
+    printf("Iterations: %d (warmup %d, %s cache)\n", options.iterations, options.warmup,
+           options.coldCache ? "cold" : "warm");
+    printf("Time: mean %.2f ms, median %.2f ms, p90 %.2f ms, min %.2f ms, max %.2f ms\n",
+           mean, median, p90, sorted.front(), sorted.back());
+    printf("Cache: %llu hits, %llu misses\n", (unsigned long long)hits, (unsigned long long)misses);
+
+    uint64_t requests = 0;
+    int64_t simulated = 0;
+    if (replay) {
+        ReplayTransport::Stats s = replay->stats();
+        requests = s.requests;
+        simulated = s.simulatedDelayMs;
+        printf("Replay: %llu requests, %llu unmatched, %llu bytes sent, %llu bytes received, %lld ms simulated\n",
+               (unsigned long long)s.requests, (unsigned long long)s.misses,
+               (unsigned long long)s.bytesSent, (unsigned long long)s.bytesReceived, (long long)s.simulatedDelayMs);
+    }
+    if (recorder) {
+        requests = recorder->recorded();
+        printf("Recorded %zu exchanges to %s\n", recorder->recorded(), options.recordPath.c_str());
+    }
+    printf("RESULT iterations=%d mean_ms=%.3f median_ms=%.3f p90_ms=%.3f requests=%llu cache_hits=%llu simulated_ms=%lld\n",
+           options.iterations, mean, median, p90, (unsigned long long)requests, (unsigned long long)hits,
+           (long long)simulated);
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Host benchmark for persistent (file-backed) ByteBuffers.
+//
+//   persist_bench [--path FILE] [--size BYTES] [--chunk BYTES]
+//
+// Fills a persistent buffer and flushes it, then lets a forked child reopen
+// it, append without flushing and die on SIGABRT. The parent reopens the
+// file and checks that exactly the flushed bytes came back. It also times
+// that reopen against reloading the same bytes with read().
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "byte_buffer.h"
+
+namespace {
+
+struct Options {
+    std::string path = "/tmp/persist_bench.buf";
+    size_t size = 64 * 1024 * 1024;
+    size_t chunk = 64 * 1024;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double millis(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+uint8_t patternByte(uint64_t position) {
+    return (uint8_t)(position * 131 + (position >> 9));
+}
+
+uint64_t checksum(const uint8_t* data, size_t length) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < length; i++) {
+        sum = sum * 31 + data[i];
+    }
+    return sum;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--path" && hasValue) options.path = argv[++i];
+        else if (arg == "--size" && hasValue) options.size = strtoull(argv[++i], nullptr, 0);
+        else if (arg == "--chunk" && hasValue) options.chunk = std::max<size_t>(1, strtoull(argv[++i], nullptr, 0));
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    const char* path = options.path.c_str();
+    unlink(path);
+
+    std::vector<uint8_t> chunk(options.chunk);
+    uint64_t expected = 0;
+    double fillMs = 0;
+    {
+        auto start = Clock::now();
+        std::shared_ptr<ByteBuffer> buffer = ByteBuffer::openPersistent(path, options.size + options.chunk);
+        if (!buffer) {
+            return 1;
+        }
+        for (size_t written = 0; written < options.size;) {
+            size_t n = std::min(options.chunk, options.size - written);
+            for (size_t i = 0; i < n; i++) {
+                chunk[i] = patternByte(written + i);
+            }
+            buffer->write(chunk.data(), n);
+            written += n;
+        }
+        if (!buffer->flush()) {
+            return 1;
+        }
+        fillMs = millis(start);
+        expected = checksum(buffer->data, buffer->size());
+    }
+
+    // Child appends past the flush point and crashes before flushing again
+    pid_t child = fork();
+    if (child == 0) {
+        std::shared_ptr<ByteBuffer> buffer = ByteBuffer::openPersistent(path, options.size + options.chunk);
+        if (!buffer || buffer->size() != options.size) {
+            _exit(3);
+        }
+        std::fill(chunk.begin(), chunk.end(), 0xEE);
+        buffer->write(chunk.data(), chunk.size());
+        abort();
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!WIFSIGNALED(status) || WTERMSIG(status) != SIGABRT) {
+        fprintf(stderr, "child did not crash as planned (status %d)\n", status);
+        return 1;
+    }
+
+    auto start = Clock::now();
+    std::shared_ptr<ByteBuffer> reopened = ByteBuffer::openPersistent(path, options.size + options.chunk);
+    double reopenMs = millis(start);
+    bool intact = reopened && reopened->size() == options.size &&
+                  checksum(reopened->data, reopened->size()) == expected;
+    double reopenScanMs = millis(start);
+    reopened.reset();
+
+    // Baseline: load the same bytes with read() into the heap
+    start = Clock::now();
+    std::vector<uint8_t> loaded(options.size);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    size_t got = 0;
+    if (fd >= 0) {
+        lseek(fd, 4096, SEEK_SET);
+        while (got < loaded.size()) {
+            ssize_t n = read(fd, loaded.data() + got, loaded.size() - got);
+            if (n <= 0) {
+                break;
+            }
+            got += (size_t)n;
+        }
+        close(fd);
+    }
+    bool loadedOk = got == options.size && checksum(loaded.data(), got) == expected;
+    double reloadMs = millis(start);
+
+    printf("%zu bytes: fill + flush %.1f ms\n", options.size, fillMs);
+    printf("reopen after crash: %.3f ms to map, %.1f ms to map + checksum (%s)\n", reopenMs, reopenScanMs,
+           intact ? "flushed bytes intact, unflushed append discarded" : "MISMATCH");
+    printf("reload with read() + checksum: %.1f ms (%s)\n", reloadMs, loadedOk ? "ok" : "MISMATCH");
+    printf("RESULT fill_ms=%.1f reopen_ms=%.3f reopen_scan_ms=%.1f reload_ms=%.1f intact=%d\n", fillMs, reopenMs,
+           reopenScanMs, reloadMs, intact ? 1 : 0);
+    unlink(path);
+    return intact && loadedOk ? 0 : 1;
+}
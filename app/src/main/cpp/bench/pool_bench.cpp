@@ -0,0 +1,96 @@
+// Host benchmark for ByteBuffer create/destroy churn.
+//
+//   pool_bench [--min BYTES] [--max BYTES] [--iterations N] [--touch BYTES] [--threads N]
+//
+// Each iteration creates a buffer of a random size in [min, max], writes
+// --touch bytes into it and destroys it. "baseline" is what ByteBuffer did
+// before the pool (new[] plus memset of the whole capacity); "pool" is
+// ByteBuffer on BufferPool.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "byte_buffer.h"
+
+namespace {
+
+struct Options {
+    size_t minSize = 4 * 1024;
+    size_t maxSize = 4 * 1024 * 1024;
+    size_t touch = 4096;
+    int iterations = 20000;
+    int threads = 1;
+};
+
+template <typename F>
+double runThreads(const Options& options, F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < options.threads; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937_64 random(42 + t);
+            std::uniform_int_distribution<size_t> sizes(options.minSize, options.maxSize);
+            std::vector<uint8_t> payload(options.touch, 0x5a);
+            for (int i = 0; i < options.iterations; i++) {
+                size_t size = sizes(random);
+                body(size, payload.data(), std::min(size, options.touch));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--min") options.minSize = (size_t)atoll(argv[i + 1]);
+        else if (arg == "--max") options.maxSize = (size_t)atoll(argv[i + 1]);
+        else if (arg == "--touch") options.touch = (size_t)atoll(argv[i + 1]);
+        else if (arg == "--iterations") options.iterations = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--threads") options.threads = std::max(1, atoi(argv[i + 1]));
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    options.maxSize = std::max(options.minSize, options.maxSize);
+
+    double baseline = runThreads(options, [](size_t size, const uint8_t* payload, size_t touch) {
+        uint8_t* data = new uint8_t[size];
+        memset(data, 0, size);
+        memcpy(data, payload, touch);
+        asm volatile("" : : "r"(data) : "memory");
+        delete[] data;
+    });
+
+    double pooled = runThreads(options, [](size_t size, const uint8_t* payload, size_t touch) {
+        ByteBuffer buffer(size);
+        buffer.write(payload, touch);
+    });
+
+    BufferPool::Stats stats = BufferPool::instance().stats();
+    double ops = (double)options.iterations * options.threads;
+    printf("Sizes %zu..%zu bytes, %zu bytes written, %d threads x %d iterations\n",
+           options.minSize, options.maxSize, options.touch, options.threads, options.iterations);
+    printf("baseline (new[] + memset): %.3f s, %.0f ns/op\n", baseline, baseline * 1e9 / ops);
+    printf("pool:                      %.3f s, %.0f ns/op\n", pooled, pooled * 1e9 / ops);
+    printf("Pool: %llu thread cache hits, %llu shared cache hits, %llu fresh blocks, %llu bytes zeroed\n",
+           (unsigned long long)stats.threadCacheHits, (unsigned long long)stats.sharedCacheHits,
+           (unsigned long long)stats.freshBlocks, (unsigned long long)stats.bytesZeroed);
+    printf("RESULT baseline_ns=%.0f pool_ns=%.0f speedup=%.1f\n", baseline * 1e9 / ops, pooled * 1e9 / ops,
+           baseline / pooled);
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Host benchmark for BufferRegistry lookups.
+//
+//   registry_bench [--buffers N] [--readers N] [--seconds S] [--churn]
+//
+// Reader threads resolve buffers by a legacy std::string lookup (what the
+// old std::map registry did), by string_view through the sharded name
+// index, and by handle. With --churn a writer thread keeps re-creating and
+// removing buffers so reclamation runs against live readers.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer_registry.h"
+
+namespace {
+
+struct Options {
+    int buffers = 64;
+    int readers = 2;
+    double seconds = 1.0;
+    bool churn = false;
+};
+
+template <typename F>
+double opsPerSecond(const Options& options, F&& lookup) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> total{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < options.readers; t++) {
+        threads.emplace_back([&, t] {
+            uint64_t count = 0;
+            uint64_t sink = 0;
+            int i = t;
+            while (!stop.load(std::memory_order_relaxed)) {
+                sink += lookup(i++ % options.buffers);
+                count++;
+            }
+            total.fetch_add(count + (sink == 42 ? 1 : 0));
+        });
+    }
+    std::thread writer;
+    if (options.churn) {
+        writer = std::thread([&] {
+            int i = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::string name = "buffer" + std::to_string(i++ % options.buffers);
+                BufferRegistry::instance().put(name, std::make_shared<ByteBuffer>(4096));
+                if (i % 7 == 0) {
+                    BufferRegistry::instance().remove("churn");
+                    BufferRegistry::instance().put("churn", std::make_shared<ByteBuffer>(4096));
+                }
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    stop.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (writer.joinable()) {
+        writer.join();
+    }
+    return total.load() / options.seconds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--buffers" && hasValue) options.buffers = std::max(1, atoi(argv[++i]));
+        else if (arg == "--readers" && hasValue) options.readers = std::max(1, atoi(argv[++i]));
+        else if (arg == "--seconds" && hasValue) options.seconds = atof(argv[++i]);
+        else if (arg == "--churn") options.churn = true;
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    BufferRegistry& registry = BufferRegistry::instance();
+    std::vector<std::string> names;
+    std::vector<BufferRegistry::Handle> handles;
+    std::map<std::string, std::shared_ptr<ByteBuffer>> legacy;
+    for (int i = 0; i < options.buffers; i++) {
+        names.push_back("buffer" + std::to_string(i));
+        auto buffer = std::make_shared<ByteBuffer>(4096);
+        legacy[names.back()] = buffer;
+        handles.push_back(registry.put(names.back(), buffer));
+    }
+
+    // Single-threaded reference: the old unlocked map with a std::string per call
+    Options single = options;
+    single.readers = 1;
+    single.churn = false;
+    double legacyOps = opsPerSecond(single, [&](int i) -> uint64_t {
+        std::string key(names[i].c_str());
+        auto it = legacy.find(key);
+        return it != legacy.end() ? it->second->capacity : 0;
+    });
+
+    double nameOps = opsPerSecond(options, [&](int i) -> uint64_t {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry.find(names[i]);
+        return buffer ? buffer->capacity : 0;
+    });
+
+    double handleOps = opsPerSecond(options, [&](int i) -> uint64_t {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry.get(handles[i]);
+        return buffer ? buffer->capacity : 0;
+    });
+
+    printf("%d buffers, %d reader threads%s\n", options.buffers, options.readers,
+           options.churn ? ", writer re-creating buffers" : "");
+    printf("legacy std::map + std::string (1 thread): %.1f M lookups/s\n", legacyOps / 1e6);
+    printf("registry by name:                         %.1f M lookups/s\n", nameOps / 1e6);
+    printf("registry by handle:                       %.1f M lookups/s\n", handleOps / 1e6);
+    printf("RESULT legacy_mops=%.1f name_mops=%.1f handle_mops=%.1f\n", legacyOps / 1e6, nameOps / 1e6,
+           handleOps / 1e6);
+    return 0;
+}
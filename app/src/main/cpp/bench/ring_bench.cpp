@@ -0,0 +1,100 @@
+// Host throughput benchmark for ByteRing (ByteTransfer ring buffer mode).
+//
+//   ring_bench [--producers N] [--size BYTES] [--batch N] [--capacity BYTES] [--seconds S]
+//
+// One consumer thread drains while N producers write fixed-size messages;
+// --producers 1 uses SingleProducer mode, more use MultiProducer.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ring_buffer.h"
+
+int main(int argc, char** argv) {
+    int producers = 1;
+    uint32_t size = 64;
+    int batch = 1;
+    size_t capacity = 1 << 20;
+    double seconds = 2.0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--producers") producers = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--size") size = (uint32_t)atoi(argv[i + 1]);
+        else if (arg == "--batch") batch = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--capacity") capacity = (size_t)atoll(argv[i + 1]);
+        else if (arg == "--seconds") seconds = atof(argv[i + 1]);
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    auto ring = ByteRing::create(capacity, producers == 1 ? ByteRing::Mode::SingleProducer
+                                                          : ByteRing::Mode::MultiProducer);
+    if (!ring || size > ring->maxMessageSize()) {
+        fprintf(stderr, "Message size %u does not fit ring of %zu bytes\n", size, capacity);
+        return 2;
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> produced{0};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            std::vector<uint8_t> payload(size, (uint8_t)p);
+            std::vector<ByteRingMessage> messages(batch, ByteRingMessage{payload.data(), size, (uint32_t)p});
+            uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                bool ok = batch == 1 ? ring->tryWrite(payload.data(), size, (uint32_t)p)
+                                     : ring->tryWriteBatch(messages.data(), messages.size());
+                if (ok) {
+                    count += batch;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            produced.fetch_add(count);
+        });
+    }
+
+    uint64_t consumed = 0;
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < deadline) {
+        size_t n = ring->consume([&](const uint8_t* data, uint32_t length, uint32_t) {
+            checksum += data[0] + length;
+        }, 4096);
+        consumed += n;
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+    }
+    stop.store(true);
+    for (auto& t : threads) {
+        t.join();
+    }
+    // Drain what was committed before the producers stopped
+    while (size_t n = ring->consume([&](const uint8_t* data, uint32_t length, uint32_t) {
+        checksum += data[0] + length;
+    })) {
+        consumed += n;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double messagesPerSec = consumed / elapsed;
+    double mbPerSec = consumed * (double)size / elapsed / (1024.0 * 1024.0);
+    printf("Mode: %s, producers: %d, message: %u bytes, batch: %d, ring: %zu bytes\n",
+           producers == 1 ? "SPSC" : "MPSC", producers, size, batch, ring->capacity());
+    printf("Consumed %llu of %llu messages in %.2f s (checksum %llu)\n",
+           (unsigned long long)consumed, (unsigned long long)produced.load(), elapsed,
+           (unsigned long long)checksum);
+    printf("RESULT messages_per_sec=%.0f mb_per_sec=%.1f\n", messagesPerSec, mbPerSec);
+    return consumed == produced.load() ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+// Host benchmark for segmented ByteBuffers.
+//
+//   segment_bench [--total BYTES] [--chunk BYTES] [--segment BYTES] [--rounds N]
+//
+// Each round streams --total bytes in random chunks of up to --chunk bytes
+// into a buffer whose final size the producer does not know. "regrow" is
+// what callers had to do with fixed buffers: start small and copy into a
+// buffer twice the size on every overflow. "segmented" appends pooled
+// segments. A last pass runs a producer and a consumer thread on one
+// segmented buffer and checks every byte.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "byte_buffer.h"
+
+namespace {
+
+struct Options {
+    size_t total = 8 * 1024 * 1024;
+    size_t chunk = 8 * 1024;
+    size_t segment = SegmentedBuffer::kDefaultSegmentSize;
+    int rounds = 20;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::vector<size_t> chunkSizes(const Options& options) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> dist(1, options.chunk);
+    std::vector<size_t> sizes;
+    for (size_t sum = 0; sum < options.total;) {
+        size_t n = std::min(dist(rng), options.total - sum);
+        sizes.push_back(n);
+        sum += n;
+    }
+    return sizes;
+}
+
+uint8_t patternByte(uint64_t position) {
+    return (uint8_t)(position * 131 + (position >> 8));
+}
+
+double runRegrow(const Options& options, const std::vector<size_t>& sizes, const std::vector<uint8_t>& source) {
+    auto start = Clock::now();
+    for (int round = 0; round < options.rounds; round++) {
+        auto buffer = std::make_unique<ByteBuffer>(options.chunk);
+        size_t offset = 0;
+        for (size_t n : sizes) {
+            if (n > buffer->capacity - buffer->size()) {
+                auto bigger = std::make_unique<ByteBuffer>(std::max(buffer->capacity * 2, buffer->size() + n));
+                bigger->write(buffer->data, buffer->size());
+                buffer = std::move(bigger);
+            }
+            buffer->write(source.data() + offset, n);
+            offset += n;
+        }
+    }
+    return seconds(start);
+}
+
+double runSegmented(const Options& options, const std::vector<size_t>& sizes, const std::vector<uint8_t>& source,
+                    bool linearize) {
+    auto start = Clock::now();
+    for (int round = 0; round < options.rounds; round++) {
+        ByteBuffer buffer(std::make_unique<SegmentedBuffer>(options.segment));
+        size_t offset = 0;
+        for (size_t n : sizes) {
+            buffer.write(source.data() + offset, n);
+            offset += n;
+        }
+        size_t length = options.total;
+        if (linearize && (!buffer.linearize(&length) || length != options.total)) {
+            fprintf(stderr, "linearize returned %zu bytes, expected %zu\n", length, options.total);
+            exit(1);
+        }
+    }
+    return seconds(start);
+}
+
+// Producer writes through writev, consumer drains with readv; both verify positions
+bool runStreaming(const Options& options, const std::vector<size_t>& sizes, const std::vector<uint8_t>& source,
+                  double* elapsed) {
+    // Bounded like a real pipe: the producer waits whenever the consumer falls behind
+    size_t limit = std::max(4 * options.segment, 2 * options.chunk);
+    ByteBuffer buffer(std::make_unique<SegmentedBuffer>(options.segment, limit));
+    std::atomic<bool> ok{true};
+    auto start = Clock::now();
+    std::thread consumer([&] {
+        std::vector<uint8_t> a(options.chunk / 2 + 1), b(options.chunk);
+        uint64_t position = 0;
+        while (position < options.total && ok.load(std::memory_order_relaxed)) {
+            struct iovec iov[2] = {{a.data(), a.size()}, {b.data(), b.size()}};
+            size_t n = buffer.readv(iov, 2);
+            for (size_t i = 0; i < n; i++) {
+                uint8_t byte = i < a.size() ? a[i] : b[i - a.size()];
+                if (byte != patternByte(position + i)) {
+                    fprintf(stderr, "mismatch at byte %llu\n", (unsigned long long)(position + i));
+                    ok.store(false);
+                    break;
+                }
+            }
+            position += n;
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    size_t offset = 0;
+    for (size_t n : sizes) {
+        // Split each chunk in two so the producer exercises gather writes
+        struct iovec iov[2] = {{const_cast<uint8_t*>(source.data() + offset), n / 2},
+                               {const_cast<uint8_t*>(source.data() + offset + n / 2), n - n / 2}};
+        while (!buffer.writev(iov, 2)) {
+            if (!ok.load(std::memory_order_relaxed)) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+        offset += n;
+    }
+    consumer.join();
+    *elapsed = seconds(start);
+    return ok.load();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--total" && hasValue) options.total = strtoull(argv[++i], nullptr, 0);
+        else if (arg == "--chunk" && hasValue) options.chunk = std::max<size_t>(2, strtoull(argv[++i], nullptr, 0));
+        else if (arg == "--segment" && hasValue) options.segment = strtoull(argv[++i], nullptr, 0);
+        else if (arg == "--rounds" && hasValue) options.rounds = std::max(1, atoi(argv[++i]));
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::vector<size_t> sizes = chunkSizes(options);
+    std::vector<uint8_t> source(options.total);
+    for (size_t i = 0; i < source.size(); i++) {
+        source[i] = patternByte(i);
+    }
+
+    double regrow = runRegrow(options, sizes, source);
+    double appended = runSegmented(options, sizes, source, false);
+    double segmented = runSegmented(options, sizes, source, true);
+    double streaming = 0;
+    bool verified = runStreaming(options, sizes, source, &streaming);
+
+    double mb = (double)options.total * options.rounds / (1024 * 1024);
+    printf("%zu bytes per round in %zu chunks of up to %zu bytes, %d rounds\n", options.total, sizes.size(),
+           options.chunk, options.rounds);
+    printf("regrow (double + copy):   %8.1f MB/s\n", mb / regrow);
+    printf("segmented append only:    %8.1f MB/s\n", mb / appended);
+    printf("segmented + linearize:    %8.1f MB/s\n", mb / segmented);
+    printf("producer/consumer stream: %8.1f MB/s (%s)\n", options.total / (1024.0 * 1024) / streaming,
+           verified ? "verified" : "MISMATCH");
+    printf("RESULT regrow_mbs=%.1f append_mbs=%.1f linearize_mbs=%.1f stream_mbs=%.1f verified=%d\n", mb / regrow,
+           mb / appended, mb / segmented, options.total / (1024.0 * 1024) / streaming, verified ? 1 : 0);
+    return verified ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+// Cross-process ByteTransfer benchmark over a shared memory buffer.
+//
+//   shm_bench [--capacity BYTES] [--chunk BYTES] [--rounds N]
+//
+// The parent creates a shared buffer and sends its descriptor to a forked
+// child over a Unix socket (SCM_RIGHTS), the same export/import path an app
+// uses with ParcelFileDescriptor. Each round the parent writes the whole
+// buffer chunk by chunk while the child follows the write cursor, consuming
+// and checksumming in place; both checksums must match.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "byte_buffer.h"
+
+namespace {
+
+bool sendFd(int socket, int fd) {
+    char byte = 0;
+    iovec iov{&byte, 1};
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    return sendmsg(socket, &msg, 0) == 1;
+}
+
+int receiveFd(int socket) {
+    char byte;
+    iovec iov{&byte, 1};
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(socket, &msg, 0) != 1) {
+        return -1;
+    }
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS) {
+        return -1;
+    }
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
+bool sendValue(int socket, uint64_t value) {
+    return write(socket, &value, sizeof(value)) == (ssize_t)sizeof(value);
+}
+
+bool receiveValue(int socket, uint64_t* value) {
+    return read(socket, value, sizeof(*value)) == (ssize_t)sizeof(*value);
+}
+
+// Order-sensitive checksum over 8-byte words
+uint64_t mix(uint64_t hash, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+void fillChunk(uint8_t* chunk, size_t length, uint64_t round, size_t offset) {
+    for (size_t i = 0; i < length; i += 8) {
+        uint64_t word = (round << 48) ^ (offset + i);
+        memcpy(chunk + i, &word, 8);
+    }
+}
+
+// Child: import the buffer and consume each round as the parent writes it
+int runConsumer(int socket) {
+    int fd = receiveFd(socket);
+    std::shared_ptr<ByteBuffer> buffer = fd >= 0 ? ByteBuffer::importShared(fd) : nullptr;
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (!buffer) {
+        fprintf(stderr, "consumer: cannot import shared buffer\n");
+        return 1;
+    }
+    uint64_t round;
+    while (receiveValue(socket, &round) && round != 0) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        while (buffer->readPosition() < buffer->capacity) {
+            size_t read_pos = buffer->readPosition();
+            size_t available = buffer->size() - read_pos;
+            if (available == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            hash = mix(hash, buffer->data + read_pos, available);
+            buffer->consume(available);
+        }
+        sendValue(socket, hash);
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t capacity = 16 << 20;
+    size_t chunk = 64 << 10;
+    int rounds = 20;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--capacity") capacity = (size_t)atoll(argv[i + 1]);
+        else if (arg == "--chunk") chunk = (size_t)atoll(argv[i + 1]);
+        else if (arg == "--rounds") rounds = std::max(1, atoi(argv[i + 1]));
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (chunk == 0 || chunk % 8 != 0 || capacity % chunk != 0) {
+        fprintf(stderr, "--chunk must be a multiple of 8 that divides --capacity\n");
+        return 2;
+    }
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+        perror("socketpair");
+        return 1;
+    }
+    pid_t child = fork();
+    if (child == 0) {
+        close(sockets[0]);
+        _exit(runConsumer(sockets[1]));
+    }
+    close(sockets[1]);
+    int socket = sockets[0];
+
+    std::shared_ptr<ByteBuffer> buffer = ByteBuffer::createShared("shm_bench", capacity);
+    int fd = buffer ? buffer->exportFd() : -1;
+    if (fd < 0 || !sendFd(socket, fd)) {
+        fprintf(stderr, "producer: cannot export shared buffer\n");
+        return 1;
+    }
+    close(fd);
+
+    std::vector<uint8_t> scratch(chunk);
+    bool verified = true;
+    double elapsed = 0;
+    for (int r = 1; r <= rounds; r++) {
+        buffer->clear();
+        // Checksum computed up front so it stays out of the timed section
+        uint64_t expected = 0xcbf29ce484222325ULL;
+        for (size_t offset = 0; offset < capacity; offset += chunk) {
+            fillChunk(scratch.data(), chunk, r, offset);
+            expected = mix(expected, scratch.data(), chunk);
+        }
+        sendValue(socket, (uint64_t)r);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t offset = 0; offset < capacity; offset += chunk) {
+            // Produce in place, then publish with one cursor store
+            fillChunk(buffer->data + offset, chunk, r, offset);
+            buffer->commit(chunk);
+        }
+        uint64_t received = 0;
+        if (!receiveValue(socket, &received)) {
+            fprintf(stderr, "producer: consumer went away in round %d\n", r);
+            return 1;
+        }
+        elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (received != expected) {
+            fprintf(stderr, "round %d: checksum mismatch %016llx != %016llx\n", r,
+                    (unsigned long long)received, (unsigned long long)expected);
+            verified = false;
+        }
+    }
+    sendValue(socket, 0);
+    int status = 0;
+    waitpid(child, &status, 0);
+    close(socket);
+
+    double bytes = (double)capacity * rounds;
+    printf("Capacity %zu bytes, chunk %zu bytes, %d rounds across 2 processes\n", capacity, chunk, rounds);
+    printf("Throughput: %.1f MB/s\n", bytes / elapsed / 1e6);
+    printf("RESULT rounds=%d bytes=%.0f mbps=%.1f verified=%s\n", rounds, bytes, bytes / elapsed / 1e6,
+           verified ? "yes" : "no");
+    return verified && WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : 1;
+}
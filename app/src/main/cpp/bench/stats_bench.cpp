@@ -0,0 +1,102 @@
+// Host benchmark for ByteBuffer traffic counters and latency histograms.
+//
+//   stats_bench [--ops N] [--size BYTES]
+//
+// Times small write + read + consume rounds on one thread with latency
+// sampling on every operation, 1 in 16 (the default) and effectively off,
+// then runs a producer and a consumer thread on one buffer and checks that
+// the counters add up. Prints the exported stats line of the last run.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "byte_buffer.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Nanoseconds per write + read + consume round
+double roundNs(int ops, size_t size, uint32_t sampling) {
+    BufferStats::setSamplingInterval(sampling);
+    ByteBuffer buffer(size * 64);
+    std::vector<uint8_t> chunk(size, 0x5A);
+    std::vector<uint8_t> out(size);
+    auto start = Clock::now();
+    for (int i = 0; i < ops; i++) {
+        if (buffer.capacity - buffer.size() < size) {
+            buffer.clear();
+        }
+        buffer.write(chunk.data(), size);
+        buffer.read(out.data(), size, buffer.readPosition());
+        buffer.consume(size);
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int ops = 2000000;
+    size_t size = 64;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--ops" && hasValue) ops = std::max(1, atoi(argv[++i]));
+        else if (arg == "--size" && hasValue) size = std::max<size_t>(1, strtoull(argv[++i], nullptr, 0));
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    // Warm up the pool and the clock
+    roundNs(ops / 10 + 1, size, 1u << 30);
+    double off = roundNs(ops, size, 1u << 30);
+    double every16 = roundNs(ops, size, 16);
+    double every1 = roundNs(ops, size, 1);
+    printf("%d rounds of %zu-byte write + read + consume\n", ops, size);
+    printf("%-28s %10.1f ns/round\n", "latency sampling off", off);
+    printf("%-28s %10.1f ns/round\n", "latency sampling 1 in 16", every16);
+    printf("%-28s %10.1f ns/round\n", "latency sampling every op", every1);
+
+    // Producer and consumer threads; every byte written must be read and consumed
+    BufferStats::setSamplingInterval(16);
+    const size_t total = (size_t)ops * size;
+    ByteBuffer buffer(total);
+    std::thread consumer([&] {
+        std::vector<uint8_t> out(size);
+        size_t done = 0;
+        while (done < total) {
+            if (buffer.size() - buffer.readPosition() < size) {
+                buffer.waitForData(size, 1000);
+                continue;
+            }
+            buffer.read(out.data(), size, buffer.readPosition());
+            buffer.consume(size);
+            done += size;
+        }
+    });
+    std::vector<uint8_t> chunk(size, 0xA5);
+    for (int i = 0; i < ops; i++) {
+        buffer.write(chunk.data(), size);
+    }
+    consumer.join();
+
+    BufferStats::Snapshot snapshot;
+    buffer.stats.snapshot(&snapshot);
+    bool balanced = snapshot.bytesIn == total && snapshot.bytesOut == total && snapshot.consumed == total &&
+                    snapshot.writes == (uint64_t)ops && snapshot.reads == (uint64_t)ops && snapshot.overflows == 0 &&
+                    snapshot.highWater >= size && snapshot.highWater <= total;
+    printf("two threads: %s\n", snapshot.format("bench").c_str());
+    printf("counters %s\n", balanced ? "balanced" : "MISMATCH");
+    printf("RESULT off_ns=%.1f sample16_ns=%.1f sample1_ns=%.1f balanced=%d\n", off, every16, every1,
+           balanced ? 1 : 0);
+    return balanced ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+// Host benchmark for ByteTransfer consumer wake-ups.
+//
+//   wake_bench [--messages N] [--interval US]
+//
+// A producer thread writes timestamped 16-byte messages every --interval
+// microseconds. The consumer picks them up by polling with a 100 us sleep
+// (what callers of bytetransfer_get_info did), by futex wait, by epoll on
+// the notification descriptor, and by futex wait and epoll with 4 KiB / 1 ms
+// batching. Reports the hand-off latency and the consumer's CPU time.
+//
+// The batched consumers are also run against a writer that stops after one
+// message, well below the byte threshold: the delay alone has to wake
+// them. A consumer that waits more than a second for data is reported as
+// stalled and the benchmark fails.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <sys/epoll.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "byte_buffer.h"
+
+namespace {
+
+enum class Mode { Poll, Futex, EventFd, Batched, BatchedEventFd };
+
+const char* modeName(Mode mode) {
+    switch (mode) {
+        case Mode::Poll: return "poll + 100us sleep";
+        case Mode::Futex: return "futex wait";
+        case Mode::EventFd: return "timerfd + epoll";
+        case Mode::Batched: return "futex, 4KiB/1ms batch";
+        case Mode::BatchedEventFd: return "epoll, 4KiB/1ms batch";
+    }
+    return "";
+}
+
+uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t threadCpuNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+struct Result {
+    double meanUs;
+    double p99Us;
+    double cpuMs;
+    bool stalled;
+};
+
+constexpr size_t kMessageSize = 16;
+
+Result run(Mode mode, int messages, int intervalUs) {
+    ByteBuffer buffer((size_t)messages * kMessageSize);
+    if (mode == Mode::Batched || mode == Mode::BatchedEventFd) {
+        buffer.setWakeThreshold(4096, 1000);
+    }
+    int epollFd = -1;
+    if (mode == Mode::EventFd || mode == Mode::BatchedEventFd) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, buffer.notificationFd(), &event);
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(messages);
+    uint64_t cpu = 0;
+    bool stalled = false;
+    std::thread consumer([&] {
+        uint64_t cpuStart = threadCpuNs();
+        int received = 0;
+        while (received < messages) {
+            if (buffer.size() - buffer.readPosition() < kMessageSize) {
+                // The writer sleeps at most intervalUs between messages
+                bool woken = true;
+                if (mode == Mode::Poll) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                } else if (epollFd >= 0) {
+                    struct epoll_event event;
+                    woken = epoll_wait(epollFd, &event, 1, 1000 + intervalUs / 1000) == 1;
+                    if (woken) {
+                        uint64_t count;
+                        ssize_t ignored = read(buffer.notificationFd(), &count, sizeof(count));
+                        (void)ignored;
+                    }
+                } else {
+                    woken = buffer.waitForData(kMessageSize, 1000000 + (int64_t)intervalUs);
+                }
+                if (!woken) {
+                    stalled = true;
+                    break;
+                }
+                continue;
+            }
+            uint64_t now = nowNs();
+            while (buffer.size() - buffer.readPosition() >= kMessageSize) {
+                uint64_t stamp;
+                buffer.read(reinterpret_cast<uint8_t*>(&stamp), sizeof(stamp), buffer.readPosition());
+                buffer.consume(kMessageSize);
+                latencies.push_back((now - stamp) / 1000.0);
+                received++;
+            }
+        }
+        cpu = threadCpuNs() - cpuStart;
+    });
+
+    uint8_t message[kMessageSize] = {};
+    for (int i = 0; i < messages; i++) {
+        std::this_thread::sleep_for(std::chrono::microseconds(intervalUs));
+        uint64_t stamp = nowNs();
+        memcpy(message, &stamp, sizeof(stamp));
+        buffer.write(message, sizeof(message));
+    }
+    consumer.join();
+    if (epollFd >= 0) {
+        close(epollFd);
+    }
+
+    if (latencies.empty()) {
+        return Result{0, 0, cpu / 1e6, true};
+    }
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (double l : latencies) {
+        sum += l;
+    }
+    return Result{sum / latencies.size(), latencies[latencies.size() * 99 / 100], cpu / 1e6, stalled};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int messages = 2000;
+    int intervalUs = 500;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--messages" && hasValue) messages = std::max(1, atoi(argv[++i]));
+        else if (arg == "--interval" && hasValue) intervalUs = std::max(0, atoi(argv[++i]));
+        else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    printf("%d messages of %zu bytes, one every %d us\n", messages, kMessageSize, intervalUs);
+    printf("%-24s %10s %10s %12s\n", "consumer", "mean us", "p99 us", "cpu ms");
+    std::string summary;
+    bool stalled = false;
+    for (Mode mode : {Mode::Poll, Mode::Futex, Mode::EventFd, Mode::Batched, Mode::BatchedEventFd}) {
+        Result r = run(mode, messages, intervalUs);
+        printf("%-24s %10.1f %10.1f %12.1f%s\n", modeName(mode), r.meanUs, r.p99Us, r.cpuMs,
+               r.stalled ? "  STALLED" : "");
+        stalled |= r.stalled;
+        char part[96];
+        snprintf(part, sizeof(part), " m%d_mean_us=%.1f m%d_cpu_ms=%.1f", (int)mode, r.meanUs, (int)mode, r.cpuMs);
+        summary += part;
+    }
+
+    // One message is far below the 4 KiB threshold
+    printf("\nwriter idle after one message\n");
+    for (Mode mode : {Mode::Batched, Mode::BatchedEventFd}) {
+        Result r = run(mode, 1, intervalUs);
+        printf("%-24s %10.1f %10.1f %12.1f%s\n", modeName(mode), r.meanUs, r.p99Us, r.cpuMs,
+               r.stalled ? "  STALLED" : "");
+        stalled |= r.stalled;
+    }
+    printf("RESULT%s stalled=%d\n", summary.c_str(), stalled ? 1 : 0);
+    return stalled ? 1 : 0;
+}
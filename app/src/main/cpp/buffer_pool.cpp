@@ -0,0 +1,212 @@
+#include "buffer_pool.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOG_TAG "BufferPool"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#define LOGE(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#endif
+
+// Per-thread stacks of recently released small blocks. Touched only by the
+// owning thread, so the common create/destroy cycle takes no lock.
+struct BufferPoolThreadCache {
+    struct Slot {
+        uint8_t* blocks[BufferPool::kThreadCacheDepth];
+        size_t count = 0;
+    };
+
+    Slot slots[BufferPool::kThreadCacheMaxShift - BufferPool::kMinBlockShift + 1];
+
+    ~BufferPoolThreadCache() { flush(); }
+
+    void flush() {
+        BufferPool& pool = BufferPool::instance();
+        for (size_t index = 0; index < sizeof(slots) / sizeof(slots[0]); index++) {
+            Slot& slot = slots[index];
+            while (slot.count > 0) {
+                pool.releaseShared(slot.blocks[--slot.count], index);
+            }
+        }
+    }
+};
+
+namespace {
+
+thread_local BufferPoolThreadCache t_cache;
+
+size_t pageAlign(size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) & ~(page - 1);
+}
+
+} // namespace
+
+BufferPool& BufferPool::instance() {
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+}
+
+size_t BufferPool::classIndex(size_t size) {
+    if (size <= ((size_t)1 << kMinBlockShift)) {
+        return 0;
+    }
+    size_t shift = sizeof(unsigned long long) * 8 - (size_t)__builtin_clzll((unsigned long long)(size - 1));
+    return shift - kMinBlockShift;
+}
+
+size_t BufferPool::blockSize(size_t size) {
+    if (size > ((size_t)1 << kMaxBlockShift)) {
+        return pageAlign(size);
+    }
+    return (size_t)1 << (classIndex(size) + kMinBlockShift);
+}
+
+uint8_t* BufferPool::allocateBlock(size_t bytes) {
+    if (bytes < kMmapThreshold) {
+        void* block = nullptr;
+        return posix_memalign(&block, 64, bytes) == 0 ? static_cast<uint8_t*>(block) : nullptr;
+    }
+    void* block = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block == MAP_FAILED) {
+        return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    if (bytes >= kHugePageThreshold) {
+        madvise(block, bytes, MADV_HUGEPAGE);
+    }
+#endif
+    return static_cast<uint8_t*>(block);
+}
+
+void BufferPool::freeBlock(uint8_t* block, size_t bytes) {
+    if (bytes < kMmapThreshold) {
+        free(block);
+    } else {
+        munmap(block, bytes);
+    }
+}
+
+uint8_t* BufferPool::acquire(size_t size, bool zeroed) {
+    if (size == 0) {
+        size = 1;
+    }
+    acquired_.fetch_add(1, std::memory_order_relaxed);
+    size_t bytes = blockSize(size);
+    uint8_t* block = nullptr;
+    if (bytes <= ((size_t)1 << kMaxBlockShift)) {
+        size_t index = classIndex(size);
+        if (index + kMinBlockShift <= kThreadCacheMaxShift && t_cache.slots[index].count > 0) {
+            BufferPoolThreadCache::Slot& slot = t_cache.slots[index];
+            block = slot.blocks[--slot.count];
+            threadCacheHits_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            SizeClass& sizeClass = classes_[index];
+            std::lock_guard<std::mutex> lock(sizeClass.mutex);
+            if (!sizeClass.blocks.empty()) {
+                block = sizeClass.blocks.back();
+                sizeClass.blocks.pop_back();
+                cachedBytes_.fetch_sub(bytes, std::memory_order_relaxed);
+                sharedCacheHits_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    if (block) {
+        // Recycled memory is dirty; clear only what the caller will see
+        if (zeroed) {
+            memset(block, 0, size);
+            bytesZeroed_.fetch_add(size, std::memory_order_relaxed);
+        }
+        return block;
+    }
+
+    block = allocateBlock(bytes);
+    if (!block) {
+        LOGE("Failed to allocate %zu byte block", bytes);
+        return nullptr;
+    }
+    freshBlocks_.fetch_add(1, std::memory_order_relaxed);
+    // Anonymous mappings start zeroed; only malloc'd small blocks need clearing
+    if (zeroed && bytes < kMmapThreshold) {
+        memset(block, 0, size);
+        bytesZeroed_.fetch_add(size, std::memory_order_relaxed);
+    }
+    return block;
+}
+
+void BufferPool::release(uint8_t* block, size_t size) {
+    if (!block) {
+        return;
+    }
+    if (size == 0) {
+        size = 1;
+    }
+    size_t bytes = blockSize(size);
+    if (bytes > ((size_t)1 << kMaxBlockShift)) {
+        freeBlock(block, bytes);
+        return;
+    }
+    size_t index = classIndex(size);
+    if (index + kMinBlockShift <= kThreadCacheMaxShift) {
+        BufferPoolThreadCache::Slot& slot = t_cache.slots[index];
+        if (slot.count < kThreadCacheDepth) {
+            slot.blocks[slot.count++] = block;
+            return;
+        }
+    }
+    releaseShared(block, index);
+}
+
+void BufferPool::releaseShared(uint8_t* block, size_t index) {
+    size_t bytes = (size_t)1 << (index + kMinBlockShift);
+    if (cachedBytes_.load(std::memory_order_relaxed) + bytes <= cacheLimit_.load(std::memory_order_relaxed)) {
+        SizeClass& sizeClass = classes_[index];
+        std::lock_guard<std::mutex> lock(sizeClass.mutex);
+        sizeClass.blocks.push_back(block);
+        cachedBytes_.fetch_add(bytes, std::memory_order_relaxed);
+        return;
+    }
+    freeBlock(block, bytes);
+}
+
+void BufferPool::setCacheLimit(size_t bytes) {
+    cacheLimit_.store(bytes, std::memory_order_relaxed);
+}
+
+void BufferPool::trim() {
+    t_cache.flush();
+    size_t freed = 0;
+    for (size_t index = 0; index < kClassCount; index++) {
+        size_t bytes = (size_t)1 << (index + kMinBlockShift);
+        std::vector<uint8_t*> blocks;
+        {
+            std::lock_guard<std::mutex> lock(classes_[index].mutex);
+            blocks.swap(classes_[index].blocks);
+        }
+        for (uint8_t* block : blocks) {
+            freeBlock(block, bytes);
+        }
+        cachedBytes_.fetch_sub(blocks.size() * bytes, std::memory_order_relaxed);
+        freed += blocks.size() * bytes;
+    }
+    LOGI("Trimmed %zu cached bytes", freed);
+}
+
+BufferPool::Stats BufferPool::stats() const {
+    Stats s;
+    s.acquired = acquired_.load(std::memory_order_relaxed);
+    s.threadCacheHits = threadCacheHits_.load(std::memory_order_relaxed);
+    s.sharedCacheHits = sharedCacheHits_.load(std::memory_order_relaxed);
+    s.freshBlocks = freshBlocks_.load(std::memory_order_relaxed);
+    s.bytesZeroed = bytesZeroed_.load(std::memory_order_relaxed);
+    s.cachedBytes = cachedBytes_.load(std::memory_order_relaxed);
+    return s;
+}
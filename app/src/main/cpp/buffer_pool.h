@@ -0,0 +1,93 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * Recycling allocator for ByteBuffer memory.
+ *
+ * Requests are rounded up to power-of-two size classes (4 KiB .. 256 MiB).
+ * Released blocks go to a small per-thread cache first, then to a shared
+ * per-class free list bounded by a byte budget, so create/destroy churn
+ * reuses memory that is already mapped instead of paying for malloc and
+ * page faults again. Classes of 64 KiB and up are mmap'd directly (2 MiB
+ * and up with a transparent huge page hint); anything past the largest
+ * class is mapped and unmapped without caching.
+ *
+ * Memory is only zeroed when the caller asks for it, and then only the
+ * requested bytes of a recycled block; fresh mappings are already zero.
+ */
+class BufferPool {
+public:
+    struct Stats {
+        uint64_t acquired = 0;
+        uint64_t threadCacheHits = 0;
+        uint64_t sharedCacheHits = 0;
+        uint64_t freshBlocks = 0;
+        uint64_t bytesZeroed = 0;
+        uint64_t cachedBytes = 0;
+    };
+
+    static constexpr size_t kMinBlockShift = 12;              // 4 KiB
+    static constexpr size_t kMaxBlockShift = 28;              // 256 MiB
+    static constexpr size_t kThreadCacheMaxShift = 18;        // per-thread caching up to 256 KiB
+    static constexpr size_t kThreadCacheDepth = 4;            // blocks per class per thread
+    static constexpr size_t kMmapThreshold = 64 * 1024;
+    static constexpr size_t kHugePageThreshold = 2 * 1024 * 1024;
+
+    // Process-wide pool; never destroyed so thread caches can flush into it at exit
+    static BufferPool& instance();
+
+    // Bytes actually reserved for a request of size bytes
+    static size_t blockSize(size_t size);
+
+    // Block of at least size bytes, 64-byte aligned. With zeroed the first
+    // size bytes read as zero; otherwise contents are unspecified.
+    uint8_t* acquire(size_t size, bool zeroed);
+
+    // Return a block from acquire(); size must be the size it was acquired with
+    // (or any size in the same class)
+    void release(uint8_t* block, size_t size);
+
+    // Bound on memory held in the shared free lists (default 64 MiB)
+    void setCacheLimit(size_t bytes);
+
+    // Give every block in the shared lists and the calling thread's cache back to the OS
+    void trim();
+
+    Stats stats() const;
+
+private:
+    static constexpr size_t kClassCount = kMaxBlockShift - kMinBlockShift + 1;
+
+    BufferPool() = default;
+
+    static size_t classIndex(size_t size);
+    static uint8_t* allocateBlock(size_t bytes);
+    static void freeBlock(uint8_t* block, size_t bytes);
+
+    friend struct BufferPoolThreadCache;
+    // Shared-list path, also used when a thread cache overflows or its thread exits
+    void releaseShared(uint8_t* block, size_t index);
+
+    struct SizeClass {
+        std::mutex mutex;
+        std::vector<uint8_t*> blocks;
+    };
+
+    SizeClass classes_[kClassCount];
+    std::atomic<size_t> cacheLimit_{64 * 1024 * 1024};
+    std::atomic<size_t> cachedBytes_{0};
+
+    std::atomic<uint64_t> acquired_{0};
+    std::atomic<uint64_t> threadCacheHits_{0};
+    std::atomic<uint64_t> sharedCacheHits_{0};
+    std::atomic<uint64_t> freshBlocks_{0};
+    std::atomic<uint64_t> bytesZeroed_{0};
+};
+
+#endif // BUFFER_POOL_H
@@ -0,0 +1,281 @@
+#include "buffer_registry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <limits>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOG_TAG "BufferRegistry"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#define LOGE(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#endif
+
+namespace {
+
+// Epoch-based reclamation. Each reading thread owns a record whose epoch is
+// the global epoch it observed on entering its outermost ReadGuard (0 while
+// outside). An entry retired at epoch E is freed once no record holds an
+// epoch <= E: every reader that could have loaded it has left.
+struct ReaderRecord {
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<bool> inUse{false};
+    ReaderRecord* next = nullptr;
+};
+
+std::atomic<uint64_t> g_epoch{1};
+std::atomic<ReaderRecord*> g_readers{nullptr};
+
+// Records are never freed; a thread's record is handed to the next new thread
+struct ThreadReader {
+    ReaderRecord* record = nullptr;
+    int depth = 0;
+
+    ReaderRecord* get() {
+        if (record) {
+            return record;
+        }
+        for (ReaderRecord* r = g_readers.load(std::memory_order_acquire); r; r = r->next) {
+            bool expected = false;
+            if (!r->inUse.load(std::memory_order_relaxed) &&
+                r->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                record = r;
+                return record;
+            }
+        }
+        record = new ReaderRecord();
+        record->inUse.store(true, std::memory_order_relaxed);
+        ReaderRecord* head = g_readers.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!g_readers.compare_exchange_weak(head, record, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+        return record;
+    }
+
+    ~ThreadReader() {
+        if (record) {
+            record->epoch.store(0, std::memory_order_release);
+            record->inUse.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadReader t_reader;
+
+uint64_t oldestActiveEpoch() {
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (ReaderRecord* r = g_readers.load(std::memory_order_acquire); r; r = r->next) {
+        uint64_t epoch = r->epoch.load(std::memory_order_seq_cst);
+        if (epoch != 0) {
+            oldest = std::min(oldest, epoch);
+        }
+    }
+    return oldest;
+}
+
+} // namespace
+
+BufferRegistry::ReadGuard::ReadGuard() {
+    if (t_reader.depth++ == 0) {
+        ReaderRecord* record = t_reader.get();
+        record->epoch.store(g_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        // Publish the epoch before any slot load (pairs with retire())
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+BufferRegistry::ReadGuard::~ReadGuard() {
+    if (--t_reader.depth == 0) {
+        t_reader.record->epoch.store(0, std::memory_order_release);
+    }
+}
+
+BufferRegistry& BufferRegistry::instance() {
+    // Never destroyed: JS finalizers and detached threads may still look up buffers at exit
+    static BufferRegistry* registry = new BufferRegistry();
+    return *registry;
+}
+
+BufferRegistry::Shard& BufferRegistry::shardFor(std::string_view name) const {
+    return shards_[std::hash<std::string_view>()(name) % kShardCount];
+}
+
+BufferRegistry::Slot* BufferRegistry::slotAt(uint32_t index) const {
+    Slot* chunk = chunks_[index >> kChunkBits].load(std::memory_order_acquire);
+    return chunk ? &chunk[index & (kChunkSize - 1)] : nullptr;
+}
+
+BufferRegistry::Slot* BufferRegistry::resolve(Handle handle) const {
+    uint32_t index = handle & kIndexMask;
+    if (index == 0) {
+        return nullptr;
+    }
+    Slot* slot = slotAt(index);
+    if (!slot || slot->generation.load(std::memory_order_acquire) != (handle >> kIndexBits)) {
+        return nullptr;
+    }
+    return slot;
+}
+
+ByteBuffer* BufferRegistry::get(Handle handle) const {
+    Slot* slot = resolve(handle);
+    if (!slot) {
+        return nullptr;
+    }
+    Entry* entry = slot->entry.load(std::memory_order_seq_cst);
+    // A slot freed and reused between the two loads has a new generation
+    if (!entry || slot->generation.load(std::memory_order_acquire) != (handle >> kIndexBits)) {
+        return nullptr;
+    }
+    return entry->buffer.get();
+}
+
+std::shared_ptr<ByteBuffer> BufferRegistry::acquire(Handle handle) const {
+    ReadGuard guard;
+    Slot* slot = resolve(handle);
+    if (!slot) {
+        return nullptr;
+    }
+    Entry* entry = slot->entry.load(std::memory_order_seq_cst);
+    if (!entry || slot->generation.load(std::memory_order_acquire) != (handle >> kIndexBits)) {
+        return nullptr;
+    }
+    return entry->buffer;
+}
+
+BufferRegistry::Handle BufferRegistry::open(std::string_view name) const {
+    Shard& shard = shardFor(name);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.names.find(name);
+    return it != shard.names.end() ? it->second : kInvalidHandle;
+}
+
+std::vector<std::string> BufferRegistry::names() const {
+    std::vector<std::string> result;
+    for (const Shard& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        for (const auto& name : shard.names) {
+            result.push_back(name.first);
+        }
+    }
+    return result;
+}
+
+BufferRegistry::Handle BufferRegistry::allocateSlot() {
+    std::lock_guard<std::mutex> lock(slotMutex_);
+    uint32_t index;
+    if (!freeSlots_.empty()) {
+        index = freeSlots_.back();
+        freeSlots_.pop_back();
+    } else {
+        if (nextIndex_ > kIndexMask) {
+            return kInvalidHandle;
+        }
+        index = nextIndex_++;
+        size_t chunkIndex = index >> kChunkBits;
+        if (!chunks_[chunkIndex].load(std::memory_order_relaxed)) {
+            chunks_[chunkIndex].store(new Slot[kChunkSize], std::memory_order_release);
+        }
+    }
+    Slot* slot = slotAt(index);
+    uint32_t generation = (slot->generation.load(std::memory_order_relaxed) + 1) & 0xFFFF;
+    if (generation == 0) {
+        generation = 1;
+    }
+    slot->generation.store(generation, std::memory_order_release);
+    return (generation << kIndexBits) | index;
+}
+
+void BufferRegistry::releaseSlot(uint32_t index) {
+    std::lock_guard<std::mutex> lock(slotMutex_);
+    freeSlots_.push_back(index);
+}
+
+// Also called with null after a plain insert, to reclaim earlier retirees
+void BufferRegistry::retire(Entry* entry) {
+    std::vector<Entry*> reclaimable;
+    {
+        std::lock_guard<std::mutex> lock(retireMutex_);
+        if (entry) {
+            // Tag with the current epoch and move on, so readers that enter
+            // from now on can never have seen this entry
+            retired_.emplace_back(g_epoch.fetch_add(1, std::memory_order_seq_cst), entry);
+        }
+        if (retired_.empty()) {
+            return;
+        }
+        uint64_t oldest = oldestActiveEpoch();
+        auto keep = std::partition(retired_.begin(), retired_.end(),
+                                   [oldest](const std::pair<uint64_t, Entry*>& r) { return r.first >= oldest; });
+        for (auto it = keep; it != retired_.end(); ++it) {
+            reclaimable.push_back(it->second);
+        }
+        retired_.erase(keep, retired_.end());
+    }
+    // Dropping the last reference may free a large buffer; do it outside the lock
+    for (Entry* e : reclaimable) {
+        delete e;
+    }
+}
+
+BufferRegistry::Handle BufferRegistry::put(std::string_view name, std::shared_ptr<ByteBuffer> buffer) {
+    Shard& shard = shardFor(name);
+    Entry* entry = new Entry{std::move(buffer)};
+    Entry* old = nullptr;
+    Handle handle;
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.names.find(name);
+        if (it != shard.names.end()) {
+            handle = it->second;
+            old = slotAt(handle & kIndexMask)->entry.exchange(entry, std::memory_order_seq_cst);
+        } else {
+            handle = allocateSlot();
+            if (handle == kInvalidHandle) {
+                LOGE("Buffer registry is full, cannot add '%.*s'", (int)name.size(), name.data());
+                delete entry;
+                return kInvalidHandle;
+            }
+            slotAt(handle & kIndexMask)->entry.store(entry, std::memory_order_seq_cst);
+            shard.names.emplace(std::string(name), handle);
+        }
+    }
+    retire(old);
+    return handle;
+}
+
+bool BufferRegistry::removeLocked(Shard& shard, std::map<std::string, Handle, std::less<>>::iterator it) {
+    uint32_t index = it->second & kIndexMask;
+    shard.names.erase(it);
+    Slot* slot = slotAt(index);
+    Entry* old = slot->entry.exchange(nullptr, std::memory_order_seq_cst);
+    // Invalidate outstanding handles before the slot can be reused
+    slot->generation.fetch_add(1, std::memory_order_release);
+    releaseSlot(index);
+    retire(old);
+    return true;
+}
+
+bool BufferRegistry::remove(std::string_view name) {
+    Shard& shard = shardFor(name);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.names.find(name);
+    if (it == shard.names.end()) {
+        return false;
+    }
+    return removeLocked(shard, it);
+}
+
+void BufferRegistry::clear() {
+    for (Shard& shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        while (!shard.names.empty()) {
+            removeLocked(shard, shard.names.begin());
+        }
+    }
+}
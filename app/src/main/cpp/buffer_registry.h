@@ -0,0 +1,120 @@
+#ifndef BUFFER_REGISTRY_H
+#define BUFFER_REGISTRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "byte_buffer.h"
+
+/**
+ * Thread-safe name -> ByteBuffer registry shared by Kotlin, QuickJS and
+ * native callers.
+ *
+ * Names are resolved once to a 32-bit handle (slot index plus generation).
+ * get(handle) is a lock-free array index and is what hot paths should use;
+ * name lookups go through one of 16 read/write-locked shards keyed by
+ * string_view, so C callers never build a std::string.
+ *
+ * Replacing a name keeps its handle and swaps the slot's buffer; removing it
+ * bumps the slot generation so stale handles resolve to null. Replaced
+ * entries are reclaimed by epoch: raw pointers from get()/find() stay valid
+ * until the enclosing ReadGuard ends, even if another thread replaces or
+ * removes the name meanwhile. Use acquire() for a reference that outlives
+ * the guard.
+ *
+ * The registry only makes lookup safe. Each linear buffer still expects one
+ * writer and one reader at a time; use ring mode for several producers.
+ */
+class BufferRegistry {
+public:
+    using Handle = uint32_t;
+    static constexpr Handle kInvalidHandle = 0;
+
+    // Pins every entry reachable through get()/find() on this thread until
+    // destroyed. Nests; costs one store and one fence on entry.
+    class ReadGuard {
+    public:
+        ReadGuard();
+        ~ReadGuard();
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+    };
+
+    static BufferRegistry& instance();
+
+    // Publish buffer under name, replacing any previous buffer. Returns the
+    // name's handle (unchanged by replacement), or kInvalidHandle if full.
+    Handle put(std::string_view name, std::shared_ptr<ByteBuffer> buffer);
+
+    // Handle for name, or kInvalidHandle
+    Handle open(std::string_view name) const;
+
+    // Lock-free; requires an active ReadGuard
+    ByteBuffer* get(Handle handle) const;
+    // Shard lookup plus get(); requires an active ReadGuard
+    ByteBuffer* find(std::string_view name) const { return get(open(name)); }
+
+    // Owning reference, usable without a guard
+    std::shared_ptr<ByteBuffer> acquire(Handle handle) const;
+    std::shared_ptr<ByteBuffer> acquire(std::string_view name) const { return acquire(open(name)); }
+
+    // Snapshot of the registered names, in no particular order
+    std::vector<std::string> names() const;
+
+    bool remove(std::string_view name);
+    void clear();
+
+private:
+    struct Entry {
+        std::shared_ptr<ByteBuffer> buffer;
+    };
+
+    struct Slot {
+        std::atomic<uint32_t> generation{0};
+        std::atomic<Entry*> entry{nullptr};
+    };
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::map<std::string, Handle, std::less<>> names;
+    };
+
+    static constexpr size_t kShardCount = 16;
+    static constexpr uint32_t kIndexBits = 16;
+    static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1;
+    static constexpr size_t kChunkBits = 8;
+    static constexpr size_t kChunkSize = (size_t)1 << kChunkBits;
+    static constexpr size_t kMaxChunks = ((size_t)1 << kIndexBits) / kChunkSize;
+
+    BufferRegistry() = default;
+
+    Shard& shardFor(std::string_view name) const;
+    Slot* slotAt(uint32_t index) const;
+    // Resolve handle to its slot if the generation still matches
+    Slot* resolve(Handle handle) const;
+    Handle allocateSlot();
+    void releaseSlot(uint32_t index);
+    void retire(Entry* entry);
+    bool removeLocked(Shard& shard, std::map<std::string, Handle, std::less<>>::iterator it);
+
+    mutable Shard shards_[kShardCount];
+
+    std::mutex slotMutex_;
+    std::atomic<Slot*> chunks_[kMaxChunks] = {};
+    std::vector<uint32_t> freeSlots_;
+    uint32_t nextIndex_ = 1;  // index 0 is never used so handle 0 stays invalid
+
+    std::mutex retireMutex_;
+    std::vector<std::pair<uint64_t, Entry*>> retired_;
+};
+
+#endif // BUFFER_REGISTRY_H
@@ -0,0 +1,147 @@
+#include "buffer_stats.h"
+
+#include <cstdio>
+#include <ctime>
+
+namespace {
+
+std::atomic<uint32_t> g_samplingMask{15};  // time 1 in 16 operations
+thread_local uint32_t t_opCounter = 0;
+
+int highestBit(uint64_t value) {
+    return 63 - __builtin_clzll(value);
+}
+
+} // namespace
+
+int LatencyHistogram::bucketFor(uint64_t ns) {
+    if (ns < (uint64_t)kSubBuckets) {
+        return (int)ns;
+    }
+    int shift = highestBit(ns);
+    if (shift > kMaxShift) {
+        return kBuckets - 1;
+    }
+    // Bucket group by power of two, then the next kSubBucketBits bits below the top one
+    int sub = (int)((ns >> (shift - kSubBucketBits)) & (kSubBuckets - 1));
+    return (shift - kSubBucketBits + 1) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::bucketLimit(int bucket) {
+    if (bucket < kSubBuckets) {
+        return (uint64_t)bucket;
+    }
+    int shift = bucket / kSubBuckets + kSubBucketBits - 1;
+    uint64_t sub = (uint64_t)(bucket % kSubBuckets);
+    return ((uint64_t)1 << shift) + ((sub + 1) << (shift - kSubBucketBits)) - 1;
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile(double fraction) const {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)(fraction * (double)total + 0.5);
+    if (target == 0) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+        seen += counts[i];
+        if (seen >= target) {
+            return bucketLimit(i);
+        }
+    }
+    return bucketLimit(kBuckets - 1);
+}
+
+void LatencyHistogram::snapshot(Snapshot* out) const {
+    out->total = 0;
+    for (int i = 0; i < kBuckets; i++) {
+        out->counts[i] = counts_[i].load(std::memory_order_relaxed);
+        out->total += out->counts[i];
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& count : counts_) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+void BufferStats::setSamplingInterval(uint32_t every) {
+    uint32_t interval = 1;
+    while (interval < every && interval < (1u << 30)) {
+        interval <<= 1;
+    }
+    g_samplingMask.store(interval - 1, std::memory_order_relaxed);
+}
+
+uint32_t BufferStats::samplingInterval() {
+    return g_samplingMask.load(std::memory_order_relaxed) + 1;
+}
+
+bool BufferStats::sampleThisOp() {
+    return (t_opCounter++ & g_samplingMask.load(std::memory_order_relaxed)) == 0;
+}
+
+uint64_t BufferStats::nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void BufferStats::recordWrite(size_t bytes, uint64_t unreadAfter) {
+    bytesIn_.fetch_add(bytes, std::memory_order_relaxed);
+    writes_.fetch_add(1, std::memory_order_relaxed);
+    uint64_t high = highWater_.load(std::memory_order_relaxed);
+    while (unreadAfter > high &&
+           !highWater_.compare_exchange_weak(high, unreadAfter, std::memory_order_relaxed)) {
+    }
+}
+
+void BufferStats::recordRead(size_t bytes) {
+    bytesOut_.fetch_add(bytes, std::memory_order_relaxed);
+    reads_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BufferStats::snapshot(Snapshot* out) const {
+    out->bytesIn = bytesIn_.load(std::memory_order_relaxed);
+    out->bytesOut = bytesOut_.load(std::memory_order_relaxed);
+    out->writes = writes_.load(std::memory_order_relaxed);
+    out->reads = reads_.load(std::memory_order_relaxed);
+    out->consumed = consumed_.load(std::memory_order_relaxed);
+    out->overflows = overflows_.load(std::memory_order_relaxed);
+    out->underflows = underflows_.load(std::memory_order_relaxed);
+    out->highWater = highWater_.load(std::memory_order_relaxed);
+    writeLatency_.snapshot(&out->writeLatency);
+    readLatency_.snapshot(&out->readLatency);
+}
+
+void BufferStats::reset() {
+    for (auto* counter : {&bytesIn_, &writes_, &overflows_, &highWater_, &bytesOut_, &reads_, &consumed_,
+                          &underflows_}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+    writeLatency_.reset();
+    readLatency_.reset();
+}
+
+std::string BufferStats::Snapshot::format(std::string_view name) const {
+    char line[384];
+    const LatencyHistogram::Snapshot& w = writeLatency;
+    const LatencyHistogram::Snapshot& r = readLatency;
+    int n = snprintf(line, sizeof(line),
+                     "in=%llu out=%llu w=%llu r=%llu cs=%llu of=%llu uf=%llu hw=%llu "
+                     "wl=%llu,%llu,%llu,%llu rl=%llu,%llu,%llu,%llu name=",
+                     (unsigned long long)bytesIn, (unsigned long long)bytesOut, (unsigned long long)writes,
+                     (unsigned long long)reads, (unsigned long long)consumed, (unsigned long long)overflows,
+                     (unsigned long long)underflows, (unsigned long long)highWater,
+                     (unsigned long long)w.percentile(0.5), (unsigned long long)w.percentile(0.9),
+                     (unsigned long long)w.percentile(0.99), (unsigned long long)w.percentile(1.0),
+                     (unsigned long long)r.percentile(0.5),
+                     (unsigned long long)r.percentile(0.9), (unsigned long long)r.percentile(0.99),
+                     (unsigned long long)r.percentile(1.0));
+    std::string result(line, n > 0 ? (size_t)n : 0);
+    result.append(name.data(), name.size());
+    return result;
+}
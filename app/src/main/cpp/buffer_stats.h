@@ -0,0 +1,124 @@
+#ifndef BUFFER_STATS_H
+#define BUFFER_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * Log-linear latency histogram in nanoseconds. Each power of two is split
+ * into 8 linear sub-buckets, so a recorded value is off by at most 12.5%.
+ * Values from 2^36 ns (~69 s) up land in the last bucket. Recording is a
+ * single relaxed increment.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 3;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kMaxShift = 36;
+    static constexpr int kBuckets = (kMaxShift - kSubBucketBits + 1) * kSubBuckets + kSubBuckets;
+
+    void record(uint64_t ns) { counts_[bucketFor(ns)].fetch_add(1, std::memory_order_relaxed); }
+
+    static int bucketFor(uint64_t ns);
+    // Upper bound of the values that land in bucket
+    static uint64_t bucketLimit(int bucket);
+
+    struct Snapshot {
+        uint64_t counts[kBuckets];
+        uint64_t total;
+        // Smallest bucket limit covering fraction (0..1] of the samples; 0 if empty
+        uint64_t percentile(double fraction) const;
+    };
+    void snapshot(Snapshot* out) const;
+    void reset();
+
+private:
+    std::atomic<uint64_t> counts_[kBuckets] = {};
+};
+
+/**
+ * Lock-free per-buffer counters: bytes and operations in each direction,
+ * bytes consumed (read cursor moves), overflow/underflow failures, the
+ * unread high-water mark, and latency histograms for write and read.
+ * Writer-side and reader-side fields sit on separate cache lines so a
+ * producer and a consumer do not false-share.
+ *
+ * Latency is sampled: each thread times one operation in samplingInterval()
+ * (an interval of 1 times every operation), so most calls skip the clock.
+ */
+class BufferStats {
+public:
+    // Process-wide sampling interval, rounded up to a power of two
+    static void setSamplingInterval(uint32_t every);
+    static uint32_t samplingInterval();
+    // True if the calling thread should time this operation
+    static bool sampleThisOp();
+    static uint64_t nowNs();
+
+    void recordWrite(size_t bytes, uint64_t unreadAfter);
+    void recordRead(size_t bytes);
+    void recordConsume(size_t bytes) { consumed_.fetch_add(bytes, std::memory_order_relaxed); }
+    void recordWriteLatency(uint64_t ns) { writeLatency_.record(ns); }
+    void recordReadLatency(uint64_t ns) { readLatency_.record(ns); }
+    void recordOverflow() { overflows_.fetch_add(1, std::memory_order_relaxed); }
+    void recordUnderflow() { underflows_.fetch_add(1, std::memory_order_relaxed); }
+
+    struct Snapshot {
+        uint64_t bytesIn;
+        uint64_t bytesOut;
+        uint64_t writes;
+        uint64_t reads;
+        uint64_t consumed;
+        uint64_t overflows;
+        uint64_t underflows;
+        uint64_t highWater;
+        LatencyHistogram::Snapshot writeLatency;
+        LatencyHistogram::Snapshot readLatency;
+
+        // One line: "in=.. out=.. w=.. r=.. cs=.. of=.. uf=.. hw=.. wl=p50,p90,p99,max
+        // rl=p50,p90,p99,max name=<name>" with latencies in ns. The name is
+        // last so it may contain spaces.
+        std::string format(std::string_view name) const;
+    };
+    void snapshot(Snapshot* out) const;
+    void reset();
+
+private:
+    // Writer side
+    alignas(64) std::atomic<uint64_t> bytesIn_{0};
+    std::atomic<uint64_t> writes_{0};
+    std::atomic<uint64_t> overflows_{0};
+    std::atomic<uint64_t> highWater_{0};
+    // Reader side
+    alignas(64) std::atomic<uint64_t> bytesOut_{0};
+    std::atomic<uint64_t> reads_{0};
+    std::atomic<uint64_t> consumed_{0};
+    std::atomic<uint64_t> underflows_{0};
+    alignas(64) LatencyHistogram writeLatency_;
+    alignas(64) LatencyHistogram readLatency_;
+};
+
+// Times one operation into a histogram when the calling thread's sample is due
+class ScopedLatency {
+public:
+    ScopedLatency(BufferStats& stats, bool write)
+        : stats_(stats), write_(write), start_(BufferStats::sampleThisOp() ? BufferStats::nowNs() : 0) {}
+    ~ScopedLatency() {
+        if (start_) {
+            uint64_t elapsed = BufferStats::nowNs() - start_;
+            write_ ? stats_.recordWriteLatency(elapsed) : stats_.recordReadLatency(elapsed);
+        }
+    }
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    BufferStats& stats_;
+    bool write_;
+    uint64_t start_;
+};
+
+#endif // BUFFER_STATS_H
@@ -0,0 +1,551 @@
+#include "byte_buffer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <new>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOG_TAG "ByteTransfer"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#define LOGE(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#endif
+
+namespace {
+
+// First bytes of every shared buffer mapping; data follows at kSharedHeaderSize
+struct SharedBufferHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    BufferCursors cursors;
+};
+
+constexpr uint32_t kSharedMagic = 0x42544246;  // "FBTB"
+constexpr uint32_t kSharedVersion = 2;
+constexpr size_t kSharedHeaderSize = 64;
+
+static_assert(sizeof(SharedBufferHeader) <= kSharedHeaderSize, "shared header too large");
+
+// Cursors as of one flush(). Two slots are written alternately, so a crash
+// while writing one leaves the other intact; the valid slot with the
+// higher sequence wins on reopen.
+struct PersistentCommit {
+    uint64_t sequence;
+    uint64_t write_pos;
+    uint64_t read_pos;
+    uint64_t checksum;
+};
+
+constexpr uint32_t kPersistentMagic = 0x50544246;  // "FBTP"
+constexpr uint32_t kPersistentVersion = 2;
+// A whole page so data syncs never rewrite the header with the live cursors first
+constexpr size_t kPersistentHeaderSize = 4096;
+
+uint64_t commitChecksum(const PersistentCommit& commit) {
+    // FNV-1a over the record fields; catches torn and stale slot writes
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (uint64_t value : {commit.sequence, commit.write_pos, commit.read_pos}) {
+        for (int i = 0; i < 8; i++) {
+            hash = (hash ^ ((value >> (i * 8)) & 0xFF)) * 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Shared buffers are mapped by several processes, so their futex must not
+// be process-private
+void futexWait(std::atomic<uint32_t>* word, uint32_t expected, int64_t timeoutUs, bool shared) {
+    struct timespec ts;
+    struct timespec* timeout = nullptr;
+    if (timeoutUs >= 0) {
+        ts.tv_sec = (time_t)(timeoutUs / 1000000);
+        ts.tv_nsec = (long)(timeoutUs % 1000000) * 1000;
+        timeout = &ts;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected,
+            timeout, nullptr, 0);
+}
+
+void futexWakeAll(std::atomic<uint32_t>* word, bool shared) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, INT_MAX,
+            nullptr, nullptr, 0);
+}
+
+// Arm the notification timer to fire after delayNs (0 = right away);
+// re-arming replaces a pending delay
+void signalNotificationFd(int fd, uint64_t delayNs) {
+    struct itimerspec spec = {};
+    uint64_t ns = delayNs != 0 ? delayNs : 1;
+    spec.it_value.tv_sec = (time_t)(ns / 1000000000ULL);
+    spec.it_value.tv_nsec = (long)(ns % 1000000000ULL);
+    timerfd_settime(fd, 0, &spec, nullptr);
+}
+
+} // namespace
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit int");
+
+struct PersistentBufferHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    // Live cursors, ahead of the last commit between flushes
+    BufferCursors cursors;
+    PersistentCommit commits[2];
+};
+
+static_assert(sizeof(PersistentBufferHeader) <= kPersistentHeaderSize, "persistent header too large");
+
+ByteBuffer::ByteBuffer(size_t cap, bool zeroed) : capacity(cap), is_owner(true), cursors_(&local_cursors_) {
+    data = BufferPool::instance().acquire(capacity, zeroed);
+    if (!data) {
+        throw std::bad_alloc();
+    }
+}
+
+ByteBuffer::ByteBuffer(uint8_t* external_data, size_t data_size)
+    : data(external_data), capacity(data_size), is_owner(false), cursors_(&local_cursors_) {
+    local_cursors_.write_pos.store(data_size, std::memory_order_relaxed);
+}
+
+ByteBuffer::ByteBuffer(std::unique_ptr<ByteRing> ring_buffer)
+    : data(nullptr), capacity(ring_buffer->capacity()), is_owner(false), ring(std::move(ring_buffer)),
+      cursors_(&local_cursors_) {
+}
+
+ByteBuffer::ByteBuffer(std::unique_ptr<SegmentedBuffer> segmented)
+    : data(nullptr), capacity(segmented->maxBytes()), is_owner(false), segments(std::move(segmented)),
+      cursors_(&local_cursors_) {
+}
+
+ByteBuffer::ByteBuffer(std::unique_ptr<SharedMemory> memory, BufferCursors* cursors, uint8_t* base, size_t cap)
+    : data(base), capacity(cap), is_owner(false), shm(std::move(memory)), cursors_(cursors) {
+}
+
+ByteBuffer::~ByteBuffer() {
+    if (persistent_) {
+        flush();
+    }
+    int fd = notify_fd_.load(std::memory_order_relaxed);
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (is_owner && data) {
+        BufferPool::instance().release(data, capacity);
+    }
+}
+
+std::shared_ptr<ByteBuffer> ByteBuffer::createShared(const char* name, size_t capacity) {
+    std::unique_ptr<SharedMemory> memory = SharedMemory::create(name, kSharedHeaderSize + capacity);
+    if (!memory) {
+        return nullptr;
+    }
+    // Fresh memfd/ashmem pages are zero, so the cursors start at 0
+    auto* header = new (memory->data()) SharedBufferHeader();
+    header->version = kSharedVersion;
+    header->capacity = capacity;
+    // Publish the magic last: an importer racing creation sees either nothing or a full header
+    __atomic_store_n(&header->magic, kSharedMagic, __ATOMIC_RELEASE);
+    uint8_t* base = memory->data() + kSharedHeaderSize;
+    return std::shared_ptr<ByteBuffer>(new ByteBuffer(std::move(memory), &header->cursors, base, capacity));
+}
+
+std::shared_ptr<ByteBuffer> ByteBuffer::importShared(int fd) {
+    std::unique_ptr<SharedMemory> memory = SharedMemory::map(fd);
+    if (!memory) {
+        return nullptr;
+    }
+    if (memory->size() < kSharedHeaderSize) {
+        LOGE("Shared memory fd %d is too small for a buffer header", fd);
+        return nullptr;
+    }
+    auto* header = reinterpret_cast<SharedBufferHeader*>(memory->data());
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != kSharedMagic || header->version != kSharedVersion) {
+        LOGE("Shared memory fd %d does not hold a ByteTransfer buffer", fd);
+        return nullptr;
+    }
+    // Never trust the peer's capacity beyond what is actually mapped
+    if (header->capacity > memory->size() - kSharedHeaderSize) {
+        LOGE("Shared buffer capacity %llu exceeds mapping of %zu bytes",
+             (unsigned long long)header->capacity, memory->size());
+        return nullptr;
+    }
+    size_t capacity = (size_t)header->capacity;
+    uint8_t* base = memory->data() + kSharedHeaderSize;
+    return std::shared_ptr<ByteBuffer>(new ByteBuffer(std::move(memory), &header->cursors, base, capacity));
+}
+
+int ByteBuffer::exportFd() const {
+    return shm ? shm->duplicateFd() : -1;
+}
+
+std::shared_ptr<ByteBuffer> ByteBuffer::openPersistent(const char* path, size_t capacity) {
+    std::unique_ptr<SharedMemory> file = SharedMemory::openFile(path, kPersistentHeaderSize + capacity);
+    if (!file) {
+        return nullptr;
+    }
+    auto* header = reinterpret_cast<PersistentBufferHeader*>(file->data());
+    uint32_t magic = __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE);
+    if (magic == 0) {
+        // New (or never completely initialized) file: write the header, make
+        // it durable, then set the magic so a crash mid-way reads as new again
+        new (header) PersistentBufferHeader();
+        header->version = kPersistentVersion;
+        header->capacity = capacity;
+        if (!file->sync(0, kPersistentHeaderSize)) {
+            return nullptr;
+        }
+        __atomic_store_n(&header->magic, kPersistentMagic, __ATOMIC_RELEASE);
+    } else if (magic != kPersistentMagic || header->version != kPersistentVersion) {
+        LOGE("'%s' is not a persistent ByteTransfer buffer", path);
+        return nullptr;
+    } else {
+        if (header->capacity > file->size() - kPersistentHeaderSize) {
+            LOGE("'%s' is truncated: capacity %llu, file %zu bytes", path,
+                 (unsigned long long)header->capacity, file->size());
+            return nullptr;
+        }
+        if (capacity > header->capacity) {
+            // openFile() already grew the file
+            header->capacity = capacity;
+        }
+        // Restore the newest intact commit
+        const PersistentCommit* restored = nullptr;
+        for (const PersistentCommit& commit : header->commits) {
+            bool valid = commit.checksum == commitChecksum(commit) && commit.read_pos <= commit.write_pos &&
+                         commit.write_pos <= header->capacity;
+            if (valid && (!restored || commit.sequence > restored->sequence)) {
+                restored = &commit;
+            }
+        }
+        header->cursors.write_pos.store(restored ? restored->write_pos : 0, std::memory_order_relaxed);
+        header->cursors.read_pos.store(restored ? restored->read_pos : 0, std::memory_order_relaxed);
+        // Nobody can be waiting on a file that was just reopened
+        header->cursors.waiters.store(0, std::memory_order_relaxed);
+        if (!file->sync(0, kPersistentHeaderSize)) {
+            return nullptr;
+        }
+        LOGI("Reopened '%s': %llu bytes written, %llu consumed", path,
+             (unsigned long long)header->cursors.write_pos.load(), (unsigned long long)header->cursors.read_pos.load());
+    }
+    size_t cap = (size_t)header->capacity;
+    uint8_t* base = file->data() + kPersistentHeaderSize;
+    std::shared_ptr<ByteBuffer> buffer(new ByteBuffer(std::move(file), &header->cursors, base, cap));
+    buffer->persistent_ = header;
+    buffer->persistent_path_ = path;
+    return buffer;
+}
+
+bool ByteBuffer::flush() {
+    if (!persistent_) {
+        return false;
+    }
+    uint64_t read_pos = cursors_->read_pos.load(std::memory_order_acquire);
+    uint64_t write_pos = cursors_->write_pos.load(std::memory_order_acquire);
+    // Data first: a commit may only describe bytes that are already durable
+    if (!shm->sync(kPersistentHeaderSize, (size_t)write_pos)) {
+        return false;
+    }
+    const PersistentCommit& a = persistent_->commits[0];
+    const PersistentCommit& b = persistent_->commits[1];
+    uint64_t sequence = (a.sequence > b.sequence ? a.sequence : b.sequence) + 1;
+    PersistentCommit& slot = persistent_->commits[sequence & 1];
+    slot.sequence = sequence;
+    slot.write_pos = write_pos;
+    slot.read_pos = read_pos;
+    slot.checksum = commitChecksum(slot);
+    return shm->sync(0, kPersistentHeaderSize);
+}
+
+void ByteBuffer::publishWrite(uint64_t write_pos, size_t bytes) {
+    cursors_->write_pos.store(write_pos, std::memory_order_release);
+    stats.recordWrite(bytes, write_pos - cursors_->read_pos.load(std::memory_order_relaxed));
+    int fd = notify_fd_.load(std::memory_order_relaxed);
+    // Pairs with the waiters increment in waitForData(): either the reader
+    // sees the new write_pos or we see the reader
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (cursors_->waiters.load(std::memory_order_relaxed) == 0 && fd < 0) {
+        return;
+    }
+    uint32_t wakeBytes = cursors_->wake_bytes.load(std::memory_order_relaxed);
+    if (wakeBytes != 0 && write_pos - cursors_->read_pos.load(std::memory_order_acquire) < wakeBytes) {
+        uint64_t delayNs = (uint64_t)cursors_->wake_delay_us.load(std::memory_order_relaxed) * 1000;
+        uint64_t now = nowNs();
+        if (batch_start_ns_ == 0) {
+            batch_start_ns_ = now;
+            // Reports the batch even if the writer goes idle; futex waiters
+            // look again every delay on their own
+            if (fd >= 0) {
+                signalNotificationFd(fd, delayNs);
+            }
+        }
+        if (now - batch_start_ns_ < delayNs) {
+            return;
+        }
+    }
+    batch_start_ns_ = 0;
+    cursors_->wake_seq.fetch_add(1, std::memory_order_release);
+    futexWakeAll(&cursors_->wake_seq, shm != nullptr);
+    if (fd >= 0) {
+        signalNotificationFd(fd, 0);
+    }
+}
+
+bool ByteBuffer::waitForData(size_t minUnread, int64_t timeoutUs) {
+    if (ring) {
+        return false;
+    }
+    auto unread = [this] {
+        return cursors_->write_pos.load(std::memory_order_acquire) -
+               cursors_->read_pos.load(std::memory_order_acquire);
+    };
+    if (unread() >= minUnread) {
+        return true;
+    }
+    uint64_t deadline = timeoutUs >= 0 ? nowNs() + (uint64_t)timeoutUs * 1000 : UINT64_MAX;
+    cursors_->waiters.fetch_add(1, std::memory_order_seq_cst);
+    bool ready = false;
+    for (;;) {
+        uint32_t seq = cursors_->wake_seq.load(std::memory_order_acquire);
+        uint64_t available = unread();
+        if (available >= minUnread) {
+            ready = true;
+            break;
+        }
+        uint64_t now = nowNs();
+        if (now >= deadline) {
+            break;
+        }
+        int64_t sliceUs = deadline == UINT64_MAX ? -1 : (int64_t)((deadline - now) / 1000);
+        // A batching writer may sit on a small trickle; look again after the delay
+        uint32_t delayUs = cursors_->wake_delay_us.load(std::memory_order_relaxed);
+        if (delayUs != 0 && (sliceUs < 0 || sliceUs > (int64_t)delayUs)) {
+            sliceUs = delayUs;
+        }
+        futexWait(&cursors_->wake_seq, seq, sliceUs, shm != nullptr);
+    }
+    cursors_->waiters.fetch_sub(1, std::memory_order_relaxed);
+    return ready;
+}
+
+bool ByteBuffer::setWakeThreshold(uint32_t bytes, uint32_t delayUs) {
+    if (bytes != 0 && delayUs == 0) {
+        return false;
+    }
+    cursors_->wake_bytes.store(bytes, std::memory_order_relaxed);
+    cursors_->wake_delay_us.store(delayUs, std::memory_order_relaxed);
+    return true;
+}
+
+int ByteBuffer::notificationFd() {
+    int fd = notify_fd_.load(std::memory_order_acquire);
+    if (fd >= 0) {
+        return fd;
+    }
+    int created = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (created < 0) {
+        LOGE("timerfd_create failed: %s", strerror(errno));
+        return -1;
+    }
+    if (!notify_fd_.compare_exchange_strong(fd, created, std::memory_order_acq_rel)) {
+        close(created);
+        return fd;
+    }
+    // A batch started before the descriptor existed has no timer
+    if (size() != readPosition()) {
+        signalNotificationFd(created, 0);
+    }
+    return created;
+}
+
+bool ByteBuffer::commit(size_t count) {
+    size_t write_pos = size();
+    if (segments) {
+        if (!segments->commit(count)) {
+            return false;
+        }
+        publishWrite(write_pos + count, count);
+        return true;
+    }
+    if (ring || count > capacity - write_pos) {
+        return false;
+    }
+    publishWrite(write_pos + count, count);
+    return true;
+}
+
+bool ByteBuffer::consume(size_t count) {
+    size_t read_pos = readPosition();
+    if (ring || count > size() - read_pos) {
+        return false;
+    }
+    if (segments && !segments->consume(count)) {
+        return false;
+    }
+    cursors_->read_pos.store(read_pos + count, std::memory_order_release);
+    stats.recordConsume(count);
+    return true;
+}
+
+bool ByteBuffer::write(const uint8_t* src, size_t len) {
+    ScopedLatency timer(stats, true);
+    if (ring) {
+        if (len > ring->maxMessageSize() || !ring->tryWrite(src, (uint32_t)len)) {
+            stats.recordOverflow();
+            return false;
+        }
+        stats.recordWrite(len, ring->usedBytes());
+        return true;
+    }
+    size_t write_pos = size();
+    if (segments) {
+        if (!segments->write(src, len)) {
+            stats.recordOverflow();
+            LOGE("Segmented buffer write of %zu bytes failed (limit %zu, unread %zu)", len, capacity,
+                 write_pos - readPosition());
+            return false;
+        }
+        publishWrite(write_pos + len, len);
+        return true;
+    }
+    if (len > capacity - write_pos) {
+        stats.recordOverflow();
+        LOGE("Buffer overflow: trying to write %zu bytes, available: %zu", len, capacity - write_pos);
+        return false;
+    }
+    memcpy(data + write_pos, src, len);
+    publishWrite(write_pos + len, len);
+    return true;
+}
+
+bool ByteBuffer::read(uint8_t* dest, size_t len, size_t offset) const {
+    ScopedLatency timer(stats, false);
+    if (ring) {
+        LOGE("Ring buffers are read message by message, not by offset");
+        return false;
+    }
+    if (segments) {
+        size_t base = readPosition();
+        if (offset < base || !segments->copyOut(dest, len, offset - base)) {
+            stats.recordUnderflow();
+            LOGE("Buffer underflow: trying to read %zu bytes at offset %zu, unread: %zu..%zu", len, offset, base,
+                 size());
+            return false;
+        }
+        stats.recordRead(len);
+        return true;
+    }
+    size_t available = size();
+    if (offset > available || len > available - offset) {
+        stats.recordUnderflow();
+        LOGE("Buffer underflow: trying to read %zu bytes at offset %zu, available: %zu", len, offset, available);
+        return false;
+    }
+    memcpy(dest, data + offset, len);
+    stats.recordRead(len);
+    return true;
+}
+
+bool ByteBuffer::writev(const struct iovec* iov, int count) {
+    if (ring) {
+        return false;
+    }
+    ScopedLatency timer(stats, true);
+    size_t write_pos = size();
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += iov[i].iov_len;
+    }
+    if (segments) {
+        if (!segments->writev(iov, count)) {
+            stats.recordOverflow();
+            return false;
+        }
+    } else {
+        if (total > capacity - write_pos) {
+            stats.recordOverflow();
+            LOGE("Buffer overflow: trying to write %zu bytes, available: %zu", total, capacity - write_pos);
+            return false;
+        }
+        uint8_t* dest = data + write_pos;
+        for (int i = 0; i < count; i++) {
+            memcpy(dest, iov[i].iov_base, iov[i].iov_len);
+            dest += iov[i].iov_len;
+        }
+    }
+    publishWrite(write_pos + total, total);
+    return true;
+}
+
+size_t ByteBuffer::readv(const struct iovec* iov, int count) {
+    if (ring) {
+        return 0;
+    }
+    ScopedLatency timer(stats, false);
+    size_t read_pos = readPosition();
+    size_t copied;
+    if (segments) {
+        copied = segments->readv(iov, count);
+    } else {
+        size_t available = size() - read_pos;
+        copied = 0;
+        for (int i = 0; i < count && copied < available; i++) {
+            size_t chunk = std::min(iov[i].iov_len, available - copied);
+            memcpy(iov[i].iov_base, data + read_pos + copied, chunk);
+            copied += chunk;
+        }
+    }
+    cursors_->read_pos.store(read_pos + copied, std::memory_order_release);
+    stats.recordRead(copied);
+    stats.recordConsume(copied);
+    return copied;
+}
+
+const uint8_t* ByteBuffer::linearize(size_t* length) {
+    *length = 0;
+    if (ring) {
+        return nullptr;
+    }
+    if (segments) {
+        return segments->linearize(length);
+    }
+    size_t read_pos = readPosition();
+    *length = size() - read_pos;
+    return *length ? data + read_pos : nullptr;
+}
+
+void ByteBuffer::clear(bool zero) {
+    if (ring) {
+        ring->reset();
+        return;
+    }
+    if (segments) {
+        segments->clear();
+        cursors_->write_pos.store(0, std::memory_order_relaxed);
+        cursors_->read_pos.store(0, std::memory_order_release);
+        return;
+    }
+    cursors_->write_pos.store(0, std::memory_order_relaxed);
+    cursors_->read_pos.store(0, std::memory_order_release);
+    if (zero) {
+        memset(data, 0, capacity);
+    }
+}
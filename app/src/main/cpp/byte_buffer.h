@@ -0,0 +1,144 @@
+#ifndef BYTE_BUFFER_H
+#define BYTE_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "buffer_pool.h"
+#include "buffer_stats.h"
+#include "ring_buffer.h"
+#include "segmented_buffer.h"
+#include "shared_memory.h"
+
+// Byte offsets into a linear buffer's data. For shared memory buffers they
+// live in the mapped header so every process that maps it sees the same
+// values; one writer and one reader may run concurrently.
+struct BufferCursors {
+    std::atomic<uint64_t> write_pos{0};
+    std::atomic<uint64_t> read_pos{0};
+    // Futex word: bumped by the writer to wake readers blocked in waitForData()
+    std::atomic<uint32_t> wake_seq{0};
+    std::atomic<uint32_t> waiters{0};
+    // Batching: wake once wake_bytes are unread, or wake_delay_us after the
+    // first unreported byte (wake_bytes 0 = wake on every write)
+    std::atomic<uint32_t> wake_bytes{0};
+    std::atomic<uint32_t> wake_delay_us{0};
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "cursors in shared memory need address-free atomics");
+
+struct PersistentBufferHeader;
+
+// Memory structure for byte transfer (JNI-free so host tools can use it)
+struct ByteBuffer {
+    uint8_t* data;
+    size_t capacity;
+    bool is_owner;
+    // Set for ring buffer mode: write() appends a framed message and data is unused
+    std::unique_ptr<ByteRing> ring;
+    // Set for shared memory buffers: data and cursors point into the mapping
+    std::unique_ptr<SharedMemory> shm;
+    // Set for segmented mode: writes append pooled segments and never run out
+    // of room below the segment limit; data is unused and capacity is that
+    // limit (0 = unlimited). Cursors are stream positions.
+    std::unique_ptr<SegmentedBuffer> segments;
+    // Traffic counters and sampled latencies; updated by the I/O methods
+    // below and by JNI paths that copy around them
+    mutable BufferStats stats;
+
+    // Linear buffer in BufferPool memory; contents are unspecified unless zeroed
+    explicit ByteBuffer(size_t cap, bool zeroed = false);
+    ByteBuffer(uint8_t* external_data, size_t data_size);
+    explicit ByteBuffer(std::unique_ptr<ByteRing> ring_buffer);
+    explicit ByteBuffer(std::unique_ptr<SegmentedBuffer> segmented);
+    // Persistent buffers flush on destruction
+    ~ByteBuffer();
+
+    ByteBuffer(const ByteBuffer&) = delete;
+    ByteBuffer& operator=(const ByteBuffer&) = delete;
+
+    // Linear buffer in memfd/ashmem memory that another process can map
+    // through the descriptor from exportFd()
+    static std::shared_ptr<ByteBuffer> createShared(const char* name, size_t capacity);
+    // Map a buffer created by createShared() in this or another process;
+    // fd stays owned by the caller
+    static std::shared_ptr<ByteBuffer> importShared(int fd);
+    // Duplicate of the shared memory descriptor (caller closes it), or -1
+    int exportFd() const;
+
+    // Linear buffer in a memory-mapped file. Reopening the same path after a
+    // restart maps the existing bytes and restores the cursors of the last
+    // flush(); anything written after it is discarded. A larger capacity
+    // grows the file, a smaller one keeps the existing capacity.
+    static std::shared_ptr<ByteBuffer> openPersistent(const char* path, size_t capacity);
+    bool isPersistent() const { return persistent_ != nullptr; }
+    const std::string& persistentPath() const { return persistent_path_; }
+    // Make the written bytes and the cursors durable (msync). Call it from
+    // the writing thread. False for buffers that are not persistent or if
+    // the sync fails.
+    bool flush();
+
+    // Block until at least minUnread bytes are unread or timeoutUs passes
+    // (negative waits forever); true if the bytes are there. Uses a futex on
+    // the cursors, so it also wakes for writers in another process. While
+    // waiting, the wake_delay_us batching delay bounds how stale a smaller
+    // trickle can get. Linear and segmented buffers only.
+    bool waitForData(size_t minUnread, int64_t timeoutUs);
+    // Batch wake-ups: wake readers after bytes unread bytes or delayUs
+    // after the first unreported write, whichever comes first. A threshold
+    // needs a delay, otherwise a writer that stops short of it would never
+    // wake anyone: false if bytes is set and delayUs is 0.
+    bool setWakeThreshold(uint32_t bytes, uint32_t delayUs);
+    // Descriptor that becomes readable under the same batching rules, for
+    // epoll/ALooper loops; read 8 bytes to reset it. It is a timerfd so the
+    // delay fires even when the writer goes idle. Owned by the buffer,
+    // created on first use, -1 on failure.
+    int notificationFd();
+
+    // Write cursor: bytes written so far
+    size_t size() const { return (size_t)cursors_->write_pos.load(std::memory_order_acquire); }
+    // Read cursor for sequential consumers (Kotlin direct views, other processes)
+    size_t readPosition() const { return (size_t)cursors_->read_pos.load(std::memory_order_acquire); }
+
+    // Advance the write cursor over bytes produced in place
+    bool commit(size_t count);
+    // Advance the read cursor over bytes consumed in place; never passes the write cursor
+    bool consume(size_t count);
+
+    bool write(const uint8_t* src, size_t len);
+    // Offsets are from the start of the stream; a segmented buffer can no
+    // longer read what was consumed
+    bool read(uint8_t* dest, size_t len, size_t offset = 0) const;
+
+    // Gather write of all iovecs, all or nothing
+    bool writev(const struct iovec* iov, int count);
+    // Scatter the unread bytes into the iovecs and consume them; returns the byte count
+    size_t readv(const struct iovec* iov, int count);
+    // Unread bytes as one contiguous block (segmented buffers are merged);
+    // valid until the next consume or clear. nullptr when empty or a ring.
+    const uint8_t* linearize(size_t* length);
+
+    // Reset the cursors; the bytes are only wiped when zero is set
+    void clear(bool zero = false);
+
+private:
+    ByteBuffer(std::unique_ptr<SharedMemory> memory, BufferCursors* cursors, uint8_t* base, size_t cap);
+
+    // Publish write_pos after bytes were written, count them and wake
+    // readers if the batching rules allow
+    void publishWrite(uint64_t write_pos, size_t bytes);
+
+    BufferCursors local_cursors_;
+    BufferCursors* cursors_;
+    PersistentBufferHeader* persistent_ = nullptr;
+    std::string persistent_path_;
+    std::atomic<int> notify_fd_{-1};
+    // Writer-side start of the current unreported batch (steady clock ns, 0 = none)
+    uint64_t batch_start_ns_ = 0;
+};
+
+#endif // BYTE_BUFFER_H
@@ -2,67 +2,68 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <iterator>
 #include <cstring>
-#include <map>
+#include <stdexcept>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/uio.h>
 #include <android/log.h>
 
+#include "buffer_registry.h"
+#include "byte_buffer.h"
+#include "jni_env.h"
+
 #define LOG_TAG "ByteTransfer"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-// Shared memory structure for byte transfer
-struct ByteBuffer {
-    uint8_t* data;
-    size_t size;
-    size_t capacity;
-    bool is_owner;
-    
-    ByteBuffer(size_t cap) : size(0), capacity(cap), is_owner(true) {
-        data = new uint8_t[capacity];
-        memset(data, 0, capacity);
-    }
-    
-    ByteBuffer(uint8_t* external_data, size_t data_size) 
-        : data(external_data), size(data_size), capacity(data_size), is_owner(false) {
-    }
-    
-    ~ByteBuffer() {
-        if (is_owner && data) {
-            delete[] data;
-        }
-    }
-    
-    bool write(const uint8_t* src, size_t len) {
-        if (size + len > capacity) {
-            LOGE("Buffer overflow: trying to write %zu bytes, available: %zu", len, capacity - size);
-            return false;
-        }
-        memcpy(data + size, src, len);
-        size += len;
-        return true;
-    }
-    
-    bool read(uint8_t* dest, size_t len, size_t offset = 0) const {
-        if (offset + len > size) {
-            LOGE("Buffer underflow: trying to read %zu bytes at offset %zu, available: %zu", len, offset, size);
-            return false;
-        }
-        memcpy(dest, data + offset, len);
-        return true;
-    }
-    
-    void clear() {
-        size = 0;
-        memset(data, 0, capacity);
-    }
+// Named buffers live in the process-wide BufferRegistry. The global buffer
+// for inter-library communication is the entry with the empty name (Kotlin
+// passes null for it). Buffers are reference counted so external holders
+// (JS ArrayBuffers) can pin the memory past nativeCleanup() or recreation
+// of the same name.
+static constexpr std::string_view kSharedBufferName = "";
+
+static BufferRegistry& registry() {
+    return BufferRegistry::instance();
+}
+
+// Modified UTF-8 view of a Java string, released on scope exit
+class JniString {
+public:
+    JniString(JNIEnv *env, jstring str) : env_(env), str_(str), chars_(env->GetStringUTFChars(str, nullptr)) {}
+    ~JniString() { env_->ReleaseStringUTFChars(str_, chars_); }
+    JniString(const JniString&) = delete;
+    JniString& operator=(const JniString&) = delete;
+
+    const char* c_str() const { return chars_; }
+    std::string_view view() const { return chars_; }
+
+private:
+    JNIEnv *env_;
+    jstring str_;
+    const char* chars_;
 };
 
-// Global buffer for inter-library communication
-static std::unique_ptr<ByteBuffer> g_sharedBuffer = nullptr;
-static std::vector<std::unique_ptr<ByteBuffer>> g_bufferPool;
+// (Re)create a linear buffer. An existing one is always replaced, never
+// reset in place: readers under a ReadGuard hold raw pointers that
+// use_count() does not see. Its block returns to the BufferPool, which
+// hands it to the next buffer of the size class, once the epoch
+// reclamation frees the old entry.
+static void createLinearBuffer(std::string_view name, size_t capacity, bool zeroed) {
+    if (registry().put(name, std::make_shared<ByteBuffer>(capacity, zeroed)) == BufferRegistry::kInvalidHandle) {
+        throw std::runtime_error("buffer registry is full");
+    }
+}
 
-// Buffer registry for named buffers
-static std::map<std::string, std::unique_ptr<ByteBuffer>> g_namedBuffers;
+// One stats line for a buffer (see BufferStats::Snapshot::format)
+static std::string formatStats(std::string_view name, const ByteBuffer* buffer) {
+    BufferStats::Snapshot snapshot;
+    buffer->stats.snapshot(&snapshot);
+    return snapshot.format(name);
+}
 
 extern "C" {
 
@@ -72,7 +73,7 @@ Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeIniti
     LOGI("Initializing byte transfer system with buffer size: %d", bufferSize);
     
     try {
-        g_sharedBuffer = std::make_unique<ByteBuffer>(bufferSize);
+        createLinearBuffer(kSharedBufferName, (size_t)bufferSize, false);
         LOGI("Byte transfer system initialized successfully");
         return JNI_TRUE;
     } catch (const std::exception& e) {
@@ -83,69 +84,138 @@ Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeIniti
 
 // Create a named buffer
 JNIEXPORT jboolean JNICALL
-Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeCreateNamedBuffer(JNIEnv *env, jobject thiz, jstring name, jint size) {
-    const char* bufferName = env->GetStringUTFChars(name, nullptr);
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeCreateNamedBuffer(JNIEnv *env, jobject thiz, jstring name, jint size, jboolean zeroed) {
+    JniString bufferName(env, name);
     
     try {
-        std::string key(bufferName);
-        g_namedBuffers[key] = std::make_unique<ByteBuffer>(size);
-        LOGI("Created named buffer '%s' with size %d", bufferName, size);
-        env->ReleaseStringUTFChars(name, bufferName);
+        createLinearBuffer(bufferName.view(), (size_t)size, zeroed == JNI_TRUE);
+        LOGI("Created named buffer '%s' with size %d", bufferName.c_str(), size);
         return JNI_TRUE;
     } catch (const std::exception& e) {
-        LOGE("Failed to create named buffer '%s': %s", bufferName, e.what());
-        env->ReleaseStringUTFChars(name, bufferName);
+        LOGE("Failed to create named buffer '%s': %s", bufferName.c_str(), e.what());
         return JNI_FALSE;
     }
 }
 
+// Copy a Java array straight into the buffer (one copy, no pinned temporary)
+static bool writeJavaBytes(JNIEnv *env, ByteBuffer* buffer, jbyteArray data) {
+    jsize len = env->GetArrayLength(data);
+    ScopedLatency timer(buffer->stats, true);
+    if (buffer->ring) {
+        ByteRing::Reservation reservation;
+        if ((size_t)len <= buffer->ring->maxMessageSize()) {
+            reservation = buffer->ring->reserve((uint32_t)len);
+        }
+        if (!reservation) {
+            buffer->stats.recordOverflow();
+            return false;
+        }
+        env->GetByteArrayRegion(data, 0, len, reinterpret_cast<jbyte*>(reservation.data));
+        buffer->ring->commit(reservation);
+        buffer->stats.recordWrite((size_t)len, buffer->ring->usedBytes());
+        return true;
+    }
+    if (buffer->segments) {
+        // Reserve first so the copy below cannot stop half way
+        if (!buffer->segments->reserve((size_t)len)) {
+            LOGE("Segmented buffer cannot take %d more bytes", len);
+            buffer->stats.recordOverflow();
+            return false;
+        }
+        for (jsize done = 0; done < len;) {
+            size_t span = 0;
+            uint8_t* dest = buffer->segments->writableSpan(&span);
+            jsize chunk = (jsize)std::min<size_t>(span, (size_t)(len - done));
+            env->GetByteArrayRegion(data, done, chunk, reinterpret_cast<jbyte*>(dest));
+            buffer->commit((size_t)chunk);
+            done += chunk;
+        }
+        return true;
+    }
+    size_t write_pos = buffer->size();
+    if ((size_t)len > buffer->capacity - write_pos) {
+        LOGE("Buffer overflow: trying to write %d bytes, available: %zu", len, buffer->capacity - write_pos);
+        buffer->stats.recordOverflow();
+        return false;
+    }
+    env->GetByteArrayRegion(data, 0, len, reinterpret_cast<jbyte*>(buffer->data + write_pos));
+    return buffer->commit(len);
+}
+
+// Copy a range of the buffer straight into a new Java array
+static jbyteArray readJavaBytes(JNIEnv *env, const ByteBuffer* buffer, jint length, jint offset) {
+    if (buffer->ring) {
+        LOGE("Ring buffers are read message by message, not by offset");
+        return nullptr;
+    }
+    ScopedLatency timer(buffer->stats, false);
+    if (buffer->segments) {
+        size_t base = buffer->readPosition();
+        jbyteArray result = (size_t)offset >= base ? env->NewByteArray(length) : nullptr;
+        jsize done = 0;
+        bool ok = result && buffer->segments->visit((size_t)offset - base, (size_t)length,
+            [&](const uint8_t* chunk, size_t chunkLength) {
+                env->SetByteArrayRegion(result, done, (jsize)chunkLength, reinterpret_cast<const jbyte*>(chunk));
+                done += (jsize)chunkLength;
+            });
+        if (!ok) {
+            LOGE("Buffer underflow: trying to read %d bytes at offset %d, unread: %zu..%zu", length, offset, base,
+                 buffer->size());
+            buffer->stats.recordUnderflow();
+            return nullptr;
+        }
+        buffer->stats.recordRead((size_t)length);
+        return result;
+    }
+    size_t available = buffer->size();
+    if ((size_t)offset + (size_t)length > available) {
+        LOGE("Buffer underflow: trying to read %d bytes at offset %d, available: %zu", length, offset, available);
+        buffer->stats.recordUnderflow();
+        return nullptr;
+    }
+    jbyteArray result = env->NewByteArray(length);
+    if (!result) {
+        LOGE("Failed to allocate byte array of size %d", length);
+        return nullptr;
+    }
+    env->SetByteArrayRegion(result, 0, length, reinterpret_cast<const jbyte*>(buffer->data + offset));
+    buffer->stats.recordRead((size_t)length);
+    return result;
+}
+
 // Write bytes to shared buffer
 JNIEXPORT jboolean JNICALL
 Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeWriteBytes(JNIEnv *env, jobject thiz, jbyteArray data) {
-    if (!g_sharedBuffer) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = registry().find(kSharedBufferName);
+    if (!buffer) {
         LOGE("Byte transfer system not initialized");
         return JNI_FALSE;
     }
     
-    jsize len = env->GetArrayLength(data);
-    jbyte* bytes = env->GetByteArrayElements(data, nullptr);
-    
-    bool success = g_sharedBuffer->write(reinterpret_cast<uint8_t*>(bytes), len);
-    
-    env->ReleaseByteArrayElements(data, bytes, JNI_ABORT);
-    
-    LOGI("Wrote %d bytes to shared buffer, success: %s", len, success ? "true" : "false");
-    return success ? JNI_TRUE : JNI_FALSE;
+    return writeJavaBytes(env, buffer, data) ? JNI_TRUE : JNI_FALSE;
 }
 
 // Write bytes to named buffer
 JNIEXPORT jboolean JNICALL
 Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeWriteBytesToNamed(JNIEnv *env, jobject thiz, jstring name, jbyteArray data) {
-    const char* bufferName = env->GetStringUTFChars(name, nullptr);
-    std::string key(bufferName);
-    env->ReleaseStringUTFChars(name, bufferName);
-    
-    auto it = g_namedBuffers.find(key);
-    if (it == g_namedBuffers.end()) {
-        LOGE("Named buffer '%s' not found", key.c_str());
+    JniString bufferName(env, name);
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = registry().find(bufferName.view());
+    if (!buffer) {
+        LOGE("Named buffer '%s' not found", bufferName.c_str());
         return JNI_FALSE;
     }
     
-    jsize len = env->GetArrayLength(data);
-    jbyte* bytes = env->GetByteArrayElements(data, nullptr);
-    
-    bool success = it->second->write(reinterpret_cast<uint8_t*>(bytes), len);
-    
-    env->ReleaseByteArrayElements(data, bytes, JNI_ABORT);
-    
-    LOGI("Wrote %d bytes to named buffer '%s', success: %s", len, key.c_str(), success ? "true" : "false");
-    return success ? JNI_TRUE : JNI_FALSE;
+    return writeJavaBytes(env, buffer, data) ? JNI_TRUE : JNI_FALSE;
 }
 
 // Read bytes from shared buffer
 JNIEXPORT jbyteArray JNICALL
 Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeReadBytes(JNIEnv *env, jobject thiz, jint length, jint offset) {
-    if (!g_sharedBuffer) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = registry().find(kSharedBufferName);
+    if (!buffer) {
         LOGE("Byte transfer system not initialized");
         return nullptr;
     }
@@ -155,34 +225,22 @@ Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeReadB
         return nullptr;
     }
     
-    jbyteArray result = env->NewByteArray(length);
+    jbyteArray result = readJavaBytes(env, buffer, length, offset);
     if (!result) {
-        LOGE("Failed to allocate byte array of size %d", length);
-        return nullptr;
-    }
-    
-    std::vector<uint8_t> buffer(length);
-    if (!g_sharedBuffer->read(buffer.data(), length, offset)) {
         LOGE("Failed to read %d bytes from offset %d", length, offset);
         return nullptr;
     }
-    
-    env->SetByteArrayRegion(result, 0, length, reinterpret_cast<jbyte*>(buffer.data()));
-    
-    LOGI("Read %d bytes from shared buffer at offset %d", length, offset);
     return result;
 }
 
 // Read bytes from named buffer
 JNIEXPORT jbyteArray JNICALL
 Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeReadBytesFromNamed(JNIEnv *env, jobject thiz, jstring name, jint length, jint offset) {
-    const char* bufferName = env->GetStringUTFChars(name, nullptr);
-    std::string key(bufferName);
-    env->ReleaseStringUTFChars(name, bufferName);
-    
-    auto it = g_namedBuffers.find(key);
-    if (it == g_namedBuffers.end()) {
-        LOGE("Named buffer '%s' not found", key.c_str());
+    JniString bufferName(env, name);
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = registry().find(bufferName.view());
+    if (!buffer) {
+        LOGE("Named buffer '%s' not found", bufferName.c_str());
         return nullptr;
     }
     
@@ -191,43 +249,606 @@ Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeReadB
         return nullptr;
     }
     
-    jbyteArray result = env->NewByteArray(length);
+    jbyteArray result = readJavaBytes(env, buffer, length, offset);
     if (!result) {
-        LOGE("Failed to allocate byte array of size %d", length);
+        LOGE("Failed to read %d bytes from named buffer '%s' at offset %d", length, bufferName.c_str(), offset);
+        return nullptr;
+    }
+    return result;
+}
+
+// Resolve a buffer by name; null name means the shared buffer.
+// The caller must hold a BufferRegistry::ReadGuard.
+static ByteBuffer* findBuffer(JNIEnv *env, jstring name) {
+    if (name == nullptr) {
+        ByteBuffer* buffer = registry().find(kSharedBufferName);
+        if (!buffer) {
+            LOGE("Byte transfer system not initialized");
+        }
+        return buffer;
+    }
+    JniString bufferName(env, name);
+    ByteBuffer* buffer = registry().find(bufferName.view());
+    if (!buffer) {
+        LOGE("Named buffer '%s' not found", bufferName.c_str());
+    }
+    return buffer;
+}
+
+// Resolve a name once; later calls index the registry by handle (0 if missing)
+JNIEXPORT jint JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeOpenBuffer(JNIEnv *env, jobject thiz, jstring name) {
+    if (name == nullptr) {
+        return (jint)registry().open(kSharedBufferName);
+    }
+    JniString bufferName(env, name);
+    return (jint)registry().open(bufferName.view());
+}
+
+// Write bytes to a buffer opened with nativeOpenBuffer (no name lookup)
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeWriteBytesToHandle(JNIEnv *env, jobject thiz, jint handle, jbyteArray data) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = registry().get((BufferRegistry::Handle)handle);
+    return buffer && writeJavaBytes(env, buffer, data) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Read bytes from a buffer opened with nativeOpenBuffer (no name lookup)
+JNIEXPORT jbyteArray JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeReadBytesFromHandle(JNIEnv *env, jobject thiz, jint handle, jint length, jint offset) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = registry().get((BufferRegistry::Handle)handle);
+    if (!buffer || length <= 0 || offset < 0) {
+        return nullptr;
+    }
+    return readJavaBytes(env, buffer, length, offset);
+}
+
+// Handle-based cursor calls are @CriticalNative in Kotlin: primitives only,
+// no JNIEnv, no thread state transition. Each has a JNI-shaped adapter for
+// releases that ignore the annotation (see registerByteTransferBridgeNatives).
+
+// Cursors packed as (read_pos << 32) | size, or -1 for a missing handle or a ring
+static jlong JNICALL criticalGetHandleCursors(jint handle) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = registry().get((BufferRegistry::Handle)handle);
+    if (!buffer || buffer->ring) {
+        return -1;
+    }
+    return ((jlong)buffer->readPosition() << 32) | (jlong)buffer->size();
+}
+
+// Commit bytes written through the direct view of a handle's buffer
+static jboolean JNICALL criticalCommitHandle(jint handle, jint count) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = registry().get((BufferRegistry::Handle)handle);
+    return buffer && count >= 0 && buffer->commit((size_t)count) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Mark bytes of a handle's buffer consumed
+static jboolean JNICALL criticalConsumeHandle(jint handle, jint count) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = registry().get((BufferRegistry::Handle)handle);
+    return buffer && count >= 0 && buffer->consume((size_t)count) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Time one buffer operation in every (rounded up to a power of two)
+static void JNICALL criticalSetStatsSampling(jint every) {
+    BufferStats::setSamplingInterval(every > 0 ? (uint32_t)every : 1);
+}
+
+static jlong JNICALL getHandleCursors(JNIEnv *, jclass, jint handle) {
+    return criticalGetHandleCursors(handle);
+}
+
+static jboolean JNICALL commitHandle(JNIEnv *, jclass, jint handle, jint count) {
+    return criticalCommitHandle(handle, count);
+}
+
+static jboolean JNICALL consumeHandle(JNIEnv *, jclass, jint handle, jint count) {
+    return criticalConsumeHandle(handle, count);
+}
+
+static void JNICALL setStatsSampling(JNIEnv *, jclass, jint every) {
+    criticalSetStatsSampling(every);
+}
+
+// Owning reference behind a direct view handed to Kotlin. The memory stays
+// valid until nativeUnpinBuffer(), even if the name is recreated, cleanup()
+// runs or the pool is trimmed meanwhile. Segmented buffers free consumed
+// segments, so a view of one owns a copy of its bytes instead.
+struct DirectViewPin {
+    std::shared_ptr<ByteBuffer> buffer;
+    uint8_t* data;
+    size_t length;
+    std::vector<uint8_t> copy;
+};
+
+static std::shared_ptr<ByteBuffer> acquireBuffer(JNIEnv *env, jstring name) {
+    if (name == nullptr) {
+        return registry().acquire(kSharedBufferName);
+    }
+    JniString bufferName(env, name);
+    return registry().acquire(bufferName.view());
+}
+
+// Pin a linear buffer's whole memory; 0 if the buffer is missing or not linear
+JNIEXPORT jlong JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativePinBuffer(JNIEnv *env, jobject thiz, jstring name) {
+    std::shared_ptr<ByteBuffer> buffer = acquireBuffer(env, name);
+    if (!buffer || buffer->ring || !buffer->data) {
+        return 0;
+    }
+    uint8_t* data = buffer->data;
+    size_t length = buffer->capacity;
+    return reinterpret_cast<jlong>(new DirectViewPin{std::move(buffer), data, length});
+}
+
+// java.nio.ByteBuffer over a pin's memory (no copy)
+JNIEXPORT jobject JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeGetDirectBuffer(JNIEnv *env, jobject thiz, jlong pin) {
+    auto* view = reinterpret_cast<DirectViewPin*>(pin);
+    return view ? env->NewDirectByteBuffer(view->data, (jlong)view->length) : nullptr;
+}
+
+JNIEXPORT void JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeUnpinBuffer(JNIEnv *env, jobject thiz, jlong pin) {
+    delete reinterpret_cast<DirectViewPin*>(pin);
+}
+
+// Cursors packed as (read_pos << 32) | size so Kotlin gets both in one call
+JNIEXPORT jlong JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeGetCursors(JNIEnv *env, jobject thiz, jstring name) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findBuffer(env, name);
+    if (!buffer || buffer->ring) {
+        return -1;
+    }
+    return ((jlong)buffer->readPosition() << 32) | (jlong)buffer->size();
+}
+
+// Commit bytes Kotlin wrote through the direct view at the write cursor
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeAdvanceWriteCursor(JNIEnv *env, jobject thiz, jstring name, jint count) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findBuffer(env, name);
+    if (!buffer || count < 0) {
+        return JNI_FALSE;
+    }
+    return buffer->commit((size_t)count) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Mark bytes consumed through the direct view; never passes the write cursor
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeAdvanceReadCursor(JNIEnv *env, jobject thiz, jstring name, jint count) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findBuffer(env, name);
+    if (!buffer || count < 0) {
+        return JNI_FALSE;
+    }
+    return buffer->consume((size_t)count) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Create a named buffer in segmented mode: it grows by pooled segments of
+// segmentSize bytes up to maxBytes unread bytes (0 = unlimited)
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeCreateSegmentedBuffer(JNIEnv *env, jobject thiz, jstring name, jint segmentSize, jlong maxBytes) {
+    JniString bufferName(env, name);
+    
+    if (segmentSize <= 0 || maxBytes < 0) {
+        return JNI_FALSE;
+    }
+    auto buffer = std::make_shared<ByteBuffer>(std::make_unique<SegmentedBuffer>((size_t)segmentSize, (size_t)maxBytes));
+    LOGI("Created segmented buffer '%s' with %zu byte segments", bufferName.c_str(), buffer->segments->segmentSize());
+    return registry().put(bufferName.view(), std::move(buffer)) != BufferRegistry::kInvalidHandle ? JNI_TRUE : JNI_FALSE;
+}
+
+// Pin the unread bytes as one block for nativeGetDirectBuffer(); 0 if the
+// buffer is missing or empty. Linear buffers are viewed in place, segmented
+// ones are merged and copied into the pin.
+JNIEXPORT jlong JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativePinLinearView(JNIEnv *env, jobject thiz, jstring name) {
+    std::shared_ptr<ByteBuffer> buffer = acquireBuffer(env, name);
+    size_t length = 0;
+    const uint8_t* bytes = buffer ? buffer->linearize(&length) : nullptr;
+    if (!bytes) {
+        return 0;
+    }
+    auto pin = std::make_unique<DirectViewPin>();
+    if (buffer->segments) {
+        pin->copy.assign(bytes, bytes + length);
+        pin->data = pin->copy.data();
+    } else {
+        pin->data = const_cast<uint8_t*>(bytes);
+    }
+    pin->length = length;
+    pin->buffer = std::move(buffer);
+    return reinterpret_cast<jlong>(pin.release());
+}
+
+// Look up a ring-mode named buffer; the caller must hold a ReadGuard
+static ByteBuffer* findRing(JNIEnv *env, jstring name) {
+    JniString bufferName(env, name);
+    ByteBuffer* buffer = registry().find(bufferName.view());
+    if (!buffer || !buffer->ring) {
+        LOGE("Ring buffer '%s' not found", bufferName.c_str());
+        return nullptr;
+    }
+    return buffer;
+}
+
+// Create a named buffer in ring mode (capacity rounded up to a power of two)
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeCreateRingBuffer(JNIEnv *env, jobject thiz, jstring name, jint capacity, jboolean multiProducer) {
+    JniString bufferName(env, name);
+    
+    std::unique_ptr<ByteRing> ring = ByteRing::create((size_t)capacity,
+        multiProducer ? ByteRing::Mode::MultiProducer : ByteRing::Mode::SingleProducer);
+    if (!ring) {
+        LOGE("Failed to allocate ring buffer '%s' with capacity %d", bufferName.c_str(), capacity);
+        return JNI_FALSE;
+    }
+    LOGI("Created %s ring buffer '%s' with capacity %zu", multiProducer ? "MPSC" : "SPSC", bufferName.c_str(), ring->capacity());
+    BufferRegistry::Handle handle = registry().put(bufferName.view(), std::make_shared<ByteBuffer>(std::move(ring)));
+    return handle != BufferRegistry::kInvalidHandle ? JNI_TRUE : JNI_FALSE;
+}
+
+// Append one framed message to a ring buffer
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeRingWrite(JNIEnv *env, jobject thiz, jstring name, jbyteArray data, jint tag) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findRing(env, name);
+    if (!buffer) {
+        return JNI_FALSE;
+    }
+    ByteRing* ring = buffer->ring.get();
+    
+    jsize len = env->GetArrayLength(data);
+    if ((size_t)len > ring->maxMessageSize()) {
+        LOGE("Message of %d bytes exceeds ring limit of %zu", len, ring->maxMessageSize());
+        buffer->stats.recordOverflow();
+        return JNI_FALSE;
+    }
+    ScopedLatency timer(buffer->stats, true);
+    ByteRing::Reservation reservation = ring->reserve((uint32_t)len, (uint32_t)tag);
+    if (!reservation) {
+        buffer->stats.recordOverflow();
+        return JNI_FALSE;
+    }
+    // Copy straight from the Java array into the reserved frame
+    env->GetByteArrayRegion(data, 0, len, reinterpret_cast<jbyte*>(reservation.data));
+    ring->commit(reservation);
+    buffer->stats.recordWrite((size_t)len, ring->usedBytes());
+    return JNI_TRUE;
+}
+
+// Append several messages with a single commit; all or nothing
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeRingWriteBatch(JNIEnv *env, jobject thiz, jstring name, jobjectArray messages, jint tag) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findRing(env, name);
+    if (!buffer) {
+        return JNI_FALSE;
+    }
+    ByteRing* ring = buffer->ring.get();
+    
+    // Null elements fail the whole batch before any space is claimed
+    jsize count = env->GetArrayLength(messages);
+    std::vector<jbyteArray> arrays(count);
+    std::vector<ByteRingMessage> batch(count);
+    bool success = true;
+    for (jsize i = 0; i < count && success; i++) {
+        arrays[i] = (jbyteArray)env->GetObjectArrayElement(messages, i);
+        success = arrays[i] != nullptr;
+        if (success) {
+            batch[i].length = (uint32_t)env->GetArrayLength(arrays[i]);
+            batch[i].tag = (uint32_t)tag;
+        }
+    }
+    
+    if (!success) {
+        LOGE("Ring batch has a null message");
+    } else {
+        {
+            ScopedLatency timer(buffer->stats, true);
+            success = ring->tryWriteBatch(batch.data(), batch.size(), [&](size_t i, uint8_t* payload) {
+                env->GetByteArrayRegion(arrays[i], 0, (jsize)batch[i].length, reinterpret_cast<jbyte*>(payload));
+            });
+        }
+        if (success) {
+            size_t total = 0;
+            for (const ByteRingMessage& message : batch) {
+                total += message.length;
+            }
+            buffer->stats.recordWrite(total, ring->usedBytes());
+        } else {
+            buffer->stats.recordOverflow();
+        }
+    }
+    
+    for (jbyteArray array : arrays) {
+        if (array) {
+            env->DeleteLocalRef(array);
+        }
+    }
+    return success ? JNI_TRUE : JNI_FALSE;
+}
+
+// Take the next message from a ring buffer, or null if it is empty
+JNIEXPORT jbyteArray JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeRingRead(JNIEnv *env, jobject thiz, jstring name) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findRing(env, name);
+    if (!buffer) {
         return nullptr;
     }
     
-    std::vector<uint8_t> buffer(length);
-    if (!it->second->read(buffer.data(), length, offset)) {
-        LOGE("Failed to read %d bytes from named buffer '%s' at offset %d", length, key.c_str(), offset);
+    ScopedLatency timer(buffer->stats, false);
+    jbyteArray result = nullptr;
+    size_t bytes = 0;
+    buffer->ring->consume([env, &result, &bytes](const uint8_t* data, uint32_t length, uint32_t tag) {
+        result = env->NewByteArray((jsize)length);
+        if (result) {
+            env->SetByteArrayRegion(result, 0, (jsize)length, reinterpret_cast<const jbyte*>(data));
+        }
+        bytes = length;
+    }, 1);
+    if (result) {
+        buffer->stats.recordRead(bytes);
+        buffer->stats.recordConsume(bytes);
+    } else {
+        buffer->stats.recordUnderflow();
+    }
+    return result;
+}
+
+// Take up to maxMessages messages, releasing their space once
+JNIEXPORT jobjectArray JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeRingReadBatch(JNIEnv *env, jobject thiz, jstring name, jint maxMessages) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findRing(env, name);
+    if (!buffer || maxMessages <= 0) {
         return nullptr;
     }
     
-    env->SetByteArrayRegion(result, 0, length, reinterpret_cast<jbyte*>(buffer.data()));
+    ScopedLatency timer(buffer->stats, false);
+    std::vector<jbyteArray> received;
+    size_t bytes = 0;
+    buffer->ring->consume([env, &received, &bytes](const uint8_t* data, uint32_t length, uint32_t tag) {
+        jbyteArray message = env->NewByteArray((jsize)length);
+        if (message) {
+            env->SetByteArrayRegion(message, 0, (jsize)length, reinterpret_cast<const jbyte*>(data));
+            received.push_back(message);
+        }
+        bytes += length;
+    }, (size_t)maxMessages);
+    if (received.empty()) {
+        buffer->stats.recordUnderflow();
+    } else {
+        buffer->stats.recordRead(bytes);
+        buffer->stats.recordConsume(bytes);
+    }
     
-    LOGI("Read %d bytes from named buffer '%s' at offset %d", length, key.c_str(), offset);
+    jclass byteArrayClass = env->FindClass("[B");
+    jobjectArray result = env->NewObjectArray((jsize)received.size(), byteArrayClass, nullptr);
+    for (size_t i = 0; i < received.size(); i++) {
+        env->SetObjectArrayElement(result, (jsize)i, received[i]);
+        env->DeleteLocalRef(received[i]);
+    }
+    env->DeleteLocalRef(byteArrayClass);
     return result;
 }
 
+// Create a named buffer in memfd/ashmem memory that other processes can map
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeCreateSharedBuffer(JNIEnv *env, jobject thiz, jstring name, jint capacity) {
+    JniString bufferName(env, name);
+
+    if (capacity <= 0) {
+        return JNI_FALSE;
+    }
+    std::shared_ptr<ByteBuffer> buffer = ByteBuffer::createShared(bufferName.c_str(), (size_t)capacity);
+    if (!buffer) {
+        LOGE("Failed to create shared buffer '%s' with capacity %d", bufferName.c_str(), capacity);
+        return JNI_FALSE;
+    }
+    LOGI("Created shared buffer '%s' with capacity %d", bufferName.c_str(), capacity);
+    return registry().put(bufferName.view(), std::move(buffer)) != BufferRegistry::kInvalidHandle ? JNI_TRUE : JNI_FALSE;
+}
+
+// New descriptor for a shared buffer (caller owns it), or -1
+JNIEXPORT jint JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeExportSharedBuffer(JNIEnv *env, jobject thiz, jstring name) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findBuffer(env, name);
+    if (!buffer || !buffer->shm) {
+        LOGE("Only shared buffers can be exported");
+        return -1;
+    }
+    return buffer->exportFd();
+}
+
+// Map a shared buffer exported by another process under a local name.
+// The descriptor is duplicated; the caller still owns fd.
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeImportSharedBuffer(JNIEnv *env, jobject thiz, jstring name, jint fd) {
+    JniString bufferName(env, name);
+
+    std::shared_ptr<ByteBuffer> buffer = ByteBuffer::importShared(fd);
+    if (!buffer) {
+        LOGE("Failed to import shared buffer '%s' from fd %d", bufferName.c_str(), fd);
+        return JNI_FALSE;
+    }
+    LOGI("Imported shared buffer '%s' with capacity %zu", bufferName.c_str(), buffer->capacity);
+    return registry().put(bufferName.view(), std::move(buffer)) != BufferRegistry::kInvalidHandle ? JNI_TRUE : JNI_FALSE;
+}
+
+// Open (or create) a named buffer backed by a file. After a restart the
+// existing bytes are mapped back with the cursors of the last flush.
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeOpenPersistentBuffer(JNIEnv *env, jobject thiz, jstring name, jstring path, jint capacity) {
+    JniString bufferName(env, name);
+    JniString filePath(env, path);
+
+    if (capacity <= 0) {
+        return JNI_FALSE;
+    }
+    {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* existing = registry().find(bufferName.view());
+        if (existing && existing->isPersistent() && existing->persistentPath() == filePath.view()) {
+            return JNI_TRUE;
+        }
+    }
+    std::shared_ptr<ByteBuffer> buffer = ByteBuffer::openPersistent(filePath.c_str(), (size_t)capacity);
+    if (!buffer) {
+        LOGE("Failed to open persistent buffer '%s' at %s", bufferName.c_str(), filePath.c_str());
+        return JNI_FALSE;
+    }
+    LOGI("Opened persistent buffer '%s' at %s with %zu bytes", bufferName.c_str(), filePath.c_str(), buffer->size());
+    return registry().put(bufferName.view(), std::move(buffer)) != BufferRegistry::kInvalidHandle ? JNI_TRUE : JNI_FALSE;
+}
+
+// Make a persistent buffer's bytes and cursors durable
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeFlushBuffer(JNIEnv *env, jobject thiz, jstring name) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findBuffer(env, name);
+    return buffer && buffer->flush() ? JNI_TRUE : JNI_FALSE;
+}
+
+// Block until minBytes are unread. Holds a reference rather than a
+// ReadGuard so a long wait does not hold back buffer reclamation.
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeWaitForData(JNIEnv *env, jobject thiz, jstring name, jint minBytes, jlong timeoutMicros) {
+    std::shared_ptr<ByteBuffer> buffer;
+    if (name == nullptr) {
+        buffer = registry().acquire(kSharedBufferName);
+    } else {
+        JniString bufferName(env, name);
+        buffer = registry().acquire(bufferName.view());
+    }
+    if (!buffer || minBytes < 0) {
+        return JNI_FALSE;
+    }
+    return buffer->waitForData((size_t)minBytes, (int64_t)timeoutMicros) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Wake readers only after bytes unread bytes or delayMicros, whichever is first
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeSetWakeThreshold(JNIEnv *env, jobject thiz, jstring name, jint bytes, jint delayMicros) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findBuffer(env, name);
+    if (!buffer || buffer->ring || bytes < 0 || delayMicros < 0) {
+        return JNI_FALSE;
+    }
+    return buffer->setWakeThreshold((uint32_t)bytes, (uint32_t)delayMicros) ? JNI_TRUE : JNI_FALSE;
+}
+
+// New descriptor for the buffer's notification timerfd (the caller owns it), or -1
+JNIEXPORT jint JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeGetNotificationFd(JNIEnv *env, jobject thiz, jstring name) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findBuffer(env, name);
+    int fd = buffer && !buffer->ring ? buffer->notificationFd() : -1;
+    return fd >= 0 ? fcntl(fd, F_DUPFD_CLOEXEC, 0) : -1;
+}
+
+// Size, capacity and free space of a buffer as a BufferInfo, or null if it does not exist
+JNIEXPORT jobject JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeGetBufferInfo(JNIEnv *env, jobject thiz, jstring name) {
+    if (!g_jni.bufferInfoInit) {
+        return nullptr;
+    }
+    size_t size;
+    size_t capacity;
+    {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = findBuffer(env, name);
+        if (!buffer) {
+            return nullptr;
+        }
+        size = buffer->ring ? buffer->ring->usedBytes() : buffer->size();
+        capacity = buffer->segments ? buffer->segments->allocated() : buffer->capacity;
+    }
+    jstring infoName = name ? name : env->NewStringUTF("shared");
+    size_t available = capacity > size ? capacity - size : 0;
+    return env->NewObject(g_jni.bufferInfoClass, g_jni.bufferInfoInit, infoName,
+                          (jint)std::min<size_t>(size, INT32_MAX), (jint)std::min<size_t>(capacity, INT32_MAX),
+                          (jint)std::min<size_t>(available, INT32_MAX));
+}
+
 // Clear buffer
 JNIEXPORT void JNICALL
-Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeClearBuffer(JNIEnv *env, jobject thiz, jstring name) {
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeClearBuffer(JNIEnv *env, jobject thiz, jstring name, jboolean wipe) {
+    BufferRegistry::ReadGuard guard;
     if (name == nullptr) {
-        if (g_sharedBuffer) {
-            g_sharedBuffer->clear();
+        if (ByteBuffer* buffer = registry().find(kSharedBufferName)) {
+            buffer->clear(wipe == JNI_TRUE);
             LOGI("Cleared shared buffer");
         }
     } else {
-        const char* bufferName = env->GetStringUTFChars(name, nullptr);
-        std::string key(bufferName);
-        env->ReleaseStringUTFChars(name, bufferName);
-        
-        auto it = g_namedBuffers.find(key);
-        if (it != g_namedBuffers.end()) {
-            it->second->clear();
-            LOGI("Cleared named buffer '%s'", key.c_str());
+        JniString bufferName(env, name);
+        if (ByteBuffer* buffer = registry().find(bufferName.view())) {
+            buffer->clear(wipe == JNI_TRUE);
+            LOGI("Cleared named buffer '%s'", bufferName.c_str());
+        }
+    }
+}
+
+// BufferPool counters for diagnostics
+JNIEXPORT jstring JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeGetBufferPoolStats(JNIEnv *env, jobject thiz) {
+    BufferPool::Stats stats = BufferPool::instance().stats();
+    char text[256];
+    snprintf(text, sizeof(text),
+             "Acquired: %llu, thread cache hits: %llu, shared cache hits: %llu, fresh blocks: %llu, "
+             "bytes zeroed: %llu, cached bytes: %llu",
+             (unsigned long long)stats.acquired, (unsigned long long)stats.threadCacheHits,
+             (unsigned long long)stats.sharedCacheHits, (unsigned long long)stats.freshBlocks,
+             (unsigned long long)stats.bytesZeroed, (unsigned long long)stats.cachedBytes);
+    return env->NewStringUTF(text);
+}
+
+// Counters and latency percentiles for one buffer, or null if it does not exist
+JNIEXPORT jstring JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeGetBufferStats(JNIEnv *env, jobject thiz, jstring name) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findBuffer(env, name);
+    if (!buffer) {
+        return nullptr;
+    }
+    if (name == nullptr) {
+        return env->NewStringUTF(formatStats(kSharedBufferName, buffer).c_str());
+    }
+    JniString bufferName(env, name);
+    return env->NewStringUTF(formatStats(bufferName.view(), buffer).c_str());
+}
+
+// Stats lines for every registered buffer, one per line
+JNIEXPORT jstring JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeGetAllBufferStats(JNIEnv *env, jobject thiz) {
+    BufferRegistry::ReadGuard guard;
+    std::string text;
+    for (const std::string& name : registry().names()) {
+        if (ByteBuffer* buffer = registry().find(name)) {
+            text += formatStats(name, buffer);
+            text += '\n';
         }
     }
+    return env->NewStringUTF(text.c_str());
+}
+
+// Zero a buffer's counters and histograms
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeResetBufferStats(JNIEnv *env, jobject thiz, jstring name) {
+    BufferRegistry::ReadGuard guard;
+    ByteBuffer* buffer = findBuffer(env, name);
+    if (!buffer) {
+        return JNI_FALSE;
+    }
+    buffer->stats.reset();
+    return JNI_TRUE;
 }
 
 // Cleanup byte transfer system
@@ -235,66 +856,254 @@ JNIEXPORT void JNICALL
 Java_com_visgupta_example_v8integrationandroidapp_ByteTransferBridge_nativeCleanup(JNIEnv *env, jobject thiz) {
     LOGI("Cleaning up byte transfer system");
     
-    g_sharedBuffer.reset();
-    g_bufferPool.clear();
-    g_namedBuffers.clear();
+    registry().clear();
+    BufferPool::instance().trim();
     
     LOGI("Byte transfer system cleanup complete");
 }
 
-// Native-to-native interface for V8 library
+// Native-to-native interface for V8 library. Names are looked up as
+// string_views (null means the shared buffer); callers on a hot path should
+// open a handle once and use the *_handle variants, which only index an array.
 extern "C" {
+    static std::string_view bufferKey(const char* buffer_name) {
+        return buffer_name ? std::string_view(buffer_name) : kSharedBufferName;
+    }
+    
+    // Handle for a buffer name, or 0 if no such buffer exists. The handle
+    // follows the name across re-creation and is invalidated by cleanup.
+    uint32_t bytetransfer_open(const char* buffer_name) {
+        return registry().open(bufferKey(buffer_name));
+    }
+    
+    bool bytetransfer_write_handle(uint32_t handle, const uint8_t* data, size_t length) {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().get(handle);
+        return buffer && buffer->write(data, length);
+    }
+    
+    bool bytetransfer_read_handle(uint32_t handle, uint8_t* dest, size_t length, size_t offset) {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().get(handle);
+        return buffer && buffer->read(dest, length, offset);
+    }
+    
     // Function that V8 library can call to write bytes
     bool bytetransfer_write_from_v8(const uint8_t* data, size_t length, const char* buffer_name = nullptr) {
-        if (buffer_name) {
-            std::string key(buffer_name);
-            auto it = g_namedBuffers.find(key);
-            if (it != g_namedBuffers.end()) {
-                return it->second->write(data, length);
-            }
-            return false;
-        } else if (g_sharedBuffer) {
-            return g_sharedBuffer->write(data, length);
-        }
-        return false;
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
+        return buffer && buffer->write(data, length);
     }
     
     // Function that V8 library can call to read bytes
     bool bytetransfer_read_for_v8(uint8_t* dest, size_t length, size_t offset = 0, const char* buffer_name = nullptr) {
-        if (buffer_name) {
-            std::string key(buffer_name);
-            auto it = g_namedBuffers.find(key);
-            if (it != g_namedBuffers.end()) {
-                return it->second->read(dest, length, offset);
-            }
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
+        return buffer && buffer->read(dest, length, offset);
+    }
+    
+    // Gather write for producers that build output in pieces (headers plus
+    // body, JS result chunks); all or nothing
+    bool bytetransfer_writev(const struct iovec* iov, int count, const char* buffer_name) {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
+        return buffer && buffer->writev(iov, count);
+    }
+    
+    // Scatter the unread bytes into iov and consume them; returns the byte count
+    size_t bytetransfer_readv(const struct iovec* iov, int count, const char* buffer_name) {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
+        return buffer ? buffer->readv(iov, count) : 0;
+    }
+    
+    // Block until min_unread bytes are unread or timeout_us passes (negative
+    // waits forever). Resolve the name once: the wait holds a reference.
+    bool bytetransfer_wait(size_t min_unread, int64_t timeout_us, const char* buffer_name) {
+        std::shared_ptr<ByteBuffer> buffer = registry().acquire(bufferKey(buffer_name));
+        return buffer && buffer->waitForData(min_unread, timeout_us);
+    }
+    
+    bool bytetransfer_set_wake_threshold(uint32_t bytes, uint32_t delay_us, const char* buffer_name) {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
+        if (!buffer || buffer->ring) {
             return false;
-        } else if (g_sharedBuffer) {
-            return g_sharedBuffer->read(dest, length, offset);
         }
-        return false;
+        return buffer->setWakeThreshold(bytes, delay_us);
+    }
+    
+    // The buffer's notification descriptor for epoll/ALooper, owned by the buffer; -1 if none
+    int bytetransfer_notification_fd(const char* buffer_name) {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
+        return buffer && !buffer->ring ? buffer->notificationFd() : -1;
+    }
+    
+    // Flush a persistent buffer (false for any other kind)
+    bool bytetransfer_flush(const char* buffer_name) {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
+        return buffer && buffer->flush();
+    }
+    
+    // Create (or replace) a named segmented buffer that grows on demand
+    bool bytetransfer_create_segmented_buffer(const char* buffer_name, size_t segment_size, size_t max_bytes) {
+        auto buffer = std::make_shared<ByteBuffer>(std::make_unique<SegmentedBuffer>(segment_size, max_bytes));
+        return registry().put(bufferKey(buffer_name), std::move(buffer)) != BufferRegistry::kInvalidHandle;
+    }
+    
+    // Ring-mode named buffer for native producers/consumers, or nullptr.
+    // Resolve once and keep the pointer: ring operations take no locks. The
+    // pointer is valid until the name is re-created or the system cleaned up.
+    ByteRing* bytetransfer_get_ring(const char* buffer_name) {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
+        return buffer ? buffer->ring.get() : nullptr;
+    }
+    
+    // Pin a linear buffer's memory for an external holder such as a JS
+    // ArrayBuffer. The memory stays valid until bytetransfer_unpin(pin), even
+    // if the buffer is recreated or the system is cleaned up meanwhile.
+    void* bytetransfer_pin(const char* buffer_name, uint8_t** data, size_t* capacity) {
+        std::shared_ptr<ByteBuffer> buffer = registry().acquire(bufferKey(buffer_name));
+        if (!buffer || buffer->ring || !buffer->data) {
+            return nullptr;
+        }
+        *data = buffer->data;
+        *capacity = buffer->capacity;
+        return new std::shared_ptr<ByteBuffer>(std::move(buffer));
+    }
+    
+    void bytetransfer_unpin(void* pin) {
+        delete static_cast<std::shared_ptr<ByteBuffer>*>(pin);
+    }
+    
+    // Create (or replace) a named linear buffer
+    bool bytetransfer_create_buffer(const char* buffer_name, size_t capacity) {
+        std::string_view key = bufferKey(buffer_name);
+        try {
+            createLinearBuffer(key, capacity, false);
+            return true;
+        } catch (const std::exception& e) {
+            LOGE("Failed to create named buffer '%.*s': %s", (int)key.size(), key.data(), e.what());
+            return false;
+        }
+    }
+    
+    bool bytetransfer_get_cursors(size_t* read_pos, size_t* write_pos, const char* buffer_name) {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
+        if (!buffer || buffer->ring) {
+            return false;
+        }
+        *read_pos = buffer->readPosition();
+        *write_pos = buffer->size();
+        return true;
+    }
+    
+    // Advance the write cursor over bytes produced in place
+    bool bytetransfer_commit(size_t count, const char* buffer_name) {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
+        return buffer && buffer->commit(count);
+    }
+    
+    // Advance the read cursor over bytes consumed in place
+    bool bytetransfer_consume(size_t count, const char* buffer_name) {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
+        return buffer && buffer->consume(count);
     }
     
     // Get buffer info for V8 library
     bool bytetransfer_get_info(size_t* size, size_t* capacity, const char* buffer_name = nullptr) {
-        ByteBuffer* buffer = nullptr;
-        
-        if (buffer_name) {
-            std::string key(buffer_name);
-            auto it = g_namedBuffers.find(key);
-            if (it != g_namedBuffers.end()) {
-                buffer = it->second.get();
-            }
-        } else {
-            buffer = g_sharedBuffer.get();
-        }
-        
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
         if (buffer) {
-            *size = buffer->size;
-            *capacity = buffer->capacity;
+            *size = buffer->ring ? buffer->ring->usedBytes() : buffer->size();
+            *capacity = buffer->segments ? buffer->segments->allocated() : buffer->capacity;
             return true;
         }
         return false;
     }
+    
+    // Write the buffer's stats line into out (NUL-terminated, truncated to
+    // cap). Returns the full line length, or 0 if the buffer does not exist.
+    size_t bytetransfer_format_stats(char* out, size_t cap, const char* buffer_name) {
+        BufferRegistry::ReadGuard guard;
+        ByteBuffer* buffer = registry().find(bufferKey(buffer_name));
+        if (!buffer) {
+            return 0;
+        }
+        std::string line = formatStats(bufferKey(buffer_name), buffer);
+        if (cap > 0) {
+            size_t n = std::min(line.size(), cap - 1);
+            memcpy(out, line.data(), n);
+            out[n] = '\0';
+        }
+        return line.size();
+    }
+}
+
 }
 
-}
\ No newline at end of file
+bool registerByteTransferBridgeNatives(JNIEnv *env) {
+    static const JNINativeMethod kMethods[] = {
+    JNI_NATIVE(ByteTransferBridge, nativeInitializeByteTransfer, "(I)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeCreateNamedBuffer, "(Ljava/lang/String;IZ)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeWriteBytes, "([B)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeWriteBytesToNamed, "(Ljava/lang/String;[B)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeReadBytes, "(II)[B"),
+    JNI_NATIVE(ByteTransferBridge, nativeReadBytesFromNamed, "(Ljava/lang/String;II)[B"),
+    JNI_NATIVE(ByteTransferBridge, nativeOpenBuffer, "(Ljava/lang/String;)I"),
+    JNI_NATIVE(ByteTransferBridge, nativeWriteBytesToHandle, "(I[B)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeReadBytesFromHandle, "(III)[B"),
+    JNI_NATIVE(ByteTransferBridge, nativePinBuffer, "(Ljava/lang/String;)J"),
+    JNI_NATIVE(ByteTransferBridge, nativeGetDirectBuffer, "(J)Ljava/nio/ByteBuffer;"),
+    JNI_NATIVE(ByteTransferBridge, nativeUnpinBuffer, "(J)V"),
+    JNI_NATIVE(ByteTransferBridge, nativeGetCursors, "(Ljava/lang/String;)J"),
+    JNI_NATIVE(ByteTransferBridge, nativeAdvanceWriteCursor, "(Ljava/lang/String;I)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeAdvanceReadCursor, "(Ljava/lang/String;I)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeCreateSegmentedBuffer, "(Ljava/lang/String;IJ)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativePinLinearView, "(Ljava/lang/String;)J"),
+    JNI_NATIVE(ByteTransferBridge, nativeCreateRingBuffer, "(Ljava/lang/String;IZ)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeRingWrite, "(Ljava/lang/String;[BI)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeRingWriteBatch, "(Ljava/lang/String;[[BI)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeRingRead, "(Ljava/lang/String;)[B"),
+    JNI_NATIVE(ByteTransferBridge, nativeRingReadBatch, "(Ljava/lang/String;I)[[B"),
+    JNI_NATIVE(ByteTransferBridge, nativeCreateSharedBuffer, "(Ljava/lang/String;I)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeExportSharedBuffer, "(Ljava/lang/String;)I"),
+    JNI_NATIVE(ByteTransferBridge, nativeImportSharedBuffer, "(Ljava/lang/String;I)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeOpenPersistentBuffer, "(Ljava/lang/String;Ljava/lang/String;I)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeFlushBuffer, "(Ljava/lang/String;)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeWaitForData, "(Ljava/lang/String;IJ)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeSetWakeThreshold, "(Ljava/lang/String;II)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeGetNotificationFd, "(Ljava/lang/String;)I"),
+    JNI_NATIVE(ByteTransferBridge, nativeGetBufferInfo, "(Ljava/lang/String;)Lcom/visgupta/example/v8integrationandroidapp/BufferInfo;"),
+    JNI_NATIVE(ByteTransferBridge, nativeClearBuffer, "(Ljava/lang/String;Z)V"),
+    JNI_NATIVE(ByteTransferBridge, nativeGetBufferPoolStats, "()Ljava/lang/String;"),
+    JNI_NATIVE(ByteTransferBridge, nativeGetBufferStats, "(Ljava/lang/String;)Ljava/lang/String;"),
+    JNI_NATIVE(ByteTransferBridge, nativeGetAllBufferStats, "()Ljava/lang/String;"),
+    JNI_NATIVE(ByteTransferBridge, nativeResetBufferStats, "(Ljava/lang/String;)Z"),
+    JNI_NATIVE(ByteTransferBridge, nativeCleanup, "()V"),
+    };
+    static const JNINativeMethod kCriticalMethods[] = {
+        {"nativeGetHandleCursors", "(I)J", reinterpret_cast<void *>(criticalGetHandleCursors)},
+        {"nativeCommitHandle", "(II)Z", reinterpret_cast<void *>(criticalCommitHandle)},
+        {"nativeConsumeHandle", "(II)Z", reinterpret_cast<void *>(criticalConsumeHandle)},
+        {"nativeSetStatsSampling", "(I)V", reinterpret_cast<void *>(criticalSetStatsSampling)},
+    };
+    static const JNINativeMethod kCompatMethods[] = {
+        {"nativeGetHandleCursors", "(I)J", reinterpret_cast<void *>(getHandleCursors)},
+        {"nativeCommitHandle", "(II)Z", reinterpret_cast<void *>(commitHandle)},
+        {"nativeConsumeHandle", "(II)Z", reinterpret_cast<void *>(consumeHandle)},
+        {"nativeSetStatsSampling", "(I)V", reinterpret_cast<void *>(setStatsSampling)},
+    };
+    static_assert(std::size(kCriticalMethods) == std::size(kCompatMethods), "one adapter per critical method");
+
+    const char *className = "com/visgupta/example/v8integrationandroidapp/ByteTransferBridge";
+    return jniRegisterNatives(env, className, kMethods, std::size(kMethods)) &&
+           jniRegisterNatives(env, className, jniCriticalNativesSupported() ? kCriticalMethods : kCompatMethods,
+                              std::size(kCriticalMethods));
+}
@@ -0,0 +1,134 @@
+#include <cstdint>
+#include <cstring>
+
+#include "bytetransfer_js.h"
+
+// Byte transfer functions (bytetransfer.cpp)
+extern "C" {
+    void* bytetransfer_pin(const char* buffer_name, uint8_t** data, size_t* capacity);
+    void bytetransfer_unpin(void* pin);
+    bool bytetransfer_create_buffer(const char* buffer_name, size_t capacity);
+    bool bytetransfer_get_cursors(size_t* read_pos, size_t* write_pos, const char* buffer_name);
+    bool bytetransfer_commit(size_t count, const char* buffer_name);
+    bool bytetransfer_consume(size_t count, const char* buffer_name);
+    bool bytetransfer_get_info(size_t* size, size_t* capacity, const char* buffer_name);
+}
+
+// Runs when the last ArrayBuffer referencing the memory is collected
+static void unpinArrayBuffer(JSRuntime *rt, void *opaque, void *ptr) {
+    bytetransfer_unpin(opaque);
+}
+
+// Buffer name from argument 0; nullptr (shared buffer) for undefined/null.
+// Returns false with an exception pending if the argument is not a string.
+static bool bufferNameArg(JSContext *ctx, int argc, JSValueConst *argv, const char **name) {
+    *name = nullptr;
+    if (argc < 1 || JS_IsUndefined(argv[0]) || JS_IsNull(argv[0])) {
+        return true;
+    }
+    *name = JS_ToCString(ctx, argv[0]);
+    return *name != nullptr;
+}
+
+static JSValue pinnedArrayBuffer(JSContext *ctx, const char *name) {
+    uint8_t *data = nullptr;
+    size_t capacity = 0;
+    void *pin = bytetransfer_pin(name, &data, &capacity);
+    if (!pin) {
+        return JS_ThrowReferenceError(ctx, "ByteTransfer buffer '%s' not found or not linear",
+                                      name ? name : "<shared>");
+    }
+    // The ArrayBuffer aliases the native memory; the pin keeps it alive
+    JSValue buffer = JS_NewArrayBuffer(ctx, data, capacity, unpinArrayBuffer, pin, false);
+    if (JS_IsException(buffer)) {
+        bytetransfer_unpin(pin);
+    }
+    return buffer;
+}
+
+// ByteTransfer.open(name?) -> ArrayBuffer over the whole buffer capacity
+static JSValue js_bytetransfer_open(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    const char *name;
+    if (!bufferNameArg(ctx, argc, argv, &name)) {
+        return JS_EXCEPTION;
+    }
+    JSValue result = pinnedArrayBuffer(ctx, name);
+    if (name) JS_FreeCString(ctx, name);
+    return result;
+}
+
+// ByteTransfer.create(name, capacity) -> ArrayBuffer over a new named buffer
+static JSValue js_bytetransfer_create(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    if (argc < 2 || !JS_IsString(argv[0])) {
+        return JS_ThrowTypeError(ctx, "ByteTransfer.create(name, capacity)");
+    }
+    int64_t capacity;
+    if (JS_ToInt64(ctx, &capacity, argv[1]) || capacity <= 0) {
+        return JS_ThrowRangeError(ctx, "invalid capacity");
+    }
+    const char *name = JS_ToCString(ctx, argv[0]);
+    if (!name) {
+        return JS_EXCEPTION;
+    }
+    JSValue result = bytetransfer_create_buffer(name, (size_t)capacity)
+        ? pinnedArrayBuffer(ctx, name)
+        : JS_ThrowInternalError(ctx, "failed to allocate %lld bytes", (long long)capacity);
+    JS_FreeCString(ctx, name);
+    return result;
+}
+
+// ByteTransfer.info(name?) -> { readPosition, writePosition, capacity }
+static JSValue js_bytetransfer_info(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    const char *name;
+    if (!bufferNameArg(ctx, argc, argv, &name)) {
+        return JS_EXCEPTION;
+    }
+    size_t readPos = 0, writePos = 0, size = 0, capacity = 0;
+    bool found = bytetransfer_get_info(&size, &capacity, name);
+    bool linear = found && bytetransfer_get_cursors(&readPos, &writePos, name);
+    if (name) JS_FreeCString(ctx, name);
+    if (!found) {
+        return JS_NULL;
+    }
+    JSValue info = JS_NewObject(ctx);
+    JS_SetPropertyStr(ctx, info, "readPosition", JS_NewInt64(ctx, (int64_t)readPos));
+    JS_SetPropertyStr(ctx, info, "writePosition", JS_NewInt64(ctx, (int64_t)(linear ? writePos : size)));
+    JS_SetPropertyStr(ctx, info, "capacity", JS_NewInt64(ctx, (int64_t)capacity));
+    return info;
+}
+
+// ByteTransfer.commit(name, count) / consume(name, count): advance a cursor
+static JSValue advanceCursor(JSContext *ctx, int argc, JSValueConst *argv, bool write) {
+    const char *name;
+    if (!bufferNameArg(ctx, argc, argv, &name)) {
+        return JS_EXCEPTION;
+    }
+    int64_t count = 0;
+    if (argc < 2 || JS_ToInt64(ctx, &count, argv[1]) || count < 0) {
+        if (name) JS_FreeCString(ctx, name);
+        return JS_ThrowRangeError(ctx, "invalid byte count");
+    }
+    bool ok = write ? bytetransfer_commit((size_t)count, name) : bytetransfer_consume((size_t)count, name);
+    if (name) JS_FreeCString(ctx, name);
+    return JS_NewBool(ctx, ok);
+}
+
+static JSValue js_bytetransfer_commit(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    return advanceCursor(ctx, argc, argv, true);
+}
+
+static JSValue js_bytetransfer_consume(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    return advanceCursor(ctx, argc, argv, false);
+}
+
+void addByteTransferBinding(JSContext *ctx) {
+    JSValue global = JS_GetGlobalObject(ctx);
+    JSValue byteTransfer = JS_NewObject(ctx);
+    JS_SetPropertyStr(ctx, byteTransfer, "open", JS_NewCFunction(ctx, js_bytetransfer_open, "open", 1));
+    JS_SetPropertyStr(ctx, byteTransfer, "create", JS_NewCFunction(ctx, js_bytetransfer_create, "create", 2));
+    JS_SetPropertyStr(ctx, byteTransfer, "info", JS_NewCFunction(ctx, js_bytetransfer_info, "info", 1));
+    JS_SetPropertyStr(ctx, byteTransfer, "commit", JS_NewCFunction(ctx, js_bytetransfer_commit, "commit", 2));
+    JS_SetPropertyStr(ctx, byteTransfer, "consume", JS_NewCFunction(ctx, js_bytetransfer_consume, "consume", 2));
+    JS_SetPropertyStr(ctx, global, "ByteTransfer", byteTransfer);
+    JS_FreeValue(ctx, global);
+}
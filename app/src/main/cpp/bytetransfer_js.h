@@ -0,0 +1,11 @@
+#ifndef BYTETRANSFER_JS_H
+#define BYTETRANSFER_JS_H
+
+extern "C" {
+#include "quickjs/quickjs.h"
+}
+
+// Install the global ByteTransfer object (open/create/info/commit/consume)
+void addByteTransferBinding(JSContext *ctx);
+
+#endif // BYTETRANSFER_JS_H
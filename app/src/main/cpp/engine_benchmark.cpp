@@ -0,0 +1,129 @@
+#include "engine_benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+struct Workload {
+    const char* name;
+    const char* function;    // global defined by definition
+    const char* definition;
+    const char* argsJson;    // single JSON argument for call()
+};
+
+// Plain ECMAScript only, so every backend runs identical code
+const Workload kWorkloads[] = {
+    {"fib", "benchFib",
+     "function benchFib(n) { return n < 2 ? n : benchFib(n - 1) + benchFib(n - 2); }",
+     "20"},
+    {"strings", "benchStrings",
+     "function benchStrings(n) {\n"
+     "  let parts = [];\n"
+     "  for (let i = 0; i < n; i++) parts.push('item-' + i.toString(16));\n"
+     "  return parts.join(',').length;\n"
+     "}",
+     "2000"},
+    {"json", "benchJson",
+     "function benchJson(n) {\n"
+     "  let doc = { id: 1, tags: ['a', 'b', 'c'], nested: { x: 1.5, y: 'text', z: [1, 2, 3] } };\n"
+     "  let total = 0;\n"
+     "  for (let i = 0; i < n; i++) { doc.id = i; total += JSON.parse(JSON.stringify(doc)).id; }\n"
+     "  return total;\n"
+     "}",
+     "500"},
+    {"arrays", "benchArrays",
+     "function benchArrays(n) {\n"
+     "  let a = [];\n"
+     "  for (let i = 0; i < n; i++) a.push((i * 7919) % 1000);\n"
+     "  return a.filter(x => x % 3 === 0).map(x => x * 2).sort((p, q) => p - q).reduce((s, x) => s + x, 0);\n"
+     "}",
+     "5000"},
+    {"objects", "benchObjects",
+     "function benchObjects(n) {\n"
+     "  let sum = 0;\n"
+     "  for (let i = 0; i < n; i++) { let p = { x: i, y: i + 1, z: i + 2 }; sum += p.x + p.y * p.z; }\n"
+     "  return sum;\n"
+     "}",
+     "20000"},
+};
+
+double elapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+std::vector<EngineBenchmarkResult> runEngineBenchmark(JsEngine& engine, int iterations) {
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    bool echoes = strcmp(engine.name(), "mock") == 0;
+    std::vector<EngineBenchmarkResult> results;
+    for (const Workload& workload : kWorkloads) {
+        EngineBenchmarkResult r;
+        r.workload = workload.name;
+        engine.reset();
+        std::string source = std::string(workload.definition) + "\n" + workload.function + "(" +
+                             workload.argsJson + ")";
+
+        auto start = std::chrono::steady_clock::now();
+        r.ok = true;
+        for (int i = 0; i < iterations && r.ok; i++) {
+            r.ok = engine.eval(source, &r.value);
+        }
+        r.evalUs = elapsedUs(start) / iterations;
+        if (!r.ok) {
+            results.push_back(r);
+            continue;
+        }
+
+        std::vector<uint8_t> bytecode;
+        start = std::chrono::steady_clock::now();
+        r.ok = engine.compile(source, &bytecode, &r.value);
+        r.compileUs = elapsedUs(start);
+        std::string loaded;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations && r.ok; i++) {
+            r.ok = engine.loadBytecode(bytecode.data(), bytecode.size(), &loaded);
+        }
+        r.loadUs = elapsedUs(start) / iterations;
+
+        // The eval above left the function defined
+        std::string called;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations && r.ok; i++) {
+            r.ok = engine.call(workload.function, {workload.argsJson}, &called);
+        }
+        r.callUs = elapsedUs(start) / iterations;
+        // The mock echoes its input, so only real engines must agree with themselves
+        if (r.ok && !echoes && (loaded != r.value || called != r.value)) {
+            r.ok = false;
+            r.value = "mismatch: eval " + r.value + ", bytecode " + loaded + ", call " + called;
+        }
+        results.push_back(r);
+    }
+    return results;
+}
+
+std::string formatEngineBenchmark(std::string_view engine, const std::vector<EngineBenchmarkResult>& results) {
+    char line[256];
+    std::string text;
+    snprintf(line, sizeof(line), "%-8s %-8s %10s %10s %10s %10s  %s\n", "engine", "workload", "eval us",
+             "compile us", "load us", "call us", "value");
+    text += line;
+    std::string summary = "RESULT engine=" + std::string(engine);
+    for (const EngineBenchmarkResult& r : results) {
+        std::string value = r.value.substr(0, std::min<size_t>(48, r.value.find('\n')));
+        snprintf(line, sizeof(line), "%-8.*s %-8s %10.1f %10.1f %10.1f %10.1f  %s%s\n", (int)engine.size(),
+                 engine.data(), r.workload.c_str(), r.evalUs, r.compileUs, r.loadUs, r.callUs,
+                 r.ok ? "" : "FAILED ", value.c_str());
+        text += line;
+        snprintf(line, sizeof(line), " %s_eval_us=%.1f %s_call_us=%.1f", r.workload.c_str(), r.evalUs,
+                 r.workload.c_str(), r.callUs);
+        summary += line;
+    }
+    return text + summary;
+}
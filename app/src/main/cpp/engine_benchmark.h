@@ -0,0 +1,32 @@
+#ifndef ENGINE_BENCHMARK_H
+#define ENGINE_BENCHMARK_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "js_engine.h"
+
+// Timings for one workload on one engine, in microseconds per run
+struct EngineBenchmarkResult {
+    std::string workload;
+    double evalUs = 0;     // source each time: parse + run
+    double compileUs = 0;  // compile() once
+    double loadUs = 0;     // loadBytecode() of that output
+    double callUs = 0;     // call() of an already defined function
+    std::string value;     // result of the last eval, or the error
+    bool ok = false;
+};
+
+/**
+ * Runs the same fixed workloads (recursion, string building, JSON round
+ * trips, array pipelines, property access) through eval, compile +
+ * loadBytecode and call on an initialized engine. Each workload defines a
+ * global function, so the engine is reset() before each one.
+ */
+std::vector<EngineBenchmarkResult> runEngineBenchmark(JsEngine& engine, int iterations);
+
+// Table plus a trailing "RESULT engine=..." line for scripts
+std::string formatEngineBenchmark(std::string_view engine, const std::vector<EngineBenchmarkResult>& results);
+
+#endif // ENGINE_BENCHMARK_H
@@ -0,0 +1,1052 @@
+#include "http_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOG_TAG "HttpCache"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#define LOGE(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#endif
+
+namespace {
+
+const char* kEntryMagic = "HTTPCACHE2";
+const int64_t kMaxHeuristicFreshnessMs = 24LL * 60 * 60 * 1000;
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string toLower(const std::string& s) {
+    std::string out(s);
+    std::transform(out.begin(), out.end(), out.begin(), [](unsigned char c) { return (char)tolower(c); });
+    return out;
+}
+
+std::string trim(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = s.find_last_not_of(" \t");
+    return s.substr(start, end - start + 1);
+}
+
+std::vector<std::string> splitList(const std::string& value) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t comma = value.find(',', start);
+        if (comma == std::string::npos) {
+            comma = value.size();
+        }
+        std::string item = trim(value.substr(start, comma - start));
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+        start = comma + 1;
+    }
+    return items;
+}
+
+std::string findHeader(const HttpHeaders& headers, const std::string& name) {
+    for (const auto& h : headers) {
+        if (strcasecmp(h.first.c_str(), name.c_str()) == 0) {
+            return h.second;
+        }
+    }
+    return "";
+}
+
+void replaceHeader(HttpHeaders& headers, const std::string& name, const std::string& value) {
+    for (auto& h : headers) {
+        if (strcasecmp(h.first.c_str(), name.c_str()) == 0) {
+            h.second = value;
+            return;
+        }
+    }
+    headers.emplace_back(name, value);
+}
+
+void removeHeader(HttpHeaders& headers, const std::string& name) {
+    headers.erase(std::remove_if(headers.begin(), headers.end(), [&](const std::pair<std::string, std::string>& h) {
+        return strcasecmp(h.first.c_str(), name.c_str()) == 0;
+    }), headers.end());
+}
+
+// IMF-fixdate, obsolete RFC 850 and asctime formats (RFC 9110 section 5.6.7)
+int64_t parseHttpDate(const std::string& value) {
+    static const char* formats[] = {
+        "%a, %d %b %Y %H:%M:%S GMT",
+        "%A, %d-%b-%y %H:%M:%S GMT",
+        "%a %b %d %H:%M:%S %Y",
+    };
+    if (value.empty()) {
+        return -1;
+    }
+    for (const char* format : formats) {
+        struct tm tm;
+        memset(&tm, 0, sizeof(tm));
+        const char* end = strptime(value.c_str(), format, &tm);
+        if (end && *end == '\0') {
+            return (int64_t)timegm(&tm) * 1000;
+        }
+    }
+    return -1;
+}
+
+int64_t parseDeltaSeconds(const std::string& value) {
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+        return -1;
+    }
+    // Values too large to represent are clamped (RFC 9111 section 1.2.2)
+    if (value.size() > 10) {
+        return 2147483648LL;
+    }
+    return strtoll(value.c_str(), nullptr, 10);
+}
+
+bool isHeuristicallyCacheable(int status) {
+    switch (status) {
+        case 200: case 203: case 204: case 300: case 301: case 308:
+        case 404: case 405: case 410: case 414: case 501:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isUnderstoodStatus(int status) {
+    return isHeuristicallyCacheable(status) || status == 302 || status == 307;
+}
+
+uint64_t fnv1a64(const std::string& s) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : s) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+JsonValue headersToJson(const HttpHeaders& headers) {
+    JsonValue obj = JsonValue::makeObject();
+    for (const auto& h : headers) {
+        obj.set(h.first, JsonValue::makeString(h.second));
+    }
+    return obj;
+}
+
+HttpHeaders headersFromJson(const JsonValue* obj, bool lowerCase) {
+    HttpHeaders headers;
+    if (!obj || !obj->isObject()) {
+        return headers;
+    }
+    for (const auto& member : obj->objectValue) {
+        std::string value;
+        if (member.second.type == JsonValue::String) {
+            value = member.second.stringValue;
+        } else {
+            value = toJson(member.second);
+        }
+        headers.emplace_back(lowerCase ? toLower(member.first) : member.first, value);
+    }
+    return headers;
+}
+
+size_t entrySize(const HttpCache::Entry& entry) {
+    size_t size = entry.key.size() + entry.response.body.size() + entry.response.statusText.size() +
+                  entry.response.url.size() + sizeof(HttpCache::Entry);
+    for (const auto& h : entry.response.headers) {
+        size += h.first.size() + h.second.size();
+    }
+    return size;
+}
+
+// Request header value as matched against a stored Vary selection (RFC 9111
+// section 4.1): list members are trimmed so "a,b" and "a, b" share an entry
+std::string normalizeHeaderValue(const std::string& value) {
+    std::string out;
+    for (const std::string& item : splitList(value)) {
+        if (!out.empty()) {
+            out += ',';
+        }
+        out += item;
+    }
+    return out;
+}
+
+std::string entryKey(const std::string& url, const HttpHeaders& varyRequestHeaders) {
+    std::string key = url;
+    for (const auto& h : varyRequestHeaders) {
+        key += '\n' + h.first + ':' + h.second;
+    }
+    return key;
+}
+
+bool varyMatches(const HttpCache::Entry& entry, const HttpRequest& request) {
+    for (const auto& vary : entry.varyRequestHeaders) {
+        if (normalizeHeaderValue(request.header(vary.first)) != vary.second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copy of entry for the disk index, without the body
+std::shared_ptr<const HttpCache::Entry> metadataOf(const HttpCache::Entry& entry) {
+    auto meta = std::make_shared<HttpCache::Entry>();
+    meta->key = entry.key;
+    meta->url = entry.url;
+    meta->response.status = entry.response.status;
+    meta->response.statusText = entry.response.statusText;
+    meta->response.url = entry.response.url;
+    meta->response.type = entry.response.type;
+    meta->response.redirected = entry.response.redirected;
+    meta->response.headers = entry.response.headers;
+    meta->varyRequestHeaders = entry.varyRequestHeaders;
+    meta->cacheControl = entry.cacheControl;
+    meta->requestTimeMs = entry.requestTimeMs;
+    meta->responseTimeMs = entry.responseTimeMs;
+    meta->sizeBytes = entry.sizeBytes;
+    meta->bodyOnDisk = true;
+    return meta;
+}
+
+// Disk entry layout: magic line, JSON metadata line, then the raw body bytes
+std::string entryHeader(const HttpCache::Entry& entry) {
+    JsonValue meta = JsonValue::makeObject();
+    meta.set("key", JsonValue::makeString(entry.key));
+    meta.set("requestUrl", JsonValue::makeString(entry.url));
+    meta.set("requestTime", JsonValue::makeNumber((double)entry.requestTimeMs));
+    meta.set("responseTime", JsonValue::makeNumber((double)entry.responseTimeMs));
+    meta.set("status", JsonValue::makeNumber(entry.response.status));
+    meta.set("statusText", JsonValue::makeString(entry.response.statusText));
+    meta.set("url", JsonValue::makeString(entry.response.url));
+    meta.set("type", JsonValue::makeString(entry.response.type));
+    meta.set("redirected", JsonValue::makeBool(entry.response.redirected));
+    meta.set("headers", headersToJson(entry.response.headers));
+    meta.set("vary", headersToJson(entry.varyRequestHeaders));
+    return std::string(kEntryMagic) + "\n" + toJson(meta) + "\n";
+}
+
+// Parses the first two lines of an entry file; *headerSize is where the body starts
+bool parseEntryHeader(const std::string& contents, HttpCache::Entry* entry, size_t* headerSize) {
+    size_t magicEnd = contents.find('\n');
+    size_t metaEnd = magicEnd == std::string::npos ? std::string::npos : contents.find('\n', magicEnd + 1);
+    JsonValue meta;
+    if (metaEnd == std::string::npos || contents.compare(0, magicEnd, kEntryMagic) != 0 ||
+        !parseJson(contents.data() + magicEnd + 1, metaEnd - magicEnd - 1, &meta)) {
+        return false;
+    }
+    entry->key = meta.getString("key");
+    entry->url = meta.getString("requestUrl");
+    entry->requestTimeMs = (int64_t)meta.getNumber("requestTime");
+    entry->responseTimeMs = (int64_t)meta.getNumber("responseTime");
+    entry->response.status = (int)meta.getNumber("status");
+    entry->response.statusText = meta.getString("statusText");
+    entry->response.url = meta.getString("url");
+    entry->response.type = meta.getString("type", "basic");
+    entry->response.redirected = meta.getBool("redirected");
+    entry->response.headers = headersFromJson(meta.get("headers"), true);
+    entry->varyRequestHeaders = headersFromJson(meta.get("vary"), true);
+    entry->cacheControl = CacheControl::parse(entry->response.header("cache-control"));
+    *headerSize = metaEnd + 1;
+    return !entry->key.empty() && !entry->url.empty();
+}
+
+} // namespace
+
+// ---- HttpRequest ----
+
+HttpRequest HttpRequest::fromOptions(const std::string& url, const std::string& optionsJson) {
+    HttpRequest request;
+    request.url = url;
+    if (!parseJson(optionsJson, &request.options) || !request.options.isObject()) {
+        request.options = JsonValue::makeObject();
+    }
+    request.method = request.options.getString("method", "GET");
+    std::transform(request.method.begin(), request.method.end(), request.method.begin(),
+                   [](unsigned char c) { return (char)toupper(c); });
+    request.headers = headersFromJson(request.options.get("headers"), false);
+    request.cacheMode = request.options.getString("cache", "default");
+    return request;
+}
+
+std::string HttpRequest::header(const std::string& name) const {
+    return findHeader(headers, name);
+}
+
+void HttpRequest::setHeader(const std::string& name, const std::string& value) {
+    replaceHeader(headers, name, value);
+}
+
+std::string HttpRequest::toOptionsJson() const {
+    JsonValue out = options.isObject() ? options : JsonValue::makeObject();
+    out.set("method", JsonValue::makeString(method));
+    out.set("headers", headersToJson(headers));
+    out.set("cache", JsonValue::makeString(cacheMode));
+    return toJson(out);
+}
+
+// ---- HttpResponse ----
+
+bool HttpResponse::fromJson(const std::string& json, HttpResponse* out) {
+    JsonValue root;
+    if (!parseJson(json, &root) || !root.isObject()) {
+        return false;
+    }
+    out->status = (int)root.getNumber("status", 0);
+    out->statusText = root.getString("statusText");
+    out->url = root.getString("url");
+    out->type = root.getString("type", "basic");
+    out->redirected = root.getBool("redirected");
+    out->headers = headersFromJson(root.get("headers"), true);
+    out->body = root.getString("body");
+    return true;
+}
+
+HttpResponse HttpResponse::networkError(const std::string& url, const std::string& statusText) {
+    HttpResponse response;
+    response.status = 0;
+    response.statusText = statusText;
+    response.url = url;
+    return response;
+}
+
+std::string HttpResponse::header(const std::string& name) const {
+    return findHeader(headers, name);
+}
+
+void HttpResponse::setHeader(const std::string& name, const std::string& value) {
+    replaceHeader(headers, toLower(name), value);
+}
+
+std::string HttpResponse::toJson() const {
+    JsonValue root = JsonValue::makeObject();
+    root.set("status", JsonValue::makeNumber(status));
+    root.set("statusText", JsonValue::makeString(statusText));
+    root.set("ok", JsonValue::makeBool(ok()));
+    root.set("redirected", JsonValue::makeBool(redirected));
+    root.set("url", JsonValue::makeString(url));
+    root.set("type", JsonValue::makeString(type));
+    root.set("body", JsonValue::makeString(body));
+    root.set("headers", headersToJson(headers));
+    return ::toJson(root);
+}
+
+// ---- CacheControl ----
+
+CacheControl CacheControl::parse(const std::string& value) {
+    CacheControl cc;
+    for (const std::string& directive : splitList(value)) {
+        size_t eq = directive.find('=');
+        std::string name = toLower(trim(directive.substr(0, eq)));
+        std::string arg;
+        if (eq != std::string::npos) {
+            arg = trim(directive.substr(eq + 1));
+            if (arg.size() >= 2 && arg.front() == '"' && arg.back() == '"') {
+                arg = arg.substr(1, arg.size() - 2);
+            }
+        }
+        if (name == "max-age") {
+            cc.maxAge = parseDeltaSeconds(arg);
+        } else if (name == "stale-while-revalidate") {
+            cc.staleWhileRevalidate = parseDeltaSeconds(arg);
+        } else if (name == "stale-if-error") {
+            cc.staleIfError = parseDeltaSeconds(arg);
+        } else if (name == "no-cache") {
+            cc.noCache = true;
+        } else if (name == "no-store") {
+            cc.noStore = true;
+        } else if (name == "must-revalidate" || name == "proxy-revalidate") {
+            cc.mustRevalidate = true;
+        } else if (name == "public") {
+            cc.isPublic = true;
+        }
+    }
+    return cc;
+}
+
+// ---- HttpCache::Entry ----
+
+int64_t HttpCache::Entry::freshnessLifetimeMs() const {
+    if (cacheControl.noCache) {
+        return 0;
+    }
+    if (cacheControl.maxAge >= 0) {
+        return cacheControl.maxAge * 1000;
+    }
+    int64_t date = parseHttpDate(response.header("date"));
+    if (date < 0) {
+        date = responseTimeMs;
+    }
+    std::string expiresHeader = response.header("expires");
+    if (!expiresHeader.empty()) {
+        // Invalid dates such as "0" mean already expired
+        int64_t expires = parseHttpDate(expiresHeader);
+        return expires < 0 ? 0 : std::max<int64_t>(0, expires - date);
+    }
+    int64_t lastModified = parseHttpDate(response.header("last-modified"));
+    if (lastModified >= 0 && isHeuristicallyCacheable(response.status) && date > lastModified) {
+        return std::min((date - lastModified) / 10, kMaxHeuristicFreshnessMs);
+    }
+    return 0;
+}
+
+int64_t HttpCache::Entry::currentAgeMs(int64_t now) const {
+    int64_t dateValue = parseHttpDate(response.header("date"));
+    if (dateValue < 0) {
+        dateValue = responseTimeMs;
+    }
+    int64_t ageValue = std::max<int64_t>(0, parseDeltaSeconds(response.header("age"))) * 1000;
+    int64_t apparentAge = std::max<int64_t>(0, responseTimeMs - dateValue);
+    int64_t responseDelay = responseTimeMs - requestTimeMs;
+    int64_t correctedAgeValue = ageValue + responseDelay;
+    int64_t correctedInitialAge = std::max(apparentAge, correctedAgeValue);
+    int64_t residentTime = now - responseTimeMs;
+    return correctedInitialAge + residentTime;
+}
+
+// ---- HttpCache ----
+
+HttpCache& HttpCache::instance() {
+    // Intentionally leaked: background revalidation threads may outlive static destruction
+    static HttpCache* cache = new HttpCache();
+    return *cache;
+}
+
+void HttpCache::configure(const std::string& directory, size_t memoryBudgetBytes, size_t diskBudgetBytes) {
+    std::vector<DiskRecord> records;
+    if (!directory.empty()) {
+        mkdir(directory.c_str(), 0700);
+        records = scanDisk(directory);
+    }
+
+    std::vector<DiskRemoval> removals;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!disk_.empty()) {
+            eraseDiskLocked(disk_.begin()->first, nullptr);
+        }
+        directory_ = directory;
+        memoryBudget_ = memoryBudgetBytes;
+        diskBudget_ = diskBudgetBytes;
+        for (DiskRecord& record : records) {
+            std::shared_ptr<const Entry> meta = record.meta;
+            diskBytes_ += record.fileBytes;
+            disk_[meta->key] = std::move(record);
+            addVariantLocked(*meta);
+        }
+        evictDiskLocked(&removals);
+        evictMemoryLocked();
+        LOGI("HTTP cache configured: dir='%s', memory=%zu, disk=%zu (%zu entries on disk)",
+             directory_.c_str(), memoryBudget_, diskBudget_, disk_.size());
+    }
+    applyDiskChanges({}, std::move(removals));
+}
+
+void HttpCache::setBackgroundNetwork(HttpNetworkFunction network) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    backgroundNetwork_ = std::move(network);
+}
+
+HttpResponse HttpCache::fetch(const HttpRequest& request, const HttpNetworkFunction& network) {
+    if (request.method != "GET") {
+        HttpResponse response = network(request);
+        // Unsafe methods invalidate the target URI (RFC 9111 section 4.4)
+        if (request.method != "HEAD" && request.method != "OPTIONS" &&
+            response.status >= 200 && response.status < 400) {
+            invalidate(request.url);
+        }
+        return response;
+    }
+
+    // Caller-driven conditional requests and no-store bypass the cache entirely
+    if (request.cacheMode == "no-store" ||
+        !request.header("if-none-match").empty() || !request.header("if-modified-since").empty()) {
+        return network(request);
+    }
+
+    int64_t now = nowMs();
+    std::shared_ptr<const Entry> entry;
+    if (request.cacheMode != "reload") {
+        entry = find(request);
+    }
+
+    if (entry) {
+        if (request.cacheMode == "force-cache" || request.cacheMode == "only-if-cached") {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.hits++;
+            return responseFromEntry(*entry, "HIT", now);
+        }
+        if (request.cacheMode != "no-cache") {
+            switch (freshness(*entry, now)) {
+                case Freshness::Fresh: {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    stats_.hits++;
+                    return responseFromEntry(*entry, "HIT", now);
+                }
+                case Freshness::StaleWhileRevalidate: {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        stats_.staleServed++;
+                    }
+                    revalidateInBackground(request, entry);
+                    return responseFromEntry(*entry, "STALE", now);
+                }
+                case Freshness::Stale:
+                    break;
+            }
+        }
+        return revalidate(request, entry, network, true);
+    }
+
+    if (request.cacheMode == "only-if-cached") {
+        HttpResponse response;
+        response.status = 504;
+        response.statusText = "Gateway Timeout";
+        response.url = request.url;
+        return response;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.misses++;
+    }
+    int64_t requestTime = nowMs();
+    HttpResponse response = network(request);
+    store(request, response, requestTime, nowMs());
+    response.setHeader("x-cache", "MISS");
+    return response;
+}
+
+HttpResponse HttpCache::revalidate(const HttpRequest& request, const std::shared_ptr<const Entry>& entry,
+                                   const HttpNetworkFunction& network, bool allowStaleOnError) {
+    HttpRequest conditional = request;
+    std::string etag = entry->response.header("etag");
+    std::string lastModified = entry->response.header("last-modified");
+    if (!etag.empty()) {
+        conditional.setHeader("If-None-Match", etag);
+    }
+    if (!lastModified.empty()) {
+        conditional.setHeader("If-Modified-Since", lastModified);
+    }
+
+    int64_t requestTime = nowMs();
+    HttpResponse response = network(conditional);
+    int64_t responseTime = nowMs();
+
+    if (response.status == 304) {
+        std::shared_ptr<const Entry> refreshed = freshen(*entry, response, requestTime, responseTime);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.revalidations++;
+        }
+        return responseFromEntry(*refreshed, "REVALIDATED", responseTime);
+    }
+
+    // status 0 means the origin could not be reached at all
+    bool failed = response.status == 0 || response.status >= 500;
+    if (failed && allowStaleOnError && canServeStaleOnError(*entry, responseTime, response.status == 0)) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.staleServed++;
+        }
+        return responseFromEntry(*entry, "STALE", responseTime);
+    }
+
+    if (!failed) {
+        store(request, response, requestTime, responseTime);
+    }
+    response.setHeader("x-cache", "UPDATED");
+    return response;
+}
+
+void HttpCache::revalidateInBackground(const HttpRequest& request, std::shared_ptr<const Entry> entry) {
+    HttpNetworkFunction network;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!backgroundNetwork_ || !revalidating_.insert(entry->key).second) {
+            return;
+        }
+        network = backgroundNetwork_;
+    }
+
+    std::string key = entry->key;
+    std::thread([this, request, entry, network, key]() {
+        revalidate(request, entry, network, false);
+        std::lock_guard<std::mutex> lock(mutex_);
+        revalidating_.erase(key);
+    }).detach();
+}
+
+HttpCache::Freshness HttpCache::freshness(const Entry& entry, int64_t now) const {
+    int64_t lifetime = entry.freshnessLifetimeMs();
+    int64_t age = entry.currentAgeMs(now);
+    if (age < lifetime) {
+        return Freshness::Fresh;
+    }
+    const CacheControl& cc = entry.cacheControl;
+    if (!cc.mustRevalidate && !cc.noCache && cc.staleWhileRevalidate >= 0 &&
+        age - lifetime <= cc.staleWhileRevalidate * 1000) {
+        return Freshness::StaleWhileRevalidate;
+    }
+    return Freshness::Stale;
+}
+
+bool HttpCache::canServeStaleOnError(const Entry& entry, int64_t now, bool disconnected) const {
+    const CacheControl& cc = entry.cacheControl;
+    if (cc.mustRevalidate || cc.noCache) {
+        return false;
+    }
+    if (cc.staleIfError >= 0) {
+        return entry.currentAgeMs(now) - entry.freshnessLifetimeMs() <= cc.staleIfError * 1000;
+    }
+    // Without stale-if-error, stale content may only be used while disconnected
+    return disconnected;
+}
+
+HttpResponse HttpCache::responseFromEntry(const Entry& entry, const char* cacheStatus, int64_t now) const {
+    HttpResponse response = entry.response;
+    response.setHeader("age", std::to_string(std::max<int64_t>(0, entry.currentAgeMs(now) / 1000)));
+    response.setHeader("x-cache", cacheStatus);
+    return response;
+}
+
+std::shared_ptr<const HttpCache::Entry> HttpCache::find(const HttpRequest& request) {
+    std::shared_ptr<const Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto variants = variants_.find(request.url);
+        if (variants == variants_.end()) {
+            return nullptr;
+        }
+        for (const std::string& key : variants->second) {
+            auto memory = index_.find(key);
+            if (memory != index_.end()) {
+                if (varyMatches(**memory->second, request)) {
+                    lru_.splice(lru_.begin(), lru_, memory->second);
+                    return *memory->second;
+                }
+                continue;
+            }
+            auto disk = disk_.find(key);
+            if (disk != disk_.end() && varyMatches(*disk->second.meta, request)) {
+                disk->second.lastUsedMs = nowMs();
+                entry = disk->second.meta;
+                break;
+            }
+        }
+    }
+    return entry ? loadBody(entry) : nullptr;
+}
+
+// Read the body of an entry found through the disk index. nullptr if its
+// file was evicted or holds something else by now.
+std::shared_ptr<const HttpCache::Entry> HttpCache::loadBody(const std::shared_ptr<const Entry>& entry) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = disk_.find(entry->key);
+        if (it == disk_.end()) {
+            return nullptr;
+        }
+        path = it->second.path;
+    }
+
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return nullptr;
+    }
+    std::string contents;
+    char buf[8192];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        contents.append(buf, n);
+    }
+    fclose(f);
+
+    auto loaded = std::make_shared<Entry>();
+    size_t headerSize = 0;
+    if (!parseEntryHeader(contents, loaded.get(), &headerSize) || loaded->key != entry->key) {
+        // Corrupt file or hash collision with another entry
+        return nullptr;
+    }
+    loaded->response.body = contents.substr(headerSize);
+    loaded->sizeBytes = entrySize(*loaded);
+    utime(path.c_str(), nullptr);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (disk_.count(loaded->key)) {
+        insertMemoryLocked(loaded);
+    }
+    return loaded;
+}
+
+std::shared_ptr<const HttpCache::Entry> HttpCache::store(const HttpRequest& request, const HttpResponse& response,
+                                                         int64_t requestTimeMs, int64_t responseTimeMs) {
+    CacheControl cc = CacheControl::parse(response.header("cache-control"));
+    CacheControl requestCc = CacheControl::parse(request.header("cache-control"));
+    std::string vary = response.header("vary");
+
+    if (!isUnderstoodStatus(response.status) || cc.noStore || requestCc.noStore || trim(vary) == "*") {
+        return nullptr;
+    }
+    if (!request.header("authorization").empty() && !cc.isPublic && !cc.mustRevalidate) {
+        return nullptr;
+    }
+    bool explicitFreshness = cc.maxAge >= 0 || !response.header("expires").empty();
+    if (!explicitFreshness && !isHeuristicallyCacheable(response.status)) {
+        return nullptr;
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->url = request.url;
+    entry->response = response;
+    removeHeader(entry->response.headers, "x-cache");
+    entry->cacheControl = cc;
+    entry->requestTimeMs = requestTimeMs;
+    entry->responseTimeMs = responseTimeMs;
+    std::set<std::string> varyNames;
+    for (const std::string& name : splitList(vary)) {
+        varyNames.insert(toLower(name));
+    }
+    for (const std::string& name : varyNames) {
+        entry->varyRequestHeaders.emplace_back(name, normalizeHeaderValue(request.header(name)));
+    }
+    entry->key = entryKey(entry->url, entry->varyRequestHeaders);
+    entry->sizeBytes = entrySize(*entry);
+    std::string header = entryHeader(*entry);
+
+    std::vector<DiskWrite> writes;
+    std::vector<DiskRemoval> removals;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        insertLocked(entry, std::move(header), &writes, &removals);
+        stats_.stores++;
+    }
+    applyDiskChanges(std::move(writes), std::move(removals));
+    return entry;
+}
+
+std::shared_ptr<const HttpCache::Entry> HttpCache::freshen(const Entry& entry, const HttpResponse& notModified,
+                                                           int64_t requestTimeMs, int64_t responseTimeMs) {
+    auto refreshed = std::make_shared<Entry>(entry);
+    // RFC 9111 section 3.2: replace stored header fields with those from the 304
+    for (const auto& h : notModified.headers) {
+        if (h.first == "content-length" || h.first == "x-cache") {
+            continue;
+        }
+        replaceHeader(refreshed->response.headers, h.first, h.second);
+    }
+    refreshed->cacheControl = CacheControl::parse(refreshed->response.header("cache-control"));
+    refreshed->requestTimeMs = requestTimeMs;
+    refreshed->responseTimeMs = responseTimeMs;
+    refreshed->sizeBytes = entrySize(*refreshed);
+    std::string header = entryHeader(*refreshed);
+
+    std::vector<DiskWrite> writes;
+    std::vector<DiskRemoval> removals;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        insertLocked(refreshed, std::move(header), &writes, &removals);
+    }
+    applyDiskChanges(std::move(writes), std::move(removals));
+    return refreshed;
+}
+
+// Drops every Vary variant of url
+void HttpCache::invalidate(const std::string& url) {
+    std::vector<DiskRemoval> removals;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = variants_.find(url);
+        if (it == variants_.end()) {
+            return;
+        }
+        std::vector<std::string> keys = it->second;
+        for (const std::string& key : keys) {
+            eraseMemoryLocked(key);
+            eraseDiskLocked(key, &removals);
+        }
+        variants_.erase(url);
+    }
+    applyDiskChanges({}, std::move(removals));
+}
+
+void HttpCache::clear() {
+    std::vector<DiskRemoval> removals;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lru_.clear();
+        index_.clear();
+        memoryBytes_ = 0;
+        while (!disk_.empty()) {
+            eraseDiskLocked(disk_.begin()->first, &removals);
+        }
+        variants_.clear();
+    }
+    applyDiskChanges({}, std::move(removals));
+    LOGI("HTTP cache cleared");
+}
+
+HttpCache::Stats HttpCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = stats_;
+    s.memoryEntries = index_.size();
+    s.memoryBytes = memoryBytes_;
+    s.diskEntries = disk_.size();
+    s.diskBytes = diskBytes_;
+    return s;
+}
+
+// Puts entry in the memory tier and queues its file; the previous version
+// of the same key is replaced in both tiers
+void HttpCache::insertLocked(const std::shared_ptr<const Entry>& entry, std::string header,
+                             std::vector<DiskWrite>* writes, std::vector<DiskRemoval>* removals) {
+    insertMemoryLocked(entry);
+
+    size_t fileBytes = header.size() + entry->response.body.size();
+    if (!directory_.empty() && fileBytes <= diskBudget_ / 4) {
+        DiskRecord& record = disk_[entry->key];
+        diskBytes_ = diskBytes_ - record.fileBytes + fileBytes;
+        record.meta = metadataOf(*entry);
+        record.path = diskPath(entry->key);
+        record.fileBytes = fileBytes;
+        record.generation = ++diskGeneration_;
+        record.lastUsedMs = nowMs();
+        writes->push_back(DiskWrite{entry, std::move(header), record.path, record.generation});
+        evictDiskLocked(removals);
+    } else {
+        eraseDiskLocked(entry->key, removals);
+    }
+
+    if (index_.count(entry->key) || disk_.count(entry->key)) {
+        addVariantLocked(*entry);
+    }
+}
+
+void HttpCache::insertMemoryLocked(const std::shared_ptr<const Entry>& entry) {
+    eraseMemoryLocked(entry->key);
+    // Very large bodies stay on disk only so they cannot flush the whole memory tier
+    if (entry->sizeBytes > memoryBudget_ / 4) {
+        return;
+    }
+    lru_.push_front(entry);
+    index_[entry->key] = lru_.begin();
+    memoryBytes_ += entry->sizeBytes;
+    evictMemoryLocked();
+}
+
+void HttpCache::evictMemoryLocked() {
+    while (memoryBytes_ > memoryBudget_ && !lru_.empty()) {
+        std::shared_ptr<const Entry> victim = lru_.back();
+        memoryBytes_ -= victim->sizeBytes;
+        index_.erase(victim->key);
+        lru_.pop_back();
+        if (!disk_.count(victim->key)) {
+            dropVariantLocked(*victim);
+        }
+    }
+}
+
+// Leaves the Vary bookkeeping to the caller
+void HttpCache::eraseMemoryLocked(const std::string& key) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        memoryBytes_ -= (*it->second)->sizeBytes;
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+}
+
+void HttpCache::evictDiskLocked(std::vector<DiskRemoval>* removals) {
+    if (diskBytes_ <= diskBudget_) {
+        return;
+    }
+    // Least recently used first; reads refresh lastUsedMs
+    std::vector<std::pair<int64_t, std::string>> records;
+    for (const auto& record : disk_) {
+        records.emplace_back(record.second.lastUsedMs, record.first);
+    }
+    std::sort(records.begin(), records.end());
+    for (const auto& record : records) {
+        if (diskBytes_ <= diskBudget_) {
+            break;
+        }
+        eraseDiskLocked(record.second, removals);
+    }
+}
+
+// Drops key from the disk index; removals (if given) gets its file to delete
+void HttpCache::eraseDiskLocked(const std::string& key, std::vector<DiskRemoval>* removals) {
+    auto it = disk_.find(key);
+    if (it == disk_.end()) {
+        return;
+    }
+    std::shared_ptr<const Entry> meta = it->second.meta;
+    diskBytes_ -= it->second.fileBytes;
+    if (removals) {
+        removals->push_back(DiskRemoval{key, it->second.path});
+    }
+    disk_.erase(it);  // may own key
+    if (!index_.count(meta->key)) {
+        dropVariantLocked(*meta);
+    }
+}
+
+void HttpCache::addVariantLocked(const Entry& entry) {
+    std::vector<std::string>& keys = variants_[entry.url];
+    if (std::find(keys.begin(), keys.end(), entry.key) == keys.end()) {
+        keys.push_back(entry.key);
+    }
+}
+
+void HttpCache::dropVariantLocked(const Entry& entry) {
+    auto it = variants_.find(entry.url);
+    if (it == variants_.end()) {
+        return;
+    }
+    std::vector<std::string>& keys = it->second;
+    keys.erase(std::remove(keys.begin(), keys.end(), entry.key), keys.end());
+    if (keys.empty()) {
+        variants_.erase(it);
+    }
+}
+
+std::string HttpCache::diskPath(const std::string& key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.entry", (unsigned long long)fnv1a64(key));
+    return directory_ + "/" + name;
+}
+
+// Runs without mutex_. A file is written under a temporary name first and
+// renamed into place only if no newer write or removal of its key was
+// queued meanwhile; a file is only deleted if its key was not stored again.
+void HttpCache::applyDiskChanges(std::vector<DiskWrite> writes, std::vector<DiskRemoval> removals) {
+    for (const DiskWrite& write : writes) {
+        const Entry& entry = *write.entry;
+        std::string tmpPath = write.path + ".tmp" + std::to_string(write.generation);
+        FILE* f = fopen(tmpPath.c_str(), "wb");
+        bool ok = f != nullptr;
+        if (f) {
+            ok = fwrite(write.header.data(), 1, write.header.size(), f) == write.header.size() &&
+                 fwrite(entry.response.body.data(), 1, entry.response.body.size(), f) == entry.response.body.size();
+            ok = (fclose(f) == 0) && ok;
+        }
+
+        std::lock_guard<std::mutex> diskLock(diskMutex_);
+        auto isCurrent = [&]() {
+            auto it = disk_.find(entry.key);
+            return it != disk_.end() && it->second.generation == write.generation;
+        };
+        bool current;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            current = isCurrent();
+        }
+        if (current && ok && rename(tmpPath.c_str(), write.path.c_str()) == 0) {
+            continue;
+        }
+        unlink(tmpPath.c_str());
+        if (current) {
+            LOGE("Failed to write cache file %s", write.path.c_str());
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                current = isCurrent();
+                if (current) {
+                    eraseDiskLocked(entry.key, nullptr);
+                }
+            }
+            if (current) {
+                unlink(write.path.c_str());
+            }
+        }
+    }
+
+    for (const DiskRemoval& removal : removals) {
+        std::lock_guard<std::mutex> diskLock(diskMutex_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = disk_.find(removal.key);
+            if (it != disk_.end() && it->second.path == removal.path) {
+                continue;
+            }
+        }
+        unlink(removal.path.c_str());
+    }
+}
+
+// Indexes the entry files of directory; runs before the cache uses it, so
+// without mutex_. Files from an older format and leftovers of interrupted
+// writes are deleted.
+std::vector<HttpCache::DiskRecord> HttpCache::scanDisk(const std::string& directory) const {
+    std::vector<DiskRecord> records;
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        LOGE("Failed to open HTTP cache directory %s", directory.c_str());
+        return records;
+    }
+    struct dirent* de;
+    while ((de = readdir(dir)) != nullptr) {
+        std::string name = de->d_name;
+        std::string path = directory + "/" + name;
+        if (name.find(".entry.tmp") != std::string::npos) {
+            unlink(path.c_str());
+            continue;
+        }
+        if (name.size() < 6 || name.compare(name.size() - 6, 6, ".entry") != 0) {
+            continue;
+        }
+        struct stat st;
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f || fstat(fileno(f), &st) != 0) {
+            if (f) {
+                fclose(f);
+            }
+            continue;
+        }
+        // Magic and metadata lines only
+        std::string header;
+        int c;
+        int lines = 0;
+        while (lines < 2 && (c = fgetc(f)) != EOF) {
+            header += (char)c;
+            lines += c == '\n';
+        }
+        fclose(f);
+
+        auto meta = std::make_shared<Entry>();
+        size_t headerSize = 0;
+        if (!parseEntryHeader(header, meta.get(), &headerSize)) {
+            unlink(path.c_str());
+            continue;
+        }
+        meta->sizeBytes = entrySize(*meta) + ((size_t)st.st_size - headerSize);
+        meta->bodyOnDisk = true;
+
+        DiskRecord record;
+        record.meta = meta;
+        record.path = path;
+        record.fileBytes = (size_t)st.st_size;
+        record.lastUsedMs = (int64_t)st.st_mtime * 1000;
+        records.push_back(std::move(record));
+    }
+    closedir(dir);
+    return records;
+}
@@ -0,0 +1,204 @@
+#ifndef HTTP_CACHE_H
+#define HTTP_CACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "json_util.h"
+
+typedef std::vector<std::pair<std::string, std::string>> HttpHeaders;
+
+// Request as issued by the fetch/XMLHttpRequest polyfills
+struct HttpRequest {
+    std::string url;
+    std::string method = "GET";
+    HttpHeaders headers;
+    // fetch() RequestInit.cache: default, no-store, reload, no-cache, force-cache, only-if-cached
+    std::string cacheMode = "default";
+    // Original options object, forwarded to HttpService with our header changes applied
+    JsonValue options;
+
+    static HttpRequest fromOptions(const std::string& url, const std::string& optionsJson);
+
+    // Case-insensitive header lookup, empty string if absent
+    std::string header(const std::string& name) const;
+    void setHeader(const std::string& name, const std::string& value);
+
+    // Options JSON for HttpService.parseRequestOptions
+    std::string toOptionsJson() const;
+};
+
+// Response in the shape returned by HttpService.responseToJson
+struct HttpResponse {
+    int status = 0;
+    std::string statusText;
+    std::string url;
+    std::string type = "basic";
+    bool redirected = false;
+    HttpHeaders headers;  // names are lower-cased
+    std::string body;
+
+    static bool fromJson(const std::string& json, HttpResponse* out);
+    static HttpResponse networkError(const std::string& url, const std::string& statusText);
+
+    bool ok() const { return status >= 200 && status <= 299; }
+    std::string header(const std::string& name) const;
+    void setHeader(const std::string& name, const std::string& value);
+    std::string toJson() const;
+};
+
+// Parsed Cache-Control directives relevant to a private client cache
+struct CacheControl {
+    int64_t maxAge = -1;               // seconds, -1 if absent
+    int64_t staleWhileRevalidate = -1;
+    int64_t staleIfError = -1;
+    bool noCache = false;
+    bool noStore = false;
+    bool mustRevalidate = false;
+    bool isPublic = false;
+
+    static CacheControl parse(const std::string& value);
+};
+
+// Network round trip used on cache misses and revalidation
+typedef std::function<HttpResponse(const HttpRequest&)> HttpNetworkFunction;
+
+/**
+ * Native RFC 9111 HTTP cache shared by every JS runtime in the process.
+ *
+ * Entries live in an LRU memory tier and, once a directory is configured,
+ * are written through to a disk tier so they survive restarts. The
+ * metadata of every disk entry stays indexed in memory, so only serving a
+ * body that is not in the memory tier reads a file, and no file is read or
+ * written under the cache lock. Each URL keeps one entry per combination
+ * of the request header values its Vary names (section 4.1). Freshness
+ * follows RFC 9111 section 4.2 (max-age, Expires, heuristic from
+ * Last-Modified) with Age/Date correction; stale entries are revalidated
+ * with If-None-Match/If-Modified-Since, and stale-while-revalidate /
+ * stale-if-error are honoured unless the response forbids it.
+ */
+class HttpCache {
+public:
+    struct Entry {
+        std::string key;                 // url plus the normalized Vary request headers
+        std::string url;
+        HttpResponse response;
+        HttpHeaders varyRequestHeaders;  // normalized request header values selected by Vary
+        CacheControl cacheControl;
+        int64_t requestTimeMs = 0;
+        int64_t responseTimeMs = 0;
+        size_t sizeBytes = 0;
+        bool bodyOnDisk = false;         // metadata only; loadBody() reads the rest
+
+        int64_t freshnessLifetimeMs() const;
+        int64_t currentAgeMs(int64_t nowMs) const;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t revalidations = 0;    // 304 responses that refreshed an entry
+        uint64_t staleServed = 0;      // stale-while-revalidate and stale-if-error
+        uint64_t stores = 0;
+        size_t memoryEntries = 0;
+        size_t memoryBytes = 0;
+        size_t diskEntries = 0;
+        size_t diskBytes = 0;
+    };
+
+    static HttpCache& instance();
+
+    // Enables the disk tier under directory (empty string disables it)
+    void configure(const std::string& directory, size_t memoryBudgetBytes, size_t diskBudgetBytes);
+
+    // Network function used for background stale-while-revalidate refreshes.
+    // It runs on a detached thread and must be safe to call from there.
+    void setBackgroundNetwork(HttpNetworkFunction network);
+
+    // Serve request from the cache where RFC 9111 allows, otherwise through network
+    HttpResponse fetch(const HttpRequest& request, const HttpNetworkFunction& network);
+
+    void clear();
+    Stats stats() const;
+
+private:
+    enum class Freshness { Fresh, StaleWhileRevalidate, Stale };
+
+    HttpCache() = default;
+
+    // Files to write or delete once the lock is released. Files are only
+    // renamed into place or deleted under diskMutex_, after checking that
+    // the index still expects them.
+    struct DiskWrite {
+        std::shared_ptr<const Entry> entry;
+        std::string header;
+        std::string path;
+        uint64_t generation = 0;
+    };
+    struct DiskRemoval {
+        std::string key;
+        std::string path;
+    };
+    struct DiskRecord {
+        std::shared_ptr<const Entry> meta;
+        std::string path;
+        size_t fileBytes = 0;
+        uint64_t generation = 0;  // of the latest write; older writers drop their file
+        int64_t lastUsedMs = 0;
+    };
+    typedef std::list<std::shared_ptr<const Entry>> LruList;
+
+    std::shared_ptr<const Entry> find(const HttpRequest& request);
+    std::shared_ptr<const Entry> loadBody(const std::shared_ptr<const Entry>& entry);
+    std::shared_ptr<const Entry> store(const HttpRequest& request, const HttpResponse& response,
+                                       int64_t requestTimeMs, int64_t responseTimeMs);
+    std::shared_ptr<const Entry> freshen(const Entry& entry, const HttpResponse& notModified,
+                                         int64_t requestTimeMs, int64_t responseTimeMs);
+    void invalidate(const std::string& url);
+    void revalidateInBackground(const HttpRequest& request, std::shared_ptr<const Entry> entry);
+    HttpResponse revalidate(const HttpRequest& request, const std::shared_ptr<const Entry>& entry,
+                            const HttpNetworkFunction& network, bool allowStaleOnError);
+
+    Freshness freshness(const Entry& entry, int64_t nowMs) const;
+    bool canServeStaleOnError(const Entry& entry, int64_t nowMs, bool disconnected) const;
+    HttpResponse responseFromEntry(const Entry& entry, const char* cacheStatus, int64_t nowMs) const;
+
+    void insertLocked(const std::shared_ptr<const Entry>& entry, std::string header,
+                      std::vector<DiskWrite>* writes, std::vector<DiskRemoval>* removals);
+    void insertMemoryLocked(const std::shared_ptr<const Entry>& entry);
+    void evictMemoryLocked();
+    void eraseMemoryLocked(const std::string& key);
+    void evictDiskLocked(std::vector<DiskRemoval>* removals);
+    void eraseDiskLocked(const std::string& key, std::vector<DiskRemoval>* removals);
+    void addVariantLocked(const Entry& entry);
+    void dropVariantLocked(const Entry& entry);
+    std::string diskPath(const std::string& key) const;
+    void applyDiskChanges(std::vector<DiskWrite> writes, std::vector<DiskRemoval> removals);
+    std::vector<DiskRecord> scanDisk(const std::string& directory) const;
+
+    mutable std::mutex mutex_;
+    std::mutex diskMutex_;  // orders renames and deletions of entry files
+    LruList lru_;           // most recently used first
+    std::unordered_map<std::string, LruList::iterator> index_;
+    std::unordered_map<std::string, DiskRecord> disk_;
+    std::unordered_map<std::string, std::vector<std::string>> variants_;  // url -> entry keys
+    std::set<std::string> revalidating_;
+    HttpNetworkFunction backgroundNetwork_;
+    std::string directory_;
+    size_t memoryBudget_ = 8 * 1024 * 1024;
+    size_t diskBudget_ = 32 * 1024 * 1024;
+    size_t memoryBytes_ = 0;
+    size_t diskBytes_ = 0;
+    uint64_t diskGeneration_ = 0;
+    Stats stats_;
+};
+
+#endif // HTTP_CACHE_H
@@ -0,0 +1,244 @@
+#include <cstring>
+#include <string>
+
+#include "http_polyfill.h"
+#include "http_cache.h"
+#include "http_transport.h"
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOG_TAG "QuickJSTest"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGE(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#endif
+
+// Route a request through whichever transport is installed (JNI, record or replay)
+static HttpResponse sendThroughCurrentTransport(const HttpRequest &request, std::string *error) {
+    std::shared_ptr<HttpTransport> transport = HttpTransport::current();
+    if (!transport) {
+        *error = "HTTP service not available";
+        return HttpResponse::networkError(request.url, *error);
+    }
+    return transport->send(request, error);
+}
+
+// Convert a native response to the object shape the polyfills expect
+static JSValue httpResponseToJS(JSContext *ctx, const HttpResponse &response) {
+    JSValue obj = JS_NewObject(ctx);
+    JS_SetPropertyStr(ctx, obj, "status", JS_NewInt32(ctx, response.status));
+    JS_SetPropertyStr(ctx, obj, "statusText", JS_NewStringLen(ctx, response.statusText.data(), response.statusText.size()));
+    JS_SetPropertyStr(ctx, obj, "ok", JS_NewBool(ctx, response.ok()));
+    JS_SetPropertyStr(ctx, obj, "redirected", JS_NewBool(ctx, response.redirected));
+    JS_SetPropertyStr(ctx, obj, "url", JS_NewStringLen(ctx, response.url.data(), response.url.size()));
+    JS_SetPropertyStr(ctx, obj, "type", JS_NewStringLen(ctx, response.type.data(), response.type.size()));
+    JS_SetPropertyStr(ctx, obj, "body", JS_NewStringLen(ctx, response.body.data(), response.body.size()));
+    
+    JSValue headers = JS_NewObject(ctx);
+    for (const auto &header : response.headers) {
+        JS_SetPropertyStr(ctx, headers, header.first.c_str(),
+            JS_NewStringLen(ctx, header.second.data(), header.second.size()));
+    }
+    JS_SetPropertyStr(ctx, obj, "headers", headers);
+    return obj;
+}
+
+// Native HTTP request function (called from JavaScript)
+static JSValue js_http_request(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    (void)this_val;
+    if (argc < 1) {
+        return JS_ThrowReferenceError(ctx, "HTTP service not available");
+    }
+    
+    // Get URL from first argument
+    const char *url = JS_ToCString(ctx, argv[0]);
+    if (!url) {
+        return JS_ThrowTypeError(ctx, "URL must be a string");
+    }
+    
+    // Get options from second argument (or empty object)
+    const char *options = "{}";
+    if (argc > 1) {
+        options = JS_ToCString(ctx, argv[1]);
+        if (!options) {
+            JS_FreeCString(ctx, url);
+            return JS_ThrowTypeError(ctx, "Options must be an object");
+        }
+    }
+    
+    HttpRequest request = HttpRequest::fromOptions(url, options);
+    JS_FreeCString(ctx, url);
+    if (argc > 1) JS_FreeCString(ctx, options);
+    
+    // Cache hits are answered here without reaching the transport
+    std::string networkError;
+    HttpResponse response = HttpCache::instance().fetch(request, [&networkError](const HttpRequest &req) {
+        return sendThroughCurrentTransport(req, &networkError);
+    });
+    
+    if (response.status == 0 && !networkError.empty()) {
+        return JS_ThrowInternalError(ctx, "%s", networkError.c_str());
+    }
+    
+    return httpResponseToJS(ctx, response);
+}
+
+// Add HTTP polyfills to QuickJS context
+void addHttpPolyfills(JSContext *ctx) {
+    HttpCache::instance().setBackgroundNetwork([](const HttpRequest &request) {
+        std::string error;
+        return sendThroughCurrentTransport(request, &error);
+    });
+    
+    // Add native HTTP request function
+    JSValue global = JS_GetGlobalObject(ctx);
+    JS_SetPropertyStr(ctx, global, "_nativeHttpRequest", 
+        JS_NewCFunction(ctx, js_http_request, "_nativeHttpRequest", 2));
+    
+    // Add fetch polyfill
+    const char *fetchPolyfill = R"(
+(function() {
+    // Fetch API polyfill
+    globalThis.fetch = function(url, options) {
+        options = options || {};
+        
+        return new Promise(function(resolve, reject) {
+            try {
+                var requestOptions = {
+                    method: options.method || 'GET',
+                    headers: options.headers || {},
+                    body: options.body || null,
+                    timeout: options.timeout || 30000,
+                    redirect: options.redirect || 'follow',
+                    credentials: options.credentials || 'same-origin',
+                    cache: options.cache || 'default'
+                };
+                
+                var response = _nativeHttpRequest(url, JSON.stringify(requestOptions));
+                
+                if (response && response.status !== undefined) {
+                    // Create Response object
+                    var responseObj = {
+                        status: response.status,
+                        statusText: response.statusText,
+                        ok: response.ok,
+                        redirected: response.redirected,
+                        url: response.url,
+                        type: response.type,
+                        headers: new Map(Object.entries(response.headers || {})),
+                        
+                        text: function() {
+                            return Promise.resolve(response.body || '');
+                        },
+                        
+                        json: function() {
+                            return Promise.resolve(JSON.parse(response.body || '{}'));
+                        },
+                        
+                        blob: function() {
+                            return Promise.reject(new Error('Blob not supported'));
+                        },
+                        
+                        arrayBuffer: function() {
+                            return Promise.reject(new Error('ArrayBuffer not supported'));
+                        }
+                    };
+                    
+                    resolve(responseObj);
+                } else {
+                    reject(new Error('Network request failed'));
+                }
+            } catch (e) {
+                reject(e);
+            }
+        });
+    };
+    
+    // XMLHttpRequest polyfill
+    globalThis.XMLHttpRequest = function() {
+        this.readyState = 0;
+        this.status = 0;
+        this.statusText = '';
+        this.responseText = '';
+        this.responseXML = null;
+        this.onreadystatechange = null;
+        this._method = 'GET';
+        this._url = '';
+        this._headers = {};
+        this._body = null;
+        
+        this.open = function(method, url, async) {
+            this._method = method;
+            this._url = url;
+            this.readyState = 1;
+            if (this.onreadystatechange) this.onreadystatechange();
+        };
+        
+        this.setRequestHeader = function(header, value) {
+            this._headers[header] = value;
+        };
+        
+        this.send = function(body) {
+            var self = this;
+            this._body = body;
+            this.readyState = 2;
+            if (this.onreadystatechange) this.onreadystatechange();
+            
+            try {
+                var options = {
+                    method: this._method,
+                    headers: this._headers,
+                    body: this._body
+                };
+                
+                var response = _nativeHttpRequest(this._url, JSON.stringify(options));
+                
+                this.status = response.status || 0;
+                this.statusText = response.statusText || '';
+                this.responseText = response.body || '';
+                this.readyState = 4;
+                
+                if (this.onreadystatechange) this.onreadystatechange();
+            } catch (e) {
+                this.status = 0;
+                this.statusText = 'Error';
+                this.responseText = '';
+                this.readyState = 4;
+                if (this.onreadystatechange) this.onreadystatechange();
+            }
+        };
+        
+        this.abort = function() {
+            this.readyState = 0;
+        };
+        
+        this.getAllResponseHeaders = function() {
+            return '';
+        };
+        
+        this.getResponseHeader = function(header) {
+            return null;
+        };
+    };
+    
+    // Constants
+    globalThis.XMLHttpRequest.UNSENT = 0;
+    globalThis.XMLHttpRequest.OPENED = 1;
+    globalThis.XMLHttpRequest.HEADERS_RECEIVED = 2;
+    globalThis.XMLHttpRequest.LOADING = 3;
+    globalThis.XMLHttpRequest.DONE = 4;
+})();
+)";
+    
+    JSValue result = JS_Eval(ctx, fetchPolyfill, strlen(fetchPolyfill), "<fetch-polyfill>", JS_EVAL_TYPE_GLOBAL);
+    if (JS_IsException(result)) {
+        JSValue exception = JS_GetException(ctx);
+        const char *exceptionStr = JS_ToCString(ctx, exception);
+        LOGE("Failed to add HTTP polyfills: %s", exceptionStr ? exceptionStr : "Unknown error");
+        if (exceptionStr) JS_FreeCString(ctx, exceptionStr);
+        JS_FreeValue(ctx, exception);
+    }
+    JS_FreeValue(ctx, result);
+    JS_FreeValue(ctx, global);
+}
@@ -0,0 +1,12 @@
+#ifndef HTTP_POLYFILL_H
+#define HTTP_POLYFILL_H
+
+extern "C" {
+#include "quickjs/quickjs.h"
+}
+
+// Install _nativeHttpRequest plus the fetch and XMLHttpRequest polyfills.
+// Requests go through HttpCache and then HttpTransport::current().
+void addHttpPolyfills(JSContext *ctx);
+
+#endif // HTTP_POLYFILL_H
@@ -0,0 +1,453 @@
+#include "http_transport.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOG_TAG "HttpTransport"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#define LOGE(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#endif
+
+namespace {
+
+std::mutex g_transportMutex;
+std::shared_ptr<HttpTransport> g_transport;
+
+int64_t steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string requestBody(const HttpRequest& request) {
+    return request.options.getString("body");
+}
+
+std::string exactKey(const std::string& method, const std::string& url, const std::string& body) {
+    return method + " " + url + "\n" + body;
+}
+
+std::string looseKey(const std::string& method, const std::string& url) {
+    return method + " " + url;
+}
+
+size_t requestSize(const HttpRequest& request) {
+    size_t size = request.method.size() + request.url.size() + 12;
+    for (const auto& h : request.headers) {
+        size += h.first.size() + h.second.size() + 4;
+    }
+    return size + requestBody(request).size();
+}
+
+size_t responseSize(const HttpResponse& response) {
+    size_t size = response.statusText.size() + 16;
+    for (const auto& h : response.headers) {
+        size += h.first.size() + h.second.size() + 4;
+    }
+    return size + response.body.size();
+}
+
+bool parseHttpUrl(const std::string& url, std::string* host, std::string* port, std::string* path) {
+    const std::string scheme = "http://";
+    if (url.compare(0, scheme.size(), scheme) != 0) {
+        return false;
+    }
+    size_t hostStart = scheme.size();
+    size_t pathStart = url.find('/', hostStart);
+    std::string authority = url.substr(hostStart, pathStart == std::string::npos ? std::string::npos : pathStart - hostStart);
+    *path = pathStart == std::string::npos ? "/" : url.substr(pathStart);
+    size_t hash = path->find('#');
+    if (hash != std::string::npos) {
+        path->erase(hash);
+    }
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos && authority.find(']', colon) == std::string::npos) {
+        *host = authority.substr(0, colon);
+        *port = authority.substr(colon + 1);
+    } else {
+        *host = authority;
+        *port = "80";
+    }
+    if (host->size() > 2 && (*host)[0] == '[') {
+        *host = host->substr(1, host->size() - 2);
+    }
+    return !host->empty();
+}
+
+bool decodeChunked(const std::string& raw, std::string* out) {
+    size_t pos = 0;
+    while (pos < raw.size()) {
+        size_t lineEnd = raw.find("\r\n", pos);
+        if (lineEnd == std::string::npos) {
+            return false;
+        }
+        size_t chunkSize = strtoul(raw.substr(pos, lineEnd - pos).c_str(), nullptr, 16);
+        pos = lineEnd + 2;
+        if (chunkSize == 0) {
+            return true;
+        }
+        if (pos + chunkSize > raw.size()) {
+            return false;
+        }
+        out->append(raw, pos, chunkSize);
+        pos += chunkSize + 2;
+    }
+    return false;
+}
+
+} // namespace
+
+// ---- HttpTransport ----
+
+std::shared_ptr<HttpTransport> HttpTransport::current() {
+    std::lock_guard<std::mutex> lock(g_transportMutex);
+    return g_transport;
+}
+
+void HttpTransport::setCurrent(std::shared_ptr<HttpTransport> transport) {
+    std::lock_guard<std::mutex> lock(g_transportMutex);
+    g_transport = std::move(transport);
+    LOGI("HTTP transport set to %s", g_transport ? g_transport->name() : "none");
+}
+
+// ---- NetworkProfile ----
+
+bool NetworkProfile::parse(const std::string& spec, NetworkProfile* out) {
+    // Round trip latency and throughput roughly follow the Chrome DevTools
+    // throttling presets so numbers are comparable with browser traces
+    struct Preset { const char* name; int64_t latencyMs; int64_t downKbps; int64_t upKbps; };
+    static const Preset presets[] = {
+        {"none",    0,    0,     0},
+        {"wifi",    20,   30000, 15000},
+        {"4g",      150,  1600,  750},
+        {"fast-3g", 563,  1440,  675},
+        {"slow-3g", 2000, 400,   400},
+    };
+    NetworkProfile profile;
+    profile.name = spec;
+    if (spec == "recorded") {
+        profile.useRecordedTiming = true;
+        *out = profile;
+        return true;
+    }
+    for (const Preset& preset : presets) {
+        if (spec == preset.name) {
+            profile.latencyMs = preset.latencyMs;
+            profile.downlinkKbps = preset.downKbps;
+            profile.uplinkKbps = preset.upKbps;
+            *out = profile;
+            return true;
+        }
+    }
+    long long latency = 0, down = 0, up = 0;
+    int fields = sscanf(spec.c_str(), "%lld:%lld:%lld", &latency, &down, &up);
+    if (fields < 2 || latency < 0 || down < 0 || up < 0) {
+        return false;
+    }
+    profile.latencyMs = latency;
+    profile.downlinkKbps = down;
+    profile.uplinkKbps = fields == 3 ? up : down;
+    *out = profile;
+    return true;
+}
+
+int64_t NetworkProfile::delayMs(size_t requestBytes, size_t responseBytes, int64_t recordedMs) const {
+    if (useRecordedTiming) {
+        return recordedMs;
+    }
+    int64_t delay = latencyMs;
+    // kbps is kilobits per second, i.e. bits per millisecond
+    if (uplinkKbps > 0) {
+        delay += (int64_t)(requestBytes * 8) / uplinkKbps;
+    }
+    if (downlinkKbps > 0) {
+        delay += (int64_t)(responseBytes * 8) / downlinkKbps;
+    }
+    return delay;
+}
+
+// ---- SocketHttpTransport ----
+
+HttpResponse SocketHttpTransport::send(const HttpRequest& request, std::string* error) {
+    std::string host, port, path;
+    if (!parseHttpUrl(request.url, &host, &port, &path)) {
+        *error = "Only http:// URLs are supported by the socket transport";
+        return HttpResponse::networkError(request.url, *error);
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+        return HttpResponse::networkError(request.url, "Network Error");
+    }
+
+    int64_t timeoutMs = (int64_t)request.options.getNumber("timeout", 30000);
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+
+    int fd = -1;
+    for (struct addrinfo* ai = addresses; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) {
+        return HttpResponse::networkError(request.url, "Network Error");
+    }
+
+    std::string body = requestBody(request);
+    std::string message = request.method + " " + path + " HTTP/1.1\r\n";
+    message += "Host: " + (port == "80" ? host : host + ":" + port) + "\r\n";
+    message += "Connection: close\r\n";
+    for (const auto& h : request.headers) {
+        if (strcasecmp(h.first.c_str(), "host") != 0 && strcasecmp(h.first.c_str(), "connection") != 0 &&
+            strcasecmp(h.first.c_str(), "content-length") != 0) {
+            message += h.first + ": " + h.second + "\r\n";
+        }
+    }
+    if (!body.empty() || (request.method != "GET" && request.method != "HEAD")) {
+        message += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    message += "\r\n";
+    message += body;
+
+    size_t sent = 0;
+    while (sent < message.size()) {
+        ssize_t n = ::send(fd, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            close(fd);
+            return HttpResponse::networkError(request.url, "Network Error");
+        }
+        sent += (size_t)n;
+    }
+
+    std::string raw;
+    char buf[16384];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        raw.append(buf, (size_t)n);
+    }
+    close(fd);
+
+    size_t headerEnd = raw.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) {
+        return HttpResponse::networkError(request.url, "Network Error");
+    }
+
+    HttpResponse response;
+    response.url = request.url;
+    size_t lineEnd = raw.find("\r\n");
+    std::string statusLine = raw.substr(0, lineEnd);
+    size_t sp1 = statusLine.find(' ');
+    if (sp1 == std::string::npos) {
+        return HttpResponse::networkError(request.url, "Network Error");
+    }
+    response.status = atoi(statusLine.c_str() + sp1 + 1);
+    size_t sp2 = statusLine.find(' ', sp1 + 1);
+    response.statusText = sp2 == std::string::npos ? "" : statusLine.substr(sp2 + 1);
+
+    size_t pos = lineEnd + 2;
+    while (pos < headerEnd) {
+        size_t end = raw.find("\r\n", pos);
+        std::string line = raw.substr(pos, end - pos);
+        pos = end + 2;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        std::string existing = response.header(line.substr(0, colon));
+        response.setHeader(line.substr(0, colon), existing.empty() ? value : existing + ", " + value);
+    }
+
+    std::string rawBody = raw.substr(headerEnd + 4);
+    if (request.method == "HEAD") {
+        return response;
+    }
+    if (strcasecmp(response.header("transfer-encoding").c_str(), "chunked") == 0) {
+        if (!decodeChunked(rawBody, &response.body)) {
+            return HttpResponse::networkError(request.url, "Network Error");
+        }
+    } else {
+        response.body = std::move(rawBody);
+    }
+    return response;
+}
+
+// ---- RecordingTransport ----
+
+RecordingTransport::RecordingTransport(std::shared_ptr<HttpTransport> upstream, const std::string& path)
+    : upstream_(std::move(upstream)), file_(fopen(path.c_str(), "a")) {
+    if (!file_) {
+        LOGE("Failed to open HTTP recording %s", path.c_str());
+    } else {
+        LOGI("Recording HTTP exchanges to %s", path.c_str());
+    }
+}
+
+RecordingTransport::~RecordingTransport() {
+    if (file_) {
+        fclose(file_);
+    }
+}
+
+size_t RecordingTransport::recorded() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return recorded_;
+}
+
+HttpResponse RecordingTransport::send(const HttpRequest& request, std::string* error) {
+    int64_t start = steadyNowMs();
+    HttpResponse response = upstream_->send(request, error);
+    int64_t elapsed = steadyNowMs() - start;
+    if (!error->empty() || !file_) {
+        return response;
+    }
+
+    std::string line = "{\"method\":";
+    appendJsonString(line, request.method);
+    line += ",\"url\":";
+    appendJsonString(line, request.url);
+    line += ",\"requestHeaders\":{";
+    for (size_t i = 0; i < request.headers.size(); i++) {
+        if (i) line += ",";
+        appendJsonString(line, request.headers[i].first);
+        line += ":";
+        appendJsonString(line, request.headers[i].second);
+    }
+    line += "},\"requestBody\":";
+    appendJsonString(line, requestBody(request));
+    line += ",\"elapsedMs\":" + std::to_string(elapsed);
+    line += ",\"response\":" + response.toJson() + "}\n";
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    fwrite(line.data(), 1, line.size(), file_);
+    fflush(file_);
+    recorded_++;
+    return response;
+}
+
+// ---- ReplayTransport ----
+
+int ReplayTransport::load(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file) {
+        LOGE("Failed to open HTTP recording %s", path.c_str());
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int loaded = 0;
+    int lineNumber = 0;
+    std::string line;
+    char buf[8192];
+    bool eof = false;
+    while (!eof) {
+        line.clear();
+        for (;;) {
+            if (!fgets(buf, sizeof(buf), file)) {
+                eof = true;
+                break;
+            }
+            line += buf;
+            if (!line.empty() && line.back() == '\n') {
+                break;
+            }
+        }
+        if (line.find_first_not_of(" \t\r\n") == std::string::npos) {
+            continue;
+        }
+        lineNumber++;
+
+        JsonValue exchange;
+        HttpResponse response;
+        const JsonValue* responseJson = nullptr;
+        if (!parseJson(line, &exchange) || !(responseJson = exchange.get("response")) ||
+            !HttpResponse::fromJson(toJson(*responseJson), &response)) {
+            LOGE("Skipping malformed exchange %d in %s", lineNumber, path.c_str());
+            continue;
+        }
+
+        std::string method = exchange.getString("method", "GET");
+        std::string url = exchange.getString("url");
+        Recording recording;
+        recording.response = std::move(response);
+        recording.elapsedMs = (int64_t)exchange.getNumber("elapsedMs", 0);
+        exact_[exactKey(method, url, exchange.getString("requestBody"))].recordings.push_back(recording);
+        loose_[looseKey(method, url)].recordings.push_back(std::move(recording));
+        loaded++;
+    }
+    fclose(file);
+    LOGI("Loaded %d HTTP exchanges from %s (profile %s)", loaded, path.c_str(), profile_.name.c_str());
+    return loaded;
+}
+
+ReplayTransport::Stats ReplayTransport::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void ReplayTransport::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = Stats();
+}
+
+HttpResponse ReplayTransport::send(const HttpRequest& request, std::string* error) {
+    Recording recording;
+    size_t sentBytes = requestSize(request);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.requests++;
+        auto it = exact_.find(exactKey(request.method, request.url, requestBody(request)));
+        if (it == exact_.end()) {
+            it = loose_.find(looseKey(request.method, request.url));
+            if (it == loose_.end()) {
+                stats_.misses++;
+                *error = "No recorded response for " + request.method + " " + request.url;
+                return HttpResponse::networkError(request.url, *error);
+            }
+        }
+        Slot& slot = it->second;
+        recording = slot.recordings[slot.next];
+        slot.next = (slot.next + 1) % slot.recordings.size();
+        stats_.bytesSent += sentBytes;
+        stats_.bytesReceived += responseSize(recording.response);
+    }
+
+    int64_t delay = profile_.delayMs(sentBytes, responseSize(recording.response), recording.elapsedMs);
+    if (delay > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.simulatedDelayMs += delay;
+    }
+
+    // Replayed conditional requests get the stored 200; the cache treats that
+    // as a full response, which is what a server ignoring validators sends
+    recording.response.url = request.url;
+    return recording.response;
+}
@@ -0,0 +1,127 @@
+#ifndef HTTP_TRANSPORT_H
+#define HTTP_TRANSPORT_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "http_cache.h"
+
+/**
+ * Network layer behind js_http_request.
+ *
+ * The active transport is process-wide and is called both from the JS
+ * thread and from HttpCache's stale-while-revalidate threads, so
+ * implementations must be thread-safe.
+ */
+class HttpTransport {
+public:
+    virtual ~HttpTransport() = default;
+
+    // Perform one round trip. A status 0 response is a network error that
+    // still reaches the script; error is set only when the transport could
+    // not run the request at all, which js_http_request turns into a throw.
+    virtual HttpResponse send(const HttpRequest& request, std::string* error) = 0;
+
+    virtual const char* name() const = 0;
+
+    static std::shared_ptr<HttpTransport> current();
+    static void setCurrent(std::shared_ptr<HttpTransport> transport);
+};
+
+// Simulated link characteristics applied when replaying
+struct NetworkProfile {
+    std::string name = "none";
+    int64_t latencyMs = 0;        // added once per request (round trip)
+    int64_t downlinkKbps = 0;     // 0 = unlimited
+    int64_t uplinkKbps = 0;       // 0 = unlimited
+    bool useRecordedTiming = false;
+
+    // Preset name (none, recorded, wifi, 4g, fast-3g, slow-3g) or
+    // "<latencyMs>:<downKbps>[:<upKbps>]"
+    static bool parse(const std::string& spec, NetworkProfile* out);
+
+    int64_t delayMs(size_t requestBytes, size_t responseBytes, int64_t recordedMs) const;
+};
+
+// Plain HTTP/1.1 over POSIX sockets (http:// only). Used by the host
+// benchmark to record against test-server/js_server.js without a device.
+class SocketHttpTransport : public HttpTransport {
+public:
+    HttpResponse send(const HttpRequest& request, std::string* error) override;
+    const char* name() const override { return "socket"; }
+};
+
+/**
+ * Forwards to another transport and appends every exchange to a JSON lines
+ * file: {"method","url","requestHeaders","requestBody","elapsedMs","response"}.
+ */
+class RecordingTransport : public HttpTransport {
+public:
+    RecordingTransport(std::shared_ptr<HttpTransport> upstream, const std::string& path);
+    ~RecordingTransport() override;
+
+    bool isOpen() const { return file_ != nullptr; }
+    size_t recorded() const;
+
+    HttpResponse send(const HttpRequest& request, std::string* error) override;
+    const char* name() const override { return "record"; }
+
+private:
+    std::shared_ptr<HttpTransport> upstream_;
+    mutable std::mutex mutex_;
+    FILE* file_;
+    size_t recorded_ = 0;
+};
+
+/**
+ * Serves exchanges captured by RecordingTransport from memory.
+ *
+ * Requests are matched on method, URL and body (falling back to method and
+ * URL); repeated requests cycle through the recordings in order. The
+ * network profile's delay is slept on the calling thread so scripts observe
+ * it the same way they would a real network.
+ */
+class ReplayTransport : public HttpTransport {
+public:
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t misses = 0;
+        uint64_t bytesSent = 0;
+        uint64_t bytesReceived = 0;
+        int64_t simulatedDelayMs = 0;
+    };
+
+    explicit ReplayTransport(const NetworkProfile& profile) : profile_(profile) {}
+
+    // Returns the number of exchanges loaded, or -1 if the file cannot be read
+    int load(const std::string& path);
+
+    Stats stats() const;
+    void resetStats();
+
+    HttpResponse send(const HttpRequest& request, std::string* error) override;
+    const char* name() const override { return "replay"; }
+
+private:
+    struct Recording {
+        HttpResponse response;
+        int64_t elapsedMs = 0;
+    };
+
+    struct Slot {
+        std::vector<Recording> recordings;
+        size_t next = 0;
+    };
+
+    NetworkProfile profile_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Slot> exact_;  // method, url and body
+    std::unordered_map<std::string, Slot> loose_;  // method and url
+    Stats stats_;
+};
+
+#endif // HTTP_TRANSPORT_H
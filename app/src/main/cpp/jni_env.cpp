@@ -0,0 +1,130 @@
+#include "jni_env.h"
+
+#include <pthread.h>
+#include <android/api-level.h>
+#include <android/log.h>
+
+#define LOG_TAG "JniEnv"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+JavaVM *g_jvm = nullptr;
+JniHandles g_jni;
+
+static thread_local JNIEnv *t_env = nullptr;
+static pthread_key_t g_detachKey;
+static pthread_once_t g_detachKeyOnce = PTHREAD_ONCE_INIT;
+
+// pthread key destructor: runs on exit of threads we attached
+static void detachExitingThread(void *value) {
+    if (g_jvm && value) {
+        g_jvm->DetachCurrentThread();
+    }
+}
+
+static void createDetachKey() {
+    pthread_key_create(&g_detachKey, detachExitingThread);
+}
+
+JNIEnv *jniGetEnv(const char *threadName) {
+    JNIEnv *env = t_env;
+    if (env) {
+        return env;
+    }
+    if (!g_jvm) {
+        return nullptr;
+    }
+    
+    jint status = g_jvm->GetEnv((void**)&env, JNI_VERSION_1_6);
+    if (status == JNI_EDETACHED) {
+        JavaVMAttachArgs args;
+        args.version = JNI_VERSION_1_6;
+        args.name = threadName ? threadName : "QuickJS-native";
+        args.group = nullptr;
+        if (g_jvm->AttachCurrentThreadAsDaemon(&env, &args) != JNI_OK) {
+            LOGE("Failed to attach native thread to the JVM");
+            return nullptr;
+        }
+        // Any non-null value makes the destructor run at thread exit
+        pthread_once(&g_detachKeyOnce, createDetachKey);
+        pthread_setspecific(g_detachKey, env);
+    } else if (status != JNI_OK) {
+        return nullptr;
+    }
+    
+    t_env = env;
+    return env;
+}
+
+// Global reference to a class, or nullptr (with the pending exception cleared)
+static jclass findClassGlobal(JNIEnv *env, const char *name) {
+    jclass local = env->FindClass(name);
+    if (!local) {
+        env->ExceptionClear();
+        LOGE("Class not found: %s", name);
+        return nullptr;
+    }
+    jclass global = (jclass)env->NewGlobalRef(local);
+    env->DeleteLocalRef(local);
+    return global;
+}
+
+void jniInitialize(JavaVM *vm, JNIEnv *env) {
+    g_jvm = vm;
+    t_env = env;
+    
+    g_jni.quickJSBridgeClass = findClassGlobal(env, "com/visgupta/example/v8integrationandroidapp/QuickJSBridge");
+    if (g_jni.quickJSBridgeClass) {
+        g_jni.handleHttpRequest = env->GetMethodID(g_jni.quickJSBridgeClass, "handleHttpRequest",
+            "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;");
+        if (!g_jni.handleHttpRequest) {
+            env->ExceptionClear();
+            LOGE("Failed to find handleHttpRequest method");
+        }
+    }
+    g_jni.bufferInfoClass = findClassGlobal(env, "com/visgupta/example/v8integrationandroidapp/BufferInfo");
+    if (g_jni.bufferInfoClass) {
+        g_jni.bufferInfoInit = env->GetMethodID(g_jni.bufferInfoClass, "<init>", "(Ljava/lang/String;III)V");
+        if (!g_jni.bufferInfoInit) {
+            env->ExceptionClear();
+            LOGE("Failed to find BufferInfo constructor");
+        }
+    }
+    LOGI("JNI handles resolved");
+}
+
+bool jniRegisterNatives(JNIEnv *env, const char *className, const JNINativeMethod *methods, size_t count) {
+    jclass clazz = env->FindClass(className);
+    if (!clazz) {
+        env->ExceptionClear();
+        LOGE("Class not found: %s", className);
+        return false;
+    }
+    bool ok = env->RegisterNatives(clazz, methods, (jint)count) == JNI_OK;
+    if (!ok) {
+        // The pending NoSuchMethodError names the method that did not match
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+        LOGE("RegisterNatives failed for %s", className);
+    }
+    env->DeleteLocalRef(clazz);
+    return ok;
+}
+
+bool jniCriticalNativesSupported() {
+    static const bool supported = android_get_device_api_level() >= 26;
+    return supported;
+}
+
+extern "C" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
+    JNIEnv *env = nullptr;
+    if (vm->GetEnv((void**)&env, JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+    jniInitialize(vm, env);
+    if (!registerQuickJSBridgeNatives(env) || !registerByteTransferBridgeNatives(env) ||
+        !registerV8BridgeNatives(env)) {
+        return JNI_ERR;
+    }
+    return JNI_VERSION_1_6;
+}
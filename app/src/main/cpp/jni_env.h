@@ -0,0 +1,55 @@
+#ifndef JNI_ENV_H
+#define JNI_ENV_H
+
+#include <cstddef>
+#include <jni.h>
+
+// Process-wide JavaVM, set in JNI_OnLoad
+extern JavaVM *g_jvm;
+
+// Classes and method IDs resolved once in JNI_OnLoad. Classes are global
+// references, so these stay valid on every thread for the life of the process.
+struct JniHandles {
+    jclass quickJSBridgeClass = nullptr;
+    jmethodID handleHttpRequest = nullptr;  // QuickJSBridge.handleHttpRequest(String, String): String
+    jclass bufferInfoClass = nullptr;
+    jmethodID bufferInfoInit = nullptr;     // BufferInfo(String, Int, Int, Int)
+};
+
+extern JniHandles g_jni;
+
+/**
+ * JNIEnv for the calling thread.
+ *
+ * The first call on a thread unknown to the VM attaches it (as a daemon, so
+ * engine worker threads never block VM shutdown) and the env is cached in
+ * thread-local storage; later calls are a single TLS load. Threads attached
+ * here are detached automatically when they exit, so callers must not call
+ * DetachCurrentThread themselves. Returns nullptr if no VM is available.
+ */
+JNIEnv *jniGetEnv(const char *threadName = nullptr);
+
+// Store the VM and resolve g_jni; called from JNI_OnLoad
+void jniInitialize(JavaVM *vm, JNIEnv *env);
+
+/**
+ * Native methods are bound with RegisterNatives from JNI_OnLoad rather than
+ * looked up by exported name; the library only exports JNI_OnLoad. Each
+ * bridge source file owns the table for its Kotlin class.
+ *
+ * Methods marked @CriticalNative in Kotlin take no JNIEnv/jclass on API 26+,
+ * where ART honours the annotation; older releases ignore it and call with
+ * the normal JNI arguments, so those tables pick an adapter instead.
+ */
+bool jniRegisterNatives(JNIEnv *env, const char *className, const JNINativeMethod *methods, size_t count);
+bool jniCriticalNativesSupported();
+
+// Table entry binding a Kotlin external to its Java_..._<name> definition
+#define JNI_NATIVE(bridge, name, signature) \
+    {#name, signature, reinterpret_cast<void *>(Java_com_visgupta_example_v8integrationandroidapp_##bridge##_##name)}
+
+bool registerQuickJSBridgeNatives(JNIEnv *env);
+bool registerByteTransferBridgeNatives(JNIEnv *env);
+bool registerV8BridgeNatives(JNIEnv *env);
+
+#endif // JNI_ENV_H
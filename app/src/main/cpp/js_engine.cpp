@@ -0,0 +1,163 @@
+#include "js_engine.h"
+
+#include <chrono>
+
+#include "quickjs_engine.h"
+#ifdef HAVE_V8
+#include "v8_engine.h"
+#endif
+
+namespace {
+
+uint64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Stand-in used when no real V8 is linked: echoes scripts back so the
+ * bindings and the benchmark driver can be exercised end to end.
+ */
+class MockJsEngine : public JsEngine {
+public:
+    const char* name() const override { return "mock"; }
+
+    bool initialize() override {
+        initialized_ = true;
+        return true;
+    }
+    bool isInitialized() const override { return initialized_; }
+    void cleanup() override { initialized_ = false; }
+    bool reset() override { return initialized_; }
+
+protected:
+    bool doEval(const std::string& source, std::string* result) override {
+        if (!initialized_) {
+            *result = "Error: V8 not initialized";
+            return false;
+        }
+        *result = "V8 Result: " + source;
+        return true;
+    }
+
+    bool doCompile(const std::string& source, std::vector<uint8_t>* bytecode, std::string* error) override {
+        (void)error;
+        bytecode->assign(source.begin(), source.end());
+        return true;
+    }
+
+    bool doLoadBytecode(const uint8_t* data, size_t length, std::string* result) override {
+        return doEval(std::string(reinterpret_cast<const char*>(data), length), result);
+    }
+
+    bool doCall(const std::string& function, const std::vector<std::string>& jsonArgs,
+                std::string* result) override {
+        std::string call = function + "(";
+        for (size_t i = 0; i < jsonArgs.size(); i++) {
+            call += (i ? ", " : "") + jsonArgs[i];
+        }
+        return doEval(call + ")", result);
+    }
+
+private:
+    bool initialized_ = false;
+};
+
+} // namespace
+
+bool JsEngine::eval(const std::string& source, std::string* result) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = doEval(source, result);
+    stats_.evals++;
+    stats_.evalNs += elapsedNs(start);
+    stats_.errors += ok ? 0 : 1;
+    return ok;
+}
+
+bool JsEngine::compile(const std::string& source, std::vector<uint8_t>* bytecode, std::string* error) {
+    auto start = std::chrono::steady_clock::now();
+    std::string ignored;
+    bool ok = doCompile(source, bytecode, error ? error : &ignored);
+    stats_.compiles++;
+    stats_.compileNs += elapsedNs(start);
+    stats_.errors += ok ? 0 : 1;
+    return ok;
+}
+
+bool JsEngine::loadBytecode(const uint8_t* data, size_t length, std::string* result) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = length > 0 && doLoadBytecode(data, length, result);
+    if (length == 0) {
+        *result = "Error: Empty bytecode";
+    }
+    stats_.bytecodeLoads++;
+    stats_.loadNs += elapsedNs(start);
+    stats_.errors += ok ? 0 : 1;
+    return ok;
+}
+
+bool JsEngine::call(const std::string& function, const std::vector<std::string>& jsonArgs, std::string* result) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = doCall(function, jsonArgs, result);
+    stats_.calls++;
+    stats_.callNs += elapsedNs(start);
+    stats_.errors += ok ? 0 : 1;
+    return ok;
+}
+
+JsEngineStats JsEngine::stats() const {
+    JsEngineStats result = stats_;
+    result.heapBytes = isInitialized() ? heapBytes() : 0;
+    return result;
+}
+
+std::string JsEngineStats::format(std::string_view engine) const {
+    auto line = [](const char* label, uint64_t count, uint64_t ns) {
+        std::string text = std::string(label) + ": " + std::to_string(count);
+        if (count > 0) {
+            text += " (avg " + std::to_string(ns / count / 1000) + " us)";
+        }
+        return text + "\n";
+    };
+    std::string text = std::string(engine) + " engine statistics:\n";
+    text += line("Evals", evals, evalNs);
+    text += line("Compiles", compiles, compileNs);
+    text += line("Bytecode loads", bytecodeLoads, loadNs);
+    text += line("Calls", calls, callNs);
+    text += "Errors: " + std::to_string(errors) + "\n";
+    text += "Heap: " + std::to_string(heapBytes) + " bytes";
+    return text;
+}
+
+std::unique_ptr<JsEngine> createJsEngine(std::string_view name) {
+    if (name == "quickjs") {
+        return std::make_unique<RealQuickJSEngine>();
+    }
+    if (name == "v8") {
+#ifdef HAVE_V8
+        return std::make_unique<V8Engine>();
+#else
+        return std::make_unique<MockJsEngine>();
+#endif
+    }
+    if (name == "mock") {
+        return std::make_unique<MockJsEngine>();
+    }
+    return nullptr;
+}
+
+std::vector<std::string> availableJsEngines() {
+#ifdef HAVE_V8
+    return {"quickjs", "v8", "mock"};
+#else
+    return {"quickjs", "mock"};
+#endif
+}
+
+bool jsEngineHasV8() {
+#ifdef HAVE_V8
+    return true;
+#else
+    return false;
+#endif
+}
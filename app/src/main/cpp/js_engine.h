@@ -0,0 +1,86 @@
+#ifndef JS_ENGINE_H
+#define JS_ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Counters kept by every JsEngine around its public entry points
+struct JsEngineStats {
+    uint64_t evals = 0;
+    uint64_t compiles = 0;
+    uint64_t bytecodeLoads = 0;
+    uint64_t calls = 0;
+    uint64_t errors = 0;
+    uint64_t evalNs = 0;
+    uint64_t compileNs = 0;
+    uint64_t loadNs = 0;
+    uint64_t callNs = 0;
+    size_t heapBytes = 0;  // as reported by the engine; 0 if unknown
+
+    // Multi-line human readable summary headed by the engine name
+    std::string format(std::string_view engine) const;
+};
+
+/**
+ * Common interface of the JavaScript backends (QuickJS, V8 and the mock
+ * fallback), so JNI bindings and benchmarks can drive any of them.
+ *
+ * Results are strings: the script's value converted with the engine's
+ * ToString, or the error message when the method returns false. Bytecode is
+ * engine specific and only valid for the engine (and build) that produced it.
+ * An engine is used by one thread at a time.
+ */
+class JsEngine {
+public:
+    virtual ~JsEngine() = default;
+
+    virtual const char* name() const = 0;
+    virtual bool initialize() = 0;
+    virtual bool isInitialized() const = 0;
+    virtual void cleanup() = 0;
+    // Fresh global object; compiled functions and globals are dropped
+    virtual bool reset() = 0;
+
+    // Run source as a global script
+    bool eval(const std::string& source, std::string* result);
+    // Compile source without running it; *error (optional) gets the reason on failure
+    bool compile(const std::string& source, std::vector<uint8_t>* bytecode, std::string* error = nullptr);
+    // Run bytecode from compile() as a global script
+    bool loadBytecode(const uint8_t* data, size_t length, std::string* result);
+    // Call a global function; arguments are JSON texts
+    bool call(const std::string& function, const std::vector<std::string>& jsonArgs, std::string* result);
+
+    JsEngineStats stats() const;
+    void resetStats() { stats_ = JsEngineStats(); }
+
+protected:
+    virtual bool doEval(const std::string& source, std::string* result) = 0;
+    virtual bool doCompile(const std::string& source, std::vector<uint8_t>* bytecode, std::string* error) = 0;
+    virtual bool doLoadBytecode(const uint8_t* data, size_t length, std::string* result) = 0;
+    virtual bool doCall(const std::string& function, const std::vector<std::string>& jsonArgs,
+                        std::string* result) = 0;
+    virtual size_t heapBytes() const { return 0; }
+
+private:
+    JsEngineStats stats_;
+};
+
+/**
+ * Engine by name: "quickjs", "v8" or "mock". "v8" is the real V8 adapter when
+ * the library was built against V8 (V8_DIR/lib present) and the mock
+ * otherwise. Returns nullptr for an unknown name. The engine is not
+ * initialized yet.
+ */
+std::unique_ptr<JsEngine> createJsEngine(std::string_view name);
+
+// Names accepted by createJsEngine() in this build, real engines first
+std::vector<std::string> availableJsEngines();
+
+// True if "v8" is backed by the real engine rather than the mock
+bool jsEngineHasV8();
+
+#endif // JS_ENGINE_H
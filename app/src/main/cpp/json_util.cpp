@@ -0,0 +1,367 @@
+#include "json_util.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+const JsonValue* JsonValue::get(const std::string& key) const {
+    if (type != Object) {
+        return nullptr;
+    }
+    for (const auto& member : objectValue) {
+        if (member.first == key) {
+            return &member.second;
+        }
+    }
+    return nullptr;
+}
+
+JsonValue* JsonValue::get(const std::string& key) {
+    return const_cast<JsonValue*>(static_cast<const JsonValue*>(this)->get(key));
+}
+
+void JsonValue::set(const std::string& key, JsonValue value) {
+    type = Object;
+    JsonValue* existing = get(key);
+    if (existing) {
+        *existing = std::move(value);
+    } else {
+        objectValue.emplace_back(key, std::move(value));
+    }
+}
+
+std::string JsonValue::getString(const std::string& key, const std::string& def) const {
+    const JsonValue* v = get(key);
+    return (v && v->type == String) ? v->stringValue : def;
+}
+
+double JsonValue::getNumber(const std::string& key, double def) const {
+    const JsonValue* v = get(key);
+    return (v && v->type == Number) ? v->numberValue : def;
+}
+
+bool JsonValue::getBool(const std::string& key, bool def) const {
+    const JsonValue* v = get(key);
+    return (v && v->type == Bool) ? v->boolValue : def;
+}
+
+namespace {
+
+class JsonParser {
+public:
+    JsonParser(const char* text, size_t length) : p(text), end(text + length) {}
+
+    bool parseDocument(JsonValue* out) {
+        skipWhitespace();
+        if (!parseValue(out, 0)) {
+            return false;
+        }
+        skipWhitespace();
+        return p == end;
+    }
+
+private:
+    static constexpr int kMaxDepth = 64;
+
+    const char* p;
+    const char* end;
+
+    void skipWhitespace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+            p++;
+        }
+    }
+
+    bool consumeLiteral(const char* literal) {
+        size_t len = strlen(literal);
+        if ((size_t)(end - p) < len || memcmp(p, literal, len) != 0) {
+            return false;
+        }
+        p += len;
+        return true;
+    }
+
+    bool parseValue(JsonValue* out, int depth) {
+        if (p >= end || depth > kMaxDepth) {
+            return false;
+        }
+        switch (*p) {
+            case '{': return parseObject(out, depth);
+            case '[': return parseArray(out, depth);
+            case '"':
+                out->type = JsonValue::String;
+                return parseString(&out->stringValue);
+            case 't':
+                out->type = JsonValue::Bool;
+                out->boolValue = true;
+                return consumeLiteral("true");
+            case 'f':
+                out->type = JsonValue::Bool;
+                out->boolValue = false;
+                return consumeLiteral("false");
+            case 'n':
+                out->type = JsonValue::Null;
+                return consumeLiteral("null");
+            default:
+                return parseNumber(out);
+        }
+    }
+
+    bool parseObject(JsonValue* out, int depth) {
+        out->type = JsonValue::Object;
+        p++; // '{'
+        skipWhitespace();
+        if (p < end && *p == '}') {
+            p++;
+            return true;
+        }
+        while (p < end) {
+            skipWhitespace();
+            std::string key;
+            if (p >= end || *p != '"' || !parseString(&key)) {
+                return false;
+            }
+            skipWhitespace();
+            if (p >= end || *p != ':') {
+                return false;
+            }
+            p++;
+            skipWhitespace();
+            JsonValue value;
+            if (!parseValue(&value, depth + 1)) {
+                return false;
+            }
+            out->objectValue.emplace_back(std::move(key), std::move(value));
+            skipWhitespace();
+            if (p < end && *p == ',') {
+                p++;
+                continue;
+            }
+            if (p < end && *p == '}') {
+                p++;
+                return true;
+            }
+            return false;
+        }
+        return false;
+    }
+
+    bool parseArray(JsonValue* out, int depth) {
+        out->type = JsonValue::Array;
+        p++; // '['
+        skipWhitespace();
+        if (p < end && *p == ']') {
+            p++;
+            return true;
+        }
+        while (p < end) {
+            skipWhitespace();
+            JsonValue value;
+            if (!parseValue(&value, depth + 1)) {
+                return false;
+            }
+            out->arrayValue.push_back(std::move(value));
+            skipWhitespace();
+            if (p < end && *p == ',') {
+                p++;
+                continue;
+            }
+            if (p < end && *p == ']') {
+                p++;
+                return true;
+            }
+            return false;
+        }
+        return false;
+    }
+
+    static void appendUtf8(std::string* out, uint32_t c) {
+        if (c < 0x80) {
+            out->push_back((char)c);
+        } else if (c < 0x800) {
+            out->push_back((char)(0xC0 | (c >> 6)));
+            out->push_back((char)(0x80 | (c & 0x3F)));
+        } else if (c < 0x10000) {
+            out->push_back((char)(0xE0 | (c >> 12)));
+            out->push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+            out->push_back((char)(0x80 | (c & 0x3F)));
+        } else {
+            out->push_back((char)(0xF0 | (c >> 18)));
+            out->push_back((char)(0x80 | ((c >> 12) & 0x3F)));
+            out->push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+            out->push_back((char)(0x80 | (c & 0x3F)));
+        }
+    }
+
+    bool parseHex4(uint32_t* out) {
+        if (end - p < 4) {
+            return false;
+        }
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = *p++;
+            v <<= 4;
+            if (c >= '0' && c <= '9') v |= c - '0';
+            else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+            else return false;
+        }
+        *out = v;
+        return true;
+    }
+
+    bool parseString(std::string* out) {
+        p++; // opening quote
+        while (p < end) {
+            char c = *p++;
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out->push_back(c);
+                continue;
+            }
+            if (p >= end) {
+                return false;
+            }
+            char esc = *p++;
+            switch (esc) {
+                case '"': out->push_back('"'); break;
+                case '\\': out->push_back('\\'); break;
+                case '/': out->push_back('/'); break;
+                case 'b': out->push_back('\b'); break;
+                case 'f': out->push_back('\f'); break;
+                case 'n': out->push_back('\n'); break;
+                case 'r': out->push_back('\r'); break;
+                case 't': out->push_back('\t'); break;
+                case 'u': {
+                    uint32_t c1;
+                    if (!parseHex4(&c1)) {
+                        return false;
+                    }
+                    // Combine UTF-16 surrogate pairs
+                    if (c1 >= 0xD800 && c1 < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                        const char* save = p;
+                        p += 2;
+                        uint32_t c2;
+                        if (parseHex4(&c2) && c2 >= 0xDC00 && c2 < 0xE000) {
+                            c1 = 0x10000 + ((c1 - 0xD800) << 10) + (c2 - 0xDC00);
+                        } else {
+                            p = save;
+                        }
+                    }
+                    appendUtf8(out, c1);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    bool parseNumber(JsonValue* out) {
+        const char* start = p;
+        if (p < end && (*p == '-' || *p == '+')) p++;
+        while (p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '-' || *p == '+')) {
+            p++;
+        }
+        if (p == start) {
+            return false;
+        }
+        std::string number(start, p - start);
+        char* numberEnd = nullptr;
+        double value = strtod(number.c_str(), &numberEnd);
+        if (!numberEnd || *numberEnd != '\0') {
+            return false;
+        }
+        out->type = JsonValue::Number;
+        out->numberValue = value;
+        return true;
+    }
+};
+
+void appendJson(std::string& out, const JsonValue& value) {
+    switch (value.type) {
+        case JsonValue::Null:
+            out += "null";
+            break;
+        case JsonValue::Bool:
+            out += value.boolValue ? "true" : "false";
+            break;
+        case JsonValue::Number: {
+            if (!std::isfinite(value.numberValue)) {
+                out += "null";
+                break;
+            }
+            char buf[32];
+            if (value.numberValue == (double)(long long)value.numberValue && fabs(value.numberValue) < 1e15) {
+                snprintf(buf, sizeof(buf), "%lld", (long long)value.numberValue);
+            } else {
+                snprintf(buf, sizeof(buf), "%.17g", value.numberValue);
+            }
+            out += buf;
+            break;
+        }
+        case JsonValue::String:
+            appendJsonString(out, value.stringValue);
+            break;
+        case JsonValue::Array:
+            out.push_back('[');
+            for (size_t i = 0; i < value.arrayValue.size(); i++) {
+                if (i) out.push_back(',');
+                appendJson(out, value.arrayValue[i]);
+            }
+            out.push_back(']');
+            break;
+        case JsonValue::Object:
+            out.push_back('{');
+            for (size_t i = 0; i < value.objectValue.size(); i++) {
+                if (i) out.push_back(',');
+                appendJsonString(out, value.objectValue[i].first);
+                out.push_back(':');
+                appendJson(out, value.objectValue[i].second);
+            }
+            out.push_back('}');
+            break;
+    }
+}
+
+} // namespace
+
+bool parseJson(const char* text, size_t length, JsonValue* out) {
+    *out = JsonValue();
+    JsonParser parser(text, length);
+    return parser.parseDocument(out);
+}
+
+void appendJsonString(std::string& out, const std::string& s) {
+    out.push_back('"');
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out.push_back((char)c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+std::string toJson(const JsonValue& value) {
+    std::string out;
+    appendJson(out, value);
+    return out;
+}
@@ -0,0 +1,74 @@
+#ifndef JSON_UTIL_H
+#define JSON_UTIL_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON value used by the native HTTP layer.
+// Only what the fetch polyfill and HttpService exchange is supported:
+// objects, arrays, strings, numbers, booleans and null.
+struct JsonValue {
+    enum Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Null;
+    bool boolValue = false;
+    double numberValue = 0;
+    std::string stringValue;
+    std::vector<JsonValue> arrayValue;
+    std::vector<std::pair<std::string, JsonValue>> objectValue;
+
+    static JsonValue makeString(const std::string& s) {
+        JsonValue v;
+        v.type = String;
+        v.stringValue = s;
+        return v;
+    }
+
+    static JsonValue makeNumber(double n) {
+        JsonValue v;
+        v.type = Number;
+        v.numberValue = n;
+        return v;
+    }
+
+    static JsonValue makeBool(bool b) {
+        JsonValue v;
+        v.type = Bool;
+        v.boolValue = b;
+        return v;
+    }
+
+    static JsonValue makeObject() {
+        JsonValue v;
+        v.type = Object;
+        return v;
+    }
+
+    bool isObject() const { return type == Object; }
+
+    // Object member lookup, nullptr if absent or not an object
+    const JsonValue* get(const std::string& key) const;
+    JsonValue* get(const std::string& key);
+
+    // Replaces an existing member or appends a new one
+    void set(const std::string& key, JsonValue value);
+
+    std::string getString(const std::string& key, const std::string& def = "") const;
+    double getNumber(const std::string& key, double def = 0) const;
+    bool getBool(const std::string& key, bool def = false) const;
+};
+
+// Parse a JSON document. Returns false on malformed input.
+bool parseJson(const char* text, size_t length, JsonValue* out);
+
+inline bool parseJson(const std::string& text, JsonValue* out) {
+    return parseJson(text.data(), text.size(), out);
+}
+
+std::string toJson(const JsonValue& value);
+
+// Append a JSON string literal (with quotes) for s
+void appendJsonString(std::string& out, const std::string& s);
+
+#endif // JSON_UTIL_H
@@ -0,0 +1,257 @@
+/*
+ * QuickJS ahead of time compiler
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cutils.h"
+#include "quickjs-libc.h"
+#include "quickjs-aot.h"
+
+/* qjsaot -o out.c -n name file.js...
+
+   writes the C functions of the scripts (see JS_GenerateAOT()) and
+   'int name(JSRuntime *rt)' which registers them. A script is compiled
+   as a module if it has the .mjs suffix or contains import/export
+   statements, as qjs does, so that the same script run by qjs or
+   evaluated by the application finds its functions.
+
+   Built with QJSAOT_TABLES defined to such a function, it runs a
+   script like 'qjs --std file.js' with the functions registered
+   (scripts/run_quickjs_tests.sh --aot). */
+
+/* also used by the compiler: the imports of the modules are resolved
+   at compile time */
+static JSContext *JS_NewCustomContext(JSRuntime *rt)
+{
+    JSContext *ctx;
+    ctx = JS_NewContext(rt);
+    if (!ctx)
+        return NULL;
+    js_init_module_std(ctx, "std");
+    js_init_module_os(ctx, "os");
+    return ctx;
+}
+
+static uint8_t *load_file(JSContext *ctx, size_t *plen, const char *filename,
+                          int *pmodule)
+{
+    uint8_t *buf;
+
+    buf = js_load_file(ctx, plen, filename);
+    if (!buf) {
+        perror(filename);
+        exit(1);
+    }
+    *pmodule = has_suffix(filename, ".mjs") ||
+        JS_DetectModule((const char *)buf, *plen);
+    return buf;
+}
+
+static JSValue compile_file(JSContext *ctx, const char *filename)
+{
+    uint8_t *buf;
+    size_t buf_len;
+    int module;
+    JSValue obj;
+
+    buf = load_file(ctx, &buf_len, filename, &module);
+    obj = JS_Eval(ctx, (const char *)buf, buf_len, filename,
+                  JS_EVAL_FLAG_COMPILE_ONLY |
+                  (module ? JS_EVAL_TYPE_MODULE : JS_EVAL_TYPE_GLOBAL));
+    js_free(ctx, buf);
+    return obj;
+}
+
+static int generate(JSContext *ctx, FILE *fo, const char *name,
+                    int count, char **files)
+{
+    char table_name[64];
+    JSValue obj;
+    char *src;
+    size_t len;
+    int i;
+
+    for(i = 0; i < count; i++) {
+        obj = compile_file(ctx, files[i]);
+        if (JS_IsException(obj)) {
+            js_std_dump_error(ctx);
+            return -1;
+        }
+        snprintf(table_name, sizeof(table_name), "%s_%d", name, i);
+        src = JS_GenerateAOT(ctx, obj, table_name, &len);
+        JS_FreeValue(ctx, obj);
+        if (!src) {
+            js_std_dump_error(ctx);
+            return -1;
+        }
+        fprintf(fo, "/* %s */\n", files[i]);
+        fwrite(src, 1, len, fo);
+        fprintf(fo, "\n");
+        js_free(ctx, src);
+    }
+    fprintf(fo, "int %s(JSRuntime *rt)\n{\n", name);
+    for(i = 0; i < count; i++) {
+        fprintf(fo, "    if (JS_AddAOTFunctions(rt, %s_%d, %s_%d_count))\n"
+                "        return -1;\n", name, i, name, i);
+    }
+    fprintf(fo, "    return 0;\n}\n");
+    return 0;
+}
+
+#ifdef QJSAOT_TABLES
+
+int QJSAOT_TABLES(JSRuntime *rt);
+
+/* same as eval_buf() in qjs.c */
+static int eval_buf(JSContext *ctx, const void *buf, int buf_len,
+                    const char *filename, int eval_flags)
+{
+    JSValue val;
+    int ret;
+
+    if ((eval_flags & JS_EVAL_TYPE_MASK) == JS_EVAL_TYPE_MODULE) {
+        val = JS_Eval(ctx, buf, buf_len, filename,
+                      eval_flags | JS_EVAL_FLAG_COMPILE_ONLY);
+        if (!JS_IsException(val)) {
+            js_module_set_import_meta(ctx, val, TRUE, TRUE);
+            val = JS_EvalFunction(ctx, val);
+        }
+        val = js_std_await(ctx, val);
+    } else {
+        val = JS_Eval(ctx, buf, buf_len, filename, eval_flags);
+    }
+    if (JS_IsException(val)) {
+        js_std_dump_error(ctx);
+        ret = -1;
+    } else {
+        ret = 0;
+    }
+    JS_FreeValue(ctx, val);
+    return ret;
+}
+
+static int run(int argc, char **argv)
+{
+    static const char std_str[] = "import * as std from 'std';\n"
+        "import * as os from 'os';\n"
+        "globalThis.std = std;\n"
+        "globalThis.os = os;\n";
+    JSRuntime *rt;
+    JSContext *ctx;
+    uint8_t *buf;
+    size_t buf_len;
+    int module, ret;
+
+    rt = JS_NewRuntime();
+    if (!rt || QJSAOT_TABLES(rt)) {
+        fprintf(stderr, "qjsaot: cannot allocate JS runtime\n");
+        exit(2);
+    }
+    js_std_set_worker_new_context_func(JS_NewCustomContext);
+    js_std_init_handlers(rt);
+    ctx = JS_NewCustomContext(rt);
+    if (!ctx) {
+        fprintf(stderr, "qjsaot: cannot allocate JS context\n");
+        exit(2);
+    }
+    JS_SetModuleLoaderFunc(rt, NULL, js_module_loader, NULL);
+    js_std_add_helpers(ctx, argc, argv);
+    eval_buf(ctx, std_str, strlen(std_str), "<input>", JS_EVAL_TYPE_MODULE);
+
+    buf = load_file(ctx, &buf_len, argv[0], &module);
+    ret = eval_buf(ctx, buf, buf_len, argv[0],
+                   module ? JS_EVAL_TYPE_MODULE : JS_EVAL_TYPE_GLOBAL);
+    js_free(ctx, buf);
+    if (ret == 0)
+        js_std_loop(ctx);
+    js_std_free_handlers(rt);
+    JS_FreeContext(ctx);
+    JS_FreeRuntime(rt);
+    return ret ? 1 : 0;
+}
+
+#endif /* QJSAOT_TABLES */
+
+static void help(void)
+{
+    printf("usage: qjsaot -o output.c [-n name] file.js...\n"
+#ifdef QJSAOT_TABLES
+           "       qjsaot file.js [args...]\n"
+#endif
+           "-o output  write the C functions of the scripts to 'output'\n"
+           "-n name    name of the registration function (default: js_aot_functions)\n");
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    const char *out_filename = NULL, *name = "js_aot_functions";
+    JSRuntime *rt;
+    JSContext *ctx;
+    FILE *fo;
+    int c, ret;
+
+    while ((c = getopt(argc, argv, "+ho:n:")) != -1) {
+        switch(c) {
+        case 'o':
+            out_filename = optarg;
+            break;
+        case 'n':
+            name = optarg;
+            break;
+        default:
+            help();
+        }
+    }
+    if (optind >= argc)
+        help();
+    /* the arguments after the script are passed to it */
+    if (!out_filename) {
+#ifdef QJSAOT_TABLES
+        return run(argc - optind, argv + optind);
+#else
+        help();
+#endif
+    }
+
+    rt = JS_NewRuntime();
+    ctx = rt ? JS_NewCustomContext(rt) : NULL;
+    if (!ctx) {
+        fprintf(stderr, "qjsaot: cannot allocate JS context\n");
+        exit(2);
+    }
+    JS_SetModuleLoaderFunc(rt, NULL, js_module_loader, NULL);
+    fo = fopen(out_filename, "w");
+    if (!fo) {
+        perror(out_filename);
+        exit(1);
+    }
+    ret = generate(ctx, fo, name, argc - optind, argv + optind);
+    fclose(fo);
+    if (ret)
+        unlink(out_filename);
+    JS_FreeContext(ctx);
+    JS_FreeRuntime(rt);
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,280 @@
+/*
+ * QuickJS ahead of time compilation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef QUICKJS_AOT_H
+#define QUICKJS_AOT_H
+
+#include <stdint.h>
+
+#include "quickjs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* JS_GenerateAOT() translates the bytecode functions of a compiled
+   script or module to C functions which are built with the
+   application. JS_AddAOTFunctions() registers them: a bytecode function
+   whose instructions match the ones of a C function (the atoms are not
+   compared, so the same source evaluated at run time or loaded as
+   bytecode matches) then runs it instead of the interpreter. An
+   instruction without C translation returns to the interpreter, which
+   continues the call. The generated code only depends on this header
+   but it must be generated by the same QuickJS version: the instruction
+   hash does not match otherwise. */
+
+/* state of a bytecode function running native code */
+typedef struct JSAOTFrame {
+    JSContext *ctx;
+    struct JSFunctionBytecode *b;
+    struct JSStackFrame *sf;
+    struct JSVarRef **var_refs;
+    JSValueConst this_obj;
+    JSValueConst new_target;
+    int argc;
+    JSValueConst *argv;
+    JSValue *var_buf;
+    JSValue *arg_buf;
+    int *interrupt_counter;
+    JSValue *sp; /* stack pointer, set at the return */
+    /* start of the bytecode at the entry, next instruction of the
+       interpreter if the function returns 0 */
+    const uint8_t *pc;
+} JSAOTFrame;
+
+/* return 0 if the interpreter continues at f->pc, 1 if the function
+   returns f->sp[-1], 2 if it returns undefined and -1 if there is an
+   exception */
+typedef int JSAOTCode(JSAOTFrame *f);
+
+typedef struct JSAOTFunction {
+    uint64_t hash; /* of the instructions without the atoms */
+    uint32_t len; /* bytecode length */
+    JSAOTCode *code;
+} JSAOTFunction;
+
+/* 'tab' must be sorted by hash and stay valid while 'rt' is used. The
+   functions already called are not searched again. */
+int JS_AddAOTFunctions(JSRuntime *rt, const JSAOTFunction *tab, int count);
+/* C source of the bytecode functions of 'obj' (result of
+   JS_EVAL_FLAG_COMPILE_ONLY) with a sorted JSAOTFunction array named
+   'name' and an int 'name'_count. Free it with js_free(). */
+char *JS_GenerateAOT(JSContext *ctx, JSValueConst obj, const char *name,
+                     size_t *plen);
+
+/* The generated code */
+
+/* execute the instruction at 'pos' without the fast paths. Return -1 if
+   there is an exception. The caller updates sp. For the *_loc_check
+   instructions, it only throws the ReferenceError and for the jumps, it
+   only polls the interrupts. */
+int JS_AOTOp(JSAOTFrame *f, JSValue *sp, int pos);
+
+#if defined(__GNUC__) || defined(__clang__)
+#define JS_AOT_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define JS_AOT_UNLIKELY(x) (x)
+#endif
+
+#define JS_AOT_OP(pos, n) do {                                          \
+        if (JS_AOT_UNLIKELY(JS_AOTOp(f, sp, pos)))                      \
+            return -1;                                                  \
+        sp += (n);                                                      \
+    } while (0)
+
+#define JS_AOT_EXIT(pos) do {                                           \
+        f->pc += (pos);                                                 \
+        f->sp = sp;                                                     \
+        return 0;                                                       \
+    } while (0)
+
+#define JS_AOT_RETURN() do {                                            \
+        f->sp = sp;                                                     \
+        return 1;                                                       \
+    } while (0)
+
+/* without pushing the value: the stack of the function may be empty */
+#define JS_AOT_RETURN_UNDEF() do {                                      \
+        f->sp = sp;                                                     \
+        return 2;                                                       \
+    } while (0)
+
+/* the instruction at 'pos' is a goto or a conditional jump */
+#define JS_AOT_POLL(pos) do {                                           \
+        if (JS_AOT_UNLIKELY(--*f->interrupt_counter <= 0))              \
+            JS_AOT_OP(pos, 0);                                          \
+    } while (0)
+
+#define JS_AOT_PUSH(v) (*sp++ = (v))
+
+#define JS_AOT_GET(lv) (*sp++ = JS_DupValue(ctx, lv))
+
+#define JS_AOT_PUT(lv) do {                                             \
+        JSValue old_ = (lv);                                            \
+        (lv) = *--sp;                                                   \
+        JS_FreeValue(ctx, old_);                                        \
+    } while (0)
+
+/* without going through the stack, which may be full */
+#define JS_AOT_STORE(lv, v) do {                                        \
+        JSValue old_ = (lv);                                            \
+        (lv) = (v);                                                     \
+        JS_FreeValue(ctx, old_);                                        \
+    } while (0)
+
+#define JS_AOT_SET(lv) do {                                             \
+        JSValue old_ = (lv);                                            \
+        (lv) = JS_DupValue(ctx, sp[-1]);                                \
+        JS_FreeValue(ctx, old_);                                        \
+    } while (0)
+
+/* the slow path of the *_check instructions throws */
+#define JS_AOT_CHECK_INIT(lv, pos) do {                                 \
+        if (JS_AOT_UNLIKELY(JS_VALUE_GET_TAG(lv) == JS_TAG_UNINITIALIZED)) \
+            JS_AOT_OP(pos, 0);                                          \
+    } while (0)
+
+#define JS_AOT_BOTH_INT(a, b)                                           \
+    (JS_VALUE_GET_TAG(a) == JS_TAG_INT && JS_VALUE_GET_TAG(b) == JS_TAG_INT)
+
+/* return TRUE and their values if 'a' and 'b' are numbers */
+static inline int JS_AOTGetNumbers(JSValueConst a, JSValueConst b,
+                                   double *pd1, double *pd2)
+{
+    if (JS_VALUE_GET_NORM_TAG(a) == JS_TAG_INT)
+        *pd1 = JS_VALUE_GET_INT(a);
+    else if (JS_VALUE_GET_NORM_TAG(a) == JS_TAG_FLOAT64)
+        *pd1 = JS_VALUE_GET_FLOAT64(a);
+    else
+        return 0;
+    if (JS_VALUE_GET_NORM_TAG(b) == JS_TAG_INT)
+        *pd2 = JS_VALUE_GET_INT(b);
+    else if (JS_VALUE_GET_NORM_TAG(b) == JS_TAG_FLOAT64)
+        *pd2 = JS_VALUE_GET_FLOAT64(b);
+    else
+        return 0;
+    return 1;
+}
+
+/* same representation as the interpreter for the result 'r' of the
+   numbers 'a' and 'b' */
+static inline JSValue JS_AOTNewNumber(JSContext *ctx, JSValueConst a,
+                                      JSValueConst b, double r)
+{
+    if (JS_VALUE_GET_NORM_TAG(a) == JS_TAG_FLOAT64 &&
+        JS_VALUE_GET_NORM_TAG(b) == JS_TAG_FLOAT64)
+        return __JS_NewFloat64(ctx, r);
+    return JS_NewFloat64(ctx, r);
+}
+
+/* add, sub and mul ('zero_ok' is false for mul because of -0) */
+#define JS_AOT_ARITH(pos, op, zero_ok) do {                             \
+        int64_t r_;                                                     \
+        double d1_, d2_;                                                \
+        if (JS_AOT_BOTH_INT(sp[-2], sp[-1]) &&                          \
+            (r_ = (int64_t)JS_VALUE_GET_INT(sp[-2]) op                  \
+             JS_VALUE_GET_INT(sp[-1]), r_ == (int32_t)r_) &&            \
+            ((zero_ok) || r_ != 0)) {                                   \
+            sp[-2] = JS_NewInt32(ctx, (int32_t)r_);                     \
+            sp--;                                                       \
+        } else if (JS_AOTGetNumbers(sp[-2], sp[-1], &d1_, &d2_)) {      \
+            sp[-2] = JS_AOTNewNumber(ctx, sp[-2], sp[-1], d1_ op d2_);  \
+            sp--;                                                       \
+        } else {                                                        \
+            JS_AOT_OP(pos, -1);                                         \
+        }                                                               \
+    } while (0)
+
+#define JS_AOT_DIV(pos) do {                                            \
+        double d1_, d2_;                                                \
+        if (JS_AOTGetNumbers(sp[-2], sp[-1], &d1_, &d2_)) {             \
+            sp[-2] = JS_AOTNewNumber(ctx, sp[-2], sp[-1], d1_ / d2_);   \
+            sp--;                                                       \
+        } else {                                                        \
+            JS_AOT_OP(pos, -1);                                         \
+        }                                                               \
+    } while (0)
+
+/* and, or and xor */
+#define JS_AOT_LOGIC(pos, op) do {                                      \
+        if (JS_AOT_BOTH_INT(sp[-2], sp[-1])) {                          \
+            sp[-2] = JS_NewInt32(ctx, JS_VALUE_GET_INT(sp[-2]) op       \
+                                 JS_VALUE_GET_INT(sp[-1]));             \
+            sp--;                                                       \
+        } else {                                                        \
+            JS_AOT_OP(pos, -1);                                         \
+        }                                                               \
+    } while (0)
+
+/* the comparisons. The equalities of two numbers are the same as the
+   strict equalities. */
+#define JS_AOT_COMPARE(pos, op) do {                                    \
+        double d1_, d2_;                                                \
+        if (JS_AOT_BOTH_INT(sp[-2], sp[-1])) {                          \
+            sp[-2] = JS_NewBool(ctx, JS_VALUE_GET_INT(sp[-2]) op        \
+                                JS_VALUE_GET_INT(sp[-1]));              \
+            sp--;                                                       \
+        } else if (JS_AOTGetNumbers(sp[-2], sp[-1], &d1_, &d2_)) {      \
+            sp[-2] = JS_NewBool(ctx, d1_ op d2_);                       \
+            sp--;                                                       \
+        } else {                                                        \
+            JS_AOT_OP(pos, -1);                                         \
+        }                                                               \
+    } while (0)
+
+/* inc and dec of 'lv', 'limit' is the int32 value without fast path */
+#define JS_AOT_INC(lv, pos, delta, limit) do {                          \
+        if (JS_VALUE_GET_TAG(lv) == JS_TAG_INT &&                       \
+            JS_VALUE_GET_INT(lv) != (limit))                            \
+            (lv) = JS_NewInt32(ctx, JS_VALUE_GET_INT(lv) + (delta));    \
+        else                                                            \
+            JS_AOT_OP(pos, 0);                                          \
+    } while (0)
+
+/* add_loc: lv += pop() */
+#define JS_AOT_ADD_LOC(lv, pos) do {                                    \
+        int64_t r_;                                                     \
+        if (JS_AOT_BOTH_INT(lv, sp[-1]) &&                              \
+            (r_ = (int64_t)JS_VALUE_GET_INT(lv) +                       \
+             JS_VALUE_GET_INT(sp[-1]), r_ == (int32_t)r_)) {            \
+            (lv) = JS_NewInt32(ctx, (int32_t)r_);                       \
+        } else {                                                        \
+            JS_AOT_OP(pos, 0);                                          \
+        }                                                               \
+        sp--;                                                           \
+    } while (0)
+
+/* pop the condition of if_true and if_false to 'res' */
+#define JS_AOT_TO_BOOL(res) do {                                        \
+        JSValue v_ = *--sp;                                             \
+        if ((uint32_t)JS_VALUE_GET_NORM_TAG(v_) <= JS_TAG_BOOL) {       \
+            res = JS_VALUE_GET_INT(v_) != 0;                            \
+        } else {                                                        \
+            res = JS_ToBool(ctx, v_);                                   \
+            JS_FreeValue(ctx, v_);                                      \
+        }                                                               \
+    } while (0)
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
+#endif /* QUICKJS_AOT_H */
@@ -363,7 +363,20 @@ DEF(   is_undefined, 1, 1, 1, none)
 DEF(        is_null, 1, 1, 1, none)
 DEF(typeof_is_undefined, 1, 1, 1, none)
 DEF( typeof_is_function, 1, 1, 1, none)
+
+/* superinstructions: the first opcode of the sequence is replaced and
+   the other instructions are left in place (fuse_superinstructions()),
+   so the size and format are those of the first instruction */
+DEF(   lt_if_false8, 1, 2, 1, none) /* lt if_false8 */
+DEF(push_i16_lt_if_false8, 3, 0, 1, i16) /* push_i16 lt if_false8 */
+DEF(  inc_loc_goto8, 2, 0, 0, loc8) /* inc_loc goto8 */
+DEF(get_var_get_field2, 5, 0, 1, atom) /* get_var get_field2 */
 #endif
+/* quickened instructions: written in place of the generic instruction at
+   run time (js_quicken()), never emitted by the compiler nor serialized */
+DEF(        add_f64, 1, 2, 1, none)
+DEF(        sub_f64, 1, 2, 1, none)
+DEF(        mul_f64, 1, 2, 1, none)
 
 #undef DEF
 #undef def
@@ -43,6 +43,7 @@
 #include "cutils.h"
 #include "list.h"
 #include "quickjs.h"
+#include "quickjs-aot.h"
 #include "libregexp.h"
 #include "libunicode.h"
 #include "dtoa.h"
@@ -77,6 +78,15 @@
 #define CONFIG_STACK_CHECK
 #endif
 
+/* baseline JIT for x86-64 (see js_jit_compile()). It is only used
+   after JS_SetJITThreshold() or if JS_JIT_DEFAULT_THRESHOLD is
+   defined. */
+#if !defined(EMSCRIPTEN) && !defined(_WIN32) && \
+    !defined(CONFIG_CHECK_JSVALUE) && !defined(JS_NAN_BOXING) && \
+    defined(__x86_64__)
+#define CONFIG_JIT
+#endif
+
 
 /* dump object free */
 //#define DUMP_FREE
@@ -106,6 +116,13 @@
 //#define DUMP_PROMISE
 //#define DUMP_READ_OBJECT
 //#define DUMP_ROPE_REBALANCE
+/* count the executed opcode pairs and dump the most frequent ones in
+   JS_FreeRuntime() (scripts/run_quickjs_tests.sh --pairs) */
+//#define DUMP_OPCODE_PAIRS
+/* profile the bytecode functions of every runtime (see
+   JS_SetProfiling()) and dump the report in JS_FreeRuntime()
+   (scripts/run_quickjs_tests.sh --profile) */
+//#define DUMP_PROFILE
 
 /* test the GC by forcing it before each object allocation */
 //#define FORCE_GC_AT_MALLOC
@@ -116,6 +133,11 @@
 #include <errno.h>
 #endif
 
+#ifdef CONFIG_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 enum {
     /* classid tag        */    /* union usage   | properties */
     JS_CLASS_OBJECT = 1,        /* must be first */
@@ -215,6 +237,7 @@ typedef struct JSShape JSShape;
 typedef struct JSString JSString;
 typedef struct JSString JSAtomStruct;
 typedef struct JSObject JSObject;
+typedef struct JSInlineCache JSInlineCache;
 
 #define JS_VALUE_GET_OBJ(v) ((JSObject *)JS_VALUE_GET_PTR(v))
 #define JS_VALUE_GET_STRING(v) ((JSString *)JS_VALUE_GET_PTR(v))
@@ -228,6 +251,48 @@ typedef enum {
 
 typedef enum OPCodeEnum OPCodeEnum;
 
+typedef struct JSAOTTable {
+    const JSAOTFunction *tab; /* sorted by hash */
+    int count;
+} JSAOTTable;
+
+/* calling context tree of the profiler (see JS_SetProfiling()) */
+typedef struct JSProfileNode {
+    struct JSProfileNode *parent; /* NULL for the root */
+    struct JSProfileNode *hash_next;
+    const struct JSFunctionBytecode *b; /* only compared: may be freed */
+    JSAtom func_name;
+    JSAtom filename;
+    int line_num;
+    int depth;
+    uint64_t calls;
+    uint64_t loops; /* backward jumps */
+    int64_t self_time; /* in ns */
+} JSProfileNode;
+
+typedef struct JSProfile {
+    JSProfileNode root; /* time spent outside of the bytecode functions */
+    JSProfileNode *cur; /* node of the running function */
+    int64_t last_time; /* of the last call or return */
+    /* end of the previous instruction of the running function, NULL
+       after a call, a return or OP_ret, to detect the backward jumps */
+    const uint8_t *last_pc;
+    int frame_count; /* profiled frames in the stack */
+    JSProfileNode **hash; /* by (parent, b), chained with hash_next */
+    int hash_size; /* power of two */
+    int node_count;
+    uint64_t op_count[256];
+} JSProfile;
+
+/* freed JSObject structures and property arrays kept in JSRuntime for
+   the next allocations (see js_alloc_object()) */
+#define JS_OBJ_CACHE_MAX 256 /* blocks per list */
+#define JS_PROP_CACHE_MAX_SIZE 8 /* largest cached prop_size */
+
+typedef struct JSFreeBlock {
+    struct JSFreeBlock *next;
+} JSFreeBlock;
+
 struct JSRuntime {
     JSMallocFunctions mf;
     JSMallocState malloc_state;
@@ -253,6 +318,22 @@ struct JSRuntime {
     struct list_head tmp_obj_list; /* used during GC */
     JSGCPhaseEnum gc_phase : 8;
     size_t malloc_gc_threshold;
+    int gc_obj_count; /* number of objects in gc_obj_list */
+    /* incremental cycle collection (see JS_SetGCBudget()) */
+    int64_t gc_budget; /* in ns, 0 if the whole heap is collected at once */
+    int gc_slice_size; /* number of objects of the next slice */
+    int gc_round_count; /* objects to collect in the current round */
+    int gc_round_left; /* objects left in the current round, 0 if none */
+    size_t gc_round_malloc_size; /* malloc_size at the start of the round */
+    size_t gc_full_malloc_size; /* malloc_size after the last full GC */
+    /* list of JSGCObjectHeader.link. Objects outside of the collected
+       slice freed by the removed cycles */
+    struct list_head gc_slice_free_list;
+    struct JSGCThreads *gc_threads; /* helper threads of the full GC */
+    JSFreeBlock *obj_cache;
+    int obj_cache_count;
+    JSFreeBlock *prop_cache[JS_PROP_CACHE_MAX_SIZE + 1]; /* by prop_size */
+    int prop_cache_count[JS_PROP_CACHE_MAX_SIZE + 1];
     struct list_head weakref_list; /* list of JSWeakRefHeader.link */
 #ifdef DUMP_LEAKS
     struct list_head string_list; /* list of JSString.link */
@@ -294,6 +375,17 @@ struct JSRuntime {
     int shape_hash_count; /* number of hashed shapes */
     JSShape **shape_hash;
     void *user_opaque;
+    /* see js_jit_enter() */
+    BOOL native_code; /* JIT enabled or AOT functions registered */
+#ifdef CONFIG_JIT
+    int jit_threshold; /* see JS_SetJITThreshold() */
+    struct JSJitChunk *jit_chunks; /* see js_jit_alloc_code() */
+#endif
+    JSAOTTable *aot_tables; /* see JS_AddAOTFunctions() */
+    int aot_table_count;
+    /* see JS_SetProfiling() */
+    BOOL profiling;
+    JSProfile *profile; /* NULL if profiling was never enabled */
 };
 
 struct JSClass {
@@ -425,6 +517,9 @@ typedef enum {
 /* must be large enough to have a negligible runtime cost and small
    enough to call the interrupt callback often. */
 #define JS_INTERRUPT_COUNTER_INIT 10000
+/* JIT call counter increment of a function looping during
+   JS_INTERRUPT_COUNTER_INIT instructions */
+#define JS_JIT_LOOP_WEIGHT 100
 
 struct JSContext {
     JSGCObjectHeader header; /* must come first */
@@ -451,6 +546,8 @@ struct JSContext {
 
     JSValue global_obj; /* global object */
     JSValue global_var_obj; /* contains the global let/const definitions */
+    /* incremented when a let/const is added to global_var_obj */
+    uint32_t global_lexical_gen;
 
     uint64_t random_state;
 
@@ -600,6 +697,45 @@ typedef enum JSFunctionKindEnum {
     JS_FUNC_ASYNC_GENERATOR = (JS_FUNC_GENERATOR | JS_FUNC_ASYNC),
 } JSFunctionKindEnum;
 
+/* polymorphic entries of an inline cache before it becomes megamorphic */
+#define JS_IC_MAX_ENTRIES 4
+/* prototypes an inline cache entry may walk to reach the property */
+#define JS_IC_MAX_DEPTH   3
+
+typedef enum {
+    JS_IC_GET_VALUE,  /* data property of the holder */
+    JS_IC_GET_GETTER, /* accessor of the holder: call the getter */
+    JS_IC_PUT_VALUE,  /* writable own data property */
+    JS_IC_PUT_SETTER, /* accessor of the holder: call the setter */
+    JS_IC_PUT_ADD,    /* new own property: shape becomes new_shape */
+} JSInlineCacheKind;
+
+typedef struct JSInlineCacheEntry {
+    JSShape *shape; /* receiver shape */
+    JSShape *proto_shape[JS_IC_MAX_DEPTH]; /* shapes of the walked prototypes */
+    JSShape *new_shape; /* JS_IC_PUT_ADD only */
+    uint32_t prop_index; /* in the holder, or in new_shape for JS_IC_PUT_ADD */
+    uint16_t class_id; /* receiver class */
+    uint8_t depth; /* walked prototypes: the holder is the last one */
+    uint8_t kind; /* JSInlineCacheKind */
+} JSInlineCacheEntry;
+
+struct JSInlineCache {
+    JSAtom atom; /* operand of the instruction */
+    uint8_t count; /* 0 or 1 for a global variable */
+    uint8_t missed : 1; /* filled from the second miss only */
+    uint8_t megamorphic : 1; /* no longer probed nor filled */
+    uint8_t is_global_var : 1; /* OP_get_var, OP_put_var... */
+    uint8_t is_lexical : 1; /* global variable in global_var_obj */
+    union {
+        JSInlineCacheEntry *entries; /* allocated on the first fill */
+        struct {
+            uint32_t prop_index; /* in global_var_obj or global_obj */
+            uint32_t lexical_gen; /* JSContext.global_lexical_gen */
+        } global;
+    } u;
+};
+
 typedef struct JSFunctionBytecode {
     JSGCObjectHeader header; /* must come first */
     uint8_t js_mode;
@@ -616,7 +752,10 @@ typedef struct JSFunctionBytecode {
     uint8_t has_debug : 1;
     uint8_t read_only_bytecode : 1;
     uint8_t is_direct_or_indirect_eval : 1; /* used by JS_GetScriptOrModuleName() */
-    /* XXX: 10 bits available */
+    uint8_t quicken_deopt_count : 3; /* see js_quicken() */
+    uint8_t jit_failed : 1; /* the function cannot be compiled */
+    uint8_t aot_checked : 1; /* the AOT functions were searched */
+    /* XXX: 5 bits available */
     uint8_t *byte_code_buf; /* (self pointer) */
     int byte_code_len;
     JSAtom func_name;
@@ -630,6 +769,14 @@ typedef struct JSFunctionBytecode {
     JSValue *cpool; /* constant pool (self pointer) */
     int cpool_count;
     int closure_var_count;
+    /* one inline cache per OP_get_field, OP_get_field2 and OP_put_field
+       (their operand is then the cache index, see js_ic_init()) */
+    JSInlineCache *ic;
+    uint32_t ic_count;
+    /* see js_jit_enter() */
+    uint32_t jit_counter;
+    uint32_t jit_code_size; /* 0 for the AOT functions */
+    void *jit_code; /* native code or NULL */
     struct {
         /* debug info, move to separate structure to save memory? */
         JSAtom filename;
@@ -1032,6 +1179,8 @@ static JSAtom __JS_NewAtomInit(JSRuntime *rt, const char *str, int len,
                                int atom_type);
 static void JS_FreeAtomStruct(JSRuntime *rt, JSAtomStruct *p);
 static void free_function_bytecode(JSRuntime *rt, JSFunctionBytecode *b);
+static void js_ic_mark(JSRuntime *rt, JSFunctionBytecode *b,
+                       JS_MarkFunc *mark_func);
 static JSValue js_call_c_function(JSContext *ctx, JSValueConst func_obj,
                                   JSValueConst this_obj,
                                   int argc, JSValueConst *argv, int flags);
@@ -1041,6 +1190,10 @@ static JSValue js_call_bound_function(JSContext *ctx, JSValueConst func_obj,
 static JSValue JS_CallInternal(JSContext *ctx, JSValueConst func_obj,
                                JSValueConst this_obj, JSValueConst new_target,
                                int argc, JSValue *argv, int flags);
+static int js_jit_enter(JSContext *ctx, JSFunctionBytecode *b,
+                        JSStackFrame *sf, JSValueConst this_obj,
+                        JSValueConst new_target, int argc,
+                        JSValueConst *argv, JSVarRef **var_refs);
 static JSValue JS_CallConstructorInternal(JSContext *ctx,
                                           JSValueConst func_obj,
                                           JSValueConst new_target,
@@ -1065,6 +1218,17 @@ static __maybe_unused void JS_PrintValue(JSContext *ctx,
                                                   const char *str,
                                                   JSValueConst val);
 static __maybe_unused void JS_DumpShapes(JSRuntime *rt);
+#ifdef DUMP_OPCODE_PAIRS
+static int js_count_opcode(int op);
+static void js_dump_opcode_pairs(void);
+#endif
+static JSProfileNode *js_profile_enter(JSRuntime *rt, JSFunctionBytecode *b,
+                                       BOOL is_call);
+static void js_profile_exit(JSRuntime *rt, JSProfileNode *parent);
+static void js_profile_free(JSRuntime *rt);
+#ifdef DUMP_PROFILE
+static void js_dump_profile(JSRuntime *rt);
+#endif
 static JSValue js_function_apply(JSContext *ctx, JSValueConst this_val,
                                  int argc, JSValueConst *argv, int magic);
 static void js_array_finalizer(JSRuntime *rt, JSValue val);
@@ -1243,7 +1407,7 @@ static JSValue js_c_function_data_call(JSContext *ctx, JSValueConst func_obj,
 static JSAtom js_symbol_to_atom(JSContext *ctx, JSValue val);
 static void add_gc_object(JSRuntime *rt, JSGCObjectHeader *h,
                           JSGCObjectTypeEnum type);
-static void remove_gc_object(JSGCObjectHeader *h);
+static void remove_gc_object(JSRuntime *rt, JSGCObjectHeader *h);
 static JSValue js_instantiate_prototype(JSContext *ctx, JSObject *p, JSAtom atom, void *opaque);
 static JSValue js_module_ns_autoinit(JSContext *ctx, JSObject *p, JSAtom atom,
                                  void *opaque);
@@ -1255,6 +1419,14 @@ static void map_delete_weakrefs(JSRuntime *rt, JSWeakRefHeader *wh);
 static void weakref_delete_weakref(JSRuntime *rt, JSWeakRefHeader *wh);
 static void finrec_delete_weakref(JSRuntime *rt, JSWeakRefHeader *wh);
 static void JS_RunGCInternal(JSRuntime *rt, BOOL remove_weak_objects);
+static void gc_run_slice(JSRuntime *rt);
+static BOOL gc_decref_scan_parallel(JSRuntime *rt);
+static void js_free_obj_cache(JSRuntime *rt);
+#ifdef CONFIG_JIT
+static void js_jit_free_code(JSRuntime *rt, void *code);
+static void js_jit_free_arena(JSRuntime *rt);
+static void js_jit_code_usage(JSRuntime *rt, int64_t *pcount, int64_t *psize);
+#endif
 static JSValue js_array_from_iterator(JSContext *ctx, uint32_t *plen,
                                       JSValueConst obj, JSValueConst method);
 
@@ -1264,6 +1436,13 @@ static const JSClassExoticMethods js_proxy_exotic_methods;
 static const JSClassExoticMethods js_module_ns_exotic_methods;
 static JSClassID js_class_id_alloc = JS_CLASS_INIT_COUNT;
 
+static int64_t js_get_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
 static void js_trigger_gc(JSRuntime *rt, size_t size)
 {
     BOOL force_gc;
@@ -1278,9 +1457,13 @@ static void js_trigger_gc(JSRuntime *rt, size_t size)
         printf("GC: size=%" PRIu64 "\n",
                (uint64_t)rt->malloc_state.malloc_size);
 #endif
-        JS_RunGC(rt);
-        rt->malloc_gc_threshold = rt->malloc_state.malloc_size +
-            (rt->malloc_state.malloc_size >> 1);
+        if (rt->gc_budget != 0 && rt->gc_phase == JS_GC_PHASE_NONE) {
+            gc_run_slice(rt);
+        } else {
+            JS_RunGC(rt);
+            rt->malloc_gc_threshold = rt->malloc_state.malloc_size +
+                (rt->malloc_state.malloc_size >> 1);
+        }
     }
 }
 
@@ -1556,7 +1739,9 @@ JSRuntime *JS_NewRuntime2(const JSMallocFunctions *mf, void *opaque)
     init_list_head(&rt->context_list);
     init_list_head(&rt->gc_obj_list);
     init_list_head(&rt->gc_zero_ref_count_list);
+    init_list_head(&rt->gc_slice_free_list);
     rt->gc_phase = JS_GC_PHASE_NONE;
+    rt->gc_slice_size = 4096;
     init_list_head(&rt->weakref_list);
 
 #ifdef DUMP_LEAKS
@@ -1584,6 +1769,20 @@ JSRuntime *JS_NewRuntime2(const JSMallocFunctions *mf, void *opaque)
 
     rt->stack_size = JS_DEFAULT_STACK_SIZE;
     JS_UpdateStackTop(rt);
+#if defined(CONFIG_JIT) && defined(JS_JIT_DEFAULT_THRESHOLD)
+    rt->jit_threshold = JS_JIT_DEFAULT_THRESHOLD;
+    rt->native_code = TRUE;
+#endif
+#ifdef JS_GC_DEFAULT_BUDGET
+    JS_SetGCBudget(rt, JS_GC_DEFAULT_BUDGET);
+#endif
+#ifdef JS_GC_DEFAULT_THREADS
+    JS_SetGCThreads(rt, JS_GC_DEFAULT_THREADS);
+#endif
+#ifdef DUMP_PROFILE
+    if (JS_SetProfiling(rt, TRUE))
+        goto fail;
+#endif
 
     rt->current_exception = JS_UNINITIALIZED;
 
@@ -1699,6 +1898,16 @@ void JS_SetGCThreshold(JSRuntime *rt, size_t gc_threshold)
     rt->malloc_gc_threshold = gc_threshold;
 }
 
+/* A function is compiled to native code after 'threshold' calls. Use 0
+   to disable the JIT. No effect if the JIT is not supported. */
+void JS_SetJITThreshold(JSRuntime *rt, int threshold)
+{
+#ifdef CONFIG_JIT
+    rt->jit_threshold = max_int(threshold, 0);
+    rt->native_code = rt->jit_threshold != 0 || rt->aot_table_count != 0;
+#endif
+}
+
 #define malloc(s) malloc_is_forbidden(s)
 #define free(p) free_is_forbidden(p)
 #define realloc(p,s) realloc_is_forbidden(p,s)
@@ -1872,6 +2081,16 @@ void JS_FreeRuntime(JSRuntime *rt)
        FinalizationRegistry */
     JS_RunGCInternal(rt, FALSE);
 
+#ifdef DUMP_OPCODE_PAIRS
+    js_dump_opcode_pairs();
+#endif
+#ifdef DUMP_PROFILE
+    js_dump_profile(rt);
+#endif
+    js_profile_free(rt);
+    JS_SetGCThreads(rt, 0);
+    js_free_obj_cache(rt);
+
 #ifdef DUMP_LEAKS
     /* leaking objects */
     {
@@ -1913,6 +2132,9 @@ void JS_FreeRuntime(JSRuntime *rt)
 #endif
     assert(list_empty(&rt->gc_obj_list));
     assert(list_empty(&rt->weakref_list));
+#ifdef CONFIG_JIT
+    js_jit_free_arena(rt);
+#endif
 
     /* free the classes */
     for(i = 0; i < rt->class_count; i++) {
@@ -1994,6 +2216,7 @@ void JS_FreeRuntime(JSRuntime *rt)
     js_free_rt(rt, rt->atom_array);
     js_free_rt(rt, rt->atom_hash);
     js_free_rt(rt, rt->shape_hash);
+    js_free_rt(rt, rt->aot_tables);
 #ifdef DUMP_LEAKS
     if (!list_empty(&rt->string_list)) {
         if (rt->rt_info) {
@@ -2252,7 +2475,7 @@ void JS_FreeContext(JSContext *ctx)
     js_free_shape_null(ctx->rt, ctx->array_shape);
 
     list_del(&ctx->link);
-    remove_gc_object(&ctx->header);
+    remove_gc_object(rt, &ctx->header);
     js_free_rt(ctx->rt, ctx);
 }
 
@@ -4748,7 +4971,7 @@ static void js_free_shape0(JSRuntime *rt, JSShape *sh)
         JS_FreeAtomRT(rt, pr->atom);
         pr++;
     }
-    remove_gc_object(&sh->header);
+    remove_gc_object(rt, &sh->header);
     js_free_rt(rt, get_alloc_from_shape(sh));
 }
 
@@ -5036,12 +5259,85 @@ static __maybe_unused void JS_DumpShapes(JSRuntime *rt)
     printf("}\n");
 }
 
+/* Most objects are freed soon after their creation by their refcount,
+   so the JSObject structures and the small property arrays are not
+   given back to malloc() but kept in short lists of the runtime. They
+   stay counted in malloc_size. */
+
+static inline void *js_cache_pop(JSFreeBlock **plist, int *pcount)
+{
+    JSFreeBlock *b = *plist;
+    *plist = b->next;
+    (*pcount)--;
+    return b;
+}
+
+static inline BOOL js_cache_push(JSFreeBlock **plist, int *pcount, void *ptr)
+{
+    JSFreeBlock *b = ptr;
+    if (*pcount >= JS_OBJ_CACHE_MAX)
+        return FALSE;
+    b->next = *plist;
+    *plist = b;
+    (*pcount)++;
+    return TRUE;
+}
+
+static JSObject *js_alloc_object(JSContext *ctx)
+{
+    JSRuntime *rt = ctx->rt;
+    if (rt->obj_cache)
+        return js_cache_pop(&rt->obj_cache, &rt->obj_cache_count);
+    return js_malloc(ctx, sizeof(JSObject));
+}
+
+/* free the structure of an object */
+static void js_free_object_struct(JSRuntime *rt, JSObject *p)
+{
+    if (!js_cache_push(&rt->obj_cache, &rt->obj_cache_count, p))
+        js_free_rt(rt, p);
+}
+
+/* the array of 'size' properties of an object */
+static JSProperty *js_alloc_prop(JSContext *ctx, int size)
+{
+    JSRuntime *rt = ctx->rt;
+    if (size <= JS_PROP_CACHE_MAX_SIZE && rt->prop_cache[size]) {
+        return js_cache_pop(&rt->prop_cache[size],
+                            &rt->prop_cache_count[size]);
+    }
+    return js_malloc(ctx, sizeof(JSProperty) * size);
+}
+
+static void js_free_prop(JSRuntime *rt, JSProperty *prop, int size)
+{
+    if (size > JS_PROP_CACHE_MAX_SIZE ||
+        !js_cache_push(&rt->prop_cache[size], &rt->prop_cache_count[size],
+                       prop)) {
+        js_free_rt(rt, prop);
+    }
+}
+
+static void js_free_obj_cache(JSRuntime *rt)
+{
+    int i;
+
+    while (rt->obj_cache)
+        js_free_rt(rt, js_cache_pop(&rt->obj_cache, &rt->obj_cache_count));
+    for(i = 0; i <= JS_PROP_CACHE_MAX_SIZE; i++) {
+        while (rt->prop_cache[i]) {
+            js_free_rt(rt, js_cache_pop(&rt->prop_cache[i],
+                                        &rt->prop_cache_count[i]));
+        }
+    }
+}
+
 static JSValue JS_NewObjectFromShape(JSContext *ctx, JSShape *sh, JSClassID class_id)
 {
     JSObject *p;
 
     js_trigger_gc(ctx->rt, sizeof(JSObject));
-    p = js_malloc(ctx, sizeof(JSObject));
+    p = js_alloc_object(ctx);
     if (unlikely(!p))
         goto fail;
     p->class_id = class_id;
@@ -5056,9 +5352,9 @@ static JSValue JS_NewObjectFromShape(JSContext *ctx, JSShape *sh, JSClassID clas
     p->weakref_count = 0;
     p->u.opaque = NULL;
     p->shape = sh;
-    p->prop = js_malloc(ctx, sizeof(JSProperty) * sh->prop_size);
+    p->prop = js_alloc_prop(ctx, sh->prop_size);
     if (unlikely(!p->prop)) {
-        js_free(ctx, p);
+        js_free_object_struct(ctx->rt, p);
     fail:
         js_free_shape(ctx->rt, sh);
         return JS_EXCEPTION;
@@ -5546,7 +5842,7 @@ static void free_var_ref(JSRuntime *rt, JSVarRef *var_ref)
                 if (var_ref->async_func)
                     async_func_free(rt, var_ref->async_func);
             }
-            remove_gc_object(&var_ref->header);
+            remove_gc_object(rt, &var_ref->header);
             js_free_rt(rt, var_ref);
         }
     }
@@ -5722,7 +6018,7 @@ static void free_object(JSRuntime *rt, JSObject *p)
         free_property(rt, &p->prop[i], pr->flags);
         pr++;
     }
-    js_free_rt(rt, p->prop);
+    js_free_prop(rt, p->prop, sh->prop_size);
     /* as an optimization we destroy the shape immediately without
        putting it in gc_zero_ref_count_list */
     js_free_shape(rt, sh);
@@ -5741,10 +6037,10 @@ static void free_object(JSRuntime *rt, JSObject *p)
     p->u.func.var_refs = NULL;
     p->u.func.home_object = NULL;
 
-    remove_gc_object(&p->header);
+    remove_gc_object(rt, &p->header);
     if (rt->gc_phase == JS_GC_PHASE_REMOVE_CYCLES) {
         if (p->header.ref_count == 0 && p->weakref_count == 0) {
-            js_free_rt(rt, p);
+            js_free_object_struct(rt, p);
         } else {
             /* keep the object structure because there are may be
                references to it */
@@ -5753,7 +6049,7 @@ static void free_object(JSRuntime *rt, JSObject *p)
     } else {
         /* keep the object structure in case there are weak references to it */
         if (p->weakref_count == 0) {
-            js_free_rt(rt, p);
+            js_free_object_struct(rt, p);
         } else {
             p->header.mark = 0; /* reset the mark so that the weakref can be freed */
         }
@@ -5845,6 +6141,11 @@ void __JS_FreeValueRT(JSRuntime *rt, JSValue v)
                 if (rt->gc_phase == JS_GC_PHASE_NONE) {
                     free_zero_refcount(rt);
                 }
+            } else if (p->mark == 0) {
+                /* not in the removed cycles: only referenced by them */
+                list_del(&p->link);
+                list_add_tail(&p->link, &rt->gc_slice_free_list);
+                p->mark = 1;
             }
         }
         break;
@@ -5911,11 +6212,13 @@ static void add_gc_object(JSRuntime *rt, JSGCObjectHeader *h,
     h->mark = 0;
     h->gc_obj_type = type;
     list_add_tail(&h->link, &rt->gc_obj_list);
+    rt->gc_obj_count++;
 }
 
-static void remove_gc_object(JSGCObjectHeader *h)
+static void remove_gc_object(JSRuntime *rt, JSGCObjectHeader *h)
 {
     list_del(&h->link);
+    rt->gc_obj_count--;
 }
 
 void JS_MarkValue(JSRuntime *rt, JSValueConst val, JS_MarkFunc *mark_func)
@@ -5987,6 +6290,7 @@ static void mark_children(JSRuntime *rt, JSGCObjectHeader *gp,
             }
             if (b->realm)
                 mark_func(rt, &b->realm->header);
+            js_ic_mark(rt, b, mark_func);
         }
         break;
     case JS_GC_OBJ_TYPE_VAR_REF:
@@ -6155,16 +6459,29 @@ static void gc_free_cycles(JSRuntime *rt)
         assert(p->gc_obj_type == JS_GC_OBJ_TYPE_JS_OBJECT ||
                p->gc_obj_type == JS_GC_OBJ_TYPE_FUNCTION_BYTECODE ||
                p->gc_obj_type == JS_GC_OBJ_TYPE_ASYNC_FUNCTION);
-        if (p->gc_obj_type == JS_GC_OBJ_TYPE_JS_OBJECT &&
-            ((JSObject *)p)->weakref_count != 0) {
-            /* keep the object because there are weak references to it */
-            p->mark = 0;
+        if (p->gc_obj_type == JS_GC_OBJ_TYPE_JS_OBJECT) {
+            if (((JSObject *)p)->weakref_count != 0) {
+                /* keep the object because there are weak references to it */
+                p->mark = 0;
+            } else {
+                js_free_object_struct(rt, (JSObject *)p);
+            }
         } else {
             js_free_rt(rt, p);
         }
     }
 
     init_list_head(&rt->gc_zero_ref_count_list);
+
+    /* free the objects which were only referenced by the cycles. They
+       are outside of the collected objects in an incremental GC slice. */
+    if (!list_empty(&rt->gc_slice_free_list)) {
+        list_for_each_safe(el, el1, &rt->gc_slice_free_list) {
+            list_del(el);
+            list_add_tail(el, &rt->gc_zero_ref_count_list);
+        }
+        free_zero_refcount(rt);
+    }
 }
 
 static void JS_RunGCInternal(JSRuntime *rt, BOOL remove_weak_objects)
@@ -6176,22 +6493,584 @@ static void JS_RunGCInternal(JSRuntime *rt, BOOL remove_weak_objects)
         gc_remove_weak_objects(rt);
     }
     
-    /* decrement the reference of the children of each object. mark =
-       1 after this pass. */
-    gc_decref(rt);
+    if (!gc_decref_scan_parallel(rt)) {
+        /* decrement the reference of the children of each object. mark =
+           1 after this pass. */
+        gc_decref(rt);
 
-    /* keep the GC objects with a non zero refcount and their childs */
-    gc_scan(rt);
+        /* keep the GC objects with a non zero refcount and their childs */
+        gc_scan(rt);
+    }
 
     /* free the GC objects in a cycle */
     gc_free_cycles(rt);
+
+    /* the incremental GC starts a new round */
+    rt->gc_round_left = 0;
+    rt->gc_full_malloc_size = rt->malloc_state.malloc_size;
 }
 
 void JS_RunGC(JSRuntime *rt)
 {
     JS_RunGCInternal(rt, TRUE);
+    js_free_obj_cache(rt);
+}
+
+/* Incremental GC: instead of the whole gc_obj_list, a slice runs the
+   trial deletion on its first objects, which then go back at the end of
+   the list. The references from the objects outside of the slice are
+   kept as external references, so the objects of the slice are only
+   freed if they are in cycles fully contained in the slice. A slice
+   does not depend on the state left by the previous one, hence the
+   mutator needs no write barrier. The slices of a round cover the
+   objects of the list once and are spread over the allocations of the
+   round. The cycles across slices are only freed by a full GC, which
+   runs at the end of a round if the heap has doubled since the last
+   one. */
+
+#define JS_GC_MIN_SLICE_SIZE 256
+#define JS_GC_MIN_SLICE_STEP (64 * 1024)
+
+static void gc_slice_decref_child(JSRuntime *rt, JSGCObjectHeader *p)
+{
+    /* mark = 1 if in the slice */
+    if (p->mark) {
+        assert(p->ref_count > 0);
+        p->ref_count--;
+    }
+}
+
+static void gc_slice_incref_child(JSRuntime *rt, JSGCObjectHeader *p)
+{
+    if (p->mark) {
+        p->ref_count++;
+        if (p->ref_count == 1) {
+            /* ref_count was 0: remove from tmp_obj_list and add at the
+               end of gc_obj_list */
+            list_del(&p->link);
+            list_add_tail(&p->link, &rt->gc_obj_list);
+        }
+    }
+}
+
+static void gc_slice_incref_child2(JSRuntime *rt, JSGCObjectHeader *p)
+{
+    if (p->mark)
+        p->ref_count++;
+}
+
+/* collect the cycles of the first 'n' objects of gc_obj_list. Return
+   the number of objects of the slice. */
+static int gc_collect_slice(JSRuntime *rt, int n)
+{
+    struct list_head slice_list, *el, *el1, *last;
+    JSGCObjectHeader *p;
+    int i;
+
+    init_list_head(&slice_list);
+    init_list_head(&rt->tmp_obj_list);
+    for(i = 0; i < n; i++) {
+        el = rt->gc_obj_list.next;
+        if (el == &rt->gc_obj_list)
+            break;
+        p = list_entry(el, JSGCObjectHeader, link);
+        assert(p->mark == 0);
+        list_del(el);
+        list_add_tail(el, &slice_list);
+        p->mark = 1;
+    }
+
+    /* remove the references between the objects of the slice */
+    list_for_each(el, &slice_list) {
+        p = list_entry(el, JSGCObjectHeader, link);
+        mark_children(rt, p, gc_slice_decref_child);
+    }
+
+    /* the objects with a non zero refcount go back at the end of
+       gc_obj_list, the others to tmp_obj_list */
+    last = rt->gc_obj_list.prev;
+    list_for_each_safe(el, el1, &slice_list) {
+        p = list_entry(el, JSGCObjectHeader, link);
+        list_del(el);
+        if (p->ref_count == 0)
+            list_add_tail(el, &rt->tmp_obj_list);
+        else
+            list_add_tail(el, &rt->gc_obj_list);
+    }
+
+    /* keep them and their children. The objects of the slice keep mark
+       = 1 until the refcounts are restored. */
+    for(el = last->next; el != &rt->gc_obj_list; el = el->next) {
+        p = list_entry(el, JSGCObjectHeader, link);
+        mark_children(rt, p, gc_slice_incref_child);
+    }
+    list_for_each(el, &rt->tmp_obj_list) {
+        p = list_entry(el, JSGCObjectHeader, link);
+        mark_children(rt, p, gc_slice_incref_child2);
+    }
+    for(el = last->next; el != &rt->gc_obj_list; el = el->next) {
+        p = list_entry(el, JSGCObjectHeader, link);
+        p->mark = 0;
+    }
+
+    gc_free_cycles(rt);
+    return i;
+}
+
+/* called instead of a full GC when the GC threshold is reached */
+static void gc_run_slice(JSRuntime *rt)
+{
+    int64_t t, size_max;
+    int n;
+    size_t size, step;
+
+    if (rt->gc_round_left == 0) {
+        gc_remove_weak_objects(rt);
+        rt->gc_round_count = max_int(rt->gc_obj_count, 1);
+        rt->gc_round_left = rt->gc_round_count;
+        rt->gc_round_malloc_size = rt->malloc_state.malloc_size;
+    }
+
+    t = js_get_time_ns();
+    n = gc_collect_slice(rt, min_int(rt->gc_slice_size, rt->gc_round_left));
+    t = js_get_time_ns() - t;
+
+    /* adjust the size of the next slice to the budget */
+    if (n == rt->gc_slice_size) {
+        size_max = min_int(n, INT32_MAX / 2) * 2;
+        if (t > 0)
+            size_max = min_int64(size_max, (int64_t)n * rt->gc_budget / t);
+        rt->gc_slice_size = max_int((int)size_max, JS_GC_MIN_SLICE_SIZE);
+    }
+
+    rt->gc_round_left -= n;
+    if (n == 0)
+        rt->gc_round_left = 0;
+    size = rt->malloc_state.malloc_size;
+    if (rt->gc_round_left == 0 && size > rt->gc_full_malloc_size * 2) {
+#ifdef DUMP_GC
+        printf("GC: full GC after incremental round, size=%" PRIu64 "\n",
+               (uint64_t)size);
+#endif
+        JS_RunGCInternal(rt, FALSE);
+        size = rt->malloc_state.malloc_size;
+        rt->malloc_gc_threshold = size + (size >> 1);
+    } else {
+        /* the rounds follow each other and a third of the size at the
+           start of the round is allocated during the round, so that the
+           garbage of a round is freed by the next one */
+        step = (double)(rt->gc_round_malloc_size / 3) * n / rt->gc_round_count;
+        if (step < JS_GC_MIN_SLICE_STEP)
+            step = JS_GC_MIN_SLICE_STEP;
+        rt->malloc_gc_threshold = size + step;
+    }
+}
+
+/* Collect the cycles in slices of about 'budget_us' microseconds spread
+   over the allocations instead of the whole heap at once. Use 0 (the
+   default) to disable. JS_RunGC() still runs a full GC. */
+void JS_SetGCBudget(JSRuntime *rt, int budget_us)
+{
+    rt->gc_budget = (int64_t)max_int(budget_us, 0) * 1000;
+    rt->gc_round_left = 0;
+    rt->gc_full_malloc_size = rt->malloc_state.malloc_size;
+}
+
+/* Parallel full GC: gc_decref() and gc_scan() run on the helper threads
+   and the calling thread while the mutator waits. The objects are
+   copied to an array whose chunks the threads take with an atomic
+   counter, and the refcounts are updated with atomic operations. The
+   lists are only rebuilt at the end, so the 'link' field of the objects
+   chains the objects to scan: a thread scans the objects it brings back
+   to a non zero refcount and gives a part of them to the idle threads
+   through a shared pool. JS_GC_SCANNED in the refcount tells that an
+   object is scanned by a thread. The gc_mark functions of the classes
+   run concurrently and must only read the objects. */
+
+#ifdef CONFIG_ATOMICS
+
+/* below, a full GC is faster on one thread */
+#ifndef JS_GC_PARALLEL_MIN_OBJS
+#define JS_GC_PARALLEL_MIN_OBJS 16384
+#endif
+#define JS_GC_CHUNK_SIZE 256
+#define JS_GC_SHARE_SIZE 64 /* objects given to the shared pool at once */
+#define JS_GC_SCANNED (1 << 30)
+
+typedef enum {
+    JS_GC_PAR_DECREF,
+    JS_GC_PAR_SCAN,
+    JS_GC_PAR_RESTORE, /* of the objects to be deleted */
+} JSGCParPhaseEnum;
+
+typedef struct JSGCThreads JSGCThreads;
+
+typedef struct JSGCWorker {
+    JSGCThreads *gt;
+    struct list_head *stack; /* objects to scan, chained by link.next */
+    int stack_count;
+} JSGCWorker;
+
+struct JSGCThreads {
+    JSRuntime *rt;
+    int count; /* helper threads */
+    pthread_t *threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond; /* helpers waiting for a phase */
+    pthread_cond_t done_cond;
+    pthread_cond_t pool_cond; /* idle workers of the scan phase */
+    int generation; /* incremented at each phase */
+    int running; /* helpers in the current phase */
+    BOOL quit;
+    JSGCParPhaseEnum phase;
+    JSGCObjectHeader **objs;
+    int obj_count;
+    _Atomic(int) next_chunk;
+    struct list_head *pool; /* shared objects to scan */
+    _Atomic(int) pool_count;
+    _Atomic(int) idle; /* workers waiting for the pool */
+    JSGCWorker main_worker;
+};
+
+static _Thread_local JSGCWorker *gc_worker;
+
+static void gc_par_decref_child(JSRuntime *rt, JSGCObjectHeader *p)
+{
+    atomic_fetch_sub_explicit((_Atomic(int) *)&p->ref_count, 1,
+                              memory_order_relaxed);
+}
+
+static void gc_par_incref_child(JSRuntime *rt, JSGCObjectHeader *p)
+{
+    _Atomic(int) *pref = (_Atomic(int) *)&p->ref_count;
+    JSGCWorker *w;
+    int ref;
+
+    ref = 0;
+    /* the thread bringing back the refcount from 0 scans the object */
+    if (atomic_compare_exchange_strong_explicit(pref, &ref,
+                                                1 | JS_GC_SCANNED,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        w = gc_worker;
+        p->link.next = w->stack;
+        w->stack = &p->link;
+        w->stack_count++;
+    } else {
+        atomic_fetch_add_explicit(pref, 1, memory_order_relaxed);
+    }
+}
+
+/* return TRUE if 'p' had a non zero refcount after the decref phase and
+   is not already scanned */
+static BOOL gc_par_claim_root(JSGCObjectHeader *p)
+{
+    _Atomic(int) *pref = (_Atomic(int) *)&p->ref_count;
+    int ref;
+
+    ref = atomic_load_explicit(pref, memory_order_relaxed);
+    for(;;) {
+        if (ref == 0 || (ref & JS_GC_SCANNED))
+            return FALSE;
+        if (atomic_compare_exchange_weak_explicit(pref, &ref,
+                                                  ref | JS_GC_SCANNED,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed))
+            return TRUE;
+    }
 }
 
+static void gc_par_incref_child2(JSRuntime *rt, JSGCObjectHeader *p)
+{
+    atomic_fetch_add_explicit((_Atomic(int) *)&p->ref_count, 1,
+                              memory_order_relaxed);
+}
+
+/* give JS_GC_SHARE_SIZE objects of the stack to the shared pool */
+static void gc_par_share(JSGCWorker *w)
+{
+    JSGCThreads *gt = w->gt;
+    struct list_head *first, *el;
+    int i;
+
+    first = w->stack;
+    el = first;
+    for(i = 1; i < JS_GC_SHARE_SIZE; i++)
+        el = el->next;
+    w->stack = el->next;
+    w->stack_count -= JS_GC_SHARE_SIZE;
+    pthread_mutex_lock(&gt->mutex);
+    el->next = gt->pool;
+    gt->pool = first;
+    atomic_fetch_add(&gt->pool_count, JS_GC_SHARE_SIZE);
+    pthread_cond_signal(&gt->pool_cond);
+    pthread_mutex_unlock(&gt->mutex);
+}
+
+static void gc_par_drain(JSGCWorker *w)
+{
+    JSGCThreads *gt = w->gt;
+    JSGCObjectHeader *p;
+    struct list_head *el;
+
+    while (w->stack) {
+        el = w->stack;
+        w->stack = el->next;
+        w->stack_count--;
+        p = list_entry(el, JSGCObjectHeader, link);
+        mark_children(gt->rt, p, gc_par_incref_child);
+        if (w->stack_count >= 2 * JS_GC_SHARE_SIZE &&
+            atomic_load(&gt->idle) != 0 &&
+            atomic_load(&gt->pool_count) == 0) {
+            gc_par_share(w);
+        }
+    }
+}
+
+/* scan the objects of the pool until all the workers are idle */
+static void gc_par_scan_pool(JSGCWorker *w)
+{
+    JSGCThreads *gt = w->gt;
+    struct list_head *el;
+    int n;
+
+    pthread_mutex_lock(&gt->mutex);
+    for(;;) {
+        if (gt->pool) {
+            /* take the whole pool: the objects are shared again if
+               there are idle workers */
+            n = 0;
+            for(el = gt->pool; el->next; el = el->next)
+                n++;
+            el->next = w->stack;
+            w->stack = gt->pool;
+            w->stack_count += n + 1;
+            gt->pool = NULL;
+            atomic_store(&gt->pool_count, 0);
+            pthread_mutex_unlock(&gt->mutex);
+            gc_par_drain(w);
+            pthread_mutex_lock(&gt->mutex);
+            continue;
+        }
+        if (++gt->idle == gt->count + 1) {
+            pthread_cond_broadcast(&gt->pool_cond);
+            break;
+        }
+        while (!gt->pool && gt->idle <= gt->count)
+            pthread_cond_wait(&gt->pool_cond, &gt->mutex);
+        if (gt->idle == gt->count + 1)
+            break;
+        gt->idle--;
+    }
+    pthread_mutex_unlock(&gt->mutex);
+}
+
+static void gc_par_work(JSGCWorker *w)
+{
+    JSGCThreads *gt = w->gt;
+    JSRuntime *rt = gt->rt;
+    JSGCObjectHeader *p;
+    int i, start, end;
+
+    gc_worker = w;
+    for(;;) {
+        start = atomic_fetch_add(&gt->next_chunk, JS_GC_CHUNK_SIZE);
+        if (start >= gt->obj_count)
+            break;
+        end = min_int(start + JS_GC_CHUNK_SIZE, gt->obj_count);
+        for(i = start; i < end; i++) {
+            p = gt->objs[i];
+            switch(gt->phase) {
+            case JS_GC_PAR_DECREF:
+                mark_children(rt, p, gc_par_decref_child);
+                break;
+            case JS_GC_PAR_SCAN:
+                /* the other objects are scanned by the thread which
+                   increments their refcount */
+                if (gc_par_claim_root(p)) {
+                    mark_children(rt, p, gc_par_incref_child);
+                    gc_par_drain(w);
+                }
+                break;
+            case JS_GC_PAR_RESTORE:
+                mark_children(rt, p, gc_par_incref_child2);
+                break;
+            }
+        }
+    }
+    if (gt->phase == JS_GC_PAR_SCAN)
+        gc_par_scan_pool(w);
+}
+
+static void *gc_thread_func(void *opaque)
+{
+    JSGCThreads *gt = opaque;
+    JSGCWorker w;
+    int generation = 0;
+
+    w.gt = gt;
+    w.stack = NULL;
+    w.stack_count = 0;
+    pthread_mutex_lock(&gt->mutex);
+    for(;;) {
+        while (gt->generation == generation && !gt->quit)
+            pthread_cond_wait(&gt->cond, &gt->mutex);
+        if (gt->quit)
+            break;
+        generation = gt->generation;
+        pthread_mutex_unlock(&gt->mutex);
+        gc_par_work(&w);
+        pthread_mutex_lock(&gt->mutex);
+        if (--gt->running == 0)
+            pthread_cond_signal(&gt->done_cond);
+    }
+    pthread_mutex_unlock(&gt->mutex);
+    return NULL;
+}
+
+/* run a phase on the 'count' first objects of 'objs' on all the
+   threads */
+static void gc_par_run(JSGCThreads *gt, JSGCParPhaseEnum phase, int count)
+{
+    pthread_mutex_lock(&gt->mutex);
+    gt->obj_count = count;
+    gt->phase = phase;
+    atomic_store(&gt->next_chunk, 0);
+    atomic_store(&gt->idle, 0);
+    gt->running = gt->count;
+    gt->generation++;
+    pthread_cond_broadcast(&gt->cond);
+    pthread_mutex_unlock(&gt->mutex);
+
+    gc_par_work(&gt->main_worker);
+
+    pthread_mutex_lock(&gt->mutex);
+    while (gt->running != 0)
+        pthread_cond_wait(&gt->done_cond, &gt->mutex);
+    pthread_mutex_unlock(&gt->mutex);
+}
+
+/* same as gc_decref() and gc_scan(). Return FALSE if not done. */
+static BOOL gc_decref_scan_parallel(JSRuntime *rt)
+{
+    JSGCThreads *gt = rt->gc_threads;
+    struct list_head *el;
+    JSGCObjectHeader *p, **objs;
+    int i, n, tmp_count;
+
+    if (!gt || rt->gc_obj_count < JS_GC_PARALLEL_MIN_OBJS)
+        return FALSE;
+    objs = js_malloc_rt(rt, sizeof(objs[0]) * rt->gc_obj_count);
+    if (!objs)
+        return FALSE;
+    n = 0;
+    list_for_each(el, &rt->gc_obj_list) {
+        p = list_entry(el, JSGCObjectHeader, link);
+        assert(p->mark == 0);
+        assert(n < rt->gc_obj_count);
+        objs[n++] = p;
+    }
+    gt->objs = objs;
+
+    gc_par_run(gt, JS_GC_PAR_DECREF, n);
+    gc_par_run(gt, JS_GC_PAR_SCAN, n);
+
+    /* the objects with a zero refcount go to tmp_obj_list and to the
+       start of 'objs' */
+    init_list_head(&rt->gc_obj_list);
+    init_list_head(&rt->tmp_obj_list);
+    tmp_count = 0;
+    for(i = 0; i < n; i++) {
+        p = objs[i];
+        p->ref_count &= ~JS_GC_SCANNED;
+        if (p->ref_count == 0) {
+            p->mark = 1;
+            list_add_tail(&p->link, &rt->tmp_obj_list);
+            objs[tmp_count++] = p;
+        } else {
+            list_add_tail(&p->link, &rt->gc_obj_list);
+        }
+    }
+
+    /* restore the refcount of the objects to be deleted */
+    if (tmp_count >= JS_GC_PARALLEL_MIN_OBJS) {
+        gc_par_run(gt, JS_GC_PAR_RESTORE, tmp_count);
+    } else {
+        for(i = 0; i < tmp_count; i++)
+            mark_children(rt, objs[i], gc_scan_incref_child2);
+    }
+    gt->objs = NULL;
+    js_free_rt(rt, objs);
+    return TRUE;
+}
+
+/* Run the full GC on 'count' helper threads in addition to the calling
+   thread. Use 0 (the default) to disable. Return -1 if the threads
+   cannot be created. */
+int JS_SetGCThreads(JSRuntime *rt, int count)
+{
+    JSGCThreads *gt = rt->gc_threads;
+    int i;
+
+    if (gt) {
+        pthread_mutex_lock(&gt->mutex);
+        gt->quit = TRUE;
+        pthread_cond_broadcast(&gt->cond);
+        pthread_mutex_unlock(&gt->mutex);
+        for(i = 0; i < gt->count; i++)
+            pthread_join(gt->threads[i], NULL);
+        pthread_cond_destroy(&gt->pool_cond);
+        pthread_cond_destroy(&gt->done_cond);
+        pthread_cond_destroy(&gt->cond);
+        pthread_mutex_destroy(&gt->mutex);
+        js_free_rt(rt, gt->threads);
+        js_free_rt(rt, gt);
+        rt->gc_threads = NULL;
+    }
+    if (count <= 0)
+        return 0;
+
+    gt = js_mallocz_rt(rt, sizeof(*gt));
+    if (!gt)
+        return -1;
+    gt->threads = js_mallocz_rt(rt, sizeof(gt->threads[0]) * count);
+    if (!gt->threads) {
+        js_free_rt(rt, gt);
+        return -1;
+    }
+    gt->rt = rt;
+    gt->main_worker.gt = gt;
+    pthread_mutex_init(&gt->mutex, NULL);
+    pthread_cond_init(&gt->cond, NULL);
+    pthread_cond_init(&gt->done_cond, NULL);
+    pthread_cond_init(&gt->pool_cond, NULL);
+    rt->gc_threads = gt;
+    for(i = 0; i < count; i++) {
+        if (pthread_create(&gt->threads[i], NULL, gc_thread_func, gt)) {
+            /* keep the threads already created */
+            gt->count = i;
+            JS_SetGCThreads(rt, i);
+            return -1;
+        }
+        gt->count = i + 1;
+    }
+    return 0;
+}
+
+#else
+
+static BOOL gc_decref_scan_parallel(JSRuntime *rt)
+{
+    return FALSE;
+}
+
+int JS_SetGCThreads(JSRuntime *rt, int count)
+{
+    return count > 0 ? -1 : 0;
+}
+
+#endif /* !CONFIG_ATOMICS */
+
 /* Return false if not an object or if the object has already been
    freed (zombie objects are visible in finalizers when freeing
    cycles). */
@@ -6251,6 +7130,16 @@ static void compute_bytecode_size(JSFunctionBytecode *b, JSMemoryUsage_helper *h
     if (!b->read_only_bytecode && b->byte_code_buf) {
         hp->js_func_code_size += b->byte_code_len;
     }
+    if (b->ic) {
+        memory_used_count++;
+        js_func_size += b->ic_count * sizeof(*b->ic);
+        for (i = 0; i < b->ic_count; i++) {
+            if (!b->ic[i].is_global_var && b->ic[i].u.entries) {
+                memory_used_count++;
+                js_func_size += b->ic[i].count * sizeof(*b->ic[i].u.entries);
+            }
+        }
+    }
     if (b->has_debug) {
         js_func_size += sizeof(*b) - offsetof(JSFunctionBytecode, debug);
         if (b->debug.source) {
@@ -6556,6 +7445,16 @@ void JS_ComputeMemoryUsage(JSRuntime *rt, JSMemoryUsage *s)
         s->atom_count + s->str_count +
         s->obj_count + s->shape_count +
         s->js_func_count + s->js_func_pc2line_count;
+#ifdef CONFIG_JIT
+    {
+        /* the native code is reported with the bytecode so that the
+           layout of JSMemoryUsage does not change */
+        int64_t chunk_count, chunk_size;
+        js_jit_code_usage(rt, &chunk_count, &chunk_size);
+        s->memory_used_count += chunk_count;
+        s->js_func_code_size += chunk_size;
+    }
+#endif
     s->memory_used_size += s->atom_size + s->str_size +
         s->obj_size + s->prop_size + s->shape_size +
         s->js_func_size + s->js_func_code_size + s->js_func_pc2line_size;
@@ -7171,6 +8070,18 @@ static no_inline __exception int __js_poll_interrupts(JSContext *ctx)
 {
     JSRuntime *rt = ctx->rt;
     ctx->interrupt_counter = JS_INTERRUPT_COUNTER_INIT;
+#ifdef CONFIG_JIT
+    if (rt->jit_threshold != 0 && rt->current_stack_frame) {
+        /* sample the loops of the running function */
+        JSValueConst func = rt->current_stack_frame->cur_func;
+        if (JS_VALUE_GET_TAG(func) == JS_TAG_OBJECT &&
+            JS_VALUE_GET_OBJ(func)->class_id == JS_CLASS_BYTECODE_FUNCTION) {
+            JSFunctionBytecode *b = JS_VALUE_GET_OBJ(func)->u.func.function_bytecode;
+            if (b->jit_counter < UINT32_MAX - JS_JIT_LOOP_WEIGHT)
+                b->jit_counter += JS_JIT_LOOP_WEIGHT;
+        }
+    }
+#endif
     if (rt->interrupt_handler) {
         if (rt->interrupt_handler(rt, rt->interrupt_opaque)) {
             JS_ThrowInterrupted(ctx);
@@ -9075,6 +9986,438 @@ int JS_SetPropertyInternal(JSContext *ctx, JSValueConst obj,
     }
 }
 
+/* Inline caches of OP_get_field, OP_get_field2 and OP_put_field.
+
+   js_ic_init() gives each of these instructions a JSInlineCache: the
+   atom operand becomes the cache index and the atom moves into the
+   cache.
+
+   An entry matches a receiver by shape and class, then checks the
+   shape of each prototype it walked. Only hashed shapes are cached and
+   the entries hold a reference to their shapes. A shared hashed shape
+   is never modified in place (js_shape_prepare_update() and
+   add_property() clone it), so a cached shape keeps its prototype and
+   its property flags, and any change of an object gives it another
+   shape. */
+
+/* TRUE if a lookup of 'atom' that misses the own properties of 'p'
+   continues with its prototype without exotic behavior */
+static BOOL js_ic_is_transparent(JSRuntime *rt, JSObject *p, JSAtom atom)
+{
+    JSString *str;
+    int c;
+
+    if (!p->is_exotic || p->class_id == JS_CLASS_ARRAY)
+        return TRUE;
+    if (p->class_id < JS_CLASS_UINT8C_ARRAY ||
+        p->class_id > JS_CLASS_FLOAT64_ARRAY)
+        return FALSE;
+    /* typed array: 'atom' must not be a canonical numeric string (same
+       test as JS_AtomIsNumericIndex1() before the conversion) */
+    str = rt->atom_array[atom];
+    if (str->atom_type != JS_ATOM_TYPE_STRING || str->len == 0)
+        return TRUE;
+    if (atom == JS_ATOM_Infinity || atom == JS_ATOM_NaN)
+        return FALSE;
+    c = string_get(str, 0);
+    return !is_num(c) && c != '-';
+}
+
+/* An object loses its hashed shape when a property is redefined or a
+   lazily created property is instantiated, as most built-in objects
+   are. Hash the shape of 'p' again so that it can be cached: later
+   changes of 'p' then clone its shape instead of modifying it. */
+static BOOL js_ic_hash_shape(JSRuntime *rt, JSObject *p)
+{
+    JSShape *sh = p->shape;
+    JSShapeProperty *pr;
+    uint32_t h, i;
+
+    if (sh->is_hashed)
+        return TRUE;
+    if (sh->header.ref_count != 1 || sh->deleted_prop_count != 0)
+        return FALSE;
+    /* same hash as the shapes built by add_shape_property() */
+    h = shape_initial_hash(sh->proto);
+    for(i = 0, pr = get_shape_prop(sh); i < sh->prop_count; i++, pr++)
+        h = shape_hash(shape_hash(h, pr->atom), pr->flags);
+    sh->hash = h;
+    sh->is_hashed = TRUE;
+    js_shape_hash_link(rt, sh);
+    return TRUE;
+}
+
+static void js_ic_dup_entry(JSInlineCacheEntry *e)
+{
+    int i;
+
+    js_dup_shape(e->shape);
+    for(i = 0; i < e->depth; i++)
+        js_dup_shape(e->proto_shape[i]);
+    if (e->new_shape)
+        js_dup_shape(e->new_shape);
+}
+
+static void js_ic_free_entry(JSRuntime *rt, JSInlineCacheEntry *e)
+{
+    int i;
+
+    js_free_shape(rt, e->shape);
+    for(i = 0; i < e->depth; i++)
+        js_free_shape(rt, e->proto_shape[i]);
+    js_free_shape_null(rt, e->new_shape);
+}
+
+static void js_ic_free_entries(JSRuntime *rt, JSInlineCache *ic)
+{
+    int i;
+
+    for(i = 0; i < ic->count; i++)
+        js_ic_free_entry(rt, &ic->u.entries[i]);
+    js_free_rt(rt, ic->u.entries);
+    ic->u.entries = NULL;
+    ic->count = 0;
+}
+
+static void js_ic_mark(JSRuntime *rt, JSFunctionBytecode *b,
+                       JS_MarkFunc *mark_func)
+{
+    JSInlineCacheEntry *e;
+    uint32_t i;
+    int j, k;
+
+    for(i = 0; i < b->ic_count; i++) {
+        if (b->ic[i].is_global_var)
+            continue;
+        for(j = 0; j < b->ic[i].count; j++) {
+            e = &b->ic[i].u.entries[j];
+            mark_func(rt, &e->shape->header);
+            for(k = 0; k < e->depth; k++)
+                mark_func(rt, &e->proto_shape[k]->header);
+            if (e->new_shape)
+                mark_func(rt, &e->new_shape->header);
+        }
+    }
+}
+
+/* add 'e', whose shape references are taken by the cache */
+static void js_ic_add_entry(JSRuntime *rt, JSInlineCache *ic,
+                            JSInlineCacheEntry *e)
+{
+    JSInlineCacheEntry *entries;
+    int i;
+
+    /* an entry with the same receiver shape missed because a prototype
+       changed: replace it */
+    for(i = 0; i < ic->count; i++) {
+        if (ic->u.entries[i].shape == e->shape &&
+            ic->u.entries[i].class_id == e->class_id) {
+            js_ic_free_entry(rt, &ic->u.entries[i]);
+            ic->u.entries[i] = *e;
+            return;
+        }
+    }
+    if (ic->count == JS_IC_MAX_ENTRIES) {
+        js_ic_free_entry(rt, e);
+        js_ic_free_entries(rt, ic);
+        ic->megamorphic = TRUE;
+        return;
+    }
+    entries = js_realloc_rt(rt, ic->u.entries,
+                            sizeof(entries[0]) * (ic->count + 1));
+    if (!entries) {
+        js_ic_free_entry(rt, e);
+        return;
+    }
+    entries[ic->count++] = *e;
+    ic->u.entries = entries;
+}
+
+/* code that runs once does not pay for the cache entries */
+static BOOL js_ic_can_fill(JSInlineCache *ic)
+{
+    if (ic->megamorphic)
+        return FALSE;
+    if (!ic->missed) {
+        ic->missed = TRUE;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* return the entry matching the receiver 'p' and set '*pholder' to
+   the object holding the property, or return NULL */
+static force_inline JSInlineCacheEntry *js_ic_lookup(JSInlineCache *ic,
+                                                     JSObject *p,
+                                                     JSObject **pholder)
+{
+    JSInlineCacheEntry *e, *e_end;
+    JSObject *p1;
+    int i;
+
+    e_end = ic->u.entries + ic->count;
+    for(e = ic->u.entries; e < e_end; e++) {
+        if (e->shape != p->shape)
+            continue;
+        /* own properties are found before any exotic behavior */
+        if (likely(e->depth == 0 && e->kind != JS_IC_PUT_ADD)) {
+            *pholder = p;
+            return e;
+        }
+        if (e->class_id != p->class_id)
+            continue;
+        p1 = p;
+        for(i = 0; i < e->depth; i++) {
+            /* not NULL: it is fixed by the previous shape */
+            p1 = p1->shape->proto;
+            if (p1->shape != e->proto_shape[i])
+                break;
+        }
+        if (i == e->depth) {
+            *pholder = p1;
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* called on a miss before the generic [[Get]] of ic->atom on 'p' */
+static void js_ic_update_get(JSContext *ctx, JSInlineCache *ic, JSObject *p)
+{
+    JSInlineCacheEntry e;
+    JSShapeProperty *prs;
+    JSProperty *pr;
+    JSObject *p1;
+
+    if (!js_ic_can_fill(ic) || !js_ic_hash_shape(ctx->rt, p))
+        return;
+    memset(&e, 0, sizeof(e));
+    e.shape = p->shape;
+    e.class_id = p->class_id;
+    p1 = p;
+    for(;;) {
+        prs = find_own_property(&pr, p1, ic->atom);
+        if (prs)
+            break;
+        if (!js_ic_is_transparent(ctx->rt, p1, ic->atom) ||
+            e.depth == JS_IC_MAX_DEPTH)
+            return;
+        p1 = p1->shape->proto;
+        if (!p1 || !js_ic_hash_shape(ctx->rt, p1))
+            return;
+        e.proto_shape[e.depth++] = p1->shape;
+    }
+    switch(prs->flags & JS_PROP_TMASK) {
+    case JS_PROP_NORMAL:
+        e.kind = JS_IC_GET_VALUE;
+        break;
+    case JS_PROP_GETSET:
+        e.kind = JS_IC_GET_GETTER;
+        break;
+    default:
+        return;
+    }
+    e.prop_index = pr - p1->prop;
+    js_ic_dup_entry(&e);
+    js_ic_add_entry(ctx->rt, ic, &e);
+}
+
+/* called on a miss before the generic [[Set]] of ic->atom on 'p'.
+   Return TRUE if the set adds an own property: 'e' then holds the
+   references of a JS_IC_PUT_ADD entry for js_ic_finish_add(). */
+static BOOL js_ic_update_put(JSContext *ctx, JSInlineCache *ic, JSObject *p,
+                             JSInlineCacheEntry *e)
+{
+    JSShapeProperty *prs;
+    JSProperty *pr;
+    JSObject *p1;
+
+    if (!js_ic_can_fill(ic) || !js_ic_hash_shape(ctx->rt, p))
+        return FALSE;
+    memset(e, 0, sizeof(*e));
+    e->shape = p->shape;
+    e->class_id = p->class_id;
+    p1 = p;
+    prs = find_own_property(&pr, p1, ic->atom);
+    if (prs) {
+        if ((prs->flags & (JS_PROP_TMASK | JS_PROP_WRITABLE |
+                           JS_PROP_LENGTH)) == JS_PROP_WRITABLE)
+            e->kind = JS_IC_PUT_VALUE;
+        else if ((prs->flags & JS_PROP_TMASK) == JS_PROP_GETSET)
+            e->kind = JS_IC_PUT_SETTER;
+        else
+            return FALSE;
+    } else {
+        if (p->is_exotic)
+            return FALSE;
+        /* the property is added unless a prototype has a setter */
+        e->kind = JS_IC_PUT_ADD;
+        for(;;) {
+            p1 = p1->shape->proto;
+            if (!p1)
+                break;
+            if (e->depth == JS_IC_MAX_DEPTH ||
+                !js_ic_hash_shape(ctx->rt, p1))
+                return FALSE;
+            e->proto_shape[e->depth++] = p1->shape;
+            prs = find_own_property(&pr, p1, ic->atom);
+            if (prs) {
+                if ((prs->flags & JS_PROP_TMASK) == JS_PROP_GETSET)
+                    e->kind = JS_IC_PUT_SETTER;
+                else if ((prs->flags & (JS_PROP_TMASK | JS_PROP_WRITABLE)) !=
+                         JS_PROP_WRITABLE)
+                    return FALSE;
+                break;
+            }
+            if (!js_ic_is_transparent(ctx->rt, p1, ic->atom))
+                return FALSE;
+        }
+    }
+    js_ic_dup_entry(e);
+    if (e->kind == JS_IC_PUT_ADD)
+        return TRUE;
+    e->prop_index = pr - p1->prop;
+    js_ic_add_entry(ctx->rt, ic, e);
+    return FALSE;
+}
+
+/* complete the entry prepared by js_ic_update_put() once the generic
+   [[Set]] on 'p' returned 'ret' */
+static void js_ic_finish_add(JSRuntime *rt, JSInlineCache *ic, JSObject *p,
+                             JSInlineCacheEntry *e, int ret)
+{
+    JSShape *sh, *old_sh;
+    JSShapeProperty *prs;
+
+    sh = p->shape;
+    old_sh = e->shape;
+    /* add_property() gives the shape of 'old_sh' plus the property */
+    if (ret == TRUE && !ic->megamorphic && sh->is_hashed &&
+        sh->proto == old_sh->proto &&
+        sh->prop_count == old_sh->prop_count + 1 &&
+        sh->deleted_prop_count == old_sh->deleted_prop_count) {
+        prs = &get_shape_prop(sh)[sh->prop_count - 1];
+        if (prs->atom == ic->atom && prs->flags == JS_PROP_C_W_E) {
+            e->new_shape = js_dup_shape(sh);
+            e->prop_index = sh->prop_count - 1;
+            js_ic_add_entry(rt, ic, e);
+            return;
+        }
+    }
+    js_ic_free_entry(rt, e);
+}
+
+static no_inline JSValue js_ic_get_field_slow(JSContext *ctx,
+                                              JSInlineCache *ic,
+                                              JSValueConst obj)
+{
+    if (JS_VALUE_GET_TAG(obj) == JS_TAG_OBJECT)
+        js_ic_update_get(ctx, ic, JS_VALUE_GET_OBJ(obj));
+    return JS_GetProperty(ctx, obj, ic->atom);
+}
+
+/* OP_get_field and OP_get_field2 of 'b': JS_GetProperty() of the atom
+   of cache 'idx', or of the atom 'idx' if 'b' has no caches */
+static no_inline JSValue js_ic_get_field(JSContext *ctx, JSFunctionBytecode *b,
+                                         uint32_t idx, JSValueConst obj)
+{
+    JSInlineCache *ic;
+    JSInlineCacheEntry *e;
+    JSObject *p, *holder;
+    JSProperty *pr;
+    JSValue func;
+
+    if (unlikely(!b->ic))
+        return JS_GetProperty(ctx, obj, idx);
+    ic = &b->ic[idx];
+    if (likely(JS_VALUE_GET_TAG(obj) == JS_TAG_OBJECT)) {
+        p = JS_VALUE_GET_OBJ(obj);
+        e = js_ic_lookup(ic, p, &holder);
+        if (likely(e)) {
+            pr = &holder->prop[e->prop_index];
+            if (likely(e->kind == JS_IC_GET_VALUE))
+                return JS_DupValue(ctx, pr->u.value);
+            if (unlikely(!pr->u.getset.getter))
+                return JS_UNDEFINED;
+            /* the getter can free the property and the cache entry */
+            func = JS_DupValue(ctx, JS_MKPTR(JS_TAG_OBJECT, pr->u.getset.getter));
+            return JS_CallFree(ctx, func, obj, 0, NULL);
+        }
+    }
+    return js_ic_get_field_slow(ctx, ic, obj);
+}
+
+static no_inline int js_ic_put_field_slow(JSContext *ctx, JSInlineCache *ic,
+                                          JSValueConst obj, JSValue val)
+{
+    JSInlineCacheEntry e;
+    BOOL add;
+    int ret;
+
+    add = FALSE;
+    if (JS_VALUE_GET_TAG(obj) == JS_TAG_OBJECT)
+        add = js_ic_update_put(ctx, ic, JS_VALUE_GET_OBJ(obj), &e);
+    ret = JS_SetPropertyInternal(ctx, obj, ic->atom, val, obj,
+                                 JS_PROP_THROW_STRICT);
+    /* 'obj' is kept alive by the caller */
+    if (add)
+        js_ic_finish_add(ctx->rt, ic, JS_VALUE_GET_OBJ(obj), &e, ret);
+    return ret;
+}
+
+/* OP_put_field of 'b', as js_ic_get_field(). 'val' is freed. */
+static no_inline int js_ic_put_field(JSContext *ctx, JSFunctionBytecode *b,
+                                     uint32_t idx, JSValueConst obj,
+                                     JSValue val)
+{
+    JSInlineCache *ic;
+    JSInlineCacheEntry *e;
+    JSObject *p, *holder;
+    JSShape *sh, *new_sh;
+    JSProperty *new_prop;
+
+    if (unlikely(!b->ic))
+        return JS_SetPropertyInternal(ctx, obj, idx, val, obj,
+                                      JS_PROP_THROW_STRICT);
+    ic = &b->ic[idx];
+    if (likely(JS_VALUE_GET_TAG(obj) == JS_TAG_OBJECT)) {
+        p = JS_VALUE_GET_OBJ(obj);
+        e = js_ic_lookup(ic, p, &holder);
+        if (likely(e)) {
+            switch(e->kind) {
+            case JS_IC_PUT_VALUE:
+                set_value(ctx, &p->prop[e->prop_index].u.value, val);
+                return TRUE;
+            case JS_IC_PUT_SETTER:
+                return call_setter(ctx, holder->prop[e->prop_index].u.getset.setter,
+                                   obj, val, JS_PROP_THROW_STRICT);
+            case JS_IC_PUT_ADD:
+                if (unlikely(!p->extensible))
+                    break;
+                /* same as add_property() with a matching hashed shape */
+                sh = p->shape;
+                new_sh = e->new_shape;
+                if (new_sh->prop_size != sh->prop_size) {
+                    new_prop = js_realloc(ctx, p->prop, sizeof(p->prop[0]) *
+                                          new_sh->prop_size);
+                    if (!new_prop) {
+                        JS_FreeValue(ctx, val);
+                        return -1;
+                    }
+                    p->prop = new_prop;
+                }
+                p->shape = js_dup_shape(new_sh);
+                js_free_shape(ctx->rt, sh);
+                p->prop[new_sh->prop_count - 1].u.value = val;
+                return TRUE;
+            default:
+                break;
+            }
+        }
+    }
+    return js_ic_put_field_slow(ctx, ic, obj, val);
+}
+
 /* flags can be JS_PROP_THROW or JS_PROP_THROW_STRICT */
 static int JS_SetPropertyValue(JSContext *ctx, JSValueConst this_obj,
                                JSValue prop, JSValue val, int flags)
@@ -9955,6 +11298,9 @@ static int JS_DefineGlobalVar(JSContext *ctx, JSAtom prop, int def_flags)
     if (unlikely(!pr))
         return -1;
     pr->u.value = val;
+    /* the new lexical variable may shadow a cached global_obj property */
+    if (def_flags & DEFINE_GLOBAL_LEX_VAR)
+        ctx->global_lexical_gen++;
     return 0;
 }
 
@@ -10098,6 +11444,122 @@ static int JS_SetGlobalVar(JSContext *ctx, JSAtom prop, JSValue val,
     return JS_SetPropertyInternal(ctx, ctx->global_obj, prop, val, ctx->global_obj, flags);
 }
 
+/* Global variable caches of OP_get_var, OP_get_var_undef, OP_put_var,
+   OP_put_var_init and OP_put_var_strict (see js_ic_init()).
+
+   A cache keeps the index of the variable in global_var_obj or
+   global_obj. These objects are never exotic and their properties only
+   move when a deleted property is compacted, which clears its atom, so
+   the cached index holds the variable as long as the atom of its shape
+   property matches. A global_obj variable is also shadowed by a
+   let/const declared later in global_var_obj. */
+
+/* called on a miss before the generic access */
+static void js_ic_update_global_var(JSContext *ctx, JSInlineCache *ic)
+{
+    JSShapeProperty *prs;
+    JSProperty *pr;
+    JSObject *p;
+    BOOL is_lexical;
+
+    if (!js_ic_can_fill(ic))
+        return;
+    is_lexical = TRUE;
+    p = JS_VALUE_GET_OBJ(ctx->global_var_obj);
+    prs = find_own_property(&pr, p, ic->atom);
+    if (!prs) {
+        is_lexical = FALSE;
+        p = JS_VALUE_GET_OBJ(ctx->global_obj);
+        prs = find_own_property(&pr, p, ic->atom);
+        if (!prs)
+            return;
+    }
+    if ((prs->flags & JS_PROP_TMASK) != JS_PROP_NORMAL)
+        return;
+    ic->count = 1;
+    ic->is_lexical = is_lexical;
+    ic->u.global.prop_index = pr - p->prop;
+    ic->u.global.lexical_gen = ctx->global_lexical_gen;
+}
+
+/* return the data property of the cached global variable and set
+   '*pflags' to its flags, or return NULL */
+static force_inline JSProperty *js_ic_lookup_global_var(JSContext *ctx,
+                                                        JSInlineCache *ic,
+                                                        int *pflags)
+{
+    JSShapeProperty *prs;
+    JSObject *p;
+    uint32_t idx;
+
+    if (!ic->count)
+        return NULL;
+    if (ic->is_lexical) {
+        p = JS_VALUE_GET_OBJ(ctx->global_var_obj);
+    } else {
+        if (unlikely(ic->u.global.lexical_gen != ctx->global_lexical_gen))
+            return NULL;
+        p = JS_VALUE_GET_OBJ(ctx->global_obj);
+    }
+    idx = ic->u.global.prop_index;
+    if (unlikely(idx >= p->shape->prop_count))
+        return NULL;
+    prs = &get_shape_prop(p->shape)[idx];
+    if (unlikely(prs->atom != ic->atom ||
+                 (prs->flags & JS_PROP_TMASK) != JS_PROP_NORMAL))
+        return NULL;
+    *pflags = prs->flags;
+    return &p->prop[idx];
+}
+
+/* atom operand of an instruction of 'b' which may have a cache */
+static inline JSAtom js_ic_get_atom(JSFunctionBytecode *b, uint32_t idx)
+{
+    return b->ic ? b->ic[idx].atom : idx;
+}
+
+/* OP_get_var and OP_get_var_undef of 'b': JS_GetGlobalVar() of the atom
+   of cache 'idx', or of the atom 'idx' if 'b' has no caches */
+static no_inline JSValue js_ic_get_var(JSContext *ctx, JSFunctionBytecode *b,
+                                       uint32_t idx, BOOL throw_ref_error)
+{
+    JSInlineCache *ic;
+    JSProperty *pr;
+    int flags;
+
+    if (unlikely(!b->ic))
+        return JS_GetGlobalVar(ctx, idx, throw_ref_error);
+    ic = &b->ic[idx];
+    pr = js_ic_lookup_global_var(ctx, ic, &flags);
+    /* an uninitialized let/const throws in the generic case */
+    if (likely(pr && !JS_IsUninitialized(pr->u.value)))
+        return JS_DupValue(ctx, pr->u.value);
+    js_ic_update_global_var(ctx, ic);
+    return JS_GetGlobalVar(ctx, ic->atom, throw_ref_error);
+}
+
+/* OP_put_var, OP_put_var_init and OP_put_var_strict of 'b', as
+   js_ic_get_var() for JS_SetGlobalVar(). 'val' is freed. */
+static no_inline int js_ic_put_var(JSContext *ctx, JSFunctionBytecode *b,
+                                   uint32_t idx, JSValue val, int flag)
+{
+    JSInlineCache *ic;
+    JSProperty *pr;
+    int flags;
+
+    if (unlikely(!b->ic))
+        return JS_SetGlobalVar(ctx, idx, val, flag);
+    ic = &b->ic[idx];
+    pr = js_ic_lookup_global_var(ctx, ic, &flags);
+    if (likely(pr && (flags & JS_PROP_WRITABLE) &&
+               !JS_IsUninitialized(pr->u.value))) {
+        set_value(ctx, &pr->u.value, val);
+        return 0;
+    }
+    js_ic_update_global_var(ctx, ic);
+    return JS_SetGlobalVar(ctx, ic->atom, val, flag);
+}
+
 /* return -1, FALSE or TRUE. return FALSE if not configurable or
    invalid object. return -1 in case of exception.
    flags can be 0, JS_PROP_THROW or JS_PROP_THROW_STRICT */
@@ -13553,6 +15015,57 @@ static no_inline int js_not_slow(JSContext *ctx, JSValue *sp)
     return -1;
 }
 
+/* Quickening: OP_add, OP_sub and OP_mul rewrite themselves in place to
+   their float64 variant (OP_add_f64...) when they see operands which are
+   numbers but not both int32. The variant tests float64 first and
+   deoptimizes, i.e. rewrites the generic instruction back and executes
+   it, on operands which are not numbers. A function which deoptimizes
+   JS_QUICKEN_MAX_DEOPT times keeps the generic instructions. */
+#define JS_QUICKEN_MAX_DEOPT 7
+
+/* 'pc' points after the instruction */
+static inline BOOL js_quicken(JSFunctionBytecode *b, const uint8_t *pc,
+                              OPCodeEnum op)
+{
+    if (b->read_only_bytecode ||
+        b->quicken_deopt_count >= JS_QUICKEN_MAX_DEOPT)
+        return FALSE;
+    *(uint8_t *)(pc - 1) = op;
+    return TRUE;
+}
+
+static void js_deoptimize(JSFunctionBytecode *b, const uint8_t *pc,
+                          OPCodeEnum op)
+{
+    *(uint8_t *)(pc - 1) = op;
+    if (b->quicken_deopt_count < JS_QUICKEN_MAX_DEOPT)
+        b->quicken_deopt_count++;
+}
+
+/* generic instruction of a quickened one */
+static int js_unquicken_op(int op)
+{
+    switch(op) {
+    case OP_add_f64:
+        return OP_add;
+    case OP_sub_f64:
+        return OP_sub;
+    case OP_mul_f64:
+        return OP_mul;
+    default:
+        return op;
+    }
+}
+
+/* 'v' must be a number */
+static inline double js_number_get_float64(JSValueConst v)
+{
+    if (JS_VALUE_GET_TAG(v) == JS_TAG_INT)
+        return JS_VALUE_GET_INT(v);
+    else
+        return JS_VALUE_GET_FLOAT64(v);
+}
+
 static no_inline __exception int js_binary_arith_slow(JSContext *ctx, JSValue *sp,
                                                       OPCodeEnum op)
 {
@@ -16160,12 +17673,32 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
     JSValue *local_buf, *stack_buf, *var_buf, *arg_buf, *sp, ret_val, *pval;
     JSVarRef **var_refs;
     size_t alloca_size;
+    /* profile node of the caller if the frame is profiled (see
+       JS_SetProfiling()) */
+    JSProfileNode *prof_parent = NULL;
+
+#define PROFILE_OP() do {                                   \
+        JSProfile *prof_ = rt->profile;                     \
+        prof_->op_count[opcode]++;                          \
+        if (pc <= prof_->last_pc)                           \
+            prof_->cur->loops++;                            \
+        prof_->last_pc = (opcode == OP_ret) ? NULL : pc;    \
+    } while (0)
 
 #if !DIRECT_DISPATCH
-#define SWITCH(pc)      switch (opcode = *pc++)
+#ifdef DUMP_OPCODE_PAIRS
+#define SWITCH(pc)      opcode = js_count_opcode(*pc++);        \
+                        if (unlikely(prof_parent)) PROFILE_OP(); \
+                        switch (opcode)
+#else
+#define SWITCH(pc)      opcode = *pc++;                         \
+                        if (unlikely(prof_parent)) PROFILE_OP(); \
+                        switch (opcode)
+#endif
 #define CASE(op)        case op
 #define DEFAULT         default
 #define BREAK           break
+#define PROFILE_DISPATCH()
 #else
     static const void * const dispatch_table[256] = {
 #define DEF(id, size, n_pop, n_push, f) && case_OP_ ## id,
@@ -16177,10 +17710,20 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
 #include "quickjs-opcode.h"
         [ OP_COUNT ... 255 ] = &&case_default
     };
-#define SWITCH(pc)      goto *dispatch_table[opcode = *pc++];
+    /* a profiled frame counts each instruction in case_profile */
+    static const void * const profile_dispatch_table[256] = {
+        [ 0 ... 255 ] = &&case_profile
+    };
+    const void * const *dispatch = dispatch_table;
+#ifdef DUMP_OPCODE_PAIRS
+#define SWITCH(pc)      goto *dispatch[opcode = js_count_opcode(*pc++)];
+#else
+#define SWITCH(pc)      goto *dispatch[opcode = *pc++];
+#endif
 #define CASE(op)        case_ ## op
 #define DEFAULT         case_default
 #define BREAK           SWITCH(pc)
+#define PROFILE_DISPATCH() (dispatch = profile_dispatch_table)
 #endif
 
     if (js_poll_interrupts(caller_ctx))
@@ -16203,6 +17746,13 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
             pc = sf->cur_pc;
             sf->prev_frame = rt->current_stack_frame;
             rt->current_stack_frame = sf;
+            if (unlikely(rt->profiling)) {
+                /* the first resume of a generator or async function
+                   is its call */
+                prof_parent = js_profile_enter(rt, b,
+                                               pc == b->byte_code_buf);
+                PROFILE_DISPATCH();
+            }
             if (s->throw_flag)
                 goto exception;
             else
@@ -16266,6 +17816,26 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
     rt->current_stack_frame = sf;
     ctx = b->realm; /* set the current realm */
 
+    if (unlikely(rt->profiling)) {
+        /* no native code so that all the instructions are counted */
+        prof_parent = js_profile_enter(rt, b, TRUE);
+        PROFILE_DISPATCH();
+    } else if (unlikely(rt->native_code)) {
+        int ret;
+        sf->cur_sp = sp;
+        ret = js_jit_enter(ctx, b, sf, this_obj, new_target, argc,
+                           (JSValueConst *)argv, var_refs);
+        pc = sf->cur_pc;
+        sp = sf->cur_sp;
+        if (ret < 0)
+            goto exception;
+        if (ret > 0) {
+            /* a function with an empty stack can only return undefined */
+            ret_val = ret == 1 ? *--sp : JS_UNDEFINED;
+            goto done;
+        }
+    }
+
  restart:
     for(;;) {
         int call_argc;
@@ -16900,12 +18470,36 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 pc += 4;
                 sf->cur_pc = pc;
 
-                val = JS_GetGlobalVar(ctx, atom, opcode - OP_get_var_undef);
+                val = js_ic_get_var(ctx, b, atom, opcode - OP_get_var_undef);
                 if (unlikely(JS_IsException(val)))
                     goto exception;
                 *sp++ = val;
             }
             BREAK;
+#if SHORT_OPCODES
+        CASE(OP_get_var_get_field2):
+            {
+                JSValue val;
+                JSAtom atom;
+                atom = get_u32(pc);
+                pc += 4;
+                sf->cur_pc = pc;
+
+                val = js_ic_get_var(ctx, b, atom, TRUE);
+                if (unlikely(JS_IsException(val)))
+                    goto exception;
+                *sp++ = val;
+                /* get_field2 */
+                atom = get_u32(pc + 1);
+                pc += 5;
+                sf->cur_pc = pc;
+                val = js_ic_get_field(ctx, b, atom, sp[-1]);
+                if (unlikely(JS_IsException(val)))
+                    goto exception;
+                *sp++ = val;
+            }
+            BREAK;
+#endif
 
         CASE(OP_put_var):
         CASE(OP_put_var_init):
@@ -16916,7 +18510,7 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 pc += 4;
                 sf->cur_pc = pc;
 
-                ret = JS_SetGlobalVar(ctx, atom, sp[-1], opcode - OP_put_var);
+                ret = js_ic_put_var(ctx, b, atom, sp[-1], opcode - OP_put_var);
                 sp--;
                 if (unlikely(ret < 0))
                     goto exception;
@@ -16933,10 +18527,10 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
 
                 /* sp[-2] is JS_TRUE or JS_FALSE */
                 if (unlikely(!JS_VALUE_GET_INT(sp[-2]))) {
-                    JS_ThrowReferenceErrorNotDefined(ctx, atom);
+                    JS_ThrowReferenceErrorNotDefined(ctx, js_ic_get_atom(b, atom));
                     goto exception;
                 }
-                ret = JS_SetGlobalVar(ctx, atom, sp[-1], 2);
+                ret = js_ic_put_var(ctx, b, atom, sp[-1], 2);
                 sp -= 2;
                 if (unlikely(ret < 0))
                     goto exception;
@@ -17554,7 +19148,7 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 pc += 4;
 
                 sf->cur_pc = pc;
-                val = JS_GetProperty(ctx, sp[-1], atom);
+                val = js_ic_get_field(ctx, b, atom, sp[-1]);
                 if (unlikely(JS_IsException(val)))
                     goto exception;
                 JS_FreeValue(ctx, sp[-1]);
@@ -17570,7 +19164,7 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 pc += 4;
 
                 sf->cur_pc = pc;
-                val = JS_GetProperty(ctx, sp[-1], atom);
+                val = js_ic_get_field(ctx, b, atom, sp[-1]);
                 if (unlikely(JS_IsException(val)))
                     goto exception;
                 *sp++ = val;
@@ -17585,8 +19179,7 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 pc += 4;
                 sf->cur_pc = pc;
 
-                ret = JS_SetPropertyInternal(ctx, sp[-2], atom, sp[-1], sp[-2],
-                                             JS_PROP_THROW_STRICT);
+                ret = js_ic_put_field(ctx, b, atom, sp[-2], sp[-1]);
                 JS_FreeValue(ctx, sp[-2]);
                 sp -= 2;
                 if (unlikely(ret < 0))
@@ -17982,6 +19575,7 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                     sp[-2] = JS_NewInt32(ctx, r);
                     sp--;
                 } else if (JS_VALUE_IS_BOTH_FLOAT(op1, op2)) {
+                    js_quicken(b, pc, OP_add_f64);
                     sp[-2] = __JS_NewFloat64(ctx, JS_VALUE_GET_FLOAT64(op1) +
                                              JS_VALUE_GET_FLOAT64(op2));
                     sp--;
@@ -17990,6 +19584,9 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                     sp--;
                     if (JS_IsException(sp[-1]))
                         goto exception;
+                } else if (JS_IsNumber(op1) && JS_IsNumber(op2) &&
+                           js_quicken(b, pc, OP_add_f64)) {
+                    pc--; /* executed again as OP_add_f64 */
                 } else {
                 add_slow:
                     sf->cur_pc = pc;
@@ -18062,9 +19659,13 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                     sp[-2] = JS_NewInt32(ctx, r);
                     sp--;
                 } else if (JS_VALUE_IS_BOTH_FLOAT(op1, op2)) {
+                    js_quicken(b, pc, OP_sub_f64);
                     sp[-2] = __JS_NewFloat64(ctx, JS_VALUE_GET_FLOAT64(op1) -
                                              JS_VALUE_GET_FLOAT64(op2));
                     sp--;
+                } else if (JS_IsNumber(op1) && JS_IsNumber(op2) &&
+                           js_quicken(b, pc, OP_sub_f64)) {
+                    pc--; /* executed again as OP_sub_f64 */
                 } else {
                     goto binary_arith_slow;
                 }
@@ -18094,10 +19695,14 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                     sp[-2] = JS_NewInt32(ctx, r);
                     sp--;
                 } else if (JS_VALUE_IS_BOTH_FLOAT(op1, op2)) {
+                    js_quicken(b, pc, OP_mul_f64);
                     d = JS_VALUE_GET_FLOAT64(op1) * JS_VALUE_GET_FLOAT64(op2);
                 mul_fp_res:
                     sp[-2] = __JS_NewFloat64(ctx, d);
                     sp--;
+                } else if (JS_IsNumber(op1) && JS_IsNumber(op2) &&
+                           js_quicken(b, pc, OP_mul_f64)) {
+                    pc--; /* executed again as OP_mul_f64 */
                 } else {
                     goto binary_arith_slow;
                 }
@@ -18114,6 +19719,10 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                     v2 = JS_VALUE_GET_INT(op2);
                     sp[-2] = JS_NewFloat64(ctx, (double)v1 / (double)v2);
                     sp--;
+                } else if (JS_VALUE_IS_BOTH_FLOAT(op1, op2)) {
+                    sp[-2] = JS_NewFloat64(ctx, JS_VALUE_GET_FLOAT64(op1) /
+                                           JS_VALUE_GET_FLOAT64(op2));
+                    sp--;
                 } else {
                     goto binary_arith_slow;
                 }
@@ -18148,6 +19757,32 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
             sp--;
             BREAK;
 
+#define OP_ARITH_F64(opcode, generic_op, binary_op)                     \
+        CASE(opcode):                                                   \
+            {                                                           \
+                JSValue op1, op2;                                       \
+                op1 = sp[-2];                                           \
+                op2 = sp[-1];                                           \
+                if (likely(JS_VALUE_IS_BOTH_FLOAT(op1, op2))) {         \
+                    sp[-2] = __JS_NewFloat64(ctx, JS_VALUE_GET_FLOAT64(op1) binary_op \
+                                             JS_VALUE_GET_FLOAT64(op2)); \
+                    sp--;                                               \
+                } else if (likely(JS_IsNumber(op1) && JS_IsNumber(op2))) { \
+                    /* same result as js_binary_arith_slow() */         \
+                    sp[-2] = JS_NewFloat64(ctx, js_number_get_float64(op1) binary_op \
+                                           js_number_get_float64(op2)); \
+                    sp--;                                               \
+                } else {                                                \
+                    js_deoptimize(b, pc, generic_op);                   \
+                    pc--;                                               \
+                }                                                       \
+            }                                                           \
+            BREAK
+
+            OP_ARITH_F64(OP_add_f64, OP_add, +);
+            OP_ARITH_F64(OP_sub_f64, OP_sub, -);
+            OP_ARITH_F64(OP_mul_f64, OP_mul, *);
+
         CASE(OP_plus):
             {
                 JSValue op1;
@@ -18262,6 +19897,36 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 }
             }
             BREAK;
+#if SHORT_OPCODES
+        CASE(OP_inc_loc_goto8):
+            {
+                JSValue op1;
+                int val;
+                int idx;
+                idx = *pc;
+                pc += 1;
+
+                op1 = var_buf[idx];
+                if (JS_VALUE_GET_TAG(op1) == JS_TAG_INT) {
+                    val = JS_VALUE_GET_INT(op1);
+                    if (unlikely(val == INT32_MAX))
+                        goto inc_loc_goto8_slow;
+                    var_buf[idx] = JS_NewInt32(ctx, val + 1);
+                } else {
+                inc_loc_goto8_slow:
+                    sf->cur_pc = pc;
+                    op1 = JS_DupValue(ctx, op1);
+                    if (js_unary_arith_slow(ctx, &op1 + 1, OP_inc))
+                        goto exception;
+                    set_value(ctx, &var_buf[idx], op1);
+                }
+                /* goto8 */
+                pc += 1 + (int8_t)pc[1];
+                if (unlikely(js_poll_interrupts(ctx)))
+                    goto exception;
+            }
+            BREAK;
+#endif
         CASE(OP_dec_loc):
             {
                 JSValue op1;
@@ -18428,6 +20093,9 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 if (likely(JS_VALUE_IS_BOTH_INT(op1, op2))) {           \
                     sp[-2] = JS_NewBool(ctx, JS_VALUE_GET_INT(op1) binary_op JS_VALUE_GET_INT(op2)); \
                     sp--;                                               \
+                } else if (JS_VALUE_IS_BOTH_FLOAT(op1, op2)) {          \
+                    sp[-2] = JS_NewBool(ctx, JS_VALUE_GET_FLOAT64(op1) binary_op JS_VALUE_GET_FLOAT64(op2)); \
+                    sp--;                                               \
                 } else {                                                \
                     sf->cur_pc = pc;                                    \
                     if (slow_call)                                      \
@@ -18446,6 +20114,61 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
             OP_CMP(OP_strict_eq, ==, js_strict_eq_slow(ctx, sp, 0));
             OP_CMP(OP_strict_neq, !=, js_strict_eq_slow(ctx, sp, 1));
 
+#if SHORT_OPCODES
+        CASE(OP_lt_if_false8):
+            {
+                JSValue op1, op2;
+                int res;
+
+                op1 = sp[-2];
+                op2 = sp[-1];
+                if (likely(JS_VALUE_IS_BOTH_INT(op1, op2))) {
+                    res = JS_VALUE_GET_INT(op1) < JS_VALUE_GET_INT(op2);
+                } else {
+                    sf->cur_pc = pc;
+                    if (js_relational_slow(ctx, sp, OP_lt))
+                        goto exception;
+                    res = JS_VALUE_GET_BOOL(sp[-2]);
+                }
+                sp -= 2;
+                /* if_false8 */
+                pc += 2;
+                if (!res)
+                    pc += (int8_t)pc[-1] - 1;
+                if (unlikely(js_poll_interrupts(ctx)))
+                    goto exception;
+            }
+            BREAK;
+        CASE(OP_push_i16_lt_if_false8):
+            {
+                JSValue op1;
+                int val, res;
+
+                val = (int16_t)get_u16(pc);
+                pc += 2;
+                op1 = sp[-1];
+                if (likely(JS_VALUE_GET_TAG(op1) == JS_TAG_INT)) {
+                    res = JS_VALUE_GET_INT(op1) < val;
+                } else {
+                    *sp++ = JS_NewInt32(ctx, val);
+                    /* after lt */
+                    sf->cur_pc = pc + 1;
+                    if (js_relational_slow(ctx, sp, OP_lt))
+                        goto exception;
+                    sp--;
+                    res = JS_VALUE_GET_BOOL(sp[-1]);
+                }
+                sp--;
+                /* lt if_false8 */
+                pc += 3;
+                if (!res)
+                    pc += (int8_t)pc[-1] - 1;
+                if (unlikely(js_poll_interrupts(ctx)))
+                    goto exception;
+            }
+            BREAK;
+#endif
+
         CASE(OP_in):
             sf->cur_pc = pc;
             if (js_operator_in(ctx, sp))
@@ -18727,6 +20450,11 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
             JS_ThrowInternalError(ctx, "invalid opcode: pc=%u opcode=0x%02x",
                                   (int)(pc - b->byte_code_buf - 1), opcode);
             goto exception;
+#if DIRECT_DISPATCH
+        case_profile:
+            PROFILE_OP();
+            goto *dispatch_table[opcode];
+#endif
         }
     }
  exception:
@@ -18776,6 +20504,8 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
             JS_FreeValue(ctx, *pval);
         }
     }
+    if (unlikely(prof_parent))
+        js_profile_exit(rt, prof_parent);
     rt->current_stack_frame = sf->prev_frame;
     return ret_val;
 }
@@ -19062,7 +20792,7 @@ static void __async_func_free(JSRuntime *rt, JSAsyncFunctionState *s)
     JS_FreeValueRT(rt, s->resolving_funcs[0]);
     JS_FreeValueRT(rt, s->resolving_funcs[1]);
 
-    remove_gc_object(&s->header);
+    remove_gc_object(rt, &s->header);
     if (rt->gc_phase == JS_GC_PHASE_REMOVE_CYCLES && s->header.ref_count != 0) {
         list_add_tail(&s->header.link, &rt->gc_zero_ref_count_list);
     } else {
@@ -19079,6 +20809,11 @@ static void async_func_free(JSRuntime *rt, JSAsyncFunctionState *s)
             if (rt->gc_phase == JS_GC_PHASE_NONE) {
                 free_zero_refcount(rt);
             }
+        } else if (s->header.mark == 0) {
+            /* not in the removed cycles: only referenced by them */
+            list_del(&s->header.link);
+            list_add_tail(&s->header.link, &rt->gc_slice_free_list);
+            s->header.mark = 1;
         }
     }
 }
@@ -19847,380 +21582,3579 @@ static JSValue js_async_generator_function_call(JSContext *ctx, JSValueConst fun
     return JS_EXCEPTION;
 }
 
-/* JS parser */
+/* JS parser */
+
+enum {
+    TOK_NUMBER = -128,
+    TOK_STRING,
+    TOK_TEMPLATE,
+    TOK_IDENT,
+    TOK_REGEXP,
+    /* warning: order matters (see js_parse_assign_expr) */
+    TOK_MUL_ASSIGN,
+    TOK_DIV_ASSIGN,
+    TOK_MOD_ASSIGN,
+    TOK_PLUS_ASSIGN,
+    TOK_MINUS_ASSIGN,
+    TOK_SHL_ASSIGN,
+    TOK_SAR_ASSIGN,
+    TOK_SHR_ASSIGN,
+    TOK_AND_ASSIGN,
+    TOK_XOR_ASSIGN,
+    TOK_OR_ASSIGN,
+    TOK_POW_ASSIGN,
+    TOK_LAND_ASSIGN,
+    TOK_LOR_ASSIGN,
+    TOK_DOUBLE_QUESTION_MARK_ASSIGN,
+    TOK_DEC,
+    TOK_INC,
+    TOK_SHL,
+    TOK_SAR,
+    TOK_SHR,
+    TOK_LT,
+    TOK_LTE,
+    TOK_GT,
+    TOK_GTE,
+    TOK_EQ,
+    TOK_STRICT_EQ,
+    TOK_NEQ,
+    TOK_STRICT_NEQ,
+    TOK_LAND,
+    TOK_LOR,
+    TOK_POW,
+    TOK_ARROW,
+    TOK_ELLIPSIS,
+    TOK_DOUBLE_QUESTION_MARK,
+    TOK_QUESTION_MARK_DOT,
+    TOK_ERROR,
+    TOK_PRIVATE_NAME,
+    TOK_EOF,
+    /* keywords: WARNING: same order as atoms */
+    TOK_NULL, /* must be first */
+    TOK_FALSE,
+    TOK_TRUE,
+    TOK_IF,
+    TOK_ELSE,
+    TOK_RETURN,
+    TOK_VAR,
+    TOK_THIS,
+    TOK_DELETE,
+    TOK_VOID,
+    TOK_TYPEOF,
+    TOK_NEW,
+    TOK_IN,
+    TOK_INSTANCEOF,
+    TOK_DO,
+    TOK_WHILE,
+    TOK_FOR,
+    TOK_BREAK,
+    TOK_CONTINUE,
+    TOK_SWITCH,
+    TOK_CASE,
+    TOK_DEFAULT,
+    TOK_THROW,
+    TOK_TRY,
+    TOK_CATCH,
+    TOK_FINALLY,
+    TOK_FUNCTION,
+    TOK_DEBUGGER,
+    TOK_WITH,
+    /* FutureReservedWord */
+    TOK_CLASS,
+    TOK_CONST,
+    TOK_ENUM,
+    TOK_EXPORT,
+    TOK_EXTENDS,
+    TOK_IMPORT,
+    TOK_SUPER,
+    /* FutureReservedWords when parsing strict mode code */
+    TOK_IMPLEMENTS,
+    TOK_INTERFACE,
+    TOK_LET,
+    TOK_PACKAGE,
+    TOK_PRIVATE,
+    TOK_PROTECTED,
+    TOK_PUBLIC,
+    TOK_STATIC,
+    TOK_YIELD,
+    TOK_AWAIT, /* must be last */
+    TOK_OF,     /* only used for js_parse_skip_parens_token() */
+};
+
+#define TOK_FIRST_KEYWORD   TOK_NULL
+#define TOK_LAST_KEYWORD    TOK_AWAIT
+
+/* unicode code points */
+#define CP_NBSP 0x00a0
+#define CP_BOM  0xfeff
+
+#define CP_LS   0x2028
+#define CP_PS   0x2029
+
+typedef struct BlockEnv {
+    struct BlockEnv *prev;
+    JSAtom label_name; /* JS_ATOM_NULL if none */
+    int label_break; /* -1 if none */
+    int label_cont; /* -1 if none */
+    int drop_count; /* number of stack elements to drop */
+    int label_finally; /* -1 if none */
+    int scope_level;
+    uint8_t has_iterator : 1;
+    uint8_t is_regular_stmt : 1; /* i.e. not a loop statement */
+} BlockEnv;
+
+typedef struct JSGlobalVar {
+    int cpool_idx; /* if >= 0, index in the constant pool for hoisted
+                      function defintion*/
+    uint8_t force_init : 1; /* force initialization to undefined */
+    uint8_t is_lexical : 1; /* global let/const definition */
+    uint8_t is_const   : 1; /* const definition */
+    int scope_level;    /* scope of definition */
+    JSAtom var_name;  /* variable name */
+} JSGlobalVar;
+
+typedef struct RelocEntry {
+    struct RelocEntry *next;
+    uint32_t addr; /* address to patch */
+    int size;   /* address size: 1, 2 or 4 bytes */
+} RelocEntry;
+
+typedef struct JumpSlot {
+    int op;
+    int size;
+    int pos;
+    int label;
+} JumpSlot;
+
+typedef struct LabelSlot {
+    int ref_count;
+    int pos;    /* phase 1 address, -1 means not resolved yet */
+    int pos2;   /* phase 2 address, -1 means not resolved yet */
+    int addr;   /* phase 3 address, -1 means not resolved yet */
+    RelocEntry *first_reloc;
+} LabelSlot;
+
+typedef struct LineNumberSlot {
+    uint32_t pc;
+    uint32_t source_pos;
+} LineNumberSlot;
+
+typedef struct {
+    /* last source position */
+    const uint8_t *ptr;
+    int line_num;
+    int col_num;
+    const uint8_t *buf_start;
+} GetLineColCache;
+
+typedef enum JSParseFunctionEnum {
+    JS_PARSE_FUNC_STATEMENT,
+    JS_PARSE_FUNC_VAR,
+    JS_PARSE_FUNC_EXPR,
+    JS_PARSE_FUNC_ARROW,
+    JS_PARSE_FUNC_GETTER,
+    JS_PARSE_FUNC_SETTER,
+    JS_PARSE_FUNC_METHOD,
+    JS_PARSE_FUNC_CLASS_STATIC_INIT,
+    JS_PARSE_FUNC_CLASS_CONSTRUCTOR,
+    JS_PARSE_FUNC_DERIVED_CLASS_CONSTRUCTOR,
+} JSParseFunctionEnum;
+
+typedef enum JSParseExportEnum {
+    JS_PARSE_EXPORT_NONE,
+    JS_PARSE_EXPORT_NAMED,
+    JS_PARSE_EXPORT_DEFAULT,
+} JSParseExportEnum;
+
+typedef struct JSFunctionDef {
+    JSContext *ctx;
+    struct JSFunctionDef *parent;
+    int parent_cpool_idx; /* index in the constant pool of the parent
+                             or -1 if none */
+    int parent_scope_level; /* scope level in parent at point of definition */
+    struct list_head child_list; /* list of JSFunctionDef.link */
+    struct list_head link;
+
+    BOOL is_eval; /* TRUE if eval code */
+    int eval_type; /* only valid if is_eval = TRUE */
+    BOOL is_global_var; /* TRUE if variables are not defined locally:
+                           eval global, eval module or non strict eval */
+    BOOL is_func_expr; /* TRUE if function expression */
+    BOOL has_home_object; /* TRUE if the home object is available */
+    BOOL has_prototype; /* true if a prototype field is necessary */
+    BOOL has_simple_parameter_list;
+    BOOL has_parameter_expressions; /* if true, an argument scope is created */
+    BOOL has_use_strict; /* to reject directive in special cases */
+    BOOL has_eval_call; /* true if the function contains a call to eval() */
+    BOOL has_arguments_binding; /* true if the 'arguments' binding is
+                                   available in the function */
+    BOOL has_this_binding; /* true if the 'this' and new.target binding are
+                              available in the function */
+    BOOL new_target_allowed; /* true if the 'new.target' does not
+                                throw a syntax error */
+    BOOL super_call_allowed; /* true if super() is allowed */
+    BOOL super_allowed; /* true if super. or super[] is allowed */
+    BOOL arguments_allowed; /* true if the 'arguments' identifier is allowed */
+    BOOL is_derived_class_constructor;
+    BOOL in_function_body;
+    JSFunctionKindEnum func_kind : 8;
+    JSParseFunctionEnum func_type : 8;
+    uint8_t js_mode; /* bitmap of JS_MODE_x */
+    JSAtom func_name; /* JS_ATOM_NULL if no name */
+
+    JSVarDef *vars;
+    int var_size; /* allocated size for vars[] */
+    int var_count;
+    JSVarDef *args;
+    int arg_size; /* allocated size for args[] */
+    int arg_count; /* number of arguments */
+    int defined_arg_count;
+    int var_object_idx; /* -1 if none */
+    int arg_var_object_idx; /* -1 if none (var object for the argument scope) */
+    int arguments_var_idx; /* -1 if none */
+    int arguments_arg_idx; /* argument variable definition in argument scope,
+                              -1 if none */
+    int func_var_idx; /* variable containing the current function (-1
+                         if none, only used if is_func_expr is true) */
+    int eval_ret_idx; /* variable containing the return value of the eval, -1 if none */
+    int this_var_idx; /* variable containg the 'this' value, -1 if none */
+    int new_target_var_idx; /* variable containg the 'new.target' value, -1 if none */
+    int this_active_func_var_idx; /* variable containg the 'this.active_func' value, -1 if none */
+    int home_object_var_idx;
+    BOOL need_home_object;
+
+    int scope_level;    /* index into fd->scopes if the current lexical scope */
+    int scope_first;    /* index into vd->vars of first lexically scoped variable */
+    int scope_size;     /* allocated size of fd->scopes array */
+    int scope_count;    /* number of entries used in the fd->scopes array */
+    JSVarScope *scopes;
+    JSVarScope def_scope_array[4];
+    int body_scope; /* scope of the body of the function or eval */
+
+    int global_var_count;
+    int global_var_size;
+    JSGlobalVar *global_vars;
+
+    DynBuf byte_code;
+    int last_opcode_pos; /* -1 if no last opcode */
+    const uint8_t *last_opcode_source_ptr;
+    BOOL use_short_opcodes; /* true if short opcodes are used in byte_code */
+
+    LabelSlot *label_slots;
+    int label_size; /* allocated size for label_slots[] */
+    int label_count;
+    BlockEnv *top_break; /* break/continue label stack */
+
+    /* constant pool (strings, functions, numbers) */
+    JSValue *cpool;
+    int cpool_count;
+    int cpool_size;
+
+    /* list of variables in the closure */
+    int closure_var_count;
+    int closure_var_size;
+    JSClosureVar *closure_var;
+
+    JumpSlot *jump_slots;
+    int jump_size;
+    int jump_count;
+
+    LineNumberSlot *line_number_slots;
+    int line_number_size;
+    int line_number_count;
+    int line_number_last;
+    int line_number_last_pc;
+
+    /* pc2line table */
+    BOOL strip_debug : 1; /* strip all debug info (implies strip_source = TRUE) */
+    BOOL strip_source : 1; /* strip only source code */
+    JSAtom filename;
+    uint32_t source_pos; /* pointer in the eval() source */
+    GetLineColCache *get_line_col_cache; /* XXX: could remove to save memory */
+    DynBuf pc2line;
+
+    char *source;  /* raw source, utf-8 encoded */
+    int source_len;
+
+    JSModuleDef *module; /* != NULL when parsing a module */
+    BOOL has_await; /* TRUE if await is used (used in module eval) */
+} JSFunctionDef;
+
+typedef struct JSToken {
+    int val;
+    const uint8_t *ptr; /* position in the source */
+    union {
+        struct {
+            JSValue str;
+            int sep;
+        } str;
+        struct {
+            JSValue val;
+        } num;
+        struct {
+            JSAtom atom;
+            BOOL has_escape;
+            BOOL is_reserved;
+        } ident;
+        struct {
+            JSValue body;
+            JSValue flags;
+        } regexp;
+    } u;
+} JSToken;
+
+typedef struct JSParseState {
+    JSContext *ctx;
+    const char *filename;
+    JSToken token;
+    BOOL got_lf; /* true if got line feed before the current token */
+    const uint8_t *last_ptr;
+    const uint8_t *buf_start;
+    const uint8_t *buf_ptr;
+    const uint8_t *buf_end;
+
+    /* current function code */
+    JSFunctionDef *cur_func;
+    BOOL is_module; /* parsing a module */
+    BOOL allow_html_comments;
+    BOOL ext_json; /* true if accepting JSON superset */
+    GetLineColCache get_line_col_cache;
+} JSParseState;
+
+typedef struct JSOpCode {
+    const char *name;
+    uint8_t size; /* in bytes */
+    /* the opcodes remove n_pop items from the top of the stack, then
+       pushes n_push items */
+    uint8_t n_pop;
+    uint8_t n_push;
+    uint8_t fmt;
+} JSOpCode;
+
+static const JSOpCode opcode_info[OP_COUNT + (OP_TEMP_END - OP_TEMP_START)] = {
+#define FMT(f)
+#define DEF(id, size, n_pop, n_push, f) { #id, size, n_pop, n_push, OP_FMT_ ## f },
+#include "quickjs-opcode.h"
+#undef DEF
+#undef FMT
+};
+
+#if SHORT_OPCODES
+/* After the final compilation pass, short opcodes are used. Their
+   opcodes overlap with the temporary opcodes which cannot appear in
+   the final bytecode. Their description is after the temporary
+   opcodes in opcode_info[]. */
+#define short_opcode_info(op)           \
+    opcode_info[(op) >= OP_TEMP_START ? \
+                (op) + (OP_TEMP_END - OP_TEMP_START) : (op)]
+#else
+#define short_opcode_info(op) opcode_info[op]
+#endif
+
+/* Native code
+
+   JSFunctionBytecode.jit_code runs a bytecode function on the stack
+   frame set up by JS_CallInternal(). It is generated by the baseline
+   JIT or compiled ahead of time from C (see quickjs-aot.h). Both call
+   the js_jit_*() helpers which do what the interpreter does and return
+   to the interpreter at an instruction they do not handle, so there is
+   no on stack replacement and the exceptions are always handled by the
+   interpreter. */
+
+typedef JSAOTFrame JSJitFrame;
+typedef JSAOTCode JSJitCode;
+
+/* The helpers return 0 or -1 if there is an exception. In this case,
+   f->sp is the stack pointer of the interpreter at the exception. */
+
+static int js_jit_exception(JSJitFrame *f, JSValue *sp)
+{
+    f->sp = sp;
+    return -1;
+}
+
+static int js_jit_poll(JSJitFrame *f, JSValue *sp)
+{
+    if (__js_poll_interrupts(f->ctx))
+        return js_jit_exception(f, sp);
+    return 0;
+}
+
+static int js_jit_throw_uninitialized(JSJitFrame *f, JSValue *sp,
+                                      int idx, BOOL is_ref)
+{
+    JS_ThrowReferenceErrorUninitialized2(f->ctx, f->b, idx, is_ref);
+    return js_jit_exception(f, sp);
+}
+
+/* same results as the slow functions when both operands are numbers
+   (see OP_ARITH_F64). Return FALSE if it is not the case. */
+static BOOL js_jit_binary_number(JSContext *ctx, JSValue *sp, OPCodeEnum op)
+{
+    JSValue op1 = sp[-2], op2 = sp[-1];
+    double d1, d2, r;
+
+    if (!JS_IsNumber(op1) || !JS_IsNumber(op2))
+        return FALSE;
+    d1 = js_number_get_float64(op1);
+    d2 = js_number_get_float64(op2);
+    switch(op) {
+    case OP_add:
+        r = d1 + d2;
+        break;
+    case OP_sub:
+        r = d1 - d2;
+        break;
+    case OP_mul:
+        r = d1 * d2;
+        break;
+    case OP_div:
+        r = d1 / d2;
+        break;
+    case OP_lt:
+        sp[-2] = JS_NewBool(ctx, d1 < d2);
+        return TRUE;
+    case OP_lte:
+        sp[-2] = JS_NewBool(ctx, d1 <= d2);
+        return TRUE;
+    case OP_gt:
+        sp[-2] = JS_NewBool(ctx, d1 > d2);
+        return TRUE;
+    case OP_gte:
+        sp[-2] = JS_NewBool(ctx, d1 >= d2);
+        return TRUE;
+    default:
+        return FALSE;
+    }
+    if (JS_VALUE_IS_BOTH_FLOAT(op1, op2))
+        sp[-2] = __JS_NewFloat64(ctx, r);
+    else
+        sp[-2] = JS_NewFloat64(ctx, r);
+    return TRUE;
+}
+
+static int js_jit_binary(JSJitFrame *f, JSValue *sp, OPCodeEnum op)
+{
+    JSContext *ctx = f->ctx;
+    int ret;
+
+    if (js_jit_binary_number(ctx, sp, op))
+        return 0;
+    switch(op) {
+    case OP_add:
+        ret = js_add_slow(ctx, sp);
+        break;
+    case OP_sub:
+    case OP_mul:
+    case OP_div:
+    case OP_mod:
+    case OP_pow:
+        ret = js_binary_arith_slow(ctx, sp, op);
+        break;
+    case OP_shl:
+    case OP_sar:
+    case OP_and:
+    case OP_or:
+    case OP_xor:
+        ret = js_binary_logic_slow(ctx, sp, op);
+        break;
+    case OP_shr:
+        ret = js_shr_slow(ctx, sp);
+        break;
+    case OP_lt:
+    case OP_lte:
+    case OP_gt:
+    case OP_gte:
+        ret = js_relational_slow(ctx, sp, op);
+        break;
+    case OP_eq:
+    case OP_neq:
+        ret = js_eq_slow(ctx, sp, op == OP_neq);
+        break;
+    case OP_strict_eq:
+    case OP_strict_neq:
+        ret = js_strict_eq_slow(ctx, sp, op == OP_strict_neq);
+        break;
+    case OP_in:
+        ret = js_operator_in(ctx, sp);
+        break;
+    case OP_instanceof:
+        ret = js_operator_instanceof(ctx, sp);
+        break;
+    default:
+        abort();
+    }
+    if (unlikely(ret))
+        return js_jit_exception(f, sp);
+    return 0;
+}
+
+static int js_jit_unary(JSJitFrame *f, JSValue *sp, OPCodeEnum op)
+{
+    JSContext *ctx = f->ctx;
+    JSValue val;
+    BOOL res;
+
+    switch(op) {
+    case OP_neg:
+    case OP_plus:
+    case OP_inc:
+    case OP_dec:
+        if (js_unary_arith_slow(ctx, sp, op))
+            return js_jit_exception(f, sp);
+        break;
+    case OP_not:
+        if (js_not_slow(ctx, sp))
+            return js_jit_exception(f, sp);
+        break;
+    case OP_lnot:
+        sp[-1] = JS_NewBool(ctx, !JS_ToBoolFree(ctx, sp[-1]));
+        break;
+    case OP_typeof:
+        {
+            JSAtom atom = js_operator_typeof(ctx, sp[-1]);
+            JS_FreeValue(ctx, sp[-1]);
+            sp[-1] = JS_AtomToString(ctx, atom);
+        }
+        break;
+    case OP_is_undefined_or_null:
+    case OP_is_undefined:
+    case OP_is_null:
+    case OP_typeof_is_undefined:
+    case OP_typeof_is_function:
+        val = sp[-1];
+        if (op == OP_is_undefined_or_null)
+            res = JS_IsUndefined(val) || JS_IsNull(val);
+        else if (op == OP_is_undefined)
+            res = JS_IsUndefined(val);
+        else if (op == OP_is_null)
+            res = JS_IsNull(val);
+        else if (op == OP_typeof_is_undefined)
+            res = (js_operator_typeof(ctx, val) == JS_ATOM_undefined);
+        else
+            res = (js_operator_typeof(ctx, val) == JS_ATOM_function);
+        JS_FreeValue(ctx, val);
+        sp[-1] = JS_NewBool(ctx, res);
+        break;
+    case OP_get_length:
+        val = JS_GetProperty(ctx, sp[-1], JS_ATOM_length);
+        if (unlikely(JS_IsException(val)))
+            return js_jit_exception(f, sp);
+        JS_FreeValue(ctx, sp[-1]);
+        sp[-1] = val;
+        break;
+    case OP_to_propkey2:
+        if (unlikely(JS_IsUndefined(sp[-2]) || JS_IsNull(sp[-2]))) {
+            JS_ThrowTypeError(ctx, "value has no property");
+            return js_jit_exception(f, sp);
+        }
+        /* fall thru */
+    case OP_to_propkey:
+        switch (JS_VALUE_GET_TAG(sp[-1])) {
+        case JS_TAG_INT:
+        case JS_TAG_STRING:
+        case JS_TAG_SYMBOL:
+            break;
+        default:
+            val = JS_ToPropertyKey(ctx, sp[-1]);
+            if (JS_IsException(val))
+                return js_jit_exception(f, sp);
+            JS_FreeValue(ctx, sp[-1]);
+            sp[-1] = val;
+            break;
+        }
+        break;
+    default:
+        abort();
+    }
+    return 0;
+}
+
+static int js_jit_post_inc(JSJitFrame *f, JSValue *sp, OPCodeEnum op)
+{
+    if (js_post_inc_slow(f->ctx, sp, op))
+        return js_jit_exception(f, sp);
+    return 0;
+}
+
+/* inc_loc and dec_loc */
+static int js_jit_inc_loc(JSJitFrame *f, JSValue *sp, int idx, OPCodeEnum op)
+{
+    JSContext *ctx = f->ctx;
+    JSValue *pv = &f->sf->var_buf[idx];
+    JSValue op1;
+
+    /* must duplicate otherwise the variable value may be destroyed
+       before JS code accesses it */
+    op1 = JS_DupValue(ctx, *pv);
+    if (js_unary_arith_slow(ctx, &op1 + 1, op))
+        return js_jit_exception(f, sp);
+    set_value(ctx, pv, op1);
+    return 0;
+}
+
+static int js_jit_add_loc(JSJitFrame *f, JSValue *sp, int idx)
+{
+    JSContext *ctx = f->ctx;
+    JSValue *pv = &f->sf->var_buf[idx];
+    JSValue op2, ops[2];
+
+    op2 = *--sp;
+    if (JS_VALUE_GET_TAG(*pv) == JS_TAG_STRING) {
+        op2 = JS_ToPrimitiveFree(ctx, op2, HINT_NONE);
+        if (JS_IsException(op2))
+            return js_jit_exception(f, sp);
+        if (JS_ConcatStringInPlace(ctx, JS_VALUE_GET_STRING(*pv), op2)) {
+            JS_FreeValue(ctx, op2);
+        } else {
+            op2 = JS_ConcatString(ctx, JS_DupValue(ctx, *pv), op2);
+            if (JS_IsException(op2))
+                return js_jit_exception(f, sp);
+            set_value(ctx, pv, op2);
+        }
+    } else {
+        ops[0] = JS_DupValue(ctx, *pv);
+        ops[1] = op2;
+        if (js_add_slow(ctx, ops + 2))
+            return js_jit_exception(f, sp);
+        set_value(ctx, pv, ops[0]);
+    }
+    return 0;
+}
+
+/* call, tail_call, call_method, tail_call_method and call_constructor */
+static int js_jit_call(JSJitFrame *f, JSValue *sp, int argc, OPCodeEnum op)
+{
+    JSContext *ctx = f->ctx;
+    JSValue *argv = sp - argc, ret;
+    int i, first;
+
+    if (op == OP_call || op == OP_tail_call) {
+        ret = JS_CallInternal(ctx, argv[-1], JS_UNDEFINED, JS_UNDEFINED,
+                              argc, argv, 0);
+        first = -1;
+    } else if (op == OP_call_constructor) {
+        ret = JS_CallConstructorInternal(ctx, argv[-2], argv[-1],
+                                         argc, argv, 0);
+        first = -2;
+    } else {
+        ret = JS_CallInternal(ctx, argv[-1], argv[-2], JS_UNDEFINED,
+                              argc, argv, 0);
+        first = -2;
+    }
+    if (unlikely(JS_IsException(ret)))
+        return js_jit_exception(f, sp);
+    for(i = first; i < argc; i++)
+        JS_FreeValue(ctx, argv[i]);
+    argv[first] = ret;
+    return 0;
+}
+
+/* get_field, get_field2 and put_field. 'idx' is the inline cache index */
+static int js_jit_field(JSJitFrame *f, JSValue *sp, uint32_t idx, OPCodeEnum op)
+{
+    JSContext *ctx = f->ctx;
+    JSValue val;
+    int ret;
+
+    if (op == OP_put_field) {
+        ret = js_ic_put_field(ctx, f->b, idx, sp[-2], sp[-1]);
+        JS_FreeValue(ctx, sp[-2]);
+        if (unlikely(ret < 0))
+            return js_jit_exception(f, sp - 2);
+    } else {
+        val = js_ic_get_field(ctx, f->b, idx, sp[-1]);
+        if (unlikely(JS_IsException(val)))
+            return js_jit_exception(f, sp);
+        if (op == OP_get_field) {
+            JS_FreeValue(ctx, sp[-1]);
+            sp[-1] = val;
+        } else {
+            sp[0] = val;
+        }
+    }
+    return 0;
+}
+
+/* get_var_undef, get_var, put_var, put_var_init and put_var_strict */
+static int js_jit_var(JSJitFrame *f, JSValue *sp, uint32_t idx, OPCodeEnum op)
+{
+    JSContext *ctx = f->ctx;
+    JSValue val;
+    int ret;
+
+    switch(op) {
+    case OP_get_var_undef:
+    case OP_get_var:
+        val = js_ic_get_var(ctx, f->b, idx, op - OP_get_var_undef);
+        if (unlikely(JS_IsException(val)))
+            return js_jit_exception(f, sp);
+        sp[0] = val;
+        break;
+    case OP_put_var:
+    case OP_put_var_init:
+        ret = js_ic_put_var(ctx, f->b, idx, sp[-1], op - OP_put_var);
+        if (unlikely(ret < 0))
+            return js_jit_exception(f, sp - 1);
+        break;
+    case OP_put_var_strict:
+        /* sp[-2] is JS_TRUE or JS_FALSE */
+        if (unlikely(!JS_VALUE_GET_INT(sp[-2]))) {
+            JS_ThrowReferenceErrorNotDefined(ctx, js_ic_get_atom(f->b, idx));
+            return js_jit_exception(f, sp);
+        }
+        ret = js_ic_put_var(ctx, f->b, idx, sp[-1], 2);
+        if (unlikely(ret < 0))
+            return js_jit_exception(f, sp - 2);
+        break;
+    default:
+        abort();
+    }
+    return 0;
+}
+
+/* get_array_el, get_array_el2 and put_array_el */
+static int js_jit_array_el(JSJitFrame *f, JSValue *sp, OPCodeEnum op)
+{
+    JSContext *ctx = f->ctx;
+    JSValue val;
+    int ret;
+
+    if (op == OP_put_array_el) {
+        ret = JS_SetPropertyValue(ctx, sp[-3], sp[-2], sp[-1],
+                                  JS_PROP_THROW_STRICT);
+        JS_FreeValue(ctx, sp[-3]);
+        if (unlikely(ret < 0))
+            return js_jit_exception(f, sp - 3);
+    } else {
+        val = JS_GetPropertyValue(ctx, sp[-2], sp[-1]);
+        if (op == OP_get_array_el) {
+            JS_FreeValue(ctx, sp[-2]);
+            sp[-2] = val;
+            sp--;
+        } else {
+            sp[-1] = val;
+        }
+        if (unlikely(JS_IsException(val)))
+            return js_jit_exception(f, sp);
+    }
+    return 0;
+}
+
+/* the other instructions with a helper. 'arg' is the operand */
+static int js_jit_op(JSJitFrame *f, JSValue *sp, uint32_t arg, OPCodeEnum op)
+{
+    JSContext *ctx = f->ctx;
+    JSValue val;
+    int i, ret;
+
+    switch(op) {
+    case OP_push_atom_value:
+        sp[0] = JS_AtomToValue(ctx, arg);
+        break;
+    case OP_push_empty_string:
+        sp[0] = JS_AtomToString(ctx, JS_ATOM_empty_string);
+        break;
+    case OP_push_this:
+        if (!(f->b->js_mode & JS_MODE_STRICT)) {
+            uint32_t tag = JS_VALUE_GET_TAG(f->this_obj);
+            if (likely(tag == JS_TAG_OBJECT)) {
+                val = JS_DupValue(ctx, f->this_obj);
+            } else if (tag == JS_TAG_NULL || tag == JS_TAG_UNDEFINED) {
+                val = JS_DupValue(ctx, ctx->global_obj);
+            } else {
+                val = JS_ToObject(ctx, f->this_obj);
+                if (JS_IsException(val))
+                    return js_jit_exception(f, sp);
+            }
+        } else {
+            val = JS_DupValue(ctx, f->this_obj);
+        }
+        sp[0] = val;
+        break;
+    case OP_object:
+        sp[0] = JS_NewObject(ctx);
+        if (unlikely(JS_IsException(sp[0])))
+            return js_jit_exception(f, sp + 1);
+        break;
+    case OP_fclosure:
+        sp[0] = js_closure(ctx, JS_DupValue(ctx, f->b->cpool[arg]),
+                           f->var_refs, f->sf);
+        if (unlikely(JS_IsException(sp[0])))
+            return js_jit_exception(f, sp + 1);
+        break;
+    case OP_array_from:
+        val = JS_NewArray(ctx);
+        if (unlikely(JS_IsException(val)))
+            return js_jit_exception(f, sp);
+        sp -= arg;
+        for(i = 0; i < arg; i++) {
+            ret = JS_DefinePropertyValue(ctx, val, __JS_AtomFromUInt32(i), sp[i],
+                                         JS_PROP_C_W_E | JS_PROP_THROW);
+            sp[i] = JS_UNDEFINED;
+            if (ret < 0) {
+                JS_FreeValue(ctx, val);
+                return js_jit_exception(f, sp + arg);
+            }
+        }
+        sp[0] = val;
+        break;
+    case OP_define_field:
+        ret = JS_DefinePropertyValue(ctx, sp[-2], arg, sp[-1],
+                                     JS_PROP_C_W_E | JS_PROP_THROW);
+        if (unlikely(ret < 0))
+            return js_jit_exception(f, sp - 1);
+        break;
+    case OP_close_loc:
+        close_lexical_var(ctx, f->sf, arg);
+        break;
+    case OP_special_object:
+        switch(arg) {
+        case OP_SPECIAL_OBJECT_ARGUMENTS:
+            val = js_build_arguments(ctx, f->argc, f->argv);
+            break;
+        case OP_SPECIAL_OBJECT_MAPPED_ARGUMENTS:
+            val = js_build_mapped_arguments(ctx, f->argc, f->argv, f->sf,
+                                            min_int(f->argc, f->b->arg_count));
+            break;
+        case OP_SPECIAL_OBJECT_THIS_FUNC:
+            val = JS_DupValue(ctx, f->sf->cur_func);
+            break;
+        case OP_SPECIAL_OBJECT_NEW_TARGET:
+            val = JS_DupValue(ctx, f->new_target);
+            break;
+        case OP_SPECIAL_OBJECT_HOME_OBJECT:
+            {
+                JSObject *p1;
+                p1 = JS_VALUE_GET_OBJ(f->sf->cur_func)->u.func.home_object;
+                if (unlikely(!p1))
+                    val = JS_UNDEFINED;
+                else
+                    val = JS_DupValue(ctx, JS_MKPTR(JS_TAG_OBJECT, p1));
+            }
+            break;
+        case OP_SPECIAL_OBJECT_VAR_OBJECT:
+            val = JS_NewObjectProto(ctx, JS_NULL);
+            break;
+        case OP_SPECIAL_OBJECT_IMPORT_META:
+            val = js_import_meta(ctx);
+            break;
+        default:
+            abort();
+        }
+        if (unlikely(JS_IsException(val)))
+            return js_jit_exception(f, sp);
+        sp[0] = val;
+        break;
+    case OP_rest:
+        sp[0] = js_build_rest(ctx, arg, f->argc, f->argv);
+        if (unlikely(JS_IsException(sp[0])))
+            return js_jit_exception(f, sp + 1);
+        break;
+    default:
+        abort();
+    }
+    return 0;
+}
+
+/* the target of the jump instruction at 'pos' */
+static int jit_get_target(const uint8_t *bc, int pos, int fmt)
+{
+    switch(fmt) {
+    case OP_FMT_label8:
+        return pos + 1 + (int8_t)bc[pos + 1];
+    case OP_FMT_label16:
+        return pos + 1 + (int16_t)get_u16(bc + pos + 1);
+    case OP_FMT_label:
+    case OP_FMT_label_u16:
+        return pos + 1 + (int32_t)get_u32(bc + pos + 1);
+    case OP_FMT_atom_label_u8:
+    case OP_FMT_atom_label_u16:
+        return pos + 5 + (int32_t)get_u32(bc + pos + 5);
+    default:
+        return -1;
+    }
+}
+
+/* the stack permutations of OP_dup to OP_insert4: the value i is the
+   source value perm[i] */
+static const uint8_t jit_dup_perms[][6] = {
+    { 0, 0 }, /* dup: a -> a a */
+    { 0, 0, 1 }, /* dup1: a b -> a a b */
+    { 0, 1, 0, 1 }, /* dup2: a b -> a b a b */
+    { 0, 1, 2, 0, 1, 2 }, /* dup3: a b c -> a b c a b c */
+    { 1, 0, 1 }, /* insert2: obj a -> a obj a */
+    { 2, 0, 1, 2 }, /* insert3: obj prop a -> a obj prop a */
+    { 3, 0, 1, 2, 3 }, /* insert4: this obj prop a -> a this obj prop a */
+};
+static const uint8_t jit_dup_n_src[] = { 1, 2, 2, 3, 2, 3, 4 };
+static const uint8_t jit_dup_n_dup[] = { 1, 1, 2, 3, 1, 1, 1 };
+
+/* the stack permutations of OP_perm3 to OP_rot5l */
+static const uint8_t jit_perms[][5] = {
+    { 1, 0, 2 }, /* perm3: obj a b -> a obj b */
+    { 2, 0, 1, 3 }, /* perm4: obj prop a b -> a obj prop b */
+    { 3, 0, 1, 2, 4 }, /* perm5: this obj prop a b -> a this obj prop b */
+    { 1, 0 }, /* swap: a b -> b a */
+    { 2, 3, 0, 1 }, /* swap2: a b c d -> c d a b */
+    { 1, 2, 0 }, /* rot3l: x a b -> a b x */
+    { 2, 0, 1 }, /* rot3r: a b x -> x a b */
+    { 1, 2, 3, 0 }, /* rot4l: x a b c -> a b c x */
+    { 1, 2, 3, 4, 0 }, /* rot5l: x a b c d -> a b c d x */
+};
+static const uint8_t jit_perm_n[] = { 3, 4, 5, 2, 4, 3, 3, 4, 5 };
+
+/* the instruction translated to native code at a superinstruction or a
+   quickened instruction */
+static int jit_get_op(int op)
+{
+    switch(op) {
+    case OP_lt_if_false8:
+        return OP_lt;
+    case OP_push_i16_lt_if_false8:
+        return OP_push_i16;
+    case OP_inc_loc_goto8:
+        return OP_inc_loc;
+    case OP_get_var_get_field2:
+        return OP_get_var;
+    default:
+        return js_unquicken_op(op);
+    }
+}
+
+#ifdef CONFIG_JIT
+
+/* Baseline JIT
+
+   A bytecode function called JSRuntime.jit_threshold times is
+   translated to native code, one template per instruction (a loop
+   running in a function counts as JS_JIT_LOOP_WEIGHT calls each time
+   the interrupt counter expires, see __js_poll_interrupts()). The
+   native code runs on the stack frame set up by JS_CallInternal() and
+   keeps the stack pointer, the frame and the variable buffers in
+   callee saved registers. The int32 cases of the frequent instructions
+   are inline, the other cases and the other supported instructions
+   call the helpers.
+
+   The code is emitted to a DynBuf and copied to the code arena of the
+   runtime, whose pages are only writable while the copy is made (W^X). */
+
+/* larger functions are not compiled */
+#define JS_JIT_MAX_BYTECODE_LEN 65536
+
+/* Code arena
+
+   The native code of a runtime is allocated by bumping a pointer in
+   mappings of at least JS_JIT_CHUNK_SIZE bytes, which are counted in
+   malloc_size so that the memory limit and the GC threshold apply to
+   them. A chunk is unmapped when its last function is freed, except
+   the most recent one which is kept for the next functions. A runtime
+   runs on one thread, so no code of the chunk executes while the pages
+   of a new function are writable. */
+
+#define JS_JIT_CHUNK_SIZE (64 * 1024)
+
+typedef struct JSJitChunk {
+    struct JSJitChunk *next;
+    uint8_t *base;
+    size_t size; /* mapped bytes */
+    size_t used;
+    int func_count; /* functions not freed yet */
+} JSJitChunk;
+
+static void js_jit_unmap_chunk(JSRuntime *rt, JSJitChunk *c)
+{
+    munmap(c->base, c->size);
+    rt->malloc_state.malloc_size -= c->size;
+    js_free_rt(rt, c);
+}
+
+/* Copy code to the arena. Return NULL if there is no memory. */
+static void *js_jit_alloc_code(JSRuntime *rt, const void *code, size_t size,
+                               uint32_t *palloc_size)
+{
+    JSJitChunk *c;
+    size_t alloc_size, page_size, map_size;
+    uintptr_t start, end;
+    uint8_t *ptr;
+
+    alloc_size = (size + 15) & ~(size_t)15;
+    for(c = rt->jit_chunks; c != NULL; c = c->next) {
+        if (c->size - c->used >= alloc_size)
+            break;
+    }
+    page_size = sysconf(_SC_PAGESIZE);
+    if (!c) {
+        map_size = alloc_size > JS_JIT_CHUNK_SIZE ? alloc_size : JS_JIT_CHUNK_SIZE;
+        map_size = (map_size + page_size - 1) & ~(page_size - 1);
+        if (rt->malloc_state.malloc_size + map_size >
+            rt->malloc_state.malloc_limit)
+            return NULL;
+        c = js_malloc_rt(rt, sizeof(*c));
+        if (!c)
+            return NULL;
+        c->base = mmap(NULL, map_size, PROT_READ | PROT_EXEC,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (c->base == MAP_FAILED) {
+            js_free_rt(rt, c);
+            return NULL;
+        }
+        c->size = map_size;
+        c->used = 0;
+        c->func_count = 0;
+        c->next = rt->jit_chunks;
+        rt->jit_chunks = c;
+        rt->malloc_state.malloc_size += map_size;
+    }
+
+    ptr = c->base + c->used;
+    start = (uintptr_t)ptr & ~(page_size - 1);
+    end = ((uintptr_t)ptr + size + page_size - 1) & ~(page_size - 1);
+    if (mprotect((void *)start, end - start, PROT_READ | PROT_WRITE))
+        return NULL;
+    memcpy(ptr, code, size);
+    /* the pages may hold code of functions called from the stack */
+    if (mprotect((void *)start, end - start, PROT_READ | PROT_EXEC))
+        abort();
+    __builtin___clear_cache((char *)ptr, (char *)ptr + size);
+    c->used += alloc_size;
+    c->func_count++;
+    *palloc_size = alloc_size;
+    return ptr;
+}
+
+static void js_jit_free_code(JSRuntime *rt, void *code)
+{
+    JSJitChunk **pc, *c;
+
+    for(pc = &rt->jit_chunks; (c = *pc) != NULL; pc = &c->next) {
+        if ((uint8_t *)code >= c->base && (uint8_t *)code < c->base + c->size)
+            break;
+    }
+    assert(c != NULL);
+    if (--c->func_count != 0)
+        return;
+    if (c == rt->jit_chunks) {
+        c->used = 0;
+    } else {
+        *pc = c->next;
+        js_jit_unmap_chunk(rt, c);
+    }
+}
+
+static void js_jit_free_arena(JSRuntime *rt)
+{
+    JSJitChunk *c, *c_next;
+
+    for(c = rt->jit_chunks; c != NULL; c = c_next) {
+        c_next = c->next;
+        js_jit_unmap_chunk(rt, c);
+    }
+    rt->jit_chunks = NULL;
+}
+
+/* number of chunks and mapped bytes */
+static void js_jit_code_usage(JSRuntime *rt, int64_t *pcount, int64_t *psize)
+{
+    JSJitChunk *c;
+
+    *pcount = 0;
+    *psize = 0;
+    for(c = rt->jit_chunks; c != NULL; c = c->next) {
+        (*pcount)++;
+        *psize += c->size;
+    }
+}
+
+/* the values are passed in two registers */
+static void js_jit_free_value(JSJitFrame *f, void *ptr, int64_t tag)
+{
+    __JS_FreeValueRT(f->ctx->rt, JS_MKPTR(tag, ptr));
+}
+
+static int js_jit_to_bool_free(JSJitFrame *f, void *ptr, int64_t tag)
+{
+    JSValue v;
+    v.u.ptr = ptr;
+    v.tag = tag;
+    return JS_ToBoolFree(f->ctx, v);
+}
+
+/* Macro assembler. The templates use virtual registers and the
+   conditions below. The flags are only valid after jit_alu32() with
+   JIT_ADD, JIT_SUB or JIT_CMP, jit_cmpi32() and jit_addmem32(). */
+
+enum {
+    JIT_T0, /* scratch registers, clobbered by the calls */
+    JIT_T1,
+    JIT_T2,
+    JIT_T3,
+    JIT_A0, /* call arguments, clobbered by the calls */
+    JIT_A1,
+    JIT_A2,
+    JIT_A3,
+    JIT_RET, /* helper return value */
+    JIT_F, /* JSJitFrame */
+    JIT_SP, /* stack pointer */
+    JIT_VAR, /* var_buf */
+    JIT_ARG, /* arg_buf */
+    JIT_SF, /* JSStackFrame */
+    JIT_REG_COUNT,
+};
+
+/* a condition and its negation only differ by the bit 0 */
+enum {
+    JIT_EQ,
+    JIT_NE,
+    JIT_LT,
+    JIT_GE,
+    JIT_LE,
+    JIT_GT,
+    JIT_ULT,
+    JIT_UGE,
+    JIT_ULE,
+    JIT_UGT,
+    JIT_OV,
+    JIT_NOV,
+    JIT_ALWAYS = -1,
+};
+
+enum {
+    JIT_ADD,
+    JIT_SUB,
+    JIT_AND,
+    JIT_OR,
+    JIT_XOR,
+    JIT_CMP,
+};
+
+typedef struct JSJitFixup {
+    int offset; /* of the branch instruction or of its displacement */
+    int label;
+} JSJitFixup;
+
+typedef struct JSJitCompiler {
+    JSContext *ctx;
+    JSFunctionBytecode *b;
+    DynBuf code;
+    /* code offset of the labels, -1 if not bound. The label 'pos' is
+       the instruction at 'pos' in the bytecode. */
+    int *labels;
+    int label_count;
+    int label_size;
+    JSJitFixup *fixups;
+    int fixup_count;
+    int fixup_size;
+    uint8_t *is_target; /* TRUE if a jump goes to the bytecode position */
+    int exit_label;
+    int return_label;
+    int return_undef_label;
+    int exception_label;
+    int epilogue_label;
+    BOOL error;
+} JSJitCompiler;
+
+static int jit_new_label(JSJitCompiler *s)
+{
+    if (js_resize_array(s->ctx, (void **)&s->labels, sizeof(s->labels[0]),
+                        &s->label_size, s->label_count + 1)) {
+        s->error = TRUE;
+        return 0;
+    }
+    s->labels[s->label_count] = -1;
+    return s->label_count++;
+}
+
+static void jit_bind(JSJitCompiler *s, int label)
+{
+    s->labels[label] = s->code.size;
+}
+
+static void jit_add_fixup(JSJitCompiler *s, int offset, int label)
+{
+    if (js_resize_array(s->ctx, (void **)&s->fixups, sizeof(s->fixups[0]),
+                        &s->fixup_size, s->fixup_count + 1)) {
+        s->error = TRUE;
+        return;
+    }
+    s->fixups[s->fixup_count].offset = offset;
+    s->fixups[s->fixup_count].label = label;
+    s->fixup_count++;
+}
+
+/* x86-64 backend */
+
+/* rax, r10, r11, r9, rdi, rsi, rdx, rcx, rax, rbx, r12, r13, r14, r15 */
+static const uint8_t jit_regs[JIT_REG_COUNT] = {
+    0, 10, 11, 9, 7, 6, 2, 1, 0, 3, 12, 13, 14, 15,
+};
+
+static const uint8_t jit_cc[] = {
+    0x4, 0x5, 0xc, 0xd, 0xe, 0xf, 0x2, 0x3, 0x6, 0x7, 0x0, 0x1,
+};
+
+static void x86_rex(JSJitCompiler *s, int w, int r, int b, BOOL force)
+{
+    int rex = 0x40 | (w << 3) | ((r >> 3) << 2) | (b >> 3);
+    if (rex != 0x40 || force)
+        dbuf_putc(&s->code, rex);
+}
+
+/* 'opc' with the operands 'reg' and [base + disp] */
+static void x86_op_mem(JSJitCompiler *s, int w, int opc, int reg, int base,
+                       int32_t disp)
+{
+    int mod;
+
+    x86_rex(s, w, reg, base, FALSE);
+    dbuf_putc(&s->code, opc);
+    if (disp == 0 && (base & 7) != 5)
+        mod = 0;
+    else if (disp == (int8_t)disp)
+        mod = 1;
+    else
+        mod = 2;
+    dbuf_putc(&s->code, (mod << 6) | ((reg & 7) << 3) | (base & 7));
+    if ((base & 7) == 4)
+        dbuf_putc(&s->code, 0x24); /* SIB byte for rsp and r12 */
+    if (mod == 1)
+        dbuf_putc(&s->code, disp);
+    else if (mod == 2)
+        dbuf_put_u32(&s->code, disp);
+}
+
+/* 'opc' with the operands 'reg' and 'rm' */
+static void x86_op_reg(JSJitCompiler *s, int w, int opc, int reg, int rm)
+{
+    x86_rex(s, w, reg, rm, FALSE);
+    dbuf_putc(&s->code, opc);
+    dbuf_putc(&s->code, 0xc0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+static void jit_ld(JSJitCompiler *s, int rd, int rb, int32_t off)
+{
+    x86_op_mem(s, 1, 0x8b, jit_regs[rd], jit_regs[rb], off);
+}
+
+static void jit_st(JSJitCompiler *s, int rb, int32_t off, int rs)
+{
+    x86_op_mem(s, 1, 0x89, jit_regs[rs], jit_regs[rb], off);
+}
+
+static void jit_ld32(JSJitCompiler *s, int rd, int rb, int32_t off)
+{
+    x86_op_mem(s, 0, 0x8b, jit_regs[rd], jit_regs[rb], off);
+}
+
+static void jit_st32(JSJitCompiler *s, int rb, int32_t off, int rs)
+{
+    x86_op_mem(s, 0, 0x89, jit_regs[rs], jit_regs[rb], off);
+}
+
+/* does not modify the flags */
+static void jit_movi(JSJitCompiler *s, int rd, int64_t imm)
+{
+    int r = jit_regs[rd];
+    if (imm == (uint32_t)imm) {
+        x86_rex(s, 0, 0, r, FALSE);
+        dbuf_putc(&s->code, 0xb8 + (r & 7));
+        dbuf_put_u32(&s->code, imm);
+    } else if (imm == (int32_t)imm) {
+        x86_rex(s, 1, 0, r, FALSE);
+        dbuf_putc(&s->code, 0xc7);
+        dbuf_putc(&s->code, 0xc0 | (r & 7));
+        dbuf_put_u32(&s->code, imm);
+    } else {
+        x86_rex(s, 1, 0, r, FALSE);
+        dbuf_putc(&s->code, 0xb8 + (r & 7));
+        dbuf_put_u64(&s->code, imm);
+    }
+}
+
+static void jit_mov(JSJitCompiler *s, int rd, int rs)
+{
+    x86_op_reg(s, 1, 0x89, jit_regs[rs], jit_regs[rd]);
+}
+
+/* 64 bit addition, may modify the flags */
+static void jit_addi(JSJitCompiler *s, int rd, int32_t imm)
+{
+    int r = jit_regs[rd];
+    if (imm == 0)
+        return;
+    x86_rex(s, 1, 0, r, FALSE);
+    if (imm == (int8_t)imm) {
+        dbuf_putc(&s->code, 0x83);
+        dbuf_putc(&s->code, 0xc0 | (r & 7));
+        dbuf_putc(&s->code, imm);
+    } else {
+        dbuf_putc(&s->code, 0x81);
+        dbuf_putc(&s->code, 0xc0 | (r & 7));
+        dbuf_put_u32(&s->code, imm);
+    }
+}
+
+/* rd = rd 'op' rs on 32 bits (JIT_CMP only sets the flags) */
+static void jit_alu32(JSJitCompiler *s, int op, int rd, int rs)
+{
+    static const uint8_t opc[] = { 0x01, 0x29, 0x21, 0x09, 0x31, 0x39 };
+    x86_op_reg(s, 0, opc[op], jit_regs[rs], jit_regs[rd]);
+}
+
+static void jit_cmpi32(JSJitCompiler *s, int rs, int32_t imm)
+{
+    int r = jit_regs[rs];
+    x86_rex(s, 0, 0, r, FALSE);
+    if (imm == (int8_t)imm) {
+        dbuf_putc(&s->code, 0x83);
+        dbuf_putc(&s->code, 0xc0 | (7 << 3) | (r & 7));
+        dbuf_putc(&s->code, imm);
+    } else {
+        dbuf_putc(&s->code, 0x81);
+        dbuf_putc(&s->code, 0xc0 | (7 << 3) | (r & 7));
+        dbuf_put_u32(&s->code, imm);
+    }
+}
+
+/* rd = 1 if 'cond' is true, 0 otherwise */
+static void jit_setcc(JSJitCompiler *s, int rd, int cond)
+{
+    int r = jit_regs[rd];
+    jit_movi(s, rd, 0);
+    x86_rex(s, 0, 0, r, TRUE);
+    dbuf_putc(&s->code, 0x0f);
+    dbuf_putc(&s->code, 0x90 | jit_cc[cond]);
+    dbuf_putc(&s->code, 0xc0 | (r & 7));
+}
+
+static void jit_jcc(JSJitCompiler *s, int cond, int label)
+{
+    if (cond == JIT_ALWAYS) {
+        dbuf_putc(&s->code, 0xe9);
+    } else {
+        dbuf_putc(&s->code, 0x0f);
+        dbuf_putc(&s->code, 0x80 | jit_cc[cond]);
+    }
+    jit_add_fixup(s, s->code.size, label);
+    dbuf_put_u32(&s->code, 0);
+}
+
+/* rd = rd * rs on 32 bits, jump to 'l_ovf' if it overflows */
+static void jit_mul32(JSJitCompiler *s, int rd, int rs, int l_ovf)
+{
+    int d = jit_regs[rd], r = jit_regs[rs];
+    x86_rex(s, 0, d, r, FALSE);
+    dbuf_putc(&s->code, 0x0f);
+    dbuf_putc(&s->code, 0xaf); /* imul */
+    dbuf_putc(&s->code, 0xc0 | ((d & 7) << 3) | (r & 7));
+    jit_jcc(s, JIT_OV, l_ovf);
+}
+
+static void jit_call(JSJitCompiler *s, void *func)
+{
+    /* movabs rax, func; call rax */
+    dbuf_putc(&s->code, 0x48);
+    dbuf_putc(&s->code, 0xb8);
+    dbuf_put_u64(&s->code, (uintptr_t)func);
+    dbuf_putc(&s->code, 0xff);
+    dbuf_putc(&s->code, 0xd0);
+}
+
+/* 32 bit [rb + off] += imm and set the flags */
+static void jit_addmem32(JSJitCompiler *s, int rb, int32_t off, int imm)
+{
+    x86_op_mem(s, 0, 0x83, 0, jit_regs[rb], off);
+    dbuf_putc(&s->code, imm);
+}
+
+static void jit_prologue(JSJitCompiler *s)
+{
+    static const uint8_t code[] = {
+        0x55, /* push rbp */
+        0x48, 0x89, 0xe5, /* mov rbp, rsp */
+        0x53, /* push rbx */
+        0x41, 0x54, /* push r12 */
+        0x41, 0x55, /* push r13 */
+        0x41, 0x56, /* push r14 */
+        0x41, 0x57, /* push r15 */
+        0x48, 0x83, 0xec, 0x08, /* sub rsp, 8 */
+        0x48, 0x89, 0xfb, /* mov rbx, rdi */
+    };
+    dbuf_put(&s->code, code, sizeof(code));
+}
+
+static void jit_epilogue(JSJitCompiler *s)
+{
+    static const uint8_t code[] = {
+        0x48, 0x83, 0xc4, 0x08, /* add rsp, 8 */
+        0x41, 0x5f, /* pop r15 */
+        0x41, 0x5e, /* pop r14 */
+        0x41, 0x5d, /* pop r13 */
+        0x41, 0x5c, /* pop r12 */
+        0x5b, /* pop rbx */
+        0x5d, /* pop rbp */
+        0xc3, /* ret */
+    };
+    dbuf_put(&s->code, code, sizeof(code));
+}
+
+static BOOL jit_patch(JSJitCompiler *s, int offset, int target)
+{
+    int32_t rel = target - (offset + 4);
+    memcpy(s->code.buf + offset, &rel, 4);
+    return TRUE;
+}
+
+/* Templates */
+
+#define JIT_VAL(i) ((i) * (int)sizeof(JSValue))
+#define JIT_TAG(i) (JIT_VAL(i) + (int)offsetof(JSValue, tag))
+
+/* increment the reference count of the value (ptr, tag) */
+static void jit_gen_dup(JSJitCompiler *s, int ptr, int tag)
+{
+    int l_done = jit_new_label(s);
+    jit_cmpi32(s, tag, JS_TAG_FIRST);
+    jit_jcc(s, JIT_ULT, l_done);
+    jit_addmem32(s, ptr, 0, 1);
+    jit_bind(s, l_done);
+}
+
+/* decrement the reference count of the value (ptr, tag) */
+static void jit_gen_free(JSJitCompiler *s, int ptr, int tag)
+{
+    int l_done = jit_new_label(s);
+    jit_cmpi32(s, tag, JS_TAG_FIRST);
+    jit_jcc(s, JIT_ULT, l_done);
+    jit_addmem32(s, ptr, 0, -1);
+    jit_jcc(s, JIT_NE, l_done);
+    jit_mov(s, JIT_A1, ptr);
+    jit_mov(s, JIT_A2, tag);
+    jit_mov(s, JIT_A0, JIT_F);
+    jit_call(s, js_jit_free_value);
+    jit_bind(s, l_done);
+}
+
+/* call the helper func(f, sp, arg2, arg3). 'pc' is the next
+   instruction. */
+static void jit_gen_helper(JSJitCompiler *s, void *func, const uint8_t *pc,
+                           int64_t arg2, int64_t arg3)
+{
+    jit_movi(s, JIT_T0, (uintptr_t)pc);
+    jit_st(s, JIT_SF, offsetof(JSStackFrame, cur_pc), JIT_T0);
+    jit_mov(s, JIT_A0, JIT_F);
+    jit_mov(s, JIT_A1, JIT_SP);
+    jit_movi(s, JIT_A2, arg2);
+    jit_movi(s, JIT_A3, arg3);
+    jit_call(s, func);
+    jit_cmpi32(s, JIT_RET, 0);
+    jit_jcc(s, JIT_NE, s->exception_label);
+}
+
+static void jit_gen_poll(JSJitCompiler *s, const uint8_t *pc)
+{
+    int l_done = jit_new_label(s);
+    jit_movi(s, JIT_T2, (uintptr_t)&s->ctx->interrupt_counter);
+    jit_addmem32(s, JIT_T2, 0, -1);
+    jit_jcc(s, JIT_GT, l_done);
+    jit_gen_helper(s, js_jit_poll, pc, 0, 0);
+    jit_bind(s, l_done);
+}
+
+/* jump to the bytecode position 'target' if 'cond' is true. The
+   interrupts are polled on the backward jumps as in the
+   interpreter. */
+static void jit_gen_branch(JSJitCompiler *s, int cond, int pos, int target,
+                           const uint8_t *pc)
+{
+    int l_skip;
+
+    if (target > pos) {
+        jit_jcc(s, cond, target);
+    } else {
+        l_skip = -1;
+        if (cond != JIT_ALWAYS) {
+            l_skip = jit_new_label(s);
+            jit_jcc(s, cond ^ 1, l_skip);
+        }
+        jit_gen_poll(s, pc);
+        jit_jcc(s, JIT_ALWAYS, target);
+        if (l_skip >= 0)
+            jit_bind(s, l_skip);
+    }
+}
+
+static void jit_gen_push_const(JSJitCompiler *s, JSValueConst val)
+{
+    uint64_t bits;
+
+    /* only the int32 is defined for the tags of the int32 values */
+    if ((uint32_t)JS_VALUE_GET_TAG(val) <= JS_TAG_UNINITIALIZED)
+        bits = (uint32_t)JS_VALUE_GET_INT(val);
+    else
+        memcpy(&bits, &val.u, sizeof(bits));
+    jit_movi(s, JIT_T0, bits);
+    if (JS_VALUE_HAS_REF_COUNT(val))
+        jit_addmem32(s, JIT_T0, 0, 1);
+    jit_st(s, JIT_SP, JIT_VAL(0), JIT_T0);
+    jit_movi(s, JIT_T0, JS_VALUE_GET_TAG(val));
+    jit_st(s, JIT_SP, JIT_TAG(0), JIT_T0);
+    jit_addi(s, JIT_SP, sizeof(JSValue));
+}
+
+/* push a copy of [base + off] */
+static void jit_gen_get(JSJitCompiler *s, int base, int off)
+{
+    jit_ld(s, JIT_T0, base, off);
+    jit_ld(s, JIT_T1, base, off + offsetof(JSValue, tag));
+    jit_gen_dup(s, JIT_T0, JIT_T1);
+    jit_st(s, JIT_SP, JIT_VAL(0), JIT_T0);
+    jit_st(s, JIT_SP, JIT_TAG(0), JIT_T1);
+    jit_addi(s, JIT_SP, sizeof(JSValue));
+}
+
+/* pop the top of the stack to [base + off] ('pop' = TRUE) or store a
+   copy of it */
+static void jit_gen_put(JSJitCompiler *s, int base, int off, BOOL pop)
+{
+    if (!pop) {
+        jit_ld(s, JIT_T2, JIT_SP, JIT_VAL(-1));
+        jit_ld(s, JIT_T3, JIT_SP, JIT_TAG(-1));
+        jit_gen_dup(s, JIT_T2, JIT_T3);
+    }
+    jit_ld(s, JIT_T0, base, off);
+    jit_ld(s, JIT_T1, base, off + offsetof(JSValue, tag));
+    if (pop) {
+        jit_ld(s, JIT_T2, JIT_SP, JIT_VAL(-1));
+        jit_ld(s, JIT_T3, JIT_SP, JIT_TAG(-1));
+        jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+    }
+    jit_st(s, base, off, JIT_T2);
+    jit_st(s, base, off + offsetof(JSValue, tag), JIT_T3);
+    jit_gen_free(s, JIT_T0, JIT_T1);
+}
+
+/* throw a ReferenceError if [base + off] is uninitialized */
+static void jit_gen_check_init(JSJitCompiler *s, int base, int off, int idx,
+                               BOOL is_ref, const uint8_t *pc)
+{
+    int l_done = jit_new_label(s);
+    jit_ld32(s, JIT_T1, base, off + offsetof(JSValue, tag));
+    jit_cmpi32(s, JIT_T1, JS_TAG_UNINITIALIZED);
+    jit_jcc(s, JIT_NE, l_done);
+    jit_gen_helper(s, js_jit_throw_uninitialized, pc, idx, is_ref);
+    jit_bind(s, l_done);
+}
+
+/* load the pvalue field of var_refs[idx] */
+static void jit_gen_var_ref(JSJitCompiler *s, int rd, int idx)
+{
+    jit_ld(s, rd, JIT_F, offsetof(JSJitFrame, var_refs));
+    jit_ld(s, rd, rd, idx * sizeof(JSVarRef *));
+    jit_ld(s, rd, rd, offsetof(JSVarRef, pvalue));
+}
+
+/* The stack top 'n_src' values are replaced by 'n_dst' values:
+   the value i is the source value perm[i]. The duplicated values must
+   be duplicated before. */
+static void jit_gen_permute(JSJitCompiler *s, int n_src, int n_dst,
+                            const uint8_t *perm)
+{
+    static const uint8_t regs[] = { JIT_T0, JIT_T1, JIT_T2, JIT_T3, JIT_A0 };
+    int i, field;
+
+    for(field = 0; field < sizeof(JSValue); field += 8) {
+        for(i = 0; i < n_src; i++)
+            jit_ld(s, regs[i], JIT_SP, JIT_VAL(i - n_src) + field);
+        for(i = 0; i < n_dst; i++)
+            jit_st(s, JIT_SP, JIT_VAL(i - n_src) + field, regs[perm[i]]);
+    }
+    jit_addi(s, JIT_SP, (n_dst - n_src) * (int)sizeof(JSValue));
+}
+
+/* load the int32 operands sp[-2] and sp[-1] in T0 and T2 or jump to
+   'l_slow' */
+static void jit_gen_load_ints(JSJitCompiler *s, int l_slow)
+{
+    jit_ld32(s, JIT_T1, JIT_SP, JIT_TAG(-2));
+    jit_ld32(s, JIT_T3, JIT_SP, JIT_TAG(-1));
+    jit_alu32(s, JIT_OR, JIT_T1, JIT_T3);
+    jit_cmpi32(s, JIT_T1, JS_TAG_INT);
+    jit_jcc(s, JIT_NE, l_slow);
+    jit_ld32(s, JIT_T0, JIT_SP, JIT_VAL(-2));
+    jit_ld32(s, JIT_T2, JIT_SP, JIT_VAL(-1));
+}
+
+/* add, sub, and, or, xor and mul ('alu_op' is ignored) */
+static void jit_gen_binary_int(JSJitCompiler *s, OPCodeEnum op, int alu_op,
+                               const uint8_t *pc)
+{
+    int l_slow = jit_new_label(s);
+    int l_done = jit_new_label(s);
+
+    jit_gen_load_ints(s, l_slow);
+    if (op == OP_mul) {
+        jit_mul32(s, JIT_T0, JIT_T2, l_slow);
+        /* the result may be -0 */
+        jit_cmpi32(s, JIT_T0, 0);
+        jit_jcc(s, JIT_EQ, l_slow);
+    } else {
+        jit_alu32(s, alu_op, JIT_T0, JIT_T2);
+        if (alu_op == JIT_ADD || alu_op == JIT_SUB)
+            jit_jcc(s, JIT_OV, l_slow);
+    }
+    jit_st32(s, JIT_SP, JIT_VAL(-2), JIT_T0);
+    jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+    jit_jcc(s, JIT_ALWAYS, l_done);
+    jit_bind(s, l_slow);
+    jit_gen_helper(s, js_jit_binary, pc, op, 0);
+    jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+    jit_bind(s, l_done);
+}
+
+/* inc and dec of the int32 at [base + off] */
+static void jit_gen_inc_int(JSJitCompiler *s, int base, int off, int alu_op,
+                            int l_slow)
+{
+    jit_ld32(s, JIT_T1, base, off + offsetof(JSValue, tag));
+    jit_cmpi32(s, JIT_T1, JS_TAG_INT);
+    jit_jcc(s, JIT_NE, l_slow);
+    jit_ld32(s, JIT_T0, base, off);
+    jit_movi(s, JIT_T2, 1);
+    jit_alu32(s, alu_op, JIT_T0, JIT_T2);
+    jit_jcc(s, JIT_OV, l_slow);
+    jit_st32(s, base, off, JIT_T0);
+}
+
+/* compare sp[-2] and sp[-1]. If it is followed by a conditional jump,
+   the jump is also generated and '*ppos_next' is updated. */
+static void jit_gen_compare(JSJitCompiler *s, OPCodeEnum op, int pos,
+                            int *ppos_next)
+{
+    const uint8_t *bc = s->b->byte_code_buf;
+    int pos_next = *ppos_next, op1, cond, target, l_slow, l_done;
+    const uint8_t *pc;
+    BOOL is_true;
+
+    switch(op) {
+    case OP_lt:
+        cond = JIT_LT;
+        break;
+    case OP_lte:
+        cond = JIT_LE;
+        break;
+    case OP_gt:
+        cond = JIT_GT;
+        break;
+    case OP_gte:
+        cond = JIT_GE;
+        break;
+    case OP_eq:
+    case OP_strict_eq:
+        cond = JIT_EQ;
+        break;
+    default:
+        cond = JIT_NE;
+        break;
+    }
+    l_slow = jit_new_label(s);
+    l_done = jit_new_label(s);
+    op1 = -1;
+    if (pos_next < s->b->byte_code_len && !s->is_target[pos_next])
+        op1 = jit_get_op(bc[pos_next]);
+    if (op1 == OP_if_false || op1 == OP_if_true ||
+        op1 == OP_if_false8 || op1 == OP_if_true8) {
+        is_true = (op1 == OP_if_true || op1 == OP_if_true8);
+        target = jit_get_target(bc, pos_next, short_opcode_info(op1).fmt);
+        pos_next += short_opcode_info(op1).size;
+        pc = bc + pos_next;
+        jit_gen_load_ints(s, l_slow);
+        jit_addi(s, JIT_SP, -2 * (int)sizeof(JSValue));
+        jit_alu32(s, JIT_CMP, JIT_T0, JIT_T2);
+        jit_gen_branch(s, is_true ? cond : cond ^ 1, pos, target, pc);
+        jit_jcc(s, JIT_ALWAYS, l_done);
+        jit_bind(s, l_slow);
+        jit_gen_helper(s, js_jit_binary, bc + pos + 1, op, 0);
+        jit_ld32(s, JIT_T0, JIT_SP, JIT_VAL(-2));
+        jit_addi(s, JIT_SP, -2 * (int)sizeof(JSValue));
+        jit_cmpi32(s, JIT_T0, 0);
+        jit_gen_branch(s, is_true ? JIT_NE : JIT_EQ, pos, target, pc);
+        jit_bind(s, l_done);
+        *ppos_next = pos_next;
+    } else {
+        jit_gen_load_ints(s, l_slow);
+        jit_alu32(s, JIT_CMP, JIT_T0, JIT_T2);
+        jit_setcc(s, JIT_T0, cond);
+        jit_st(s, JIT_SP, JIT_VAL(-2), JIT_T0);
+        jit_movi(s, JIT_T1, JS_TAG_BOOL);
+        jit_st(s, JIT_SP, JIT_TAG(-2), JIT_T1);
+        jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+        jit_jcc(s, JIT_ALWAYS, l_done);
+        jit_bind(s, l_slow);
+        jit_gen_helper(s, js_jit_binary, bc + pos + 1, op, 0);
+        jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+        jit_bind(s, l_done);
+    }
+}
+
+/* if_false and if_true */
+static void jit_gen_if(JSJitCompiler *s, BOOL is_true, int pos, int target,
+                       const uint8_t *pc)
+{
+    int l_slow = jit_new_label(s);
+    int l_test = jit_new_label(s);
+
+    /* JS_TAG_INT, JS_TAG_BOOL, JS_TAG_NULL and JS_TAG_UNDEFINED */
+    jit_ld32(s, JIT_T1, JIT_SP, JIT_TAG(-1));
+    jit_cmpi32(s, JIT_T1, JS_TAG_UNDEFINED);
+    jit_jcc(s, JIT_UGT, l_slow);
+    jit_ld32(s, JIT_T0, JIT_SP, JIT_VAL(-1));
+    jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+    jit_cmpi32(s, JIT_T0, 0);
+    jit_jcc(s, JIT_ALWAYS, l_test);
+    jit_bind(s, l_slow);
+    jit_ld(s, JIT_A1, JIT_SP, JIT_VAL(-1));
+    jit_ld(s, JIT_A2, JIT_SP, JIT_TAG(-1));
+    jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+    jit_mov(s, JIT_A0, JIT_F);
+    jit_call(s, js_jit_to_bool_free);
+    jit_cmpi32(s, JIT_RET, 0);
+    jit_bind(s, l_test);
+    jit_gen_branch(s, is_true ? JIT_NE : JIT_EQ, pos, target, pc);
+}
+
+/* Generate the instruction at 'pos'. Return -1 if it has no
+   template. */
+static int jit_gen_op(JSJitCompiler *s, int pos, int op, int *ppos_next)
+{
+    const uint8_t *bc = s->b->byte_code_buf;
+    const uint8_t *pc = bc + *ppos_next; /* next instruction */
+    const uint8_t *operand = bc + pos + 1;
+    int idx, argc, l_slow, l_done;
+
+    switch(op) {
+    case OP_nop:
+        break;
+    case OP_push_i32:
+        jit_gen_push_const(s, JS_NewInt32(s->ctx, get_u32(operand)));
+        break;
+    case OP_push_minus1:
+    case OP_push_0:
+    case OP_push_1:
+    case OP_push_2:
+    case OP_push_3:
+    case OP_push_4:
+    case OP_push_5:
+    case OP_push_6:
+    case OP_push_7:
+        jit_gen_push_const(s, JS_NewInt32(s->ctx, op - OP_push_0));
+        break;
+    case OP_push_i8:
+        jit_gen_push_const(s, JS_NewInt32(s->ctx, get_i8(operand)));
+        break;
+    case OP_push_i16:
+        jit_gen_push_const(s, JS_NewInt32(s->ctx, get_i16(operand)));
+        break;
+    case OP_push_const:
+        jit_gen_push_const(s, s->b->cpool[get_u32(operand)]);
+        break;
+    case OP_push_const8:
+        jit_gen_push_const(s, s->b->cpool[*operand]);
+        break;
+    case OP_undefined:
+        jit_gen_push_const(s, JS_UNDEFINED);
+        break;
+    case OP_null:
+        jit_gen_push_const(s, JS_NULL);
+        break;
+    case OP_push_false:
+        jit_gen_push_const(s, JS_FALSE);
+        break;
+    case OP_push_true:
+        jit_gen_push_const(s, JS_TRUE);
+        break;
+    case OP_push_atom_value:
+    case OP_fclosure:
+        jit_gen_helper(s, js_jit_op, pc, get_u32(operand), op);
+        jit_addi(s, JIT_SP, sizeof(JSValue));
+        break;
+    case OP_fclosure8:
+        jit_gen_helper(s, js_jit_op, pc, *operand, OP_fclosure);
+        jit_addi(s, JIT_SP, sizeof(JSValue));
+        break;
+    case OP_push_empty_string:
+    case OP_push_this:
+    case OP_object:
+        jit_gen_helper(s, js_jit_op, pc, 0, op);
+        jit_addi(s, JIT_SP, sizeof(JSValue));
+        break;
+    case OP_special_object:
+        jit_gen_helper(s, js_jit_op, pc, *operand, op);
+        jit_addi(s, JIT_SP, sizeof(JSValue));
+        break;
+    case OP_rest:
+        jit_gen_helper(s, js_jit_op, pc, get_u16(operand), op);
+        jit_addi(s, JIT_SP, sizeof(JSValue));
+        break;
+
+    case OP_drop:
+        jit_ld(s, JIT_T0, JIT_SP, JIT_VAL(-1));
+        jit_ld(s, JIT_T1, JIT_SP, JIT_TAG(-1));
+        jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+        jit_gen_free(s, JIT_T0, JIT_T1);
+        break;
+    case OP_nip:
+    case OP_nip1:
+        {
+            static const uint8_t perm[] = { 1, 2 };
+            int n = (op == OP_nip) ? 2 : 3;
+            jit_ld(s, JIT_T0, JIT_SP, JIT_VAL(-n));
+            jit_ld(s, JIT_T1, JIT_SP, JIT_TAG(-n));
+            jit_gen_free(s, JIT_T0, JIT_T1);
+            jit_gen_permute(s, n, n - 1, perm);
+        }
+        break;
+    case OP_dup:
+    case OP_dup1:
+    case OP_dup2:
+    case OP_dup3:
+    case OP_insert2:
+    case OP_insert3:
+    case OP_insert4:
+        {
+            int k = op - OP_dup, n_src = jit_dup_n_src[k], i;
+            /* the duplicated values are the first n_dup values, except
+               for insertN which duplicates the top of the stack */
+            for(i = 0; i < jit_dup_n_dup[k]; i++) {
+                int v = (op >= OP_insert2) ? n_src - 1 : (op == OP_dup1 ? 0 : i);
+                jit_ld(s, JIT_T0, JIT_SP, JIT_VAL(v - n_src));
+                jit_ld(s, JIT_T1, JIT_SP, JIT_TAG(v - n_src));
+                jit_gen_dup(s, JIT_T0, JIT_T1);
+            }
+            jit_gen_permute(s, n_src, n_src + jit_dup_n_dup[k],
+                            jit_dup_perms[k]);
+        }
+        break;
+    case OP_perm3:
+    case OP_perm4:
+    case OP_perm5:
+    case OP_swap:
+    case OP_swap2:
+    case OP_rot3l:
+    case OP_rot3r:
+    case OP_rot4l:
+    case OP_rot5l:
+        idx = op - OP_perm3;
+        jit_gen_permute(s, jit_perm_n[idx], jit_perm_n[idx], jit_perms[idx]);
+        break;
+
+    case OP_get_loc:
+    case OP_get_loc8:
+    case OP_get_loc0:
+    case OP_get_loc1:
+    case OP_get_loc2:
+    case OP_get_loc3:
+    case OP_get_loc_check:
+        if (op == OP_get_loc || op == OP_get_loc_check)
+            idx = get_u16(operand);
+        else if (op == OP_get_loc8)
+            idx = *operand;
+        else
+            idx = op - OP_get_loc0;
+        if (op == OP_get_loc_check)
+            jit_gen_check_init(s, JIT_VAR, JIT_VAL(idx), idx, FALSE, pc);
+        jit_gen_get(s, JIT_VAR, JIT_VAL(idx));
+        break;
+    case OP_put_loc:
+    case OP_put_loc8:
+    case OP_put_loc0:
+    case OP_put_loc1:
+    case OP_put_loc2:
+    case OP_put_loc3:
+    case OP_put_loc_check:
+        if (op == OP_put_loc || op == OP_put_loc_check)
+            idx = get_u16(operand);
+        else if (op == OP_put_loc8)
+            idx = *operand;
+        else
+            idx = op - OP_put_loc0;
+        if (op == OP_put_loc_check)
+            jit_gen_check_init(s, JIT_VAR, JIT_VAL(idx), idx, FALSE, pc);
+        jit_gen_put(s, JIT_VAR, JIT_VAL(idx), TRUE);
+        break;
+    case OP_set_loc:
+    case OP_set_loc8:
+    case OP_set_loc0:
+    case OP_set_loc1:
+    case OP_set_loc2:
+    case OP_set_loc3:
+        if (op == OP_set_loc)
+            idx = get_u16(operand);
+        else if (op == OP_set_loc8)
+            idx = *operand;
+        else
+            idx = op - OP_set_loc0;
+        jit_gen_put(s, JIT_VAR, JIT_VAL(idx), FALSE);
+        break;
+    case OP_set_loc_uninitialized:
+        idx = get_u16(operand);
+        jit_ld(s, JIT_T0, JIT_VAR, JIT_VAL(idx));
+        jit_ld(s, JIT_T1, JIT_VAR, JIT_TAG(idx));
+        jit_movi(s, JIT_T2, 0);
+        jit_st(s, JIT_VAR, JIT_VAL(idx), JIT_T2);
+        jit_movi(s, JIT_T2, JS_TAG_UNINITIALIZED);
+        jit_st(s, JIT_VAR, JIT_TAG(idx), JIT_T2);
+        jit_gen_free(s, JIT_T0, JIT_T1);
+        break;
+    case OP_close_loc:
+        jit_gen_helper(s, js_jit_op, pc, get_u16(operand), op);
+        break;
+    case OP_get_arg:
+    case OP_get_arg0:
+    case OP_get_arg1:
+    case OP_get_arg2:
+    case OP_get_arg3:
+        idx = (op == OP_get_arg) ? get_u16(operand) : op - OP_get_arg0;
+        jit_gen_get(s, JIT_ARG, JIT_VAL(idx));
+        break;
+    case OP_put_arg:
+    case OP_put_arg0:
+    case OP_put_arg1:
+    case OP_put_arg2:
+    case OP_put_arg3:
+        idx = (op == OP_put_arg) ? get_u16(operand) : op - OP_put_arg0;
+        jit_gen_put(s, JIT_ARG, JIT_VAL(idx), TRUE);
+        break;
+    case OP_set_arg:
+    case OP_set_arg0:
+    case OP_set_arg1:
+    case OP_set_arg2:
+    case OP_set_arg3:
+        idx = (op == OP_set_arg) ? get_u16(operand) : op - OP_set_arg0;
+        jit_gen_put(s, JIT_ARG, JIT_VAL(idx), FALSE);
+        break;
+    case OP_get_var_ref:
+    case OP_get_var_ref0:
+    case OP_get_var_ref1:
+    case OP_get_var_ref2:
+    case OP_get_var_ref3:
+    case OP_get_var_ref_check:
+        if (op == OP_get_var_ref || op == OP_get_var_ref_check)
+            idx = get_u16(operand);
+        else
+            idx = op - OP_get_var_ref0;
+        jit_gen_var_ref(s, JIT_A3, idx);
+        if (op == OP_get_var_ref_check) {
+            jit_gen_check_init(s, JIT_A3, 0, idx, TRUE, pc);
+            jit_gen_var_ref(s, JIT_A3, idx);
+        }
+        jit_gen_get(s, JIT_A3, 0);
+        break;
+    case OP_put_var_ref:
+    case OP_put_var_ref0:
+    case OP_put_var_ref1:
+    case OP_put_var_ref2:
+    case OP_put_var_ref3:
+    case OP_put_var_ref_check:
+        if (op == OP_put_var_ref || op == OP_put_var_ref_check)
+            idx = get_u16(operand);
+        else
+            idx = op - OP_put_var_ref0;
+        jit_gen_var_ref(s, JIT_A3, idx);
+        if (op == OP_put_var_ref_check) {
+            jit_gen_check_init(s, JIT_A3, 0, idx, TRUE, pc);
+            jit_gen_var_ref(s, JIT_A3, idx);
+        }
+        jit_gen_put(s, JIT_A3, 0, TRUE);
+        break;
+    case OP_set_var_ref:
+    case OP_set_var_ref0:
+    case OP_set_var_ref1:
+    case OP_set_var_ref2:
+    case OP_set_var_ref3:
+        idx = (op == OP_set_var_ref) ? get_u16(operand) : op - OP_set_var_ref0;
+        jit_gen_var_ref(s, JIT_A3, idx);
+        jit_gen_put(s, JIT_A3, 0, FALSE);
+        break;
+
+    case OP_get_field:
+    case OP_get_field2:
+    case OP_put_field:
+        jit_gen_helper(s, js_jit_field, pc, get_u32(operand), op);
+        if (op == OP_get_field2)
+            jit_addi(s, JIT_SP, sizeof(JSValue));
+        else if (op == OP_put_field)
+            jit_addi(s, JIT_SP, -2 * (int)sizeof(JSValue));
+        break;
+    case OP_get_var_undef:
+    case OP_get_var:
+    case OP_put_var:
+    case OP_put_var_init:
+    case OP_put_var_strict:
+        jit_gen_helper(s, js_jit_var, pc, get_u32(operand), op);
+        if (op == OP_get_var_undef || op == OP_get_var)
+            jit_addi(s, JIT_SP, sizeof(JSValue));
+        else if (op == OP_put_var_strict)
+            jit_addi(s, JIT_SP, -2 * (int)sizeof(JSValue));
+        else
+            jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+        break;
+    case OP_get_array_el:
+    case OP_get_array_el2:
+    case OP_put_array_el:
+        jit_gen_helper(s, js_jit_array_el, pc, op, 0);
+        if (op == OP_get_array_el)
+            jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+        else if (op == OP_put_array_el)
+            jit_addi(s, JIT_SP, -3 * (int)sizeof(JSValue));
+        break;
+    case OP_define_field:
+        jit_gen_helper(s, js_jit_op, pc, get_u32(operand), op);
+        jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+        break;
+    case OP_array_from:
+        argc = get_u16(operand);
+        jit_gen_helper(s, js_jit_op, pc, argc, op);
+        jit_addi(s, JIT_SP, (1 - argc) * (int)sizeof(JSValue));
+        break;
+
+    case OP_call0:
+    case OP_call1:
+    case OP_call2:
+    case OP_call3:
+        argc = op - OP_call0;
+        jit_gen_helper(s, js_jit_call, pc, argc, OP_call);
+        jit_addi(s, JIT_SP, -argc * (int)sizeof(JSValue));
+        break;
+    case OP_call:
+    case OP_tail_call:
+    case OP_call_method:
+    case OP_tail_call_method:
+    case OP_call_constructor:
+        argc = get_u16(operand);
+        jit_gen_helper(s, js_jit_call, pc, argc, op);
+        if (op == OP_call || op == OP_tail_call)
+            jit_addi(s, JIT_SP, -argc * (int)sizeof(JSValue));
+        else
+            jit_addi(s, JIT_SP, (-1 - argc) * (int)sizeof(JSValue));
+        if (op == OP_tail_call || op == OP_tail_call_method)
+            jit_jcc(s, JIT_ALWAYS, s->return_label);
+        break;
+    case OP_return:
+        jit_jcc(s, JIT_ALWAYS, s->return_label);
+        break;
+    case OP_return_undef:
+        /* the stack may have no room for the value */
+        jit_jcc(s, JIT_ALWAYS, s->return_undef_label);
+        break;
+
+    case OP_add:
+        jit_gen_binary_int(s, op, JIT_ADD, pc);
+        break;
+    case OP_sub:
+        jit_gen_binary_int(s, op, JIT_SUB, pc);
+        break;
+    case OP_and:
+        jit_gen_binary_int(s, op, JIT_AND, pc);
+        break;
+    case OP_or:
+        jit_gen_binary_int(s, op, JIT_OR, pc);
+        break;
+    case OP_xor:
+        jit_gen_binary_int(s, op, JIT_XOR, pc);
+        break;
+    case OP_mul:
+        jit_gen_binary_int(s, op, 0, pc);
+        break;
+    case OP_div:
+    case OP_mod:
+    case OP_pow:
+    case OP_shl:
+    case OP_sar:
+    case OP_shr:
+    case OP_in:
+    case OP_instanceof:
+        jit_gen_helper(s, js_jit_binary, pc, op, 0);
+        jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+        break;
+    case OP_lt:
+    case OP_lte:
+    case OP_gt:
+    case OP_gte:
+    case OP_eq:
+    case OP_neq:
+    case OP_strict_eq:
+    case OP_strict_neq:
+        jit_gen_compare(s, op, pos, ppos_next);
+        break;
+    case OP_inc:
+    case OP_dec:
+        l_slow = jit_new_label(s);
+        l_done = jit_new_label(s);
+        jit_gen_inc_int(s, JIT_SP, JIT_VAL(-1),
+                        op == OP_inc ? JIT_ADD : JIT_SUB, l_slow);
+        jit_jcc(s, JIT_ALWAYS, l_done);
+        jit_bind(s, l_slow);
+        jit_gen_helper(s, js_jit_unary, pc, op, 0);
+        jit_bind(s, l_done);
+        break;
+    case OP_neg:
+    case OP_plus:
+    case OP_not:
+    case OP_lnot:
+    case OP_typeof:
+    case OP_is_undefined_or_null:
+    case OP_is_undefined:
+    case OP_is_null:
+    case OP_typeof_is_undefined:
+    case OP_typeof_is_function:
+    case OP_get_length:
+    case OP_to_propkey:
+    case OP_to_propkey2:
+        jit_gen_helper(s, js_jit_unary, pc, op, 0);
+        break;
+    case OP_post_inc:
+    case OP_post_dec:
+        jit_gen_helper(s, js_jit_post_inc, pc, op, 0);
+        jit_addi(s, JIT_SP, sizeof(JSValue));
+        break;
+    case OP_inc_loc:
+    case OP_dec_loc:
+        idx = *operand;
+        l_slow = jit_new_label(s);
+        l_done = jit_new_label(s);
+        jit_gen_inc_int(s, JIT_VAR, JIT_VAL(idx),
+                        op == OP_inc_loc ? JIT_ADD : JIT_SUB, l_slow);
+        jit_jcc(s, JIT_ALWAYS, l_done);
+        jit_bind(s, l_slow);
+        jit_gen_helper(s, js_jit_inc_loc, pc, idx,
+                       op == OP_inc_loc ? OP_inc : OP_dec);
+        jit_bind(s, l_done);
+        break;
+    case OP_add_loc:
+        idx = *operand;
+        l_slow = jit_new_label(s);
+        l_done = jit_new_label(s);
+        jit_ld32(s, JIT_T1, JIT_VAR, JIT_TAG(idx));
+        jit_ld32(s, JIT_T3, JIT_SP, JIT_TAG(-1));
+        jit_alu32(s, JIT_OR, JIT_T1, JIT_T3);
+        jit_cmpi32(s, JIT_T1, JS_TAG_INT);
+        jit_jcc(s, JIT_NE, l_slow);
+        jit_ld32(s, JIT_T0, JIT_VAR, JIT_VAL(idx));
+        jit_ld32(s, JIT_T2, JIT_SP, JIT_VAL(-1));
+        jit_alu32(s, JIT_ADD, JIT_T0, JIT_T2);
+        jit_jcc(s, JIT_OV, l_slow);
+        jit_st32(s, JIT_VAR, JIT_VAL(idx), JIT_T0);
+        jit_jcc(s, JIT_ALWAYS, l_done);
+        jit_bind(s, l_slow);
+        jit_gen_helper(s, js_jit_add_loc, pc, idx, 0);
+        jit_bind(s, l_done);
+        jit_addi(s, JIT_SP, -(int)sizeof(JSValue));
+        break;
+
+    case OP_goto:
+    case OP_goto16:
+    case OP_goto8:
+        jit_gen_branch(s, JIT_ALWAYS, pos,
+                       jit_get_target(bc, pos, short_opcode_info(op).fmt), pc);
+        break;
+    case OP_if_false:
+    case OP_if_true:
+    case OP_if_false8:
+    case OP_if_true8:
+        jit_gen_if(s, op == OP_if_true || op == OP_if_true8, pos,
+                   jit_get_target(bc, pos, short_opcode_info(op).fmt), pc);
+        break;
+    default:
+        return -1;
+    }
+    return 0;
+}
+
+static int js_jit_compile(JSContext *ctx, JSFunctionBytecode *b)
+{
+    JSJitCompiler s_s, *s = &s_s;
+    const uint8_t *bc = b->byte_code_buf;
+    int pos, pos_next, op, target, i, ret;
+    void *ptr;
+
+    if (b->byte_code_len > JS_JIT_MAX_BYTECODE_LEN)
+        return -1;
+    memset(s, 0, sizeof(*s));
+    s->ctx = ctx;
+    s->b = b;
+    js_dbuf_init(ctx, &s->code);
+    ret = -1;
+    s->is_target = js_mallocz(ctx, b->byte_code_len);
+    if (!s->is_target)
+        goto done;
+    for(pos = 0; pos < b->byte_code_len; pos = pos_next) {
+        op = bc[pos];
+        pos_next = pos + short_opcode_info(op).size;
+        target = jit_get_target(bc, pos, short_opcode_info(op).fmt);
+        if (target >= 0 && target < b->byte_code_len)
+            s->is_target[target] = TRUE;
+    }
+    /* one label per bytecode position */
+    for(pos = 0; pos < b->byte_code_len; pos++)
+        jit_new_label(s);
+    s->exit_label = jit_new_label(s);
+    s->return_label = jit_new_label(s);
+    s->return_undef_label = jit_new_label(s);
+    s->exception_label = jit_new_label(s);
+    s->epilogue_label = jit_new_label(s);
+
+    jit_prologue(s);
+    jit_ld(s, JIT_SF, JIT_F, offsetof(JSJitFrame, sf));
+    jit_ld(s, JIT_SP, JIT_F, offsetof(JSJitFrame, sp));
+    jit_ld(s, JIT_VAR, JIT_SF, offsetof(JSStackFrame, var_buf));
+    jit_ld(s, JIT_ARG, JIT_SF, offsetof(JSStackFrame, arg_buf));
+
+    for(pos = 0; pos < b->byte_code_len; pos = pos_next) {
+        op = jit_get_op(bc[pos]);
+        pos_next = pos + short_opcode_info(op).size;
+        jit_bind(s, pos);
+        if (jit_gen_op(s, pos, op, &pos_next) < 0) {
+            /* continue in the interpreter */
+            jit_movi(s, JIT_T0, (uintptr_t)(bc + pos));
+            jit_jcc(s, JIT_ALWAYS, s->exit_label);
+        }
+    }
+
+    jit_bind(s, s->exit_label);
+    jit_st(s, JIT_F, offsetof(JSJitFrame, pc), JIT_T0);
+    jit_st(s, JIT_F, offsetof(JSJitFrame, sp), JIT_SP);
+    jit_movi(s, JIT_RET, 0);
+    jit_jcc(s, JIT_ALWAYS, s->epilogue_label);
+    jit_bind(s, s->return_label);
+    jit_st(s, JIT_F, offsetof(JSJitFrame, sp), JIT_SP);
+    jit_movi(s, JIT_RET, 1);
+    jit_jcc(s, JIT_ALWAYS, s->epilogue_label);
+    jit_bind(s, s->return_undef_label);
+    jit_st(s, JIT_F, offsetof(JSJitFrame, sp), JIT_SP);
+    jit_movi(s, JIT_RET, 2);
+    jit_jcc(s, JIT_ALWAYS, s->epilogue_label);
+    jit_bind(s, s->exception_label);
+    jit_movi(s, JIT_RET, -1);
+    jit_bind(s, s->epilogue_label);
+    jit_epilogue(s);
+
+    if (s->error || s->code.error)
+        goto done;
+    for(i = 0; i < s->fixup_count; i++) {
+        target = s->labels[s->fixups[i].label];
+        if (target < 0 || !jit_patch(s, s->fixups[i].offset, target))
+            goto done;
+    }
+
+    ptr = js_jit_alloc_code(ctx->rt, s->code.buf, s->code.size,
+                            &b->jit_code_size);
+    if (!ptr)
+        goto done;
+    b->jit_code = ptr;
+    ret = 0;
+ done:
+    dbuf_free(&s->code);
+    js_free(ctx, s->labels);
+    js_free(ctx, s->fixups);
+    js_free(ctx, s->is_target);
+    return ret;
+}
+
+#endif /* CONFIG_JIT */
+
+/* Ahead of time compilation (see quickjs-aot.h)
+
+   JS_GenerateAOT() emits one C statement per instruction with the same
+   int32 fast paths as the JIT templates. The other cases call
+   JS_AOTOp() which reads the operands from the bytecode, so the
+   generated code does not depend on the atoms and the internal
+   structures. */
+
+/* incremented when the generated code changes, so that code generated
+   before does not match */
+#define JS_AOT_VERSION 2
+
+/* FNV-1a hash of the instructions without the atom operands */
+static uint64_t js_aot_hash(JSFunctionBytecode *b)
+{
+    const uint8_t *bc = b->byte_code_buf;
+    uint64_t h = 0xcbf29ce484222325;
+    int pos, pos_next, op, i;
+
+    h = (h ^ JS_AOT_VERSION) * 0x100000001b3;
+
+    for(pos = 0; pos < b->byte_code_len; pos = pos_next) {
+        op = jit_get_op(bc[pos]);
+        pos_next = pos + short_opcode_info(op).size;
+        h = (h ^ op) * 0x100000001b3;
+        i = pos + 1;
+        switch(short_opcode_info(op).fmt) {
+        case OP_FMT_atom:
+        case OP_FMT_atom_u8:
+        case OP_FMT_atom_u16:
+        case OP_FMT_atom_label_u8:
+        case OP_FMT_atom_label_u16:
+            i += 4;
+            break;
+        default:
+            break;
+        }
+        for(; i < pos_next; i++)
+            h = (h ^ bc[i]) * 0x100000001b3;
+    }
+    return h;
+}
+
+static JSJitCode *js_aot_find(JSRuntime *rt, JSFunctionBytecode *b)
+{
+    const JSAOTFunction *tab;
+    uint64_t h = js_aot_hash(b);
+    int i, lo, hi, mid;
+
+    for(i = 0; i < rt->aot_table_count; i++) {
+        tab = rt->aot_tables[i].tab;
+        lo = 0;
+        hi = rt->aot_tables[i].count;
+        while (lo < hi) {
+            mid = (lo + hi) >> 1;
+            if (tab[mid].hash < h)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        for(; lo < rt->aot_tables[i].count && tab[lo].hash == h; lo++) {
+            if (tab[lo].len == b->byte_code_len)
+                return tab[lo].code;
+        }
+    }
+    return NULL;
+}
+
+/* The functions already called once are not searched again. */
+int JS_AddAOTFunctions(JSRuntime *rt, const JSAOTFunction *tab, int count)
+{
+    JSAOTTable *tables;
+
+    tables = js_realloc_rt(rt, rt->aot_tables,
+                           sizeof(tables[0]) * (rt->aot_table_count + 1));
+    if (!tables)
+        return -1;
+    tables[rt->aot_table_count].tab = tab;
+    tables[rt->aot_table_count].count = count;
+    rt->aot_tables = tables;
+    rt->aot_table_count++;
+    rt->native_code = TRUE;
+    return 0;
+}
+
+int JS_AOTOp(JSAOTFrame *f, JSValue *sp, int pos)
+{
+    JSFunctionBytecode *b = f->b;
+    const uint8_t *operand = b->byte_code_buf + pos + 1;
+    int op = jit_get_op(b->byte_code_buf[pos]), idx;
+    JSValue *pv;
+
+    f->sf->cur_pc = b->byte_code_buf + pos + short_opcode_info(op).size;
+    switch(op) {
+    case OP_push_const:
+        sp[0] = JS_DupValue(f->ctx, b->cpool[get_u32(operand)]);
+        return 0;
+    case OP_push_const8:
+        sp[0] = JS_DupValue(f->ctx, b->cpool[*operand]);
+        return 0;
+    case OP_push_atom_value:
+    case OP_fclosure:
+    case OP_define_field:
+        return js_jit_op(f, sp, get_u32(operand), op);
+    case OP_fclosure8:
+        return js_jit_op(f, sp, *operand, OP_fclosure);
+    case OP_push_empty_string:
+    case OP_push_this:
+    case OP_object:
+        return js_jit_op(f, sp, 0, op);
+    case OP_special_object:
+        return js_jit_op(f, sp, *operand, op);
+    case OP_rest:
+    case OP_close_loc:
+    case OP_array_from:
+        return js_jit_op(f, sp, get_u16(operand), op);
+    case OP_get_loc_check:
+    case OP_put_loc_check:
+        return js_jit_throw_uninitialized(f, sp, get_u16(operand), FALSE);
+    case OP_get_var_ref:
+    case OP_get_var_ref0:
+    case OP_get_var_ref1:
+    case OP_get_var_ref2:
+    case OP_get_var_ref3:
+    case OP_get_var_ref_check:
+        if (op == OP_get_var_ref || op == OP_get_var_ref_check)
+            idx = get_u16(operand);
+        else
+            idx = op - OP_get_var_ref0;
+        pv = f->var_refs[idx]->pvalue;
+        if (op == OP_get_var_ref_check && JS_IsUninitialized(*pv))
+            return js_jit_throw_uninitialized(f, sp, idx, TRUE);
+        sp[0] = JS_DupValue(f->ctx, *pv);
+        return 0;
+    case OP_put_var_ref:
+    case OP_put_var_ref0:
+    case OP_put_var_ref1:
+    case OP_put_var_ref2:
+    case OP_put_var_ref3:
+    case OP_put_var_ref_check:
+        if (op == OP_put_var_ref || op == OP_put_var_ref_check)
+            idx = get_u16(operand);
+        else
+            idx = op - OP_put_var_ref0;
+        pv = f->var_refs[idx]->pvalue;
+        if (op == OP_put_var_ref_check && JS_IsUninitialized(*pv))
+            return js_jit_throw_uninitialized(f, sp, idx, TRUE);
+        set_value(f->ctx, pv, sp[-1]);
+        return 0;
+    case OP_set_var_ref:
+    case OP_set_var_ref0:
+    case OP_set_var_ref1:
+    case OP_set_var_ref2:
+    case OP_set_var_ref3:
+        idx = (op == OP_set_var_ref) ? get_u16(operand) : op - OP_set_var_ref0;
+        set_value(f->ctx, f->var_refs[idx]->pvalue, JS_DupValue(f->ctx, sp[-1]));
+        return 0;
+    case OP_get_field:
+    case OP_get_field2:
+    case OP_put_field:
+        return js_jit_field(f, sp, get_u32(operand), op);
+    case OP_get_var_undef:
+    case OP_get_var:
+    case OP_put_var:
+    case OP_put_var_init:
+    case OP_put_var_strict:
+        return js_jit_var(f, sp, get_u32(operand), op);
+    case OP_get_array_el:
+    case OP_get_array_el2:
+    case OP_put_array_el:
+        return js_jit_array_el(f, sp, op);
+    case OP_call0:
+    case OP_call1:
+    case OP_call2:
+    case OP_call3:
+        return js_jit_call(f, sp, op - OP_call0, OP_call);
+    case OP_call:
+    case OP_tail_call:
+    case OP_call_method:
+    case OP_tail_call_method:
+    case OP_call_constructor:
+        return js_jit_call(f, sp, get_u16(operand), op);
+    case OP_add:
+    case OP_sub:
+    case OP_mul:
+    case OP_div:
+    case OP_mod:
+    case OP_pow:
+    case OP_shl:
+    case OP_sar:
+    case OP_shr:
+    case OP_and:
+    case OP_or:
+    case OP_xor:
+    case OP_in:
+    case OP_instanceof:
+    case OP_lt:
+    case OP_lte:
+    case OP_gt:
+    case OP_gte:
+    case OP_eq:
+    case OP_neq:
+    case OP_strict_eq:
+    case OP_strict_neq:
+        return js_jit_binary(f, sp, op);
+    case OP_inc:
+    case OP_dec:
+    case OP_neg:
+    case OP_plus:
+    case OP_not:
+    case OP_lnot:
+    case OP_typeof:
+    case OP_is_undefined_or_null:
+    case OP_is_undefined:
+    case OP_is_null:
+    case OP_typeof_is_undefined:
+    case OP_typeof_is_function:
+    case OP_get_length:
+    case OP_to_propkey:
+    case OP_to_propkey2:
+        return js_jit_unary(f, sp, op);
+    case OP_post_inc:
+    case OP_post_dec:
+        return js_jit_post_inc(f, sp, op);
+    case OP_inc_loc:
+    case OP_dec_loc:
+        return js_jit_inc_loc(f, sp, *operand,
+                              op == OP_inc_loc ? OP_inc : OP_dec);
+    case OP_add_loc:
+        return js_jit_add_loc(f, sp, *operand);
+    case OP_goto:
+    case OP_goto16:
+    case OP_goto8:
+    case OP_if_false:
+    case OP_if_true:
+    case OP_if_false8:
+    case OP_if_true8:
+        return js_jit_poll(f, sp);
+    default:
+        abort();
+    }
+}
+
+/* see jit_gen_permute(). A source value used twice is duplicated. */
+static void js_aot_gen_permute(DynBuf *d, int n_src, int n_dst,
+                               const uint8_t *perm)
+{
+    int i, used = 0;
+
+    dbuf_printf(d, "    {\n        JSValue");
+    for(i = 0; i < n_src; i++)
+        dbuf_printf(d, "%s t%d = sp[%d]", i ? "," : "", i, i - n_src);
+    dbuf_printf(d, ";\n");
+    for(i = 0; i < n_dst; i++) {
+        if (used & (1 << perm[i]))
+            dbuf_printf(d, "        sp[%d] = JS_DupValue(ctx, t%d);\n",
+                        i - n_src, perm[i]);
+        else
+            dbuf_printf(d, "        sp[%d] = t%d;\n", i - n_src, perm[i]);
+        used |= 1 << perm[i];
+    }
+    if (n_dst != n_src)
+        dbuf_printf(d, "        sp += %d;\n", n_dst - n_src);
+    dbuf_printf(d, "    }\n");
+}
+
+/* Generate the instruction at 'pos'. Return -1 if it has no C
+   translation. */
+static int js_aot_gen_op(DynBuf *d, JSFunctionBytecode *b, int pos, int op)
+{
+    const uint8_t *bc = b->byte_code_buf;
+    const uint8_t *operand = bc + pos + 1;
+    int idx, argc, target;
+
+    switch(op) {
+    case OP_nop:
+        break;
+    case OP_push_i32:
+        dbuf_printf(d, "    JS_AOT_PUSH(JS_NewInt32(ctx, %d));\n",
+                    (int32_t)get_u32(operand));
+        break;
+    case OP_push_minus1:
+    case OP_push_0:
+    case OP_push_1:
+    case OP_push_2:
+    case OP_push_3:
+    case OP_push_4:
+    case OP_push_5:
+    case OP_push_6:
+    case OP_push_7:
+        dbuf_printf(d, "    JS_AOT_PUSH(JS_NewInt32(ctx, %d));\n",
+                    op - OP_push_0);
+        break;
+    case OP_push_i8:
+        dbuf_printf(d, "    JS_AOT_PUSH(JS_NewInt32(ctx, %d));\n",
+                    get_i8(operand));
+        break;
+    case OP_push_i16:
+        dbuf_printf(d, "    JS_AOT_PUSH(JS_NewInt32(ctx, %d));\n",
+                    get_i16(operand));
+        break;
+    case OP_undefined:
+        dbuf_printf(d, "    JS_AOT_PUSH(JS_UNDEFINED);\n");
+        break;
+    case OP_null:
+        dbuf_printf(d, "    JS_AOT_PUSH(JS_NULL);\n");
+        break;
+    case OP_push_false:
+        dbuf_printf(d, "    JS_AOT_PUSH(JS_FALSE);\n");
+        break;
+    case OP_push_true:
+        dbuf_printf(d, "    JS_AOT_PUSH(JS_TRUE);\n");
+        break;
+    case OP_push_const:
+    case OP_push_const8:
+    case OP_push_atom_value:
+    case OP_fclosure:
+    case OP_fclosure8:
+    case OP_push_empty_string:
+    case OP_push_this:
+    case OP_object:
+    case OP_special_object:
+    case OP_rest:
+        dbuf_printf(d, "    JS_AOT_OP(%d, 1);\n", pos);
+        break;
+
+    case OP_drop:
+        dbuf_printf(d, "    JS_FreeValue(ctx, *--sp);\n");
+        break;
+    case OP_nip:
+    case OP_nip1:
+        {
+            static const uint8_t perm[] = { 1, 2 };
+            int n = (op == OP_nip) ? 2 : 3;
+            dbuf_printf(d, "    JS_FreeValue(ctx, sp[%d]);\n", -n);
+            js_aot_gen_permute(d, n, n - 1, perm);
+        }
+        break;
+    case OP_dup:
+    case OP_dup1:
+    case OP_dup2:
+    case OP_dup3:
+    case OP_insert2:
+    case OP_insert3:
+    case OP_insert4:
+        idx = op - OP_dup;
+        js_aot_gen_permute(d, jit_dup_n_src[idx],
+                           jit_dup_n_src[idx] + jit_dup_n_dup[idx],
+                           jit_dup_perms[idx]);
+        break;
+    case OP_perm3:
+    case OP_perm4:
+    case OP_perm5:
+    case OP_swap:
+    case OP_swap2:
+    case OP_rot3l:
+    case OP_rot3r:
+    case OP_rot4l:
+    case OP_rot5l:
+        idx = op - OP_perm3;
+        js_aot_gen_permute(d, jit_perm_n[idx], jit_perm_n[idx],
+                           jit_perms[idx]);
+        break;
+
+    case OP_get_loc:
+    case OP_get_loc8:
+    case OP_get_loc0:
+    case OP_get_loc1:
+    case OP_get_loc2:
+    case OP_get_loc3:
+    case OP_get_loc_check:
+        if (op == OP_get_loc || op == OP_get_loc_check)
+            idx = get_u16(operand);
+        else if (op == OP_get_loc8)
+            idx = *operand;
+        else
+            idx = op - OP_get_loc0;
+        if (op == OP_get_loc_check)
+            dbuf_printf(d, "    JS_AOT_CHECK_INIT(var_buf[%d], %d);\n",
+                        idx, pos);
+        dbuf_printf(d, "    JS_AOT_GET(var_buf[%d]);\n", idx);
+        break;
+    case OP_put_loc:
+    case OP_put_loc8:
+    case OP_put_loc0:
+    case OP_put_loc1:
+    case OP_put_loc2:
+    case OP_put_loc3:
+    case OP_put_loc_check:
+        if (op == OP_put_loc || op == OP_put_loc_check)
+            idx = get_u16(operand);
+        else if (op == OP_put_loc8)
+            idx = *operand;
+        else
+            idx = op - OP_put_loc0;
+        if (op == OP_put_loc_check)
+            dbuf_printf(d, "    JS_AOT_CHECK_INIT(var_buf[%d], %d);\n",
+                        idx, pos);
+        dbuf_printf(d, "    JS_AOT_PUT(var_buf[%d]);\n", idx);
+        break;
+    case OP_set_loc:
+    case OP_set_loc8:
+    case OP_set_loc0:
+    case OP_set_loc1:
+    case OP_set_loc2:
+    case OP_set_loc3:
+        if (op == OP_set_loc)
+            idx = get_u16(operand);
+        else if (op == OP_set_loc8)
+            idx = *operand;
+        else
+            idx = op - OP_set_loc0;
+        dbuf_printf(d, "    JS_AOT_SET(var_buf[%d]);\n", idx);
+        break;
+    case OP_set_loc_uninitialized:
+        dbuf_printf(d, "    JS_AOT_STORE(var_buf[%d], JS_UNINITIALIZED);\n",
+                    get_u16(operand));
+        break;
+    case OP_close_loc:
+        dbuf_printf(d, "    JS_AOT_OP(%d, 0);\n", pos);
+        break;
+    case OP_get_arg:
+    case OP_get_arg0:
+    case OP_get_arg1:
+    case OP_get_arg2:
+    case OP_get_arg3:
+        idx = (op == OP_get_arg) ? get_u16(operand) : op - OP_get_arg0;
+        dbuf_printf(d, "    JS_AOT_GET(arg_buf[%d]);\n", idx);
+        break;
+    case OP_put_arg:
+    case OP_put_arg0:
+    case OP_put_arg1:
+    case OP_put_arg2:
+    case OP_put_arg3:
+        idx = (op == OP_put_arg) ? get_u16(operand) : op - OP_put_arg0;
+        dbuf_printf(d, "    JS_AOT_PUT(arg_buf[%d]);\n", idx);
+        break;
+    case OP_set_arg:
+    case OP_set_arg0:
+    case OP_set_arg1:
+    case OP_set_arg2:
+    case OP_set_arg3:
+        idx = (op == OP_set_arg) ? get_u16(operand) : op - OP_set_arg0;
+        dbuf_printf(d, "    JS_AOT_SET(arg_buf[%d]);\n", idx);
+        break;
+    case OP_get_var_ref:
+    case OP_get_var_ref0:
+    case OP_get_var_ref1:
+    case OP_get_var_ref2:
+    case OP_get_var_ref3:
+    case OP_get_var_ref_check:
+        dbuf_printf(d, "    JS_AOT_OP(%d, 1);\n", pos);
+        break;
+    case OP_put_var_ref:
+    case OP_put_var_ref0:
+    case OP_put_var_ref1:
+    case OP_put_var_ref2:
+    case OP_put_var_ref3:
+    case OP_put_var_ref_check:
+        dbuf_printf(d, "    JS_AOT_OP(%d, -1);\n", pos);
+        break;
+    case OP_set_var_ref:
+    case OP_set_var_ref0:
+    case OP_set_var_ref1:
+    case OP_set_var_ref2:
+    case OP_set_var_ref3:
+        dbuf_printf(d, "    JS_AOT_OP(%d, 0);\n", pos);
+        break;
+
+    case OP_get_field:
+    case OP_get_field2:
+    case OP_put_field:
+        dbuf_printf(d, "    JS_AOT_OP(%d, %d);\n", pos,
+                    op == OP_get_field2 ? 1 : op == OP_put_field ? -2 : 0);
+        break;
+    case OP_get_var_undef:
+    case OP_get_var:
+    case OP_put_var:
+    case OP_put_var_init:
+    case OP_put_var_strict:
+        dbuf_printf(d, "    JS_AOT_OP(%d, %d);\n", pos,
+                    (op == OP_get_var_undef || op == OP_get_var) ? 1 :
+                    op == OP_put_var_strict ? -2 : -1);
+        break;
+    case OP_get_array_el:
+    case OP_get_array_el2:
+    case OP_put_array_el:
+        dbuf_printf(d, "    JS_AOT_OP(%d, %d);\n", pos,
+                    op == OP_get_array_el ? -1 : op == OP_put_array_el ? -3 : 0);
+        break;
+    case OP_define_field:
+        dbuf_printf(d, "    JS_AOT_OP(%d, -1);\n", pos);
+        break;
+    case OP_array_from:
+        dbuf_printf(d, "    JS_AOT_OP(%d, %d);\n", pos, 1 - get_u16(operand));
+        break;
+
+    case OP_call0:
+    case OP_call1:
+    case OP_call2:
+    case OP_call3:
+        dbuf_printf(d, "    JS_AOT_OP(%d, %d);\n", pos, -(op - OP_call0));
+        break;
+    case OP_call:
+    case OP_tail_call:
+    case OP_call_method:
+    case OP_tail_call_method:
+    case OP_call_constructor:
+        argc = get_u16(operand);
+        if (op == OP_call || op == OP_tail_call)
+            dbuf_printf(d, "    JS_AOT_OP(%d, %d);\n", pos, -argc);
+        else
+            dbuf_printf(d, "    JS_AOT_OP(%d, %d);\n", pos, -1 - argc);
+        if (op == OP_tail_call || op == OP_tail_call_method)
+            dbuf_printf(d, "    JS_AOT_RETURN();\n");
+        break;
+    case OP_return:
+        dbuf_printf(d, "    JS_AOT_RETURN();\n");
+        break;
+    case OP_return_undef:
+        dbuf_printf(d, "    JS_AOT_RETURN_UNDEF();\n");
+        break;
+
+    case OP_add:
+        dbuf_printf(d, "    JS_AOT_ARITH(%d, +, 1);\n", pos);
+        break;
+    case OP_sub:
+        dbuf_printf(d, "    JS_AOT_ARITH(%d, -, 1);\n", pos);
+        break;
+    case OP_mul:
+        dbuf_printf(d, "    JS_AOT_ARITH(%d, *, 0);\n", pos);
+        break;
+    case OP_and:
+        dbuf_printf(d, "    JS_AOT_LOGIC(%d, &);\n", pos);
+        break;
+    case OP_or:
+        dbuf_printf(d, "    JS_AOT_LOGIC(%d, |);\n", pos);
+        break;
+    case OP_xor:
+        dbuf_printf(d, "    JS_AOT_LOGIC(%d, ^);\n", pos);
+        break;
+    case OP_div:
+        dbuf_printf(d, "    JS_AOT_DIV(%d);\n", pos);
+        break;
+    case OP_mod:
+    case OP_pow:
+    case OP_shl:
+    case OP_sar:
+    case OP_shr:
+    case OP_in:
+    case OP_instanceof:
+        dbuf_printf(d, "    JS_AOT_OP(%d, -1);\n", pos);
+        break;
+    case OP_lt:
+        dbuf_printf(d, "    JS_AOT_COMPARE(%d, <);\n", pos);
+        break;
+    case OP_lte:
+        dbuf_printf(d, "    JS_AOT_COMPARE(%d, <=);\n", pos);
+        break;
+    case OP_gt:
+        dbuf_printf(d, "    JS_AOT_COMPARE(%d, >);\n", pos);
+        break;
+    case OP_gte:
+        dbuf_printf(d, "    JS_AOT_COMPARE(%d, >=);\n", pos);
+        break;
+    case OP_eq:
+    case OP_strict_eq:
+        dbuf_printf(d, "    JS_AOT_COMPARE(%d, ==);\n", pos);
+        break;
+    case OP_neq:
+    case OP_strict_neq:
+        dbuf_printf(d, "    JS_AOT_COMPARE(%d, !=);\n", pos);
+        break;
+    case OP_inc:
+        dbuf_printf(d, "    JS_AOT_INC(sp[-1], %d, 1, INT32_MAX);\n", pos);
+        break;
+    case OP_dec:
+        dbuf_printf(d, "    JS_AOT_INC(sp[-1], %d, -1, INT32_MIN);\n", pos);
+        break;
+    case OP_neg:
+    case OP_plus:
+    case OP_not:
+    case OP_lnot:
+    case OP_typeof:
+    case OP_is_undefined_or_null:
+    case OP_is_undefined:
+    case OP_is_null:
+    case OP_typeof_is_undefined:
+    case OP_typeof_is_function:
+    case OP_get_length:
+    case OP_to_propkey:
+    case OP_to_propkey2:
+        dbuf_printf(d, "    JS_AOT_OP(%d, 0);\n", pos);
+        break;
+    case OP_post_inc:
+    case OP_post_dec:
+        dbuf_printf(d, "    JS_AOT_OP(%d, 1);\n", pos);
+        break;
+    case OP_inc_loc:
+        dbuf_printf(d, "    JS_AOT_INC(var_buf[%d], %d, 1, INT32_MAX);\n",
+                    *operand, pos);
+        break;
+    case OP_dec_loc:
+        dbuf_printf(d, "    JS_AOT_INC(var_buf[%d], %d, -1, INT32_MIN);\n",
+                    *operand, pos);
+        break;
+    case OP_add_loc:
+        dbuf_printf(d, "    JS_AOT_ADD_LOC(var_buf[%d], %d);\n",
+                    *operand, pos);
+        break;
+
+    case OP_goto:
+    case OP_goto16:
+    case OP_goto8:
+        target = jit_get_target(bc, pos, short_opcode_info(op).fmt);
+        if (target <= pos)
+            dbuf_printf(d, "    JS_AOT_POLL(%d);\n", pos);
+        dbuf_printf(d, "    goto L%d;\n", target);
+        break;
+    case OP_if_false:
+    case OP_if_true:
+    case OP_if_false8:
+    case OP_if_true8:
+        target = jit_get_target(bc, pos, short_opcode_info(op).fmt);
+        dbuf_printf(d, "    JS_AOT_TO_BOOL(res);\n");
+        dbuf_printf(d, "    if (%sres) {\n",
+                    (op == OP_if_false || op == OP_if_false8) ? "!" : "");
+        if (target <= pos)
+            dbuf_printf(d, "        JS_AOT_POLL(%d);\n", pos);
+        dbuf_printf(d, "        goto L%d;\n    }\n", target);
+        break;
+    default:
+        return -1;
+    }
+    return 0;
+}
+
+/* Generate the C function 'name'_'idx'. Return FALSE if its first
+   instruction has no C translation: it would only return to the
+   interpreter. */
+static BOOL js_aot_gen_function(JSContext *ctx, DynBuf *d,
+                                JSFunctionBytecode *b, const char *name,
+                                int idx)
+{
+    const uint8_t *bc = b->byte_code_buf;
+    int pos, pos_next, op, target;
+    size_t start = d->size;
+    uint8_t *is_target;
+
+    is_target = js_mallocz(ctx, b->byte_code_len);
+    if (!is_target) {
+        d->error = TRUE;
+        return FALSE;
+    }
+    for(pos = 0; pos < b->byte_code_len; pos = pos_next) {
+        op = jit_get_op(bc[pos]);
+        pos_next = pos + short_opcode_info(op).size;
+        switch(op) {
+        case OP_goto:
+        case OP_goto16:
+        case OP_goto8:
+        case OP_if_false:
+        case OP_if_true:
+        case OP_if_false8:
+        case OP_if_true8:
+            target = jit_get_target(bc, pos, short_opcode_info(op).fmt);
+            if (target >= 0 && target < b->byte_code_len)
+                is_target[target] = TRUE;
+            break;
+        default:
+            break;
+        }
+    }
+
+    dbuf_printf(d, "static int %s_%d(JSAOTFrame *f)\n"
+                "{\n"
+                "    JSContext *ctx = f->ctx;\n"
+                "    JSValue *sp = f->sp, *var_buf = f->var_buf, *arg_buf = f->arg_buf;\n"
+                "    int res;\n"
+                "\n"
+                "    (void)ctx;\n"
+                "    (void)var_buf;\n"
+                "    (void)arg_buf;\n"
+                "    (void)res;\n", name, idx);
+    for(pos = 0; pos < b->byte_code_len; pos = pos_next) {
+        op = jit_get_op(bc[pos]);
+        pos_next = pos + short_opcode_info(op).size;
+        if (is_target[pos])
+            dbuf_printf(d, " L%d:\n", pos);
+        if (js_aot_gen_op(d, b, pos, op) < 0) {
+            if (pos == 0) {
+                d->size = start;
+                break;
+            }
+            dbuf_printf(d, "    JS_AOT_EXIT(%d);\n", pos);
+        }
+    }
+    js_free(ctx, is_target);
+    if (d->size == start)
+        return FALSE;
+    dbuf_printf(d, "}\n\n");
+    return TRUE;
+}
+
+typedef struct JSAOTEntry {
+    uint64_t hash;
+    JSFunctionBytecode *b;
+} JSAOTEntry;
+
+static int js_aot_entry_cmp(const void *a, const void *b, void *opaque)
+{
+    const JSAOTEntry *e1 = a, *e2 = b;
+
+    if (e1->hash != e2->hash)
+        return e1->hash < e2->hash ? -1 : 1;
+    return e1->b->byte_code_len - e2->b->byte_code_len;
+}
+
+/* add the bytecode functions of 'obj' and of its constant pools */
+static int js_aot_collect(JSContext *ctx, JSAOTEntry **ptab, int *psize,
+                          int *pcount, JSValueConst obj)
+{
+    JSFunctionBytecode *b;
+    int i;
+
+    switch(JS_VALUE_GET_TAG(obj)) {
+    case JS_TAG_MODULE:
+        return js_aot_collect(ctx, ptab, psize, pcount,
+                              ((JSModuleDef *)JS_VALUE_GET_PTR(obj))->func_obj);
+    case JS_TAG_FUNCTION_BYTECODE:
+        b = JS_VALUE_GET_PTR(obj);
+        if (js_resize_array(ctx, (void **)ptab, sizeof((*ptab)[0]), psize,
+                            *pcount + 1))
+            return -1;
+        (*ptab)[*pcount].hash = js_aot_hash(b);
+        (*ptab)[*pcount].b = b;
+        (*pcount)++;
+        for(i = 0; i < b->cpool_count; i++) {
+            if (js_aot_collect(ctx, ptab, psize, pcount, b->cpool[i]))
+                return -1;
+        }
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+char *JS_GenerateAOT(JSContext *ctx, JSValueConst obj, const char *name,
+                     size_t *plen)
+{
+    JSAOTEntry *tab = NULL;
+    int i, size = 0, count = 0, n = 0;
+    DynBuf d, dtab;
+    char *res = NULL;
+
+    js_dbuf_init(ctx, &d);
+    js_dbuf_init(ctx, &dtab);
+    if (js_aot_collect(ctx, &tab, &size, &count, obj))
+        goto done;
+    rqsort(tab, count, sizeof(tab[0]), js_aot_entry_cmp, NULL);
+
+    dbuf_printf(&d, "/* generated by JS_GenerateAOT() */\n\n"
+                "#include \"quickjs-aot.h\"\n\n");
+    dbuf_printf(&dtab, "const JSAOTFunction %s[] = {\n", name);
+    for(i = 0; i < count; i++) {
+        if (i > 0 && !js_aot_entry_cmp(&tab[i - 1], &tab[i], NULL))
+            continue;
+        if (!js_aot_gen_function(ctx, &d, tab[i].b, name, n))
+            continue;
+        dbuf_printf(&dtab, "    { 0x%016" PRIx64 "ULL, %d, %s_%d },\n",
+                    tab[i].hash, tab[i].b->byte_code_len, name, n);
+        n++;
+    }
+    if (n == 0)
+        dbuf_printf(&dtab, "    { 0, 0, NULL },\n");
+    dbuf_printf(&dtab, "};\n\nconst int %s_count = %d;\n", name, n);
+    dbuf_put(&d, dtab.buf, dtab.size);
+    dbuf_putc(&d, '\0');
+    if (d.error || dtab.error) {
+        JS_ThrowOutOfMemory(ctx);
+        goto done;
+    }
+    *plen = d.size - 1;
+    res = (char *)d.buf;
+    d.buf = NULL;
+ done:
+    js_free(ctx, tab);
+    dbuf_free(&d);
+    dbuf_free(&dtab);
+    return res;
+}
+
+/* Called at the start of a bytecode function. Return 0 if the
+   interpreter runs the function from sf->cur_pc with the stack
+   pointer sf->cur_sp, 1 if the function returned sf->cur_sp[-1], 2 if
+   it returned undefined and -1 if there is an exception. The stack
+   pointer is passed in sf->cur_sp, which is otherwise only used by the
+   generators. */
+static no_inline int js_jit_enter(JSContext *ctx, JSFunctionBytecode *b,
+                                  JSStackFrame *sf, JSValueConst this_obj,
+                                  JSValueConst new_target, int argc,
+                                  JSValueConst *argv, JSVarRef **var_refs)
+{
+    JSJitFrame f;
+    int ret;
+
+    if (!b->jit_code) {
+        if (!b->aot_checked) {
+            b->aot_checked = TRUE;
+            if (ctx->rt->aot_table_count != 0)
+                b->jit_code = js_aot_find(ctx->rt, b);
+        }
+#ifdef CONFIG_JIT
+        if (!b->jit_code && !b->jit_failed && ctx->rt->jit_threshold != 0 &&
+            ++b->jit_counter >= ctx->rt->jit_threshold) {
+            if (js_jit_compile(ctx, b))
+                b->jit_failed = TRUE;
+        }
+#endif
+        if (!b->jit_code) {
+            sf->cur_pc = b->byte_code_buf;
+            return 0;
+        }
+    }
+    f.ctx = ctx;
+    f.b = b;
+    f.sf = sf;
+    f.var_refs = var_refs;
+    f.this_obj = this_obj;
+    f.new_target = new_target;
+    f.argc = argc;
+    f.argv = argv;
+    f.var_buf = sf->var_buf;
+    f.arg_buf = sf->arg_buf;
+    f.interrupt_counter = &ctx->interrupt_counter;
+    f.sp = sf->cur_sp;
+    f.pc = b->byte_code_buf;
+    ret = ((JSJitCode *)b->jit_code)(&f);
+    sf->cur_sp = f.sp;
+    if (ret == 0)
+        sf->cur_pc = f.pc;
+    return ret;
+}
+
+#ifdef DUMP_OPCODE_PAIRS
+/* process wide: the counts of all the runtimes are summed */
+static uint64_t js_opcode_pair_count[256][256];
+static int js_prev_opcode;
 
-enum {
-    TOK_NUMBER = -128,
-    TOK_STRING,
-    TOK_TEMPLATE,
-    TOK_IDENT,
-    TOK_REGEXP,
-    /* warning: order matters (see js_parse_assign_expr) */
-    TOK_MUL_ASSIGN,
-    TOK_DIV_ASSIGN,
-    TOK_MOD_ASSIGN,
-    TOK_PLUS_ASSIGN,
-    TOK_MINUS_ASSIGN,
-    TOK_SHL_ASSIGN,
-    TOK_SAR_ASSIGN,
-    TOK_SHR_ASSIGN,
-    TOK_AND_ASSIGN,
-    TOK_XOR_ASSIGN,
-    TOK_OR_ASSIGN,
-    TOK_POW_ASSIGN,
-    TOK_LAND_ASSIGN,
-    TOK_LOR_ASSIGN,
-    TOK_DOUBLE_QUESTION_MARK_ASSIGN,
-    TOK_DEC,
-    TOK_INC,
-    TOK_SHL,
-    TOK_SAR,
-    TOK_SHR,
-    TOK_LT,
-    TOK_LTE,
-    TOK_GT,
-    TOK_GTE,
-    TOK_EQ,
-    TOK_STRICT_EQ,
-    TOK_NEQ,
-    TOK_STRICT_NEQ,
-    TOK_LAND,
-    TOK_LOR,
-    TOK_POW,
-    TOK_ARROW,
-    TOK_ELLIPSIS,
-    TOK_DOUBLE_QUESTION_MARK,
-    TOK_QUESTION_MARK_DOT,
-    TOK_ERROR,
-    TOK_PRIVATE_NAME,
-    TOK_EOF,
-    /* keywords: WARNING: same order as atoms */
-    TOK_NULL, /* must be first */
-    TOK_FALSE,
-    TOK_TRUE,
-    TOK_IF,
-    TOK_ELSE,
-    TOK_RETURN,
-    TOK_VAR,
-    TOK_THIS,
-    TOK_DELETE,
-    TOK_VOID,
-    TOK_TYPEOF,
-    TOK_NEW,
-    TOK_IN,
-    TOK_INSTANCEOF,
-    TOK_DO,
-    TOK_WHILE,
-    TOK_FOR,
-    TOK_BREAK,
-    TOK_CONTINUE,
-    TOK_SWITCH,
-    TOK_CASE,
-    TOK_DEFAULT,
-    TOK_THROW,
-    TOK_TRY,
-    TOK_CATCH,
-    TOK_FINALLY,
-    TOK_FUNCTION,
-    TOK_DEBUGGER,
-    TOK_WITH,
-    /* FutureReservedWord */
-    TOK_CLASS,
-    TOK_CONST,
-    TOK_ENUM,
-    TOK_EXPORT,
-    TOK_EXTENDS,
-    TOK_IMPORT,
-    TOK_SUPER,
-    /* FutureReservedWords when parsing strict mode code */
-    TOK_IMPLEMENTS,
-    TOK_INTERFACE,
-    TOK_LET,
-    TOK_PACKAGE,
-    TOK_PRIVATE,
-    TOK_PROTECTED,
-    TOK_PUBLIC,
-    TOK_STATIC,
-    TOK_YIELD,
-    TOK_AWAIT, /* must be last */
-    TOK_OF,     /* only used for js_parse_skip_parens_token() */
-};
+static int js_count_opcode(int op)
+{
+    js_opcode_pair_count[js_prev_opcode][op]++;
+    js_prev_opcode = op;
+    return op;
+}
 
-#define TOK_FIRST_KEYWORD   TOK_NULL
-#define TOK_LAST_KEYWORD    TOK_AWAIT
+static int js_opcode_pair_cmp(const void *a, const void *b, void *opaque)
+{
+    uint64_t ca = ((uint64_t *)js_opcode_pair_count)[*(const int *)a];
+    uint64_t cb = ((uint64_t *)js_opcode_pair_count)[*(const int *)b];
+    return (ca < cb) - (ca > cb);
+}
 
-/* unicode code points */
-#define CP_NBSP 0x00a0
-#define CP_BOM  0xfeff
+static void js_dump_opcode_pairs(void)
+{
+    static int tab[256 * 256];
+    uint64_t total, count;
+    int i, n;
 
-#define CP_LS   0x2028
-#define CP_PS   0x2029
+    total = 0;
+    for(i = 0; i < 256 * 256; i++) {
+        tab[i] = i;
+        total += ((uint64_t *)js_opcode_pair_count)[i];
+    }
+    if (total == 0)
+        return;
+    rqsort(tab, 256 * 256, sizeof(tab[0]), js_opcode_pair_cmp, NULL);
+    printf("%" PRIu64 " instructions executed, most frequent pairs:\n",
+           total);
+    for(i = 0; i < 40; i++) {
+        n = tab[i];
+        count = ((uint64_t *)js_opcode_pair_count)[n];
+        if (count == 0)
+            break;
+        printf("  %5.2f%%  %s %s\n", count * 100.0 / total,
+               short_opcode_info(n >> 8).name, short_opcode_info(n & 0xff).name);
+    }
+}
+#endif
 
-typedef struct BlockEnv {
-    struct BlockEnv *prev;
-    JSAtom label_name; /* JS_ATOM_NULL if none */
-    int label_break; /* -1 if none */
-    int label_cont; /* -1 if none */
-    int drop_count; /* number of stack elements to drop */
-    int label_finally; /* -1 if none */
-    int scope_level;
-    uint8_t has_iterator : 1;
-    uint8_t is_regular_stmt : 1; /* i.e. not a loop statement */
-} BlockEnv;
+/* Profiler
 
-typedef struct JSGlobalVar {
-    int cpool_idx; /* if >= 0, index in the constant pool for hoisted
-                      function defintion*/
-    uint8_t force_init : 1; /* force initialization to undefined */
-    uint8_t is_lexical : 1; /* global let/const definition */
-    uint8_t is_const   : 1; /* const definition */
-    int scope_level;    /* scope of definition */
-    JSAtom var_name;  /* variable name */
-} JSGlobalVar;
+   When profiling is enabled (JS_SetProfiling()), JS_CallInternal()
+   runs the bytecode functions with a dispatch table which counts each
+   instruction and the backward jumps (loop iterations) before running
+   it. The calls are recorded in a calling context tree: a node per
+   function and call path, with the direct recursive calls and the calls
+   deeper than JS_PROFILE_MAX_DEPTH merged into the caller node. The time
+   between two calls or returns is the self time of the running
+   function, including the C functions it calls. The nodes are found by
+   function bytecode, so a function of a script evaluated again gets new
+   nodes, which the reports merge by name and location. */
 
-typedef struct RelocEntry {
-    struct RelocEntry *next;
-    uint32_t addr; /* address to patch */
-    int size;   /* address size: 1, 2 or 4 bytes */
-} RelocEntry;
+#define JS_PROFILE_MAX_DEPTH 128
 
-typedef struct JumpSlot {
-    int op;
-    int size;
-    int pos;
-    int label;
-} JumpSlot;
+static inline uint32_t js_profile_hash(const JSProfileNode *parent,
+                                       const JSFunctionBytecode *b)
+{
+    uint64_t h = (uintptr_t)parent * 0x9E3779B97F4A7C15 + (uintptr_t)b;
+    return (uint32_t)(h ^ (h >> 32));
+}
 
-typedef struct LabelSlot {
-    int ref_count;
-    int pos;    /* phase 1 address, -1 means not resolved yet */
-    int pos2;   /* phase 2 address, -1 means not resolved yet */
-    int addr;   /* phase 3 address, -1 means not resolved yet */
-    RelocEntry *first_reloc;
-} LabelSlot;
+static int js_profile_resize(JSRuntime *rt, JSProfile *prof, int new_size)
+{
+    JSProfileNode **new_hash, *node, *next;
+    uint32_t h;
+    int i;
 
-typedef struct LineNumberSlot {
-    uint32_t pc;
-    uint32_t source_pos;
-} LineNumberSlot;
+    new_hash = js_mallocz_rt(rt, sizeof(new_hash[0]) * new_size);
+    if (!new_hash)
+        return -1;
+    for(i = 0; i < prof->hash_size; i++) {
+        for(node = prof->hash[i]; node != NULL; node = next) {
+            next = node->hash_next;
+            h = js_profile_hash(node->parent, node->b) & (new_size - 1);
+            node->hash_next = new_hash[h];
+            new_hash[h] = node;
+        }
+    }
+    js_free_rt(rt, prof->hash);
+    prof->hash = new_hash;
+    prof->hash_size = new_size;
+    return 0;
+}
 
-typedef struct {
-    /* last source position */
-    const uint8_t *ptr;
-    int line_num;
+/* return NULL if not enough memory */
+static JSProfileNode *js_profile_find_node(JSRuntime *rt, JSProfile *prof,
+                                           JSProfileNode *parent,
+                                           JSFunctionBytecode *b)
+{
+    JSProfileNode *node;
+    JSAtom filename;
+    uint32_t h;
     int col_num;
-    const uint8_t *buf_start;
-} GetLineColCache;
 
-typedef enum JSParseFunctionEnum {
-    JS_PARSE_FUNC_STATEMENT,
-    JS_PARSE_FUNC_VAR,
-    JS_PARSE_FUNC_EXPR,
-    JS_PARSE_FUNC_ARROW,
-    JS_PARSE_FUNC_GETTER,
-    JS_PARSE_FUNC_SETTER,
-    JS_PARSE_FUNC_METHOD,
-    JS_PARSE_FUNC_CLASS_STATIC_INIT,
-    JS_PARSE_FUNC_CLASS_CONSTRUCTOR,
-    JS_PARSE_FUNC_DERIVED_CLASS_CONSTRUCTOR,
-} JSParseFunctionEnum;
+    filename = b->has_debug ? b->debug.filename : JS_ATOM_NULL;
+    h = js_profile_hash(parent, b) & (prof->hash_size - 1);
+    for(node = prof->hash[h]; node != NULL; node = node->hash_next) {
+        /* the atoms are compared in case 'b' was freed and its memory
+           reused */
+        if (node->parent == parent && node->b == b &&
+            node->func_name == b->func_name && node->filename == filename)
+            return node;
+    }
+    if (prof->node_count >= 2 * prof->hash_size) {
+        if (js_profile_resize(rt, prof, prof->hash_size * 2))
+            return NULL;
+        h = js_profile_hash(parent, b) & (prof->hash_size - 1);
+    }
+    node = js_mallocz_rt(rt, sizeof(*node));
+    if (!node)
+        return NULL;
+    node->parent = parent;
+    node->b = b;
+    node->func_name = JS_DupAtomRT(rt, b->func_name);
+    node->filename = JS_DupAtomRT(rt, filename);
+    node->line_num = find_line_num(b->realm, b, -1, &col_num);
+    node->depth = parent->depth + 1;
+    node->hash_next = prof->hash[h];
+    prof->hash[h] = node;
+    prof->node_count++;
+    return node;
+}
+
+/* return the node to restore with js_profile_exit() */
+static JSProfileNode *js_profile_enter(JSRuntime *rt, JSFunctionBytecode *b,
+                                       BOOL is_call)
+{
+    JSProfile *prof = rt->profile;
+    JSProfileNode *parent, *node;
+    int64_t t;
+
+    parent = prof->cur;
+    t = js_get_time_ns();
+    parent->self_time += t - prof->last_time;
+    prof->last_time = t;
+    node = parent;
+    if (parent->b != b && parent->depth < JS_PROFILE_MAX_DEPTH) {
+        node = js_profile_find_node(rt, prof, parent, b);
+        if (!node)
+            node = parent;
+    }
+    if (is_call)
+        node->calls++;
+    prof->cur = node;
+    prof->last_pc = NULL;
+    prof->frame_count++;
+    return parent;
+}
+
+static void js_profile_exit(JSRuntime *rt, JSProfileNode *parent)
+{
+    JSProfile *prof = rt->profile;
+    int64_t t;
+
+    t = js_get_time_ns();
+    prof->cur->self_time += t - prof->last_time;
+    prof->last_time = t;
+    prof->cur = parent;
+    prof->last_pc = NULL;
+    prof->frame_count--;
+}
+
+static void js_profile_free_nodes(JSRuntime *rt, JSProfile *prof)
+{
+    JSProfileNode *node, *next;
+    int i;
 
-typedef enum JSParseExportEnum {
-    JS_PARSE_EXPORT_NONE,
-    JS_PARSE_EXPORT_NAMED,
-    JS_PARSE_EXPORT_DEFAULT,
-} JSParseExportEnum;
+    for(i = 0; i < prof->hash_size; i++) {
+        for(node = prof->hash[i]; node != NULL; node = next) {
+            next = node->hash_next;
+            JS_FreeAtomRT(rt, node->func_name);
+            JS_FreeAtomRT(rt, node->filename);
+            js_free_rt(rt, node);
+        }
+        prof->hash[i] = NULL;
+    }
+    prof->node_count = 0;
+}
 
-typedef struct JSFunctionDef {
-    JSContext *ctx;
-    struct JSFunctionDef *parent;
-    int parent_cpool_idx; /* index in the constant pool of the parent
-                             or -1 if none */
-    int parent_scope_level; /* scope level in parent at point of definition */
-    struct list_head child_list; /* list of JSFunctionDef.link */
-    struct list_head link;
+static void js_profile_free(JSRuntime *rt)
+{
+    JSProfile *prof = rt->profile;
 
-    BOOL is_eval; /* TRUE if eval code */
-    int eval_type; /* only valid if is_eval = TRUE */
-    BOOL is_global_var; /* TRUE if variables are not defined locally:
-                           eval global, eval module or non strict eval */
-    BOOL is_func_expr; /* TRUE if function expression */
-    BOOL has_home_object; /* TRUE if the home object is available */
-    BOOL has_prototype; /* true if a prototype field is necessary */
-    BOOL has_simple_parameter_list;
-    BOOL has_parameter_expressions; /* if true, an argument scope is created */
-    BOOL has_use_strict; /* to reject directive in special cases */
-    BOOL has_eval_call; /* true if the function contains a call to eval() */
-    BOOL has_arguments_binding; /* true if the 'arguments' binding is
-                                   available in the function */
-    BOOL has_this_binding; /* true if the 'this' and new.target binding are
-                              available in the function */
-    BOOL new_target_allowed; /* true if the 'new.target' does not
-                                throw a syntax error */
-    BOOL super_call_allowed; /* true if super() is allowed */
-    BOOL super_allowed; /* true if super. or super[] is allowed */
-    BOOL arguments_allowed; /* true if the 'arguments' identifier is allowed */
-    BOOL is_derived_class_constructor;
-    BOOL in_function_body;
-    JSFunctionKindEnum func_kind : 8;
-    JSParseFunctionEnum func_type : 8;
-    uint8_t js_mode; /* bitmap of JS_MODE_x */
-    JSAtom func_name; /* JS_ATOM_NULL if no name */
+    if (!prof)
+        return;
+    js_profile_free_nodes(rt, prof);
+    js_free_rt(rt, prof->hash);
+    js_free_rt(rt, prof);
+    rt->profile = NULL;
+    rt->profiling = FALSE;
+}
 
-    JSVarDef *vars;
-    int var_size; /* allocated size for vars[] */
-    int var_count;
-    JSVarDef *args;
-    int arg_size; /* allocated size for args[] */
-    int arg_count; /* number of arguments */
-    int defined_arg_count;
-    int var_object_idx; /* -1 if none */
-    int arg_var_object_idx; /* -1 if none (var object for the argument scope) */
-    int arguments_var_idx; /* -1 if none */
-    int arguments_arg_idx; /* argument variable definition in argument scope,
-                              -1 if none */
-    int func_var_idx; /* variable containing the current function (-1
-                         if none, only used if is_func_expr is true) */
-    int eval_ret_idx; /* variable containing the return value of the eval, -1 if none */
-    int this_var_idx; /* variable containg the 'this' value, -1 if none */
-    int new_target_var_idx; /* variable containg the 'new.target' value, -1 if none */
-    int this_active_func_var_idx; /* variable containg the 'this.active_func' value, -1 if none */
-    int home_object_var_idx;
-    BOOL need_home_object;
+/* Enable or disable the profiling of the bytecode functions called
+   afterwards. The native code (JIT or AOT) is not used while profiling
+   is enabled. The profile is kept when profiling is disabled. Return -1
+   if not enough memory. */
+int JS_SetProfiling(JSRuntime *rt, JS_BOOL enable)
+{
+    JSProfile *prof = rt->profile;
 
-    int scope_level;    /* index into fd->scopes if the current lexical scope */
-    int scope_first;    /* index into vd->vars of first lexically scoped variable */
-    int scope_size;     /* allocated size of fd->scopes array */
-    int scope_count;    /* number of entries used in the fd->scopes array */
-    JSVarScope *scopes;
-    JSVarScope def_scope_array[4];
-    int body_scope; /* scope of the body of the function or eval */
+    if (enable && !prof) {
+        prof = js_mallocz_rt(rt, sizeof(*prof));
+        if (!prof)
+            return -1;
+        prof->hash_size = 64;
+        prof->hash = js_mallocz_rt(rt, sizeof(prof->hash[0]) * prof->hash_size);
+        if (!prof->hash) {
+            js_free_rt(rt, prof);
+            return -1;
+        }
+        prof->cur = &prof->root;
+        rt->profile = prof;
+    }
+    if (enable && !rt->profiling)
+        prof->last_time = js_get_time_ns();
+    rt->profiling = enable;
+    return 0;
+}
 
-    int global_var_count;
-    int global_var_size;
-    JSGlobalVar *global_vars;
+/* Clear the profile. The calling context tree is only freed if no
+   profiled function is running. */
+void JS_ResetProfile(JSRuntime *rt)
+{
+    JSProfile *prof = rt->profile;
+    JSProfileNode *node;
+    int i;
 
-    DynBuf byte_code;
-    int last_opcode_pos; /* -1 if no last opcode */
-    const uint8_t *last_opcode_source_ptr;
-    BOOL use_short_opcodes; /* true if short opcodes are used in byte_code */
+    if (!prof)
+        return;
+    if (prof->frame_count == 0) {
+        js_profile_free_nodes(rt, prof);
+    } else {
+        for(i = 0; i < prof->hash_size; i++) {
+            for(node = prof->hash[i]; node != NULL; node = node->hash_next) {
+                node->calls = 0;
+                node->loops = 0;
+                node->self_time = 0;
+            }
+        }
+    }
+    prof->root.self_time = 0;
+    memset(prof->op_count, 0, sizeof(prof->op_count));
+    prof->last_time = js_get_time_ns();
+}
 
-    LabelSlot *label_slots;
-    int label_size; /* allocated size for label_slots[] */
-    int label_count;
-    BlockEnv *top_break; /* break/continue label stack */
+/* return the nodes of the profile in a js_malloc_rt() array */
+static JSProfileNode **js_profile_get_nodes(JSRuntime *rt, int *pcount)
+{
+    JSProfile *prof = rt->profile;
+    JSProfileNode **tab, *node;
+    int i, n;
 
-    /* constant pool (strings, functions, numbers) */
-    JSValue *cpool;
-    int cpool_count;
-    int cpool_size;
+    *pcount = 0;
+    if (!prof || prof->node_count == 0)
+        return NULL;
+    tab = js_malloc_rt(rt, sizeof(tab[0]) * prof->node_count);
+    if (!tab)
+        return NULL;
+    n = 0;
+    for(i = 0; i < prof->hash_size; i++) {
+        for(node = prof->hash[i]; node != NULL; node = node->hash_next)
+            tab[n++] = node;
+    }
+    *pcount = n;
+    return tab;
+}
 
-    /* list of variables in the closure */
-    int closure_var_count;
-    int closure_var_size;
-    JSClosureVar *closure_var;
+/* by function location */
+static int js_profile_node_cmp(const void *a, const void *b, void *opaque)
+{
+    const JSProfileNode *n1 = *(const JSProfileNode **)a;
+    const JSProfileNode *n2 = *(const JSProfileNode **)b;
 
-    JumpSlot *jump_slots;
-    int jump_size;
-    int jump_count;
+    if (n1->filename != n2->filename)
+        return (n1->filename > n2->filename) - (n1->filename < n2->filename);
+    if (n1->line_num != n2->line_num)
+        return (n1->line_num > n2->line_num) - (n1->line_num < n2->line_num);
+    return (n1->func_name > n2->func_name) - (n1->func_name < n2->func_name);
+}
 
-    LineNumberSlot *line_number_slots;
-    int line_number_size;
-    int line_number_count;
-    int line_number_last;
-    int line_number_last_pc;
+/* JSProfileNode array by decreasing self time */
+static int js_profile_time_cmp(const void *a, const void *b, void *opaque)
+{
+    const JSProfileNode *n1 = a, *n2 = b;
+    return (n1->self_time < n2->self_time) - (n1->self_time > n2->self_time);
+}
 
-    /* pc2line table */
-    BOOL strip_debug : 1; /* strip all debug info (implies strip_source = TRUE) */
-    BOOL strip_source : 1; /* strip only source code */
-    JSAtom filename;
-    uint32_t source_pos; /* pointer in the eval() source */
-    GetLineColCache *get_line_col_cache; /* XXX: could remove to save memory */
-    DynBuf pc2line;
+static int js_profile_op_cmp(const void *a, const void *b, void *opaque)
+{
+    const uint64_t *op_count = opaque;
+    uint64_t c1 = op_count[*(const uint8_t *)a];
+    uint64_t c2 = op_count[*(const uint8_t *)b];
+    return (c1 < c2) - (c1 > c2);
+}
 
-    char *source;  /* raw source, utf-8 encoded */
-    int source_len;
+static void js_profile_print_location(JSRuntime *rt, DynBuf *dbuf,
+                                      const JSProfileNode *node)
+{
+    char buf[ATOM_GET_STR_BUF_SIZE];
 
-    JSModuleDef *module; /* != NULL when parsing a module */
-    BOOL has_await; /* TRUE if await is used (used in module eval) */
-} JSFunctionDef;
+    if (node->func_name == JS_ATOM_NULL)
+        dbuf_putstr(dbuf, "<anonymous>");
+    else
+        dbuf_putstr(dbuf, JS_AtomGetStrRT(rt, buf, sizeof(buf), node->func_name));
+    if (node->filename != JS_ATOM_NULL) {
+        dbuf_printf(dbuf, " (%s:%d)",
+                    JS_AtomGetStrRT(rt, buf, sizeof(buf), node->filename),
+                    node->line_num);
+    }
+}
 
-typedef struct JSToken {
-    int val;
-    const uint8_t *ptr; /* position in the source */
-    union {
-        struct {
-            JSValue str;
-            int sep;
-        } str;
-        struct {
-            JSValue val;
-        } num;
-        struct {
-            JSAtom atom;
-            BOOL has_escape;
-            BOOL is_reserved;
-        } ident;
-        struct {
-            JSValue body;
-            JSValue flags;
-        } regexp;
-    } u;
-} JSToken;
+static char *js_profile_dbuf_end(DynBuf *dbuf, size_t *plen)
+{
+    if (dbuf_putc(dbuf, '\0') || dbuf->error) {
+        dbuf_free(dbuf);
+        return NULL;
+    }
+    if (plen)
+        *plen = dbuf->size - 1;
+    return (char *)dbuf->buf;
+}
 
-typedef struct JSParseState {
-    JSContext *ctx;
-    const char *filename;
-    JSToken token;
-    BOOL got_lf; /* true if got line feed before the current token */
-    const uint8_t *last_ptr;
-    const uint8_t *buf_start;
-    const uint8_t *buf_ptr;
-    const uint8_t *buf_end;
+/* Text report of the profile: the functions by decreasing self time
+   with their calls and loop iterations, then the executed instructions
+   by opcode. Return NULL if not enough memory. The result must be freed
+   with js_free_rt(). */
+char *JS_GetProfileReport(JSRuntime *rt, size_t *plen)
+{
+    JSProfile *prof = rt->profile;
+    JSProfileNode **tab, *funcs, *f;
+    uint8_t ops[256];
+    uint64_t op_total;
+    int64_t total_time;
+    DynBuf dbuf;
+    int i, count, func_count, op_count;
 
-    /* current function code */
-    JSFunctionDef *cur_func;
-    BOOL is_module; /* parsing a module */
-    BOOL allow_html_comments;
-    BOOL ext_json; /* true if accepting JSON superset */
-    GetLineColCache get_line_col_cache;
-} JSParseState;
+    tab = js_profile_get_nodes(rt, &count);
+    funcs = js_malloc_rt(rt, sizeof(funcs[0]) * max_int(count, 1));
+    if (!funcs) {
+        js_free_rt(rt, tab);
+        return NULL;
+    }
+    /* merge the nodes of each function */
+    rqsort(tab, count, sizeof(tab[0]), js_profile_node_cmp, NULL);
+    func_count = 0;
+    total_time = 0;
+    f = NULL;
+    for(i = 0; i < count; i++) {
+        if (i == 0 || js_profile_node_cmp(&tab[i - 1], &tab[i], NULL) != 0) {
+            f = &funcs[func_count++];
+            *f = *tab[i];
+        } else {
+            f->calls += tab[i]->calls;
+            f->loops += tab[i]->loops;
+            f->self_time += tab[i]->self_time;
+        }
+        total_time += tab[i]->self_time;
+    }
+    js_free_rt(rt, tab);
+    rqsort(funcs, func_count, sizeof(funcs[0]), js_profile_time_cmp, NULL);
+
+    op_count = 0;
+    op_total = 0;
+    if (prof) {
+        for(i = 0; i < 256; i++) {
+            if (prof->op_count[i] != 0) {
+                ops[op_count++] = i;
+                op_total += prof->op_count[i];
+            }
+        }
+        rqsort(ops, op_count, sizeof(ops[0]), js_profile_op_cmp,
+               prof->op_count);
+    }
+
+    dbuf_init2(&dbuf, rt, (DynBufReallocFunc *)js_realloc_rt);
+    dbuf_printf(&dbuf, "%.3f ms in %d functions, %" PRIu64 " instructions\n",
+                total_time / 1e6, func_count, op_total);
+    dbuf_printf(&dbuf, "%10s %10s %12s  %s\n",
+                "self ms", "calls", "loops", "function");
+    for(i = 0; i < func_count; i++) {
+        f = &funcs[i];
+        dbuf_printf(&dbuf, "%10.3f %10" PRIu64 " %12" PRIu64 "  ",
+                    f->self_time / 1e6, f->calls, f->loops);
+        js_profile_print_location(rt, &dbuf, f);
+        dbuf_putc(&dbuf, '\n');
+    }
+    js_free_rt(rt, funcs);
+    dbuf_printf(&dbuf, "%12s %6s  %s\n", "count", "%", "opcode");
+    for(i = 0; i < op_count; i++) {
+        dbuf_printf(&dbuf, "%12" PRIu64 " %5.1f%%  %s\n",
+                    prof->op_count[ops[i]],
+                    prof->op_count[ops[i]] * 100.0 / op_total,
+                    short_opcode_info(ops[i]).name);
+    }
+    return js_profile_dbuf_end(&dbuf, plen);
+}
 
-typedef struct JSOpCode {
-#ifdef DUMP_BYTECODE
-    const char *name;
-#endif
-    uint8_t size; /* in bytes */
-    /* the opcodes remove n_pop items from the top of the stack, then
-       pushes n_push items */
-    uint8_t n_pop;
-    uint8_t n_push;
-    uint8_t fmt;
-} JSOpCode;
+#ifdef DUMP_PROFILE
+static void js_dump_profile(JSRuntime *rt)
+{
+    char *str;
+    size_t len;
 
-static const JSOpCode opcode_info[OP_COUNT + (OP_TEMP_END - OP_TEMP_START)] = {
-#define FMT(f)
-#ifdef DUMP_BYTECODE
-#define DEF(id, size, n_pop, n_push, f) { #id, size, n_pop, n_push, OP_FMT_ ## f },
-#else
-#define DEF(id, size, n_pop, n_push, f) { size, n_pop, n_push, OP_FMT_ ## f },
+    str = JS_GetProfileReport(rt, &len);
+    if (str) {
+        fwrite(str, 1, len, stdout);
+        js_free_rt(rt, str);
+    }
+}
 #endif
-#include "quickjs-opcode.h"
-#undef DEF
-#undef FMT
-};
 
-#if SHORT_OPCODES
-/* After the final compilation pass, short opcodes are used. Their
-   opcodes overlap with the temporary opcodes which cannot appear in
-   the final bytecode. Their description is after the temporary
-   opcodes in opcode_info[]. */
-#define short_opcode_info(op)           \
-    opcode_info[(op) >= OP_TEMP_START ? \
-                (op) + (OP_TEMP_END - OP_TEMP_START) : (op)]
-#else
-#define short_opcode_info(op) opcode_info[op]
-#endif
+/* Folded stacks of the profile, as used by flamegraph.pl and
+   speedscope: a line per call path with its self time in microseconds,
+   the functions separated by ';' from the outermost one. Return NULL if
+   not enough memory. The result must be freed with js_free_rt(). */
+char *JS_GetProfileFoldedStacks(JSRuntime *rt, size_t *plen)
+{
+    JSProfileNode **tab, *path[JS_PROFILE_MAX_DEPTH], *node;
+    DynBuf dbuf;
+    int64_t us;
+    int i, j, n, count;
+
+    tab = js_profile_get_nodes(rt, &count);
+    dbuf_init2(&dbuf, rt, (DynBufReallocFunc *)js_realloc_rt);
+    for(i = 0; i < count; i++) {
+        us = tab[i]->self_time / 1000;
+        if (us <= 0)
+            continue;
+        n = 0;
+        for(node = tab[i]; node->parent != NULL; node = node->parent)
+            path[n++] = node;
+        for(j = n - 1; j >= 0; j--) {
+            js_profile_print_location(rt, &dbuf, path[j]);
+            if (j != 0)
+                dbuf_putc(&dbuf, ';');
+        }
+        dbuf_printf(&dbuf, " %" PRId64 "\n", us);
+    }
+    js_free_rt(rt, tab);
+    return js_profile_dbuf_end(&dbuf, plen);
+}
 
 static __exception int next_token(JSParseState *s);
 
@@ -29754,6 +34688,90 @@ static void free_bytecode_atoms(JSRuntime *rt,
     }
 }
 
+static BOOL js_ic_is_global_var_op(int op)
+{
+    return op == OP_get_var_undef || op == OP_get_var ||
+#if SHORT_OPCODES
+        op == OP_get_var_get_field2 ||
+#endif
+        op == OP_put_var || op == OP_put_var_init || op == OP_put_var_strict;
+}
+
+static BOOL js_ic_is_cached_op(int op)
+{
+    return op == OP_get_field || op == OP_get_field2 || op == OP_put_field ||
+        js_ic_is_global_var_op(op);
+}
+
+/* Give an inline cache to the property and global variable accesses of
+   'b': their atom operand is replaced by the cache index. Nothing is done if the
+   caches cannot be allocated. */
+static void js_ic_init(JSContext *ctx, JSFunctionBytecode *b)
+{
+    uint8_t *bc_buf = b->byte_code_buf;
+    JSInlineCache *ic;
+    uint32_t count;
+    int pos, op;
+
+    count = 0;
+    for(pos = 0; pos < b->byte_code_len; pos += short_opcode_info(op).size) {
+        op = bc_buf[pos];
+        if (js_ic_is_cached_op(op))
+            count++;
+    }
+    if (count == 0)
+        return;
+    ic = js_mallocz_rt(ctx->rt, sizeof(ic[0]) * count);
+    if (!ic)
+        return;
+    count = 0;
+    for(pos = 0; pos < b->byte_code_len; pos += short_opcode_info(op).size) {
+        op = bc_buf[pos];
+        if (js_ic_is_cached_op(op)) {
+            ic[count].atom = get_u32(bc_buf + pos + 1);
+            ic[count].is_global_var = js_ic_is_global_var_op(op);
+            /* integer keys take the array fast paths */
+            ic[count].megamorphic = __JS_AtomIsTaggedInt(ic[count].atom);
+            put_u32(bc_buf + pos + 1, count);
+            count++;
+        }
+    }
+    b->ic = ic;
+    b->ic_count = count;
+}
+
+/* put back the atom operands of the caches of 'b' into 'bc_buf', a
+   copy of its bytecode */
+static void js_ic_restore_atoms(const JSFunctionBytecode *b, uint8_t *bc_buf)
+{
+    int pos, op;
+
+    if (!b->ic)
+        return;
+    for(pos = 0; pos < b->byte_code_len; pos += short_opcode_info(op).size) {
+        op = bc_buf[pos];
+        if (js_ic_is_cached_op(op))
+            put_u32(bc_buf + pos + 1, b->ic[get_u32(bc_buf + pos + 1)].atom);
+    }
+}
+
+/* the atoms are restored so that free_bytecode_atoms() frees them */
+static void js_ic_free(JSRuntime *rt, JSFunctionBytecode *b)
+{
+    uint32_t i;
+
+    if (!b->ic)
+        return;
+    js_ic_restore_atoms(b, b->byte_code_buf);
+    for(i = 0; i < b->ic_count; i++) {
+        if (!b->ic[i].is_global_var)
+            js_ic_free_entries(rt, &b->ic[i]);
+    }
+    js_free_rt(rt, b->ic);
+    b->ic = NULL;
+    b->ic_count = 0;
+}
+
 static void js_free_function_def(JSContext *ctx, JSFunctionDef *fd)
 {
     int i;
@@ -32964,6 +37982,15 @@ static __exception int resolve_labels(JSContext *ctx, JSFunctionDef *s)
                     if (line2 >= 0) line_num = line2;
                     break;
                 }
+                /* Transformation: dup put_loc_check(n) drop -> put_loc_check(n) */
+                if (code_match(&cc, pos_next, OP_put_loc_check, -1, OP_drop, -1)) {
+                    if (cc.line_num >= 0) line_num = cc.line_num;
+                    add_pc2line_info(s, bc_out.size, line_num);
+                    dbuf_putc(&bc_out, OP_put_loc_check);
+                    dbuf_put_u16(&bc_out, cc.idx);
+                    pos_next = cc.pos;
+                    break;
+                }
             }
             goto no_change;
 
@@ -33077,6 +38104,7 @@ static __exception int resolve_labels(JSContext *ctx, JSFunctionDef *s)
             if (OPTIMIZE) {
                 /* transformation:
                    post_inc put_x drop -> inc put_x
+                   post_inc put_loc_check drop -> inc put_loc_check
                    post_inc perm3 put_field drop -> inc put_field
                    post_inc perm3 put_var_strict drop -> inc put_var_strict
                    post_inc perm4 put_array_el drop -> inc put_array_el
@@ -33097,6 +38125,15 @@ static __exception int resolve_labels(JSContext *ctx, JSFunctionDef *s)
                     put_short_code(&bc_out, op1, idx);
                     break;
                 }
+                if (code_match(&cc, pos_next, OP_put_loc_check, -1, OP_drop, -1)) {
+                    if (cc.line_num >= 0) line_num = cc.line_num;
+                    add_pc2line_info(s, bc_out.size, line_num);
+                    dbuf_putc(&bc_out, OP_dec + (op - OP_post_dec));
+                    dbuf_putc(&bc_out, OP_put_loc_check);
+                    dbuf_put_u16(&bc_out, cc.idx);
+                    pos_next = cc.pos;
+                    break;
+                }
                 if (code_match(&cc, pos_next, OP_perm3, M2(OP_put_field, OP_put_var_strict), OP_drop, -1)) {
                     if (cc.line_num >= 0) line_num = cc.line_num;
                     add_pc2line_info(s, bc_out.size, line_num);
@@ -33271,6 +38308,52 @@ static __exception int resolve_labels(JSContext *ctx, JSFunctionDef *s)
     return -1;
 }
 
+#if SHORT_OPCODES
+/* Superinstructions: the first opcode of a frequent sequence is
+   replaced by an opcode executing the whole sequence. The bytecode
+   keeps its layout, so a jump to a later instruction of the sequence
+   and the passes decoding the bytecode see the original instructions.
+   The sequences are the most executed opcode pairs of the test-server
+   scripts and tests/microbench.js (DUMP_OPCODE_PAIRS). Must run after
+   compute_stack_size(). */
+static void fuse_superinstructions(JSFunctionDef *s)
+{
+    uint8_t *bc_buf = s->byte_code.buf;
+    int bc_len = s->byte_code.size;
+    int pos, pos_next, op, op_next;
+
+    for(pos = 0; pos < bc_len; pos = pos_next) {
+        op = bc_buf[pos];
+        pos_next = pos + short_opcode_info(op).size;
+        if (pos_next >= bc_len)
+            break;
+        op_next = bc_buf[pos_next];
+        switch(op) {
+        case OP_lt:
+            if (op_next == OP_if_false8)
+                bc_buf[pos] = OP_lt_if_false8;
+            break;
+        case OP_push_i16:
+            /* lt is one byte */
+            if (op_next == OP_lt && pos_next + 1 < bc_len &&
+                bc_buf[pos_next + 1] == OP_if_false8)
+                bc_buf[pos] = OP_push_i16_lt_if_false8;
+            break;
+        case OP_inc_loc:
+            if (op_next == OP_goto8)
+                bc_buf[pos] = OP_inc_loc_goto8;
+            break;
+        case OP_get_var:
+            if (op_next == OP_get_field2)
+                bc_buf[pos] = OP_get_var_get_field2;
+            break;
+        default:
+            break;
+        }
+    }
+}
+#endif
+
 /* compute the maximum stack size needed by the function */
 
 typedef struct StackSizeState {
@@ -33659,6 +38742,11 @@ static JSValue js_create_function(JSContext *ctx, JSFunctionDef *fd)
     if (compute_stack_size(ctx, fd, &stack_size) < 0)
         goto fail;
 
+#if SHORT_OPCODES
+    if (OPTIMIZE)
+        fuse_superinstructions(fd);
+#endif
+
     if (fd->strip_debug) {
         function_size = offsetof(JSFunctionBytecode, debug);
     } else {
@@ -33775,6 +38863,7 @@ static JSValue js_create_function(JSContext *ctx, JSFunctionDef *fd)
         js_dump_function_bytecode(ctx, b);
     }
 #endif
+    js_ic_init(ctx, b);
 
     if (fd->parent) {
         /* remove from parent list */
@@ -33798,6 +38887,11 @@ static void free_function_bytecode(JSRuntime *rt, JSFunctionBytecode *b)
         printf("freeing %s\n",
                JS_AtomGetStrRT(rt, buf, sizeof(buf), b->func_name));
     }
+#endif
+    js_ic_free(rt, b);
+#ifdef CONFIG_JIT
+    if (b->jit_code_size != 0)
+        js_jit_free_code(rt, b->jit_code);
 #endif
     free_bytecode_atoms(rt, b->byte_code_buf, b->byte_code_len, TRUE);
 
@@ -33823,7 +38917,7 @@ static void free_function_bytecode(JSRuntime *rt, JSFunctionBytecode *b)
         js_free_rt(rt, b->debug.source);
     }
 
-    remove_gc_object(&b->header);
+    remove_gc_object(rt, &b->header);
     if (rt->gc_phase == JS_GC_PHASE_REMOVE_CYCLES && b->header.ref_count != 0) {
         list_add_tail(&b->header.link, &rt->gc_zero_ref_count_list);
     } else {
@@ -35008,7 +40102,7 @@ typedef enum BCTagEnum {
     BC_TAG_OBJECT_REFERENCE,
 } BCTagEnum;
 
-#define BC_VERSION 4
+#define BC_VERSION 5
 
 typedef struct BCWriterState {
     JSContext *ctx;
@@ -35221,21 +40315,24 @@ static void bc_byte_swap(uint8_t *bc_buf, int bc_len)
 }
 
 static int JS_WriteFunctionBytecode(BCWriterState *s,
-                                    const uint8_t *bc_buf1, int bc_len)
+                                    const JSFunctionBytecode *b)
 {
-    int pos, len, op;
+    int pos, len, op, bc_len;
     JSAtom atom;
     uint8_t *bc_buf;
     uint32_t val;
 
+    bc_len = b->byte_code_len;
     bc_buf = js_malloc(s->ctx, bc_len);
     if (!bc_buf)
         return -1;
-    memcpy(bc_buf, bc_buf1, bc_len);
+    memcpy(bc_buf, b->byte_code_buf, bc_len);
+    js_ic_restore_atoms(b, bc_buf);
 
     pos = 0;
     while (pos < bc_len) {
-        op = bc_buf[pos];
+        op = js_unquicken_op(bc_buf[pos]);
+        bc_buf[pos] = op;
         len = short_opcode_info(op).size;
         switch(short_opcode_info(op).fmt) {
         case OP_FMT_atom:
@@ -35394,7 +40491,7 @@ static int JS_WriteFunctionTag(BCWriterState *s, JSValueConst obj)
         bc_put_u8(s, flags);
     }
 
-    if (JS_WriteFunctionBytecode(s, b->byte_code_buf, b->byte_code_len))
+    if (JS_WriteFunctionBytecode(s, b))
         goto fail;
 
     if (b->has_debug) {
@@ -36352,6 +41449,9 @@ static JSValue JS_ReadFunctionTag(BCReaderState *s)
         bc_read_trace(s, "bytecode {\n");
         if (JS_ReadFunctionBytecode(s, b, byte_code_offset, b->byte_code_len))
             goto fail;
+        /* ROM bytecode is not modified */
+        if (!b->read_only_bytecode)
+            js_ic_init(ctx, b);
         bc_read_trace(s, "}\n");
     }
     if (b->has_debug) {
@@ -47157,7 +52257,7 @@ static void js_weakref_free(JSRuntime *rt, JSValue val)
            free_zero_refcount() */
         if (p->weakref_count == 0 && p->header.ref_count == 0 &&
             p->header.mark == 0) {
-            js_free_rt(rt, p);
+            js_free_object_struct(rt, p);
         }
     } else if (JS_VALUE_GET_TAG(val) == JS_TAG_SYMBOL) {
         JSString *p = JS_VALUE_GET_STRING(val);
@@ -369,6 +369,16 @@ JSRuntime *JS_NewRuntime(void);
 void JS_SetRuntimeInfo(JSRuntime *rt, const char *info);
 void JS_SetMemoryLimit(JSRuntime *rt, size_t limit);
 void JS_SetGCThreshold(JSRuntime *rt, size_t gc_threshold);
+/* maximum time of the automatic cycle collection steps in microseconds,
+   0 (default) to collect the whole heap at once */
+void JS_SetGCBudget(JSRuntime *rt, int budget_us);
+/* number of helper threads of the full GC, 0 (default) to run it on
+   the calling thread only. The gc_mark functions of the classes must be
+   thread safe. Return -1 if the threads cannot be created. */
+int JS_SetGCThreads(JSRuntime *rt, int count);
+/* number of calls before a function is compiled to native code, 0
+   (default) to disable the JIT */
+void JS_SetJITThreshold(JSRuntime *rt, int threshold);
 /* use 0 to disable maximum stack size check */
 void JS_SetMaxStackSize(JSRuntime *rt, size_t stack_size);
 /* should be called when changing thread to update the stack top value
@@ -445,6 +455,14 @@ typedef struct JSMemoryUsage {
 void JS_ComputeMemoryUsage(JSRuntime *rt, JSMemoryUsage *s);
 void JS_DumpMemoryUsage(FILE *fp, const JSMemoryUsage *s, JSRuntime *rt);
 
+/* interpreter profile: executed instructions by opcode, calls, self
+   time and loop iterations of the bytecode functions */
+int JS_SetProfiling(JSRuntime *rt, JS_BOOL enable);
+void JS_ResetProfile(JSRuntime *rt);
+/* text reports, to be freed with js_free_rt() */
+char *JS_GetProfileReport(JSRuntime *rt, size_t *plen);
+char *JS_GetProfileFoldedStacks(JSRuntime *rt, size_t *plen);
+
 /* atom support */
 #define JS_ATOM_NULL 0
 
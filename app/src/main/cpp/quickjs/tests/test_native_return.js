@@ -0,0 +1,48 @@
+// Native code must stay within the operand stack of the bytecode. A function
+// returning undefined may have no stack slot for the result, and a local
+// reset to uninitialized may be stored while the stack is full. Run under
+// ASan (scripts/run_quickjs_tests.sh --asan --jit / --aot).
+
+function assert(actual, expected, message) {
+    if (actual !== expected)
+        throw Error("assertion failed: got |" + actual + "|, expected |" +
+                    expected + "|" + (message ? " (" + message + ")" : ""));
+}
+
+function empty() {}
+function fall_through(a) { a = 1; }
+function return_undef(a) { if (a) return; return; }
+function nested() { function inner() {} inner(); }
+function* gen() {}
+async function async_empty() {}
+class Empty { constructor() {} }
+class Derived extends Empty { constructor() { super(); } }
+
+function test_empty() {
+    for (let i = 0; i < 3; i++) {
+        assert(empty(), undefined, "empty");
+        assert(fall_through(i), undefined, "fall_through");
+        assert(return_undef(i), undefined, "return_undef");
+        assert(nested(), undefined, "nested");
+        assert(empty.call({}), undefined, "call");
+        assert(Reflect.apply(empty, null, [1, 2, 3]), undefined, "apply");
+        assert(typeof new Empty(), "object", "constructor");
+        assert(new Derived() instanceof Empty, true, "derived");
+        assert(gen().next().done, true, "generator");
+        assert(async_empty() instanceof Promise, true, "async");
+        assert((() => {})(), undefined, "arrow");
+    }
+    [1, 2, 3].forEach(function () {});
+}
+
+function test_uninitialized() {
+    var fns = [];
+    for (let i = 0; i < 3; i++) {
+        let x = { i };
+        fns.push(() => x.i);
+    }
+    assert(fns[0]() + fns[1]() + fns[2](), 3, "per iteration bindings");
+}
+
+test_empty();
+test_uninitialized();
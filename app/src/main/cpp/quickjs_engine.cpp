@@ -0,0 +1,300 @@
+#include "quickjs_engine.h"
+
+#include <cstdio>
+
+#include "http_polyfill.h"
+
+extern "C" {
+#include "quickjs/quickjs-libc.h"
+}
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOG_TAG "QuickJSTest"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#define LOGE(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#endif
+
+bool RealQuickJSEngine::initialize() {
+    LOGI("Initializing Real QuickJS Engine");
+    cleanup();
+
+    runtime_ = JS_NewRuntime();
+    if (!runtime_) {
+        LOGE("Failed to create QuickJS runtime");
+        return false;
+    }
+
+    // Set memory limits for mobile environment
+    JS_SetMemoryLimit(runtime_, 64 * 1024 * 1024); // 64MB limit
+    JS_SetGCThreshold(runtime_, 1024 * 1024);       // 1MB GC threshold
+    JS_SetJITThreshold(runtime_, jitThreshold_);
+    JS_SetGCBudget(runtime_, gcBudgetUs_);
+    JS_SetGCThreads(runtime_, gcThreads_);
+    for (AotFunctions add : aotFunctions_) {
+        add(runtime_);
+    }
+    if (profiling_) {
+        JS_SetProfiling(runtime_, 1);
+    }
+
+    if (!createContext()) {
+        LOGE("Failed to create QuickJS context");
+        JS_FreeRuntime(runtime_);
+        runtime_ = nullptr;
+        return false;
+    }
+
+    initialized_ = true;
+    LOGI("QuickJS Engine initialized successfully with memory management and HTTP polyfills");
+    return true;
+}
+
+bool RealQuickJSEngine::createContext() {
+    context_ = JS_NewContext(runtime_);
+    if (!context_) {
+        return false;
+    }
+    // Standard library, fetch()/XMLHttpRequest, then the caller's globals
+    js_std_add_helpers(context_, 0, nullptr);
+    addHttpPolyfills(context_);
+    if (setup_) {
+        setup_(context_);
+    }
+    return true;
+}
+
+void RealQuickJSEngine::cleanup() {
+    if (context_) {
+        JS_FreeContext(context_);
+        context_ = nullptr;
+    }
+    if (runtime_) {
+        JS_FreeRuntime(runtime_);
+        runtime_ = nullptr;
+    }
+    initialized_ = false;
+}
+
+void RealQuickJSEngine::setJitThreshold(int threshold) {
+    jitThreshold_ = threshold;
+    if (runtime_) {
+        JS_SetJITThreshold(runtime_, threshold);
+    }
+}
+
+void RealQuickJSEngine::setGcBudget(int budgetUs) {
+    gcBudgetUs_ = budgetUs;
+    if (runtime_) {
+        JS_SetGCBudget(runtime_, budgetUs);
+    }
+}
+
+void RealQuickJSEngine::setGcThreads(int count) {
+    gcThreads_ = count;
+    if (runtime_) {
+        JS_SetGCThreads(runtime_, count);
+    }
+}
+
+void RealQuickJSEngine::addAotFunctions(AotFunctions add) {
+    aotFunctions_.push_back(add);
+    if (runtime_) {
+        add(runtime_);
+    }
+}
+
+void RealQuickJSEngine::setProfiling(bool enabled) {
+    profiling_ = enabled;
+    if (runtime_ && JS_SetProfiling(runtime_, enabled) < 0) {
+        LOGE("Not enough memory to enable profiling");
+    }
+}
+
+// Takes ownership of a JS_GetProfile*() result
+static std::string takeProfileText(JSRuntime *rt, char *text, size_t length) {
+    if (!text) {
+        return std::string();
+    }
+    std::string result(text, length);
+    js_free_rt(rt, text);
+    return result;
+}
+
+std::string RealQuickJSEngine::profileSnapshot() const {
+    if (!runtime_) {
+        return std::string();
+    }
+    size_t length = 0;
+    char *text = JS_GetProfileReport(runtime_, &length);
+    return takeProfileText(runtime_, text, length);
+}
+
+std::string RealQuickJSEngine::profileFoldedStacks() const {
+    if (!runtime_) {
+        return std::string();
+    }
+    size_t length = 0;
+    char *text = JS_GetProfileFoldedStacks(runtime_, &length);
+    return takeProfileText(runtime_, text, length);
+}
+
+void RealQuickJSEngine::resetProfile() {
+    if (runtime_) {
+        JS_ResetProfile(runtime_);
+    }
+}
+
+bool RealQuickJSEngine::reset() {
+    LOGI("Resetting QuickJS context");
+
+    if (!runtime_) {
+        LOGE("Cannot reset context: runtime not initialized");
+        return false;
+    }
+    if (context_) {
+        JS_FreeContext(context_);
+        context_ = nullptr;
+    }
+    if (!createContext()) {
+        LOGE("Failed to create new QuickJS context");
+        initialized_ = false;
+        return false;
+    }
+    return true;
+}
+
+bool RealQuickJSEngine::takeResult(JSValue value, const char* errorPrefix, std::string* result) {
+    if (JS_IsException(value)) {
+        JSValue exception = JS_GetException(context_);
+        const char *exceptionStr = JS_ToCString(context_, exception);
+        *result = errorPrefix;
+        *result += exceptionStr ? exceptionStr : "Unknown error";
+        if (exceptionStr) {
+            JS_FreeCString(context_, exceptionStr);
+        }
+        JS_FreeValue(context_, exception);
+        LOGE("JavaScript execution error: %s", result->c_str());
+        return false;
+    }
+    const char *str = JS_ToCString(context_, value);
+    if (str) {
+        *result = str;
+        JS_FreeCString(context_, str);
+    } else {
+        *result = "undefined";
+    }
+    JS_FreeValue(context_, value);
+    return true;
+}
+
+bool RealQuickJSEngine::doEval(const std::string& source, std::string* result) {
+    if (!isInitialized()) {
+        *result = "Error: QuickJS not initialized";
+        return false;
+    }
+    JSValue value = JS_Eval(context_, source.c_str(), source.length(), "<input>", JS_EVAL_TYPE_GLOBAL);
+    return takeResult(value, "JavaScript Error: ", result);
+}
+
+bool RealQuickJSEngine::doCompile(const std::string& source, std::vector<uint8_t>* bytecode, std::string* error) {
+    if (!isInitialized()) {
+        *error = "QuickJS not initialized for compilation";
+        return false;
+    }
+
+    // Compile the script as-is first; a body with a top-level return only
+    // compiles wrapped in a function, which loadBytecode() then calls
+    JSValue compiled = JS_Eval(context_, source.c_str(), source.length(), "<compile>",
+                               JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (JS_IsException(compiled)) {
+        JS_FreeValue(context_, JS_GetException(context_));
+        std::string wrapped = "(function() {\n" + source + "\n})";
+        compiled = JS_Eval(context_, wrapped.c_str(), wrapped.length(), "<compile-wrapped>",
+                           JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+        if (JS_IsException(compiled)) {
+            takeResult(compiled, "Compilation error: ", error);
+            return false;
+        }
+    }
+
+    size_t size;
+    uint8_t* bytes = JS_WriteObject(context_, &size, compiled, JS_WRITE_OBJ_BYTECODE);
+    JS_FreeValue(context_, compiled);
+    if (!bytes) {
+        *error = "Failed to compile JavaScript to bytecode";
+        return false;
+    }
+    bytecode->assign(bytes, bytes + size);
+    js_free(context_, bytes);
+    return true;
+}
+
+bool RealQuickJSEngine::doLoadBytecode(const uint8_t* data, size_t length, std::string* result) {
+    if (!isInitialized()) {
+        *result = "Error: QuickJS not initialized";
+        return false;
+    }
+
+    JSValue obj = JS_ReadObject(context_, data, length, JS_READ_OBJ_BYTECODE);
+    if (JS_IsException(obj)) {
+        return takeResult(obj, "Bytecode Error: ", result);
+    }
+    JSValue value = JS_EvalFunction(context_, obj);
+    if (JS_IsException(value)) {
+        return takeResult(value, "Bytecode Function Error: ", result);
+    }
+    // Scripts compiled with the function wrapper evaluate to that function
+    if (JS_IsFunction(context_, value)) {
+        JSValue called = JS_Call(context_, value, JS_UNDEFINED, 0, nullptr);
+        JS_FreeValue(context_, value);
+        value = called;
+    }
+    return takeResult(value, "JavaScript Error: ", result);
+}
+
+bool RealQuickJSEngine::doCall(const std::string& function, const std::vector<std::string>& jsonArgs,
+                               std::string* result) {
+    if (!isInitialized()) {
+        *result = "Error: QuickJS not initialized";
+        return false;
+    }
+
+    JSValue global = JS_GetGlobalObject(context_);
+    JSValue func = JS_GetPropertyStr(context_, global, function.c_str());
+    JS_FreeValue(context_, global);
+    if (!JS_IsFunction(context_, func)) {
+        JS_FreeValue(context_, func);
+        *result = "Error: " + function + " is not a function";
+        return false;
+    }
+
+    std::vector<JSValue> args;
+    args.reserve(jsonArgs.size());
+    JSValue value = JS_UNDEFINED;
+    for (const std::string& json : jsonArgs) {
+        JSValue arg = JS_ParseJSON(context_, json.c_str(), json.length(), "<arg>");
+        if (JS_IsException(arg)) {
+            value = arg;
+            break;
+        }
+        args.push_back(arg);
+    }
+    if (!JS_IsException(value)) {
+        value = JS_Call(context_, func, JS_UNDEFINED, (int)args.size(), args.data());
+    }
+    for (JSValue arg : args) {
+        JS_FreeValue(context_, arg);
+    }
+    JS_FreeValue(context_, func);
+    return takeResult(value, "JavaScript Error: ", result);
+}
+
+size_t RealQuickJSEngine::heapBytes() const {
+    JSMemoryUsage usage;
+    JS_ComputeMemoryUsage(runtime_, &usage);
+    return (size_t)usage.memory_used_size;
+}
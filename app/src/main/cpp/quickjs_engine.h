@@ -0,0 +1,88 @@
+#ifndef QUICKJS_ENGINE_H
+#define QUICKJS_ENGINE_H
+
+#include <vector>
+
+#include "js_engine.h"
+
+extern "C" {
+#include "quickjs/quickjs.h"
+}
+
+/**
+ * QuickJS backend: one runtime with one context carrying the std helpers
+ * and the fetch()/XMLHttpRequest polyfills. Bytecode is QuickJS's
+ * JS_WriteObject format.
+ */
+class RealQuickJSEngine : public JsEngine {
+public:
+    // Extra globals installed into every new context (e.g. ByteTransfer)
+    using ContextSetup = void (*)(JSContext *ctx);
+    // Registration function written by qjsaot -n (declared extern "C")
+    using AotFunctions = int (*)(JSRuntime *rt);
+
+    RealQuickJSEngine() = default;
+    ~RealQuickJSEngine() override { cleanup(); }
+    RealQuickJSEngine(const RealQuickJSEngine&) = delete;
+    RealQuickJSEngine& operator=(const RealQuickJSEngine&) = delete;
+
+    const char* name() const override { return "quickjs"; }
+    bool initialize() override;
+    bool isInitialized() const override { return initialized_ && runtime_ && context_; }
+    void cleanup() override;
+    bool reset() override;
+
+    // Applies to contexts created after the call
+    void setContextSetup(ContextSetup setup) { setup_ = setup; }
+    // Calls before a function is compiled to native code, 0 (default)
+    // keeps everything in the interpreter. Kept across initialize().
+    void setJitThreshold(int threshold);
+    // Longest automatic cycle collection step in microseconds, 0 (default)
+    // collects the whole heap at once. Kept across initialize().
+    void setGcBudget(int budgetUs);
+    // Helper threads of the full cycle collection, 0 (default) runs it on
+    // the calling thread. Kept across initialize().
+    void setGcThreads(int count);
+    // Functions compiled to C by qjsaot: scripts with the same source run
+    // them instead of the bytecode. Kept across initialize().
+    void addAotFunctions(AotFunctions add);
+    // Interpreter profiling: opcode counts, calls, self time and loop
+    // iterations per JS function. Native code is bypassed while enabled.
+    // The setting is kept across initialize(), the profile is not.
+    void setProfiling(bool enabled);
+    // Text report of the profile so far (functions by self time, then
+    // opcodes)
+    std::string profileSnapshot() const;
+    // The same profile as folded stacks ("outer;inner self_us" lines)
+    // for flamegraph.pl or speedscope
+    std::string profileFoldedStacks() const;
+    void resetProfile();
+
+    JSRuntime* runtime() const { return runtime_; }
+    JSContext* context() const { return context_; }
+
+protected:
+    bool doEval(const std::string& source, std::string* result) override;
+    bool doCompile(const std::string& source, std::vector<uint8_t>* bytecode, std::string* error) override;
+    bool doLoadBytecode(const uint8_t* data, size_t length, std::string* result) override;
+    bool doCall(const std::string& function, const std::vector<std::string>& jsonArgs,
+                std::string* result) override;
+    size_t heapBytes() const override;
+
+private:
+    bool createContext();
+    // Takes ownership of value; converts it, or the pending exception, into *result
+    bool takeResult(JSValue value, const char* errorPrefix, std::string* result);
+
+    JSRuntime *runtime_ = nullptr;
+    JSContext *context_ = nullptr;
+    bool initialized_ = false;
+    ContextSetup setup_ = nullptr;
+    int jitThreshold_ = 0;
+    int gcBudgetUs_ = 0;
+    int gcThreads_ = 0;
+    std::vector<AotFunctions> aotFunctions_;
+    bool profiling_ = false;
+};
+
+#endif // QUICKJS_ENGINE_H
@@ -7,6 +7,7 @@
 #include <regex>
 #include <algorithm>
 #include <cmath>
+#include <iterator>
 
 #define LOG_TAG "QuickJSTest"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -19,85 +20,77 @@ extern "C" {
     bool bytetransfer_get_info(size_t* size, size_t* capacity, const char* buffer_name = nullptr);
 }
 
-// Include real QuickJS headers
-extern "C" {
-#include "quickjs/quickjs.h"
-#include "quickjs/quickjs-libc.h"
-}
+#include "bytetransfer_js.h"
+#include "http_cache.h"
+#include "http_polyfill.h"
+#include "http_transport.h"
+#include "jni_env.h"
 
-// Global JavaVM reference for JNI calls from native threads
-JavaVM *g_jvm = nullptr;
+#include "quickjs_engine.h"
 
-// Global references for HTTP polyfills
+// Global reference to the bridge instance that services HTTP requests
 static jobject g_quickjsBridgeInstance = nullptr;
-static jmethodID g_handleHttpRequestMethod = nullptr;
 
 // Forward declarations
-static JSValue js_http_request(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv);
 void initializeHttpPolyfill(JNIEnv *env, jobject bridgeInstance);
-void addHttpPolyfills(JSContext *ctx);
 
-// Native HTTP request function (called from JavaScript)
-static JSValue js_http_request(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
-    if (argc < 1 || !g_quickjsBridgeInstance || !g_handleHttpRequestMethod) {
-        return JS_ThrowReferenceError(ctx, "HTTP service not available");
-    }
-    
-    // Get URL from first argument
-    const char *url = JS_ToCString(ctx, argv[0]);
-    if (!url) {
-        return JS_ThrowTypeError(ctx, "URL must be a string");
-    }
-    
-    // Get options from second argument (or empty object)
-    const char *options = "{}";
-    if (argc > 1) {
-        options = JS_ToCString(ctx, argv[1]);
-        if (!options) {
-            JS_FreeCString(ctx, url);
-            return JS_ThrowTypeError(ctx, "Options must be an object");
+/**
+ * Live transport: performs requests through HttpService via
+ * QuickJSBridge.handleHttpRequest. Works from any thread; native threads
+ * (engine workers, stale-while-revalidate refreshes) are attached on first use.
+ */
+class JniHttpTransport : public HttpTransport {
+public:
+    HttpResponse send(const HttpRequest &request, std::string *error) override {
+        JNIEnv *env = jniGetEnv();
+        if (!env) {
+            *error = "Failed to get JNI environment";
+            return HttpResponse::networkError(request.url, *error);
         }
+        return performJavaHttpRequest(env, request, error);
     }
     
-    // Get JNI environment
-    JNIEnv *env = nullptr;
-    
-    // This is a simplified approach - in production you'd want proper JVM attachment
-    if (!g_jvm || g_jvm->GetEnv((void**)&env, JNI_VERSION_1_6) != JNI_OK) {
-        JS_FreeCString(ctx, url);
-        if (argc > 1) JS_FreeCString(ctx, options);
-        return JS_ThrowInternalError(ctx, "Failed to get JNI environment");
-    }
+    const char *name() const override { return "jni"; }
     
-    // Call Java method
-    jstring jUrl = env->NewStringUTF(url);
-    jstring jOptions = env->NewStringUTF(options);
+private:
+    static HttpResponse performJavaHttpRequest(JNIEnv *env, const HttpRequest &request, std::string *error) {
+        if (!g_quickjsBridgeInstance || !g_jni.handleHttpRequest) {
+            *error = "HTTP service not available";
+            return HttpResponse::networkError(request.url, *error);
+        }
     
-    jstring jResult = (jstring)env->CallObjectMethod(g_quickjsBridgeInstance, 
-        g_handleHttpRequestMethod, jUrl, jOptions);
+        // The native cache already handled this request; HttpService must not cache it again
+        HttpRequest forwarded = request;
+        forwarded.cacheMode = "no-store";
     
-    env->DeleteLocalRef(jUrl);
-    env->DeleteLocalRef(jOptions);
+        jstring jUrl = env->NewStringUTF(request.url.c_str());
+        jstring jOptions = env->NewStringUTF(forwarded.toOptionsJson().c_str());
     
-    if (env->ExceptionCheck()) {
-        env->ExceptionClear();
-        JS_FreeCString(ctx, url);
-        if (argc > 1) JS_FreeCString(ctx, options);
-        return JS_ThrowInternalError(ctx, "HTTP request failed");
-    }
+        jstring jResult = (jstring)env->CallObjectMethod(g_quickjsBridgeInstance, 
+            g_jni.handleHttpRequest, jUrl, jOptions);
     
-    // Convert result back to JavaScript
-    const char *resultStr = env->GetStringUTFChars(jResult, nullptr);
-    JSValue result = JS_ParseJSON(ctx, resultStr, strlen(resultStr), "<http-response>");
+        env->DeleteLocalRef(jUrl);
+        env->DeleteLocalRef(jOptions);
     
-    env->ReleaseStringUTFChars(jResult, resultStr);
-    env->DeleteLocalRef(jResult);
+        if (env->ExceptionCheck() || !jResult) {
+            env->ExceptionClear();
+            *error = "HTTP request failed";
+            return HttpResponse::networkError(request.url, *error);
+        }
     
-    JS_FreeCString(ctx, url);
-    if (argc > 1) JS_FreeCString(ctx, options);
+        const char *resultStr = env->GetStringUTFChars(jResult, nullptr);
+        HttpResponse response;
+        bool parsed = HttpResponse::fromJson(resultStr, &response);
+        env->ReleaseStringUTFChars(jResult, resultStr);
+        env->DeleteLocalRef(jResult);
     
-    return result;
-}
+        if (!parsed) {
+            *error = "Malformed HTTP response";
+            return HttpResponse::networkError(request.url, *error);
+        }
+        return response;
+    }
+};
 
 // Initialize HTTP polyfill references
 void initializeHttpPolyfill(JNIEnv *env, jobject bridgeInstance) {
@@ -106,464 +99,31 @@ void initializeHttpPolyfill(JNIEnv *env, jobject bridgeInstance) {
     }
     g_quickjsBridgeInstance = env->NewGlobalRef(bridgeInstance);
     
-    jclass bridgeClass = env->GetObjectClass(bridgeInstance);
-    g_handleHttpRequestMethod = env->GetMethodID(bridgeClass, "handleHttpRequest", 
-        "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;");
-    
-    if (!g_handleHttpRequestMethod) {
-        LOGE("Failed to find handleHttpRequest method");
-    }
-}
-
-// Add HTTP polyfills to QuickJS context
-void addHttpPolyfills(JSContext *ctx) {
-    // Add native HTTP request function
-    JSValue global = JS_GetGlobalObject(ctx);
-    JS_SetPropertyStr(ctx, global, "_nativeHttpRequest", 
-        JS_NewCFunction(ctx, js_http_request, "_nativeHttpRequest", 2));
-    
-    // Add fetch polyfill
-    const char *fetchPolyfill = R"(
-(function() {
-    // Fetch API polyfill
-    globalThis.fetch = function(url, options) {
-        options = options || {};
-        
-        return new Promise(function(resolve, reject) {
-            try {
-                var requestOptions = {
-                    method: options.method || 'GET',
-                    headers: options.headers || {},
-                    body: options.body || null,
-                    timeout: options.timeout || 30000,
-                    redirect: options.redirect || 'follow',
-                    credentials: options.credentials || 'same-origin'
-                };
-                
-                var response = _nativeHttpRequest(url, JSON.stringify(requestOptions));
-                
-                if (response && response.status !== undefined) {
-                    // Create Response object
-                    var responseObj = {
-                        status: response.status,
-                        statusText: response.statusText,
-                        ok: response.ok,
-                        redirected: response.redirected,
-                        url: response.url,
-                        type: response.type,
-                        headers: new Map(Object.entries(response.headers || {})),
-                        
-                        text: function() {
-                            return Promise.resolve(response.body || '');
-                        },
-                        
-                        json: function() {
-                            return Promise.resolve(JSON.parse(response.body || '{}'));
-                        },
-                        
-                        blob: function() {
-                            return Promise.reject(new Error('Blob not supported'));
-                        },
-                        
-                        arrayBuffer: function() {
-                            return Promise.reject(new Error('ArrayBuffer not supported'));
-                        }
-                    };
-                    
-                    resolve(responseObj);
-                } else {
-                    reject(new Error('Network request failed'));
-                }
-            } catch (e) {
-                reject(e);
-            }
-        });
-    };
-    
-    // XMLHttpRequest polyfill
-    globalThis.XMLHttpRequest = function() {
-        this.readyState = 0;
-        this.status = 0;
-        this.statusText = '';
-        this.responseText = '';
-        this.responseXML = null;
-        this.onreadystatechange = null;
-        this._method = 'GET';
-        this._url = '';
-        this._headers = {};
-        this._body = null;
-        
-        this.open = function(method, url, async) {
-            this._method = method;
-            this._url = url;
-            this.readyState = 1;
-            if (this.onreadystatechange) this.onreadystatechange();
-        };
-        
-        this.setRequestHeader = function(header, value) {
-            this._headers[header] = value;
-        };
-        
-        this.send = function(body) {
-            var self = this;
-            this._body = body;
-            this.readyState = 2;
-            if (this.onreadystatechange) this.onreadystatechange();
-            
-            try {
-                var options = {
-                    method: this._method,
-                    headers: this._headers,
-                    body: this._body
-                };
-                
-                var response = _nativeHttpRequest(this._url, JSON.stringify(options));
-                
-                this.status = response.status || 0;
-                this.statusText = response.statusText || '';
-                this.responseText = response.body || '';
-                this.readyState = 4;
-                
-                if (this.onreadystatechange) this.onreadystatechange();
-            } catch (e) {
-                this.status = 0;
-                this.statusText = 'Error';
-                this.responseText = '';
-                this.readyState = 4;
-                if (this.onreadystatechange) this.onreadystatechange();
-            }
-        };
-        
-        this.abort = function() {
-            this.readyState = 0;
-        };
-        
-        this.getAllResponseHeaders = function() {
-            return '';
-        };
-        
-        this.getResponseHeader = function(header) {
-            return null;
-        };
-    };
-    
-    // Constants
-    globalThis.XMLHttpRequest.UNSENT = 0;
-    globalThis.XMLHttpRequest.OPENED = 1;
-    globalThis.XMLHttpRequest.HEADERS_RECEIVED = 2;
-    globalThis.XMLHttpRequest.LOADING = 3;
-    globalThis.XMLHttpRequest.DONE = 4;
-})();
-)";
-    
-    JSValue result = JS_Eval(ctx, fetchPolyfill, strlen(fetchPolyfill), "<fetch-polyfill>", JS_EVAL_TYPE_GLOBAL);
-    if (JS_IsException(result)) {
-        JSValue exception = JS_GetException(ctx);
-        const char *exceptionStr = JS_ToCString(ctx, exception);
-        LOGE("Failed to add HTTP polyfills: %s", exceptionStr ? exceptionStr : "Unknown error");
-        if (exceptionStr) JS_FreeCString(ctx, exceptionStr);
-        JS_FreeValue(ctx, exception);
-    }
-    JS_FreeValue(ctx, result);
-    JS_FreeValue(ctx, global);
-}
-
-// Real QuickJS Engine implementation
-class RealQuickJSEngine {
-public:
-    JSRuntime *runtime;  // Made public for memory stats access
-private:
-    JSContext *context;
-    bool initialized;
-    
-public:
-    RealQuickJSEngine() : runtime(nullptr), context(nullptr), initialized(false) {
+    if (!g_jni.handleHttpRequest) {
+        LOGE("handleHttpRequest was not resolved in JNI_OnLoad");
     }
     
-    bool initialize() {
-        LOGI("Initializing Real QuickJS Engine");
-
-        runtime = JS_NewRuntime();
-        if (!runtime) {
-            LOGE("Failed to create QuickJS runtime");
-            return false;
-        }
-
-        // Set memory limits for mobile environment
-        JS_SetMemoryLimit(runtime, 64 * 1024 * 1024); // 64MB limit
-        JS_SetGCThreshold(runtime, 1024 * 1024);       // 1MB GC threshold
-
-        context = JS_NewContext(runtime);
-        if (!context) {
-            LOGE("Failed to create QuickJS context");
-            JS_FreeRuntime(runtime);
-            runtime = nullptr;
-            return false;
-        }
-
-        // Add standard library
-        js_std_add_helpers(context, 0, nullptr);
-        
-        // Add HTTP polyfills (fetch and XMLHttpRequest)
-        addHttpPolyfills(context);
-
-        initialized = true;
-        LOGI("QuickJS Engine initialized successfully with memory management and HTTP polyfills");
-        return true;
+    // Keep a record/replay transport installed before the engine started
+    if (!HttpTransport::current()) {
+        HttpTransport::setCurrent(std::make_shared<JniHttpTransport>());
     }
-    
-    std::string executeScript(const std::string& script) {
-        if (!initialized || !context) {
-            return "Error: QuickJS not initialized";
-        }
-        
-        LOGI("Executing QuickJS script: %s", script.c_str());
-
-        // Evaluate the JavaScript code
-        JSValue result = JS_Eval(context, script.c_str(), script.length(),
-                "<input>", JS_EVAL_TYPE_GLOBAL);
-
-        if (JS_IsException(result)) {
-            // Handle JavaScript exceptions
-            JSValue exception = JS_GetException(context);
-            const char *exceptionStr = JS_ToCString(context, exception);
-            std::string error = "JavaScript Error: ";
-            if (exceptionStr) {
-                error += exceptionStr;
-                JS_FreeCString(context, exceptionStr);
-            } else {
-                error += "Unknown error";
-            }
-            JS_FreeValue(context, exception);
-            JS_FreeValue(context, result);
-            LOGE("JavaScript execution error: %s", error.c_str());
-            return error;
-        }
-
-        // Convert result to string
-        const char *resultStr = JS_ToCString(context, result);
-        std::string resultString;
-        if (resultStr) {
-            resultString = resultStr;
-            JS_FreeCString(context, resultStr);
-        } else {
-            resultString = "undefined";
-        }
-
-        JS_FreeValue(context, result);
-
-        LOGI("JavaScript result: %s", resultString.c_str());
+}
 
-        // Test byte transfer with result
-        std::string fullResult = "QuickJS Result: " + resultString;
-        if (bytetransfer_write_from_v8(reinterpret_cast<const uint8_t *>(fullResult.c_str()),
-                fullResult.length(), "quickjs_output")) {
-            LOGI("Successfully wrote %zu bytes to byte transfer system", fullResult.length());
-        } else {
-            LOGE("Failed to write to byte transfer system");
-        }
+static RealQuickJSEngine *g_quickjsEngine = nullptr;
 
-        return resultString;
-    }
-    
-    /**
-     * Compile JavaScript to bytecode for caching
-     */
-    std::vector<uint8_t> compileScript(const std::string& script) {
-        if (!initialized || !context) {
-            LOGE("QuickJS not initialized for compilation");
-            return {};
-        }
-        
-        LOGI("Compiling JavaScript to bytecode");
-        
-        // Try to compile the script as-is first, then try wrapping if it fails
-        std::string scriptToCompile = script;
-        LOGI("Attempting to compile script directly (length: %zu)", script.length());
-        
-        // Compile to bytecode
-        JSValue compiled = JS_Eval(context, scriptToCompile.c_str(), scriptToCompile.length(), 
-            "<compile>", JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
-        
-        if (JS_IsException(compiled)) {
-            // First attempt failed, try wrapping in function
-            JS_FreeValue(context, compiled);
-            LOGI("Direct compilation failed, trying with function wrapper");
-            
-            scriptToCompile = "(function() {\n" + script + "\n})";
-            compiled = JS_Eval(context, scriptToCompile.c_str(), scriptToCompile.length(), 
-                "<compile-wrapped>", JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
-            
-            if (JS_IsException(compiled)) {
-                JSValue exception = JS_GetException(context);
-                const char *exceptionStr = JS_ToCString(context, exception);
-                LOGE("Compilation error (both attempts): %s", exceptionStr ? exceptionStr : "Unknown error");
-                if (exceptionStr) JS_FreeCString(context, exceptionStr);
-                JS_FreeValue(context, exception);
-                JS_FreeValue(context, compiled);
-                return {};
-            } else {
-                LOGI("Compilation successful with function wrapper");
-            }
-        } else {
-            LOGI("Compilation successful without wrapper");
-        }
-        
-        size_t bytecode_size;
-        uint8_t* bytecode = JS_WriteObject(context, &bytecode_size, compiled, JS_WRITE_OBJ_BYTECODE);
-        JS_FreeValue(context, compiled);
-        
-        if (!bytecode) {
-            LOGE("Failed to compile JavaScript to bytecode");
-            return {};
-        }
-        
-        // Copy to vector
-        std::vector<uint8_t> result(bytecode, bytecode + bytecode_size);
-        js_free(context, bytecode);
-        
-        LOGI("Compiled JavaScript to %zu bytes of bytecode", result.size());
+// Run a script and mirror its result into the "quickjs_output" buffer
+static std::string executeScript(const std::string& script) {
+    std::string result;
+    if (!g_quickjsEngine->eval(script, &result)) {
         return result;
     }
-    
-    /**
-     * Execute bytecode directly
-     */
-    std::string executeBytecode(const std::vector<uint8_t>& bytecode) {
-        if (!initialized || !context) {
-            return "Error: QuickJS not initialized";
-        }
-        
-        if (bytecode.empty()) {
-            return "Error: Empty bytecode";
-        }
-        
-        LOGI("Executing QuickJS bytecode (%zu bytes)", bytecode.size());
-        
-        // Read bytecode object
-        JSValue obj = JS_ReadObject(context, bytecode.data(), bytecode.size(), JS_READ_OBJ_BYTECODE);
-        if (JS_IsException(obj)) {
-            JSValue exception = JS_GetException(context);
-            const char *exceptionStr = JS_ToCString(context, exception);
-            std::string error = "Bytecode Error: ";
-            if (exceptionStr) {
-                error += exceptionStr;
-                JS_FreeCString(context, exceptionStr);
-            } else {
-                error += "Failed to read bytecode";
-            }
-            JS_FreeValue(context, exception);
-            JS_FreeValue(context, obj);
-            LOGE("Bytecode execution error: %s", error.c_str());
-            return error;
-        }
-        
-        // Execute the bytecode (it's a function, so we need to call it)
-        JSValue func = JS_EvalFunction(context, obj);
-        if (JS_IsException(func)) {
-            JSValue exception = JS_GetException(context);
-            const char *exceptionStr = JS_ToCString(context, exception);
-            std::string error = "Bytecode Function Error: ";
-            if (exceptionStr) {
-                error += exceptionStr;
-                JS_FreeCString(context, exceptionStr);
-            } else {
-                error += "Failed to evaluate bytecode function";
-            }
-            JS_FreeValue(context, exception);
-            JS_FreeValue(context, func);
-            LOGE("Bytecode function evaluation error: %s", error.c_str());
-            return error;
-        }
-        
-        // Call the function to get the actual result
-        JSValue result = JS_Call(context, func, JS_UNDEFINED, 0, nullptr);
-        JS_FreeValue(context, func);
-        
-        if (JS_IsException(result)) {
-            JSValue exception = JS_GetException(context);
-            const char *exceptionStr = JS_ToCString(context, exception);
-            std::string error = "JavaScript Error: ";
-            if (exceptionStr) {
-                error += exceptionStr;
-                JS_FreeCString(context, exceptionStr);
-            } else {
-                error += "Unknown error";
-            }
-            JS_FreeValue(context, exception);
-            JS_FreeValue(context, result);
-            LOGE("JavaScript execution error: %s", error.c_str());
-            return error;
-        }
-        
-        // Convert result to string
-        const char *resultStr = JS_ToCString(context, result);
-        std::string resultString;
-        if (resultStr) {
-            resultString = resultStr;
-            JS_FreeCString(context, resultStr);
-        } else {
-            resultString = "undefined";
-        }
-        
-        JS_FreeValue(context, result);
-        LOGI("Bytecode execution completed successfully");
-        return resultString;
-    }
-    
-    bool resetContext() {
-        LOGI("Resetting QuickJS context");
-        
-        if (!runtime) {
-            LOGE("Cannot reset context: runtime not initialized");
-            return false;
-        }
-        
-        // Free the old context
-        if (context) {
-            JS_FreeContext(context);
-            context = nullptr;
-        }
-        
-        // Create a new context
-        context = JS_NewContext(runtime);
-        if (!context) {
-            LOGE("Failed to create new QuickJS context");
-            initialized = false;
-            return false;
-        }
-        
-        // Add standard library and HTTP polyfills to new context
-        js_std_add_helpers(context, 0, nullptr);
-        addHttpPolyfills(context);
-        
-        LOGI("QuickJS context reset successfully");
-        return true;
+    std::string fullResult = "QuickJS Result: " + result;
+    if (!bytetransfer_write_from_v8(reinterpret_cast<const uint8_t *>(fullResult.c_str()),
+            fullResult.length(), "quickjs_output")) {
+        LOGE("Failed to write to byte transfer system");
     }
-    
-    void cleanup() {
-        LOGI("Cleaning up Real QuickJS Engine");
-
-        if (context) {
-            JS_FreeContext(context);
-            context = nullptr;
-        }
-
-        if (runtime) {
-            JS_FreeRuntime(runtime);
-            runtime = nullptr;
-        }
-
-        initialized = false;
-        LOGI("QuickJS cleanup complete");
-    }
-    
-    bool isInitialized() const {
-        return initialized && runtime && context;
-    }
-};
-
-static RealQuickJSEngine *g_quickjsEngine = nullptr;
+    return result;
+}
 
 extern "C" {
 
@@ -572,13 +132,10 @@ JNIEXPORT jboolean JNICALL
 Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_initializeQuickJS(JNIEnv *env, jobject thiz) {
     LOGI("JNI: Initializing Real QuickJS Engine with HTTP polyfills");
     
-    // Store JavaVM reference for HTTP requests
-    if (!g_jvm) {
-        env->GetJavaVM(&g_jvm);
-    }
-    
     if (g_quickjsEngine == nullptr) {
         g_quickjsEngine = new RealQuickJSEngine();
+        // Zero-copy access to ByteTransfer buffers
+        g_quickjsEngine->setContextSetup(addByteTransferBinding);
     }
     
     // Initialize HTTP polyfill references
@@ -595,7 +152,7 @@ Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_executeScript(JN
     }
     
     const char* scriptStr = env->GetStringUTFChars(script, nullptr);
-    std::string result = g_quickjsEngine->executeScript(std::string(scriptStr));
+    std::string result = executeScript(std::string(scriptStr));
     env->ReleaseStringUTFChars(script, scriptStr);
     
     return env->NewStringUTF(result.c_str());
@@ -613,12 +170,15 @@ LOGI("JNI: Cleaning up Real QuickJS Engine") ;
     }
 }
 
-// Check if QuickJS is initialized
-JNIEXPORT jboolean JNICALL
-Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_isInitialized(JNIEnv *env, jobject thiz) {
+// Check if QuickJS is initialized (@CriticalNative: no JNIEnv on API 26+)
+static jboolean JNICALL criticalIsInitialized() {
     return (g_quickjsEngine != nullptr && g_quickjsEngine->isInitialized()) ? JNI_TRUE : JNI_FALSE;
 }
 
+static jboolean JNICALL isInitialized(JNIEnv *, jclass) {
+    return criticalIsInitialized();
+}
+
 // Test byte transfer integration with QuickJS
 JNIEXPORT jboolean JNICALL
 Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeTestByteTransfer(JNIEnv *env, jobject thiz, jbyteArray data, jstring bufferName) {
@@ -691,25 +251,25 @@ std::string results = "Real QuickJS Comprehensive Tests:\n";
     bool allPassed = true;
     
     // Test 1: Arrow function
-    std::string arrowTest = g_quickjsEngine->executeScript("const sum = (a, b) => a + b; sum(15, 27)");
+    std::string arrowTest = executeScript("const sum = (a, b) => a + b; sum(15, 27)");
     bool arrowPassed = arrowTest == "42";
     results += "1. Arrow Functions: " + std::string(arrowPassed ? "PASS" : "FAIL") + " (got: " + arrowTest + ")\n";
     allPassed &= arrowPassed;
     
     // Test 2: Destructuring
-    std::string destructTest = g_quickjsEngine->executeScript("const [a, b] = [10, 20]; a + b");
+    std::string destructTest = executeScript("const [a, b] = [10, 20]; a + b");
     bool destructPassed = destructTest == "30";
     results += "2. Destructuring: " + std::string(destructPassed ? "PASS" : "FAIL") + " (got: " + destructTest + ")\n";
     allPassed &= destructPassed;
     
     // Test 3: Template literals
-    std::string templateTest = g_quickjsEngine->executeScript("const name = 'QuickJS'; `Hello ${name}!`");
+    std::string templateTest = executeScript("const name = 'QuickJS'; `Hello ${name}!`");
     bool templatePassed = templateTest == "Hello QuickJS!";
     results += "3. Template Literals: " + std::string(templatePassed ? "PASS" : "FAIL") + " (got: " + templateTest + ")\n";
     allPassed &= templatePassed;
 
 // Test 4: Math operations
-std::string mathTest = g_quickjsEngine->executeScript("Math.sqrt(16) + Math.pow(2, 3)");
+std::string mathTest = executeScript("Math.sqrt(16) + Math.pow(2, 3)");
 bool mathPassed = mathTest == "12";
 results += "4. Math Operations: " +
 std::string(mathPassed
@@ -718,7 +278,7 @@ allPassed &=
 mathPassed;
 
 // Test 5: Array methods
-std::string arrayTest = g_quickjsEngine->executeScript("[1, 2, 3, 4].filter(x => x % 2 === 0).length");
+std::string arrayTest = executeScript("[1, 2, 3, 4].filter(x => x % 2 === 0).length");
 bool arrayPassed = arrayTest == "2";
 results += "5. Array Methods: " +
 std::string(arrayPassed
@@ -760,7 +320,7 @@ Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeGetMemoryS
     
     // Get memory statistics from QuickJS runtime
     JSMemoryUsage usage;
-    JS_ComputeMemoryUsage(g_quickjsEngine->runtime, &usage);
+    JS_ComputeMemoryUsage(g_quickjsEngine->runtime(), &usage);
     
     std::string stats = "QuickJS Memory Statistics:\n";
     stats += "Malloc size: " + std::to_string(usage.malloc_size) + " bytes\n";
@@ -783,6 +343,128 @@ Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeGetMemoryS
     return env->NewStringUTF(stats.c_str());
 }
 
+// Enable or disable the interpreter profiler
+JNIEXPORT void JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeSetProfiling(JNIEnv *env, jobject thiz, jboolean enabled) {
+    if (g_quickjsEngine == nullptr || !g_quickjsEngine->isInitialized()) {
+        LOGE("QuickJS not initialized for profiling");
+        return;
+    }
+    g_quickjsEngine->setProfiling(enabled == JNI_TRUE);
+}
+
+// Get the profile report (functions by self time, then opcodes)
+JNIEXPORT jstring JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeGetProfile(JNIEnv *env, jobject thiz) {
+    if (g_quickjsEngine == nullptr || !g_quickjsEngine->isInitialized()) {
+        return env->NewStringUTF("QuickJS not initialized");
+    }
+    return env->NewStringUTF(g_quickjsEngine->profileSnapshot().c_str());
+}
+
+// Get the profile as folded stacks
+JNIEXPORT jstring JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeGetProfileFoldedStacks(JNIEnv *env, jobject thiz) {
+    if (g_quickjsEngine == nullptr || !g_quickjsEngine->isInitialized()) {
+        return env->NewStringUTF("");
+    }
+    return env->NewStringUTF(g_quickjsEngine->profileFoldedStacks().c_str());
+}
+
+// Clear the profile
+JNIEXPORT void JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeResetProfile(JNIEnv *env, jobject thiz) {
+    if (g_quickjsEngine != nullptr) {
+        g_quickjsEngine->resetProfile();
+    }
+}
+
+// Configure the native HTTP cache shared by all runtimes
+JNIEXPORT void JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeConfigureHttpCache(JNIEnv *env, jobject thiz, jstring directory, jlong memoryBudgetBytes, jlong diskBudgetBytes) {
+    std::string dir;
+    if (directory) {
+        const char *dirStr = env->GetStringUTFChars(directory, nullptr);
+        dir = dirStr;
+        env->ReleaseStringUTFChars(directory, dirStr);
+    }
+    HttpCache::instance().configure(dir, (size_t)memoryBudgetBytes, (size_t)diskBudgetBytes);
+}
+
+// Get native HTTP cache statistics
+JNIEXPORT jstring JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeGetHttpCacheStats(JNIEnv *env, jobject thiz) {
+    HttpCache::Stats s = HttpCache::instance().stats();
+    
+    std::string stats = "Native HTTP Cache Statistics:\n";
+    stats += "Hits: " + std::to_string(s.hits) + "\n";
+    stats += "Misses: " + std::to_string(s.misses) + "\n";
+    stats += "Revalidated (304): " + std::to_string(s.revalidations) + "\n";
+    stats += "Stale served: " + std::to_string(s.staleServed) + "\n";
+    stats += "Stored: " + std::to_string(s.stores) + "\n";
+    stats += "Memory: " + std::to_string(s.memoryEntries) + " entries (" + std::to_string(s.memoryBytes) + " bytes)\n";
+    stats += "Disk: " + std::to_string(s.diskEntries) + " entries (" + std::to_string(s.diskBytes) + " bytes)";
+    
+    std::shared_ptr<HttpTransport> transport = HttpTransport::current();
+    stats += "\nTransport: ";
+    stats += transport ? transport->name() : "none";
+    
+    return env->NewStringUTF(stats.c_str());
+}
+
+// Clear the native HTTP cache (memory and disk)
+JNIEXPORT void JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeClearHttpCache(JNIEnv *env, jobject thiz) {
+    HttpCache::instance().clear();
+}
+
+// Select the transport behind fetch(): "live", "record" (live + capture to path)
+// or "replay" (serve captures from path with a network profile)
+JNIEXPORT jboolean JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeSetHttpTransport(JNIEnv *env, jobject thiz, jstring mode, jstring path, jstring profile) {
+    auto toStdString = [env](jstring s) {
+        std::string out;
+        if (s) {
+            const char *chars = env->GetStringUTFChars(s, nullptr);
+            out = chars;
+            env->ReleaseStringUTFChars(s, chars);
+        }
+        return out;
+    };
+    std::string modeStr = toStdString(mode);
+    std::string pathStr = toStdString(path);
+    std::string profileStr = toStdString(profile);
+    
+    std::shared_ptr<HttpTransport> live = std::make_shared<JniHttpTransport>();
+    if (modeStr == "live") {
+        HttpTransport::setCurrent(live);
+        return JNI_TRUE;
+    }
+    if (modeStr == "record") {
+        auto recorder = std::make_shared<RecordingTransport>(live, pathStr);
+        if (!recorder->isOpen()) {
+            return JNI_FALSE;
+        }
+        HttpTransport::setCurrent(recorder);
+        return JNI_TRUE;
+    }
+    if (modeStr == "replay") {
+        NetworkProfile networkProfile;
+        if (!NetworkProfile::parse(profileStr.empty() ? "none" : profileStr, &networkProfile)) {
+            LOGE("Unknown network profile: %s", profileStr.c_str());
+            return JNI_FALSE;
+        }
+        auto replay = std::make_shared<ReplayTransport>(networkProfile);
+        if (replay->load(pathStr) < 0) {
+            return JNI_FALSE;
+        }
+        HttpTransport::setCurrent(replay);
+        return JNI_TRUE;
+    }
+    LOGE("Unknown HTTP transport mode: %s", modeStr.c_str());
+    return JNI_FALSE;
+}
+
 // HTTP request JNI function
 JNIEXPORT jstring JNICALL
 Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeHttpRequest(JNIEnv *env, jobject thiz, jstring url, jstring options) {
@@ -794,7 +476,7 @@ Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_nativeHttpReques
 // Reset context JNI function
 JNIEXPORT jboolean JNICALL
 Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_resetContext(JNIEnv *env, jobject thiz) {
-    return g_quickjsEngine ? g_quickjsEngine->resetContext() : false;
+    return g_quickjsEngine && g_quickjsEngine->reset() ? JNI_TRUE : JNI_FALSE;
 }
 
 // Compile JavaScript to bytecode JNI function
@@ -811,11 +493,13 @@ Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_compileScript(JN
         return nullptr;
     }
     
-    std::vector<uint8_t> bytecode = g_quickjsEngine->compileScript(std::string(scriptStr));
+    std::vector<uint8_t> bytecode;
+    std::string error;
+    bool compiled = g_quickjsEngine->compile(std::string(scriptStr), &bytecode, &error);
     env->ReleaseStringUTFChars(script, scriptStr);
     
-    if (bytecode.empty()) {
-        LOGE("Failed to compile script to bytecode");
+    if (!compiled) {
+        LOGE("Failed to compile script to bytecode: %s", error.c_str());
         return nullptr;
     }
     
@@ -855,20 +539,44 @@ Java_com_visgupta_example_v8integrationandroidapp_QuickJSBridge_executeBytecode(
         return env->NewStringUTF("Error: Failed to get bytecode data");
     }
     
-    // Convert to vector
-    std::vector<uint8_t> bytecodeVector(
-        reinterpret_cast<uint8_t*>(bytecodeData),
-        reinterpret_cast<uint8_t*>(bytecodeData) + bytecodeLength
-    );
-    
-    // Release the array elements
+    // Execute straight from the array elements, then release them
+    std::string result;
+    g_quickjsEngine->loadBytecode(reinterpret_cast<const uint8_t*>(bytecodeData), (size_t)bytecodeLength, &result);
     env->ReleaseByteArrayElements(bytecode, bytecodeData, JNI_ABORT);
     
-    // Execute bytecode
-    std::string result = g_quickjsEngine->executeBytecode(bytecodeVector);
-    
     LOGI("Bytecode execution completed, result length: %zu", result.length());
     return env->NewStringUTF(result.c_str());
 }
 
-}
\ No newline at end of file
+}
+
+bool registerQuickJSBridgeNatives(JNIEnv *env) {
+    static const JNINativeMethod kMethods[] = {
+    JNI_NATIVE(QuickJSBridge, initializeQuickJS, "()Z"),
+    JNI_NATIVE(QuickJSBridge, executeScript, "(Ljava/lang/String;)Ljava/lang/String;"),
+    JNI_NATIVE(QuickJSBridge, cleanupQuickJS, "()V"),
+    JNI_NATIVE(QuickJSBridge, nativeTestByteTransfer, "([BLjava/lang/String;)Z"),
+    JNI_NATIVE(QuickJSBridge, nativeReadBytesFromTransfer, "(IILjava/lang/String;)[B"),
+    JNI_NATIVE(QuickJSBridge, nativeRunQuickJSTests, "()Ljava/lang/String;"),
+    JNI_NATIVE(QuickJSBridge, nativeGetMemoryStats, "()Ljava/lang/String;"),
+    JNI_NATIVE(QuickJSBridge, nativeSetProfiling, "(Z)V"),
+    JNI_NATIVE(QuickJSBridge, nativeGetProfile, "()Ljava/lang/String;"),
+    JNI_NATIVE(QuickJSBridge, nativeGetProfileFoldedStacks, "()Ljava/lang/String;"),
+    JNI_NATIVE(QuickJSBridge, nativeResetProfile, "()V"),
+    JNI_NATIVE(QuickJSBridge, nativeConfigureHttpCache, "(Ljava/lang/String;JJ)V"),
+    JNI_NATIVE(QuickJSBridge, nativeGetHttpCacheStats, "()Ljava/lang/String;"),
+    JNI_NATIVE(QuickJSBridge, nativeClearHttpCache, "()V"),
+    JNI_NATIVE(QuickJSBridge, nativeSetHttpTransport, "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)Z"),
+    JNI_NATIVE(QuickJSBridge, nativeHttpRequest, "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
+    JNI_NATIVE(QuickJSBridge, resetContext, "()Z"),
+    JNI_NATIVE(QuickJSBridge, compileScript, "(Ljava/lang/String;)[B"),
+    JNI_NATIVE(QuickJSBridge, executeBytecode, "([B)Ljava/lang/String;"),
+    };
+    const char *className = "com/visgupta/example/v8integrationandroidapp/QuickJSBridge";
+    JNINativeMethod isInitializedMethod = {
+        "isInitialized", "()Z",
+        jniCriticalNativesSupported() ? reinterpret_cast<void *>(criticalIsInitialized)
+                                      : reinterpret_cast<void *>(isInitialized)};
+    return jniRegisterNatives(env, className, kMethods, std::size(kMethods)) &&
+           jniRegisterNatives(env, className, &isInitializedMethod, 1);
+}
@@ -0,0 +1,199 @@
+#include "ring_buffer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+std::unique_ptr<ByteRing> ByteRing::create(size_t capacity, Mode mode) {
+    size_t rounded = 4096;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    // Frames are read in place, so the ring itself is cache-line aligned and
+    // starts zeroed (a zero header word means "not committed")
+    void* data = nullptr;
+    if (posix_memalign(&data, kCacheLine, rounded) != 0) {
+        return nullptr;
+    }
+    memset(data, 0, rounded);
+    return std::unique_ptr<ByteRing>(new ByteRing(static_cast<uint8_t*>(data), rounded, mode));
+}
+
+ByteRing::ByteRing(uint8_t* data, size_t capacity, Mode mode)
+    : data_(data), capacity_(capacity), mask_(capacity - 1), mode_(mode) {
+}
+
+ByteRing::~ByteRing() {
+    free(data_);
+}
+
+size_t ByteRing::usedBytes() const {
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    return (size_t)(head - tail);
+}
+
+size_t ByteRing::spaceNeeded(uint64_t pos, const size_t* frames, size_t count) const {
+    uint64_t end = pos;
+    for (size_t i = 0; i < count; i++) {
+        size_t contiguous = capacity_ - (end & mask_);
+        if (frames[i] > contiguous) {
+            end += contiguous;
+        }
+        end += frames[i];
+    }
+    return (size_t)(end - pos);
+}
+
+uint8_t* ByteRing::placeFrame(uint64_t* pos, uint32_t length, uint32_t tag, uint32_t** word) {
+    size_t frame = frameSize(length);
+    size_t offset = *pos & mask_;
+    size_t contiguous = capacity_ - offset;
+    if (frame > contiguous) {
+        uint32_t* pad = reinterpret_cast<uint32_t*>(data_ + offset);
+        __atomic_store_n(pad, kPadBit | kReadyBit | (uint32_t)contiguous, __ATOMIC_RELEASE);
+        *pos += contiguous;
+        offset = 0;
+    }
+    uint8_t* header = data_ + offset;
+    *word = reinterpret_cast<uint32_t*>(header);
+    *reinterpret_cast<uint32_t*>(header + 4) = tag;
+    if (mode_ == Mode::SingleProducer) {
+        // Visibility comes from the head store in commit()
+        **word = kReadyBit | length;
+    }
+    *pos += frame;
+    return header + kFrameHeader;
+}
+
+ByteRing::Reservation ByteRing::reserve(uint32_t length, uint32_t tag) {
+    Reservation reservation;
+    if (length > maxMessageSize()) {
+        return reservation;
+    }
+    size_t frame = frameSize(length);
+    uint64_t pos;
+
+    if (mode_ == Mode::SingleProducer) {
+        pos = reserveHead_;
+        size_t need = spaceNeeded(pos, &frame, 1);
+        if (pos + need - cachedTail_ > capacity_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (pos + need - cachedTail_ > capacity_) {
+                return reservation;
+            }
+        }
+        reserveHead_ = pos + need;
+    } else {
+        pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            size_t need = spaceNeeded(pos, &frame, 1);
+            uint64_t tail = tail_.load(std::memory_order_acquire);
+            if (pos + need - tail > capacity_) {
+                return reservation;
+            }
+            if (head_.compare_exchange_weak(pos, pos + need, std::memory_order_acq_rel,
+                                            std::memory_order_relaxed)) {
+                break;
+            }
+        }
+    }
+
+    reservation.data = placeFrame(&pos, length, tag, &reservation.word);
+    reservation.length = length;
+    reservation.end = pos;
+    return reservation;
+}
+
+void ByteRing::commit(const Reservation& reservation) {
+    if (mode_ == Mode::SingleProducer) {
+        // Publishes this and every earlier reservation
+        head_.store(reservation.end, std::memory_order_release);
+    } else {
+        __atomic_store_n(reservation.word, kReadyBit | reservation.length, __ATOMIC_RELEASE);
+    }
+}
+
+bool ByteRing::tryWrite(const void* data, uint32_t length, uint32_t tag) {
+    Reservation reservation = reserve(length, tag);
+    if (!reservation) {
+        return false;
+    }
+    memcpy(reservation.data, data, length);
+    commit(reservation);
+    return true;
+}
+
+bool ByteRing::tryWriteBatch(const ByteRingMessage* messages, size_t count) {
+    return tryWriteBatch(messages, count, [messages](size_t i, uint8_t* payload) {
+        memcpy(payload, messages[i].data, messages[i].length);
+    });
+}
+
+bool ByteRing::claimBatch(const ByteRingMessage* messages, size_t count, uint64_t* start) {
+    size_t stackFrames[64];
+    std::unique_ptr<size_t[]> heapFrames;
+    size_t* frames = stackFrames;
+    if (count > 64) {
+        heapFrames.reset(new size_t[count]);
+        frames = heapFrames.get();
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (messages[i].length > maxMessageSize()) {
+            return false;
+        }
+        frames[i] = frameSize(messages[i].length);
+    }
+
+    uint64_t pos;
+    if (mode_ == Mode::SingleProducer) {
+        pos = reserveHead_;
+        size_t need = spaceNeeded(pos, frames, count);
+        if (pos + need - cachedTail_ > capacity_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (pos + need - cachedTail_ > capacity_) {
+                return false;
+            }
+        }
+        reserveHead_ = pos + need;
+    } else {
+        pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            size_t need = spaceNeeded(pos, frames, count);
+            uint64_t tail = tail_.load(std::memory_order_acquire);
+            if (pos + need - tail > capacity_) {
+                return false;
+            }
+            if (head_.compare_exchange_weak(pos, pos + need, std::memory_order_acq_rel,
+                                            std::memory_order_relaxed)) {
+                break;
+            }
+        }
+    }
+    *start = pos;
+    return true;
+}
+
+void ByteRing::releaseConsumed(uint64_t from, uint64_t to) {
+    if (mode_ == Mode::MultiProducer) {
+        // Frame boundaries move between laps; clear everything so a producer
+        // that has claimed but not yet committed a frame reads as not ready
+        size_t offset = from & mask_;
+        size_t length = (size_t)(to - from);
+        size_t first = length < capacity_ - offset ? length : capacity_ - offset;
+        memset(data_ + offset, 0, first);
+        if (length > first) {
+            memset(data_, 0, length - first);
+        }
+    }
+    tail_.store(to, std::memory_order_release);
+}
+
+void ByteRing::reset() {
+    memset(data_, 0, capacity_);
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    reserveHead_ = 0;
+    cachedTail_ = 0;
+    cachedHead_ = 0;
+}
@@ -0,0 +1,188 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// One message for ByteRing::tryWriteBatch
+struct ByteRingMessage {
+    const void* data;
+    uint32_t length;
+    uint32_t tag;
+};
+
+/**
+ * Lock-free ring of variable-length framed messages.
+ *
+ * Positions are free-running 64-bit byte counters; head is owned by the
+ * producer side, tail by the single consumer, each on its own cache line.
+ * Every message is an 8-byte frame header {word, tag} followed by the
+ * payload, padded to 8 bytes. A frame that would straddle the end of the
+ * ring is preceded by a pad frame so payloads are always contiguous and
+ * can be handed out as plain pointers.
+ *
+ * SingleProducer: reserve() only advances a producer-private cursor; the
+ *   shared head is published by commit() with one release store,
+ *   so a batch of reservations becomes visible at once.
+ * MultiProducer: producers claim space with a CAS on head and commit each
+ *   frame by setting the ready bit in its header. The consumer stops at the
+ *   first uncommitted frame and zeroes what it consumed, so stale bytes are
+ *   never mistaken for a header on the next lap.
+ *
+ * Consumers release space once per consume() call, not per message.
+ */
+class ByteRing {
+public:
+    enum class Mode { SingleProducer, MultiProducer };
+
+    static constexpr size_t kCacheLine = 64;
+    static constexpr size_t kFrameHeader = 8;
+
+    struct Reservation {
+        uint8_t* data = nullptr;
+        uint32_t length = 0;
+        uint64_t end = 0;       // ring position just past this frame
+        uint32_t* word = nullptr;
+
+        explicit operator bool() const { return data != nullptr; }
+    };
+
+    // Capacity is rounded up to a power of two (at least 4 KiB)
+    static std::unique_ptr<ByteRing> create(size_t capacity, Mode mode);
+    ~ByteRing();
+
+    ByteRing(const ByteRing&) = delete;
+    ByteRing& operator=(const ByteRing&) = delete;
+
+    Mode mode() const { return mode_; }
+    size_t capacity() const { return capacity_; }
+    // Largest payload that is guaranteed to fit once the ring drains
+    size_t maxMessageSize() const { return capacity_ / 2 - kFrameHeader; }
+    // Bytes between tail and head, including frame headers and padding
+    size_t usedBytes() const;
+
+    // ---- Producer side ----
+
+    // Copy one message in and commit it. Returns false if the ring is full.
+    bool tryWrite(const void* data, uint32_t length, uint32_t tag = 0);
+
+    // Write all messages or none. SingleProducer publishes once for the
+    // whole batch; MultiProducer claims the space with a single CAS.
+    bool tryWriteBatch(const ByteRingMessage* messages, size_t count);
+
+    // Same, but fill(size_t i, uint8_t* payload) writes message i's length
+    // bytes straight into its frame; the data pointers are not read. For
+    // sources that cannot hand out a pointer, such as Java arrays.
+    template <typename F>
+    bool tryWriteBatch(const ByteRingMessage* messages, size_t count, F&& fill);
+
+    // Reserve a frame to fill in place; empty Reservation if full.
+    Reservation reserve(uint32_t length, uint32_t tag = 0);
+
+    // Make a reservation visible to the consumer. In SingleProducer mode
+    // this also publishes every earlier reservation (batched commit).
+    void commit(const Reservation& reservation);
+
+    // ---- Consumer side (one thread at a time) ----
+
+    // Call fn(const uint8_t* data, uint32_t length, uint32_t tag) for up to
+    // maxMessages committed messages, then release their space in one step.
+    // data is only valid during the callback. Returns the number consumed.
+    template <typename F>
+    size_t consume(F&& fn, size_t maxMessages = SIZE_MAX);
+
+    // Discard all contents. Only safe while no producer or consumer is active.
+    void reset();
+
+private:
+    static constexpr uint32_t kReadyBit = 1u << 30;
+    static constexpr uint32_t kPadBit = 1u << 31;
+    static constexpr uint32_t kLengthMask = kReadyBit - 1;
+
+    ByteRing(uint8_t* data, size_t capacity, Mode mode);
+
+    static size_t frameSize(uint32_t length) { return (kFrameHeader + length + 7) & ~(size_t)7; }
+
+    // Bytes needed at pos for frames of the given sizes, including wrap padding
+    size_t spaceNeeded(uint64_t pos, const size_t* frames, size_t count) const;
+    // Write pad frames and headers starting at pos; returns first payload
+    uint8_t* placeFrame(uint64_t* pos, uint32_t length, uint32_t tag, uint32_t** word);
+    // Claim space for a whole batch; *start is its first position
+    bool claimBatch(const ByteRingMessage* messages, size_t count, uint64_t* start);
+    void releaseConsumed(uint64_t from, uint64_t to);
+
+    uint8_t* const data_;
+    const size_t capacity_;
+    const size_t mask_;
+    const Mode mode_;
+
+    // Producer line: shared head plus the producer-private reservation
+    // cursor and cached tail (SingleProducer only)
+    alignas(kCacheLine) std::atomic<uint64_t> head_{0};
+    uint64_t reserveHead_ = 0;
+    uint64_t cachedTail_ = 0;
+
+    // Consumer line
+    alignas(kCacheLine) std::atomic<uint64_t> tail_{0};
+    uint64_t cachedHead_ = 0;
+};
+
+template <typename F>
+bool ByteRing::tryWriteBatch(const ByteRingMessage* messages, size_t count, F&& fill) {
+    if (count == 0) {
+        return true;
+    }
+    uint64_t pos;
+    if (!claimBatch(messages, count, &pos)) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        uint32_t* word;
+        uint8_t* payload = placeFrame(&pos, messages[i].length, messages[i].tag, &word);
+        fill(i, payload);
+        if (mode_ == Mode::MultiProducer) {
+            __atomic_store_n(word, kReadyBit | messages[i].length, __ATOMIC_RELEASE);
+        }
+    }
+    if (mode_ == Mode::SingleProducer) {
+        head_.store(pos, std::memory_order_release);
+    }
+    return true;
+}
+
+template <typename F>
+size_t ByteRing::consume(F&& fn, size_t maxMessages) {
+    uint64_t start = tail_.load(std::memory_order_relaxed);
+    uint64_t pos = start;
+    size_t consumed = 0;
+    while (consumed < maxMessages) {
+        if (pos == cachedHead_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (pos == cachedHead_) {
+                break;
+            }
+        }
+        uint8_t* frame = data_ + (pos & mask_);
+        uint32_t word = __atomic_load_n(reinterpret_cast<uint32_t*>(frame), __ATOMIC_ACQUIRE);
+        if (!(word & kReadyBit)) {
+            break;  // MultiProducer frame claimed but not committed yet
+        }
+        if (word & kPadBit) {
+            pos += word & kLengthMask;
+            continue;
+        }
+        uint32_t length = word & kLengthMask;
+        uint32_t tag = *reinterpret_cast<uint32_t*>(frame + 4);
+        fn(static_cast<const uint8_t*>(frame + kFrameHeader), length, tag);
+        pos += frameSize(length);
+        consumed++;
+    }
+    if (pos != start) {
+        releaseConsumed(start, pos);
+    }
+    return consumed;
+}
+
+#endif // RING_BUFFER_H
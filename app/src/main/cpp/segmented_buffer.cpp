@@ -0,0 +1,273 @@
+#include "segmented_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "buffer_pool.h"
+
+SegmentedBuffer::SegmentedBuffer(size_t segmentSize, size_t maxBytes)
+    : segmentSize_(BufferPool::blockSize(std::max<size_t>(segmentSize, 1))), maxBytes_(maxBytes) {
+}
+
+SegmentedBuffer::~SegmentedBuffer() {
+    for (const Segment& segment : segments_) {
+        releaseSegment(segment);
+    }
+}
+
+void SegmentedBuffer::releaseSegment(const Segment& segment) {
+    BufferPool::instance().release(segment.data, segment.capacity);
+}
+
+size_t SegmentedBuffer::readableLocked() const {
+    return (size_t)(written_ - consumed_);
+}
+
+size_t SegmentedBuffer::readable() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return readableLocked();
+}
+
+size_t SegmentedBuffer::allocated() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t total = 0;
+    for (const Segment& segment : segments_) {
+        total += segment.capacity;
+    }
+    return total;
+}
+
+uint64_t SegmentedBuffer::writePosition() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return written_;
+}
+
+uint64_t SegmentedBuffer::readPosition() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return consumed_;
+}
+
+// Ensure length bytes of tail space, allocating every missing segment
+// before touching the list so a failed allocation leaves it unchanged
+bool SegmentedBuffer::appendSegmentsLocked(size_t length) {
+    if (maxBytes_ != 0 && (length > maxBytes_ || readableLocked() > maxBytes_ - length)) {
+        return false;
+    }
+    size_t space = segments_.empty() ? 0 : segments_.back().capacity - segments_.back().end;
+    if (space >= length) {
+        return true;
+    }
+    size_t missing = length - space;
+    size_t next = segments_.empty() ? segmentSize_
+                                    : std::max(segmentSize_, std::min(segments_.back().capacity * 2, kMaxSegmentSize));
+    std::vector<Segment> added;
+    for (size_t total = 0; total < missing; total += next) {
+        if (!added.empty()) {
+            next = std::max(segmentSize_, std::min(next * 2, kMaxSegmentSize));
+        }
+        uint8_t* block = BufferPool::instance().acquire(next, false);
+        if (!block) {
+            for (const Segment& segment : added) {
+                releaseSegment(segment);
+            }
+            return false;
+        }
+        added.push_back(Segment{block, next, 0, 0});
+    }
+    segments_.insert(segments_.end(), added.begin(), added.end());
+    return true;
+}
+
+bool SegmentedBuffer::reserve(size_t length) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return appendSegmentsLocked(length);
+}
+
+bool SegmentedBuffer::write(const void* data, size_t length) {
+    struct iovec iov = {const_cast<void*>(data), length};
+    return writev(&iov, 1);
+}
+
+bool SegmentedBuffer::writev(const struct iovec* iov, int count) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += iov[i].iov_len;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!appendSegmentsLocked(total)) {
+        return false;
+    }
+    size_t index = writeSegmentLocked();
+    for (int i = 0; i < count; i++) {
+        const uint8_t* src = static_cast<const uint8_t*>(iov[i].iov_base);
+        size_t remaining = iov[i].iov_len;
+        while (remaining > 0) {
+            Segment& segment = segments_[index];
+            size_t chunk = std::min(remaining, segment.capacity - segment.end);
+            memcpy(segment.data + segment.end, src, chunk);
+            segment.end += chunk;
+            src += chunk;
+            remaining -= chunk;
+            if (segment.end == segment.capacity) {
+                index++;
+            }
+        }
+    }
+    written_ += total;
+    return true;
+}
+
+// Every segment before the write segment is full; reserve() may have
+// appended empty ones after it
+size_t SegmentedBuffer::writeSegmentLocked() const {
+    size_t index = 0;
+    while (index < segments_.size() && segments_[index].end == segments_[index].capacity) {
+        index++;
+    }
+    return index;
+}
+
+uint8_t* SegmentedBuffer::writableSpan(size_t* length) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t index = writeSegmentLocked();
+    if (index == segments_.size()) {
+        if (!appendSegmentsLocked(1)) {
+            *length = 0;
+            return nullptr;
+        }
+        index = segments_.size() - 1;
+    }
+    Segment& segment = segments_[index];
+    *length = segment.capacity - segment.end;
+    return segment.data + segment.end;
+}
+
+bool SegmentedBuffer::commit(size_t length) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t index = writeSegmentLocked();
+    if (index == segments_.size()) {
+        return length == 0;
+    }
+    Segment& segment = segments_[index];
+    if (length > segment.capacity - segment.end) {
+        return false;
+    }
+    segment.end += length;
+    written_ += length;
+    return true;
+}
+
+int SegmentedBuffer::peek(struct iovec* iov, int max) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int count = 0;
+    for (const Segment& segment : segments_) {
+        if (count == max) {
+            break;
+        }
+        if (segment.end > segment.begin) {
+            iov[count].iov_base = segment.data + segment.begin;
+            iov[count].iov_len = segment.end - segment.begin;
+            count++;
+        }
+    }
+    return count;
+}
+
+bool SegmentedBuffer::copyOut(void* dest, size_t length, size_t offset) const {
+    uint8_t* out = static_cast<uint8_t*>(dest);
+    return visit(offset, length, [&out](const uint8_t* data, size_t chunk) {
+        memcpy(out, data, chunk);
+        out += chunk;
+    });
+}
+
+size_t SegmentedBuffer::readv(const struct iovec* iov, int count) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += iov[i].iov_len;
+    }
+    total = std::min(total, readable());
+    size_t copied = 0;
+    for (int i = 0; i < count && copied < total; i++) {
+        size_t chunk = std::min(iov[i].iov_len, total - copied);
+        copyOut(iov[i].iov_base, chunk, copied);
+        copied += chunk;
+    }
+    consume(copied);
+    return copied;
+}
+
+bool SegmentedBuffer::consume(size_t length) {
+    std::vector<Segment> released;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (length > readableLocked()) {
+            return false;
+        }
+        consumed_ += length;
+        while (!segments_.empty()) {
+            Segment& front = segments_.front();
+            size_t chunk = std::min(length, front.end - front.begin);
+            front.begin += chunk;
+            length -= chunk;
+            // The write segment stays until it is full: a producer may hold a
+            // span into it
+            if (front.begin != front.capacity) {
+                break;
+            }
+            released.push_back(front);
+            segments_.pop_front();
+        }
+    }
+    for (const Segment& segment : released) {
+        releaseSegment(segment);
+    }
+    return true;
+}
+
+const uint8_t* SegmentedBuffer::linearize(size_t* length) {
+    std::vector<Segment> released;
+    const uint8_t* result = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        *length = readableLocked();
+        if (*length == 0) {
+            return nullptr;
+        }
+        const Segment& front = segments_.front();
+        if (front.end - front.begin == *length) {
+            return front.data + front.begin;
+        }
+        size_t capacity = BufferPool::blockSize(*length);
+        uint8_t* block = BufferPool::instance().acquire(capacity, false);
+        if (!block) {
+            *length = 0;
+            return nullptr;
+        }
+        size_t offset = 0;
+        for (const Segment& segment : segments_) {
+            memcpy(block + offset, segment.data + segment.begin, segment.end - segment.begin);
+            offset += segment.end - segment.begin;
+            released.push_back(segment);
+        }
+        segments_.clear();
+        segments_.push_back(Segment{block, capacity, 0, offset});
+        result = block;
+    }
+    for (const Segment& segment : released) {
+        releaseSegment(segment);
+    }
+    return result;
+}
+
+void SegmentedBuffer::clear() {
+    std::deque<Segment> released;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        written_ = consumed_ = 0;
+        released.swap(segments_);
+    }
+    for (const Segment& segment : released) {
+        releaseSegment(segment);
+    }
+}
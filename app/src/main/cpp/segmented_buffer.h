@@ -0,0 +1,137 @@
+#ifndef SEGMENTED_BUFFER_H
+#define SEGMENTED_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <sys/uio.h>
+
+/**
+ * Byte stream stored as a chain of BufferPool segments.
+ *
+ * Writes append to the tail segment and add pooled segments as needed, so
+ * a producer that cannot predict its output size (JS results, HTTP bodies)
+ * never reallocates or copies what it already wrote. Consumed segments go
+ * back to the pool. Readers see the data either as a gather list
+ * (peek/visit), by copying out (copyOut/readv), or as one contiguous block
+ * after linearize().
+ *
+ * One producer and one consumer may run concurrently; segment bookkeeping
+ * is guarded by a mutex, and pointers handed to the consumer stay valid
+ * until it consumes past them or the buffer is cleared.
+ */
+class SegmentedBuffer {
+public:
+    static constexpr size_t kDefaultSegmentSize = 64 * 1024;
+    // Segments double up to this size, so long streams use few blocks and
+    // the large ones get transparent huge pages from the pool
+    static constexpr size_t kMaxSegmentSize = 2 * 1024 * 1024;
+
+    // segmentSize (rounded up to a BufferPool size class) is the first
+    // segment's size. maxBytes bounds the unconsumed bytes (0 = unlimited);
+    // writes past it fail whole.
+    explicit SegmentedBuffer(size_t segmentSize = kDefaultSegmentSize, size_t maxBytes = 0);
+    ~SegmentedBuffer();
+
+    SegmentedBuffer(const SegmentedBuffer&) = delete;
+    SegmentedBuffer& operator=(const SegmentedBuffer&) = delete;
+
+    size_t segmentSize() const { return segmentSize_; }
+    size_t maxBytes() const { return maxBytes_; }
+
+    // Bytes written and not yet consumed
+    size_t readable() const;
+    // Bytes held in segments, consumed or not
+    size_t allocated() const;
+    // Total bytes ever written / consumed (stream positions)
+    uint64_t writePosition() const;
+    uint64_t readPosition() const;
+
+    // ---- Producer side ----
+
+    // Append length bytes; all or nothing
+    bool write(const void* data, size_t length);
+    bool writev(const struct iovec* iov, int count);
+
+    // Make sure the next length bytes can be written without allocating,
+    // so writableSpan()/commit() cannot fail part way through
+    bool reserve(size_t length);
+    // Free space at the tail (appending a segment if the tail is full).
+    // Fill some of it, then commit() the byte count.
+    uint8_t* writableSpan(size_t* length);
+    bool commit(size_t length);
+
+    // ---- Consumer side ----
+
+    // Gather list of up to max readable chunks starting at the read position
+    int peek(struct iovec* iov, int max) const;
+
+    // Call fn(const uint8_t* data, size_t length) for each chunk of
+    // [offset, offset + length) relative to the read position
+    template <typename F>
+    bool visit(size_t offset, size_t length, F&& fn) const;
+
+    // Copy without consuming; offset is relative to the read position
+    bool copyOut(void* dest, size_t length, size_t offset = 0) const;
+    // Copy into the iovecs and consume what was copied; returns the byte count
+    size_t readv(const struct iovec* iov, int count);
+    bool consume(size_t length);
+
+    // Readable bytes as one contiguous block, merging segments if needed.
+    // Valid until the next consume() or clear(); nullptr when empty. Must
+    // not run while the producer holds a writableSpan().
+    const uint8_t* linearize(size_t* length);
+
+    // Drop all data, rewind the positions to 0 and return the segments to
+    // the pool. Same restriction
+    // as linearize().
+    void clear();
+
+private:
+    struct Segment {
+        uint8_t* data;
+        size_t capacity;
+        size_t begin;   // first unconsumed byte
+        size_t end;     // one past the last written byte
+    };
+
+    size_t readableLocked() const;
+    size_t writeSegmentLocked() const;
+    bool appendSegmentsLocked(size_t length);
+    void releaseSegment(const Segment& segment);
+
+    const size_t segmentSize_;
+    const size_t maxBytes_;
+
+    mutable std::mutex mutex_;
+    std::deque<Segment> segments_;
+    uint64_t written_ = 0;
+    uint64_t consumed_ = 0;
+};
+
+template <typename F>
+bool SegmentedBuffer::visit(size_t offset, size_t length, F&& fn) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (offset > readableLocked() || length > readableLocked() - offset) {
+        return false;
+    }
+    for (const Segment& segment : segments_) {
+        if (length == 0) {
+            break;
+        }
+        size_t available = segment.end - segment.begin;
+        if (offset >= available) {
+            offset -= available;
+            continue;
+        }
+        size_t chunk = available - offset < length ? available - offset : length;
+        fn(static_cast<const uint8_t*>(segment.data + segment.begin + offset), chunk);
+        length -= chunk;
+        offset = 0;
+    }
+    return true;
+}
+
+#endif // SEGMENTED_BUFFER_H
@@ -0,0 +1,191 @@
+#include "shared_memory.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#include <linux/ashmem.h>
+#include <sys/ioctl.h>
+#define LOG_TAG "SharedMemory"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#define LOGE(...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#endif
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+
+namespace {
+
+size_t pageAlign(size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) & ~(page - 1);
+}
+
+// Called through syscall() so it works with Bionic before API 30 and with
+// glibc older than 2.27, neither of which has the memfd_create() wrapper
+int createMemfd(const char* name, size_t size) {
+#ifdef __NR_memfd_create
+    int fd = (int)syscall(__NR_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        LOGE("ftruncate(%zu) on memfd failed: %s", size, strerror(errno));
+        close(fd);
+        return -1;
+    }
+#ifdef F_ADD_SEALS
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+#endif
+    return fd;
+#else
+    (void)name;
+    (void)size;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+#ifdef __ANDROID__
+int createAshmem(const char* name, size_t size) {
+    int fd = open("/dev/ashmem", O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    char region[ASHMEM_NAME_LEN];
+    snprintf(region, sizeof(region), "%s", name);
+    if (ioctl(fd, ASHMEM_SET_NAME, region) < 0 || ioctl(fd, ASHMEM_SET_SIZE, size) < 0) {
+        LOGE("ashmem setup for '%s' failed: %s", name, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+#endif
+
+// Size of the object behind fd: ashmem reports it through an ioctl, memfd
+// (and any regular file) through fstat
+size_t regionSize(int fd) {
+#ifdef __ANDROID__
+    int ashmemSize = ioctl(fd, ASHMEM_GET_SIZE, nullptr);
+    if (ashmemSize > 0) {
+        return (size_t)ashmemSize;
+    }
+#endif
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        return 0;
+    }
+    return (size_t)st.st_size;
+}
+
+} // namespace
+
+std::unique_ptr<SharedMemory> SharedMemory::create(const char* name, size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+    size = pageAlign(size);
+    int fd = createMemfd(name, size);
+#ifdef __ANDROID__
+    if (fd < 0 && errno == ENOSYS) {
+        fd = createAshmem(name, size);
+    }
+#endif
+    if (fd < 0) {
+        LOGE("Cannot create shared memory '%s' (%zu bytes): %s", name, size, strerror(errno));
+        return nullptr;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        LOGE("mmap of shared memory '%s' failed: %s", name, strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    return std::unique_ptr<SharedMemory>(new SharedMemory(fd, static_cast<uint8_t*>(data), size));
+}
+
+std::unique_ptr<SharedMemory> SharedMemory::map(int fd) {
+    int own = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (own < 0) {
+        LOGE("Cannot duplicate shared memory fd %d: %s", fd, strerror(errno));
+        return nullptr;
+    }
+    size_t size = regionSize(own);
+    if (size == 0) {
+        LOGE("Shared memory fd %d has no size", fd);
+        close(own);
+        return nullptr;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, own, 0);
+    if (data == MAP_FAILED) {
+        LOGE("mmap of shared memory fd %d failed: %s", fd, strerror(errno));
+        close(own);
+        return nullptr;
+    }
+    return std::unique_ptr<SharedMemory>(new SharedMemory(own, static_cast<uint8_t*>(data), size));
+}
+
+SharedMemory::~SharedMemory() {
+    munmap(data_, size_);
+    close(fd_);
+}
+
+int SharedMemory::duplicateFd() const {
+    return fcntl(fd_, F_DUPFD_CLOEXEC, 0);
+}
+
+std::unique_ptr<SharedMemory> SharedMemory::openFile(const char* path, size_t size) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOGE("Cannot open '%s': %s", path, strerror(errno));
+        return nullptr;
+    }
+    // One writer per file: a second mapping would race the cursors
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        LOGE("'%s' is already open: %s", path, strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    size_t existing = regionSize(fd);
+    size_t mapped = pageAlign(existing > size ? existing : size);
+    if (mapped > existing && ftruncate(fd, (off_t)mapped) != 0) {
+        LOGE("Cannot grow '%s' to %zu bytes: %s", path, mapped, strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    void* data = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        LOGE("mmap of '%s' failed: %s", path, strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    return std::unique_ptr<SharedMemory>(new SharedMemory(fd, static_cast<uint8_t*>(data), mapped));
+}
+
+bool SharedMemory::sync(size_t offset, size_t length) const {
+    if (offset >= size_ || length == 0) {
+        return true;
+    }
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset & ~(page - 1);
+    size_t end = offset + length < size_ ? offset + length : size_;
+    if (msync(data_ + start, end - start, MS_SYNC) != 0) {
+        LOGE("msync of %zu bytes failed: %s", end - start, strerror(errno));
+        return false;
+    }
+    return true;
+}
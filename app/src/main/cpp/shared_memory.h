@@ -0,0 +1,57 @@
+#ifndef SHARED_MEMORY_H
+#define SHARED_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Anonymous shared memory that can be passed to another process as a file
+ * descriptor (Binder ParcelFileDescriptor on Android, SCM_RIGHTS on Linux).
+ *
+ * Backed by memfd_create where the kernel has it (Linux 3.17+, every
+ * Android 8+ device) and by /dev/ashmem on older Android kernels. memfd
+ * regions are sealed against resizing so an importer can trust the size
+ * it maps.
+ *
+ * openFile() maps a regular file the same way, for buffers that persist
+ * across process restarts.
+ */
+class SharedMemory {
+public:
+    // New zero-filled region of at least size bytes (rounded up to pages)
+    static std::unique_ptr<SharedMemory> create(const char* name, size_t size);
+
+    // Map a region exported by another process. fd is duplicated, so the
+    // caller keeps ownership of the descriptor it passed in.
+    static std::unique_ptr<SharedMemory> map(int fd);
+
+    // Map the file at path, creating it or growing it (zero-filled) to at
+    // least size bytes. Fails if another descriptor holds the file locked.
+    static std::unique_ptr<SharedMemory> openFile(const char* path, size_t size);
+
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    int fd() const { return fd_; }
+
+    // New descriptor for handing to another process; the caller owns it
+    int duplicateFd() const;
+
+    // Write dirty pages of [offset, offset + length) back to the file and
+    // wait for them (msync MS_SYNC); a no-op for anonymous memory
+    bool sync(size_t offset, size_t length) const;
+
+private:
+    SharedMemory(int fd, uint8_t* data, size_t size) : fd_(fd), data_(data), size_(size) {}
+
+    const int fd_;
+    uint8_t* const data_;
+    const size_t size_;
+};
+
+#endif // SHARED_MEMORY_H
@@ -0,0 +1,225 @@
+#include "v8_engine.h"
+
+#include <cstring>
+#include <mutex>
+
+#include <android/log.h>
+
+#include "libplatform/libplatform.h"
+
+#define LOG_TAG "V8Test"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+// V8 allows one platform per process and never shuts down here
+void initializePlatformOnce() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        static std::unique_ptr<v8::Platform> platform = v8::platform::NewDefaultPlatform();
+        v8::V8::InitializePlatform(platform.get());
+        v8::V8::Initialize();
+    });
+}
+
+// Serialized compile() output: [u32 source length][source][code cache]
+constexpr size_t kSourceLengthSize = sizeof(uint32_t);
+
+} // namespace
+
+bool V8Engine::initialize() {
+    LOGI("Initializing V8 Engine %s", v8::V8::GetVersion());
+    cleanup();
+    initializePlatformOnce();
+
+    allocator_.reset(v8::ArrayBuffer::Allocator::NewDefaultAllocator());
+    v8::Isolate::CreateParams params;
+    params.array_buffer_allocator = allocator_.get();
+    // Same budget as the QuickJS runtime
+    params.constraints.ConfigureDefaultsFromHeapSize(0, 64 * 1024 * 1024);
+    isolate_ = v8::Isolate::New(params);
+    if (!isolate_) {
+        LOGE("Failed to create V8 isolate");
+        return false;
+    }
+    return reset();
+}
+
+void V8Engine::cleanup() {
+    context_.Reset();
+    if (isolate_) {
+        isolate_->Dispose();
+        isolate_ = nullptr;
+    }
+    allocator_.reset();
+}
+
+bool V8Engine::reset() {
+    if (!isolate_) {
+        return false;
+    }
+    v8::Isolate::Scope isolateScope(isolate_);
+    v8::HandleScope handleScope(isolate_);
+    v8::Local<v8::Context> context = v8::Context::New(isolate_);
+    if (context.IsEmpty()) {
+        LOGE("Failed to create V8 context");
+        return false;
+    }
+    context_.Reset(isolate_, context);
+    return true;
+}
+
+bool V8Engine::toResult(v8::Local<v8::Value> value, std::string* result) {
+    v8::String::Utf8Value utf8(isolate_, value);
+    *result = *utf8 ? std::string(*utf8, utf8.length()) : "undefined";
+    return true;
+}
+
+bool V8Engine::exceptionResult(const v8::TryCatch& tryCatch, std::string* result) {
+    v8::String::Utf8Value message(isolate_, tryCatch.Exception());
+    *result = "JavaScript Error: ";
+    *result += *message ? *message : "Unknown error";
+    LOGE("JavaScript execution error: %s", result->c_str());
+    return false;
+}
+
+bool V8Engine::run(const std::string& source, const uint8_t* cache, size_t cacheLength, std::string* result) {
+    if (!isInitialized()) {
+        *result = "Error: V8 not initialized";
+        return false;
+    }
+    v8::Isolate::Scope isolateScope(isolate_);
+    v8::HandleScope handleScope(isolate_);
+    v8::Local<v8::Context> context = context_.Get(isolate_);
+    v8::Context::Scope contextScope(context);
+    v8::TryCatch tryCatch(isolate_);
+
+    v8::Local<v8::String> code;
+    if (!v8::String::NewFromUtf8(isolate_, source.data(), v8::NewStringType::kNormal, (int)source.size())
+             .ToLocal(&code)) {
+        *result = "Error: script too large";
+        return false;
+    }
+    // The Source owns the CachedData; BufferNotOwned leaves our bytes alone
+    v8::ScriptCompiler::Source scriptSource(
+        code, cache ? new v8::ScriptCompiler::CachedData(cache, (int)cacheLength) : nullptr);
+    v8::Local<v8::Script> script;
+    v8::Local<v8::Value> value;
+    if (!v8::ScriptCompiler::Compile(context, &scriptSource,
+                                     cache ? v8::ScriptCompiler::kConsumeCodeCache
+                                           : v8::ScriptCompiler::kNoCompileOptions)
+             .ToLocal(&script) ||
+        !script->Run(context).ToLocal(&value)) {
+        return exceptionResult(tryCatch, result);
+    }
+    if (cache && scriptSource.GetCachedData()->rejected) {
+        LOGI("V8 rejected the code cache; the script was compiled from source");
+    }
+    return toResult(value, result);
+}
+
+bool V8Engine::doEval(const std::string& source, std::string* result) {
+    return run(source, nullptr, 0, result);
+}
+
+bool V8Engine::doCompile(const std::string& source, std::vector<uint8_t>* bytecode, std::string* error) {
+    if (!isInitialized()) {
+        *error = "V8 not initialized for compilation";
+        return false;
+    }
+    v8::Isolate::Scope isolateScope(isolate_);
+    v8::HandleScope handleScope(isolate_);
+    v8::Local<v8::Context> context = context_.Get(isolate_);
+    v8::Context::Scope contextScope(context);
+    v8::TryCatch tryCatch(isolate_);
+
+    v8::Local<v8::String> code;
+    if (!v8::String::NewFromUtf8(isolate_, source.data(), v8::NewStringType::kNormal, (int)source.size())
+             .ToLocal(&code)) {
+        *error = "Script too large";
+        return false;
+    }
+    v8::ScriptCompiler::Source scriptSource(code);
+    v8::Local<v8::UnboundScript> unbound;
+    if (!v8::ScriptCompiler::CompileUnboundScript(isolate_, &scriptSource, v8::ScriptCompiler::kEagerCompile)
+             .ToLocal(&unbound)) {
+        exceptionResult(tryCatch, error);
+        return false;
+    }
+    std::unique_ptr<v8::ScriptCompiler::CachedData> cache(v8::ScriptCompiler::CreateCodeCache(unbound));
+    if (!cache) {
+        *error = "V8 did not produce a code cache";
+        return false;
+    }
+
+    uint32_t sourceLength = (uint32_t)source.size();
+    bytecode->resize(kSourceLengthSize + source.size() + (size_t)cache->length);
+    memcpy(bytecode->data(), &sourceLength, kSourceLengthSize);
+    memcpy(bytecode->data() + kSourceLengthSize, source.data(), source.size());
+    memcpy(bytecode->data() + kSourceLengthSize + source.size(), cache->data, (size_t)cache->length);
+    return true;
+}
+
+bool V8Engine::doLoadBytecode(const uint8_t* data, size_t length, std::string* result) {
+    uint32_t sourceLength = 0;
+    if (length < kSourceLengthSize) {
+        *result = "Bytecode Error: truncated";
+        return false;
+    }
+    memcpy(&sourceLength, data, kSourceLengthSize);
+    if (sourceLength > length - kSourceLengthSize) {
+        *result = "Bytecode Error: truncated";
+        return false;
+    }
+    std::string source(reinterpret_cast<const char*>(data) + kSourceLengthSize, sourceLength);
+    const uint8_t* cache = data + kSourceLengthSize + sourceLength;
+    size_t cacheLength = length - kSourceLengthSize - sourceLength;
+    return run(source, cacheLength ? cache : nullptr, cacheLength, result);
+}
+
+bool V8Engine::doCall(const std::string& function, const std::vector<std::string>& jsonArgs, std::string* result) {
+    if (!isInitialized()) {
+        *result = "Error: V8 not initialized";
+        return false;
+    }
+    v8::Isolate::Scope isolateScope(isolate_);
+    v8::HandleScope handleScope(isolate_);
+    v8::Local<v8::Context> context = context_.Get(isolate_);
+    v8::Context::Scope contextScope(context);
+    v8::TryCatch tryCatch(isolate_);
+
+    v8::Local<v8::String> key;
+    v8::Local<v8::Value> target;
+    if (!v8::String::NewFromUtf8(isolate_, function.c_str()).ToLocal(&key) ||
+        !context->Global()->Get(context, key).ToLocal(&target) || !target->IsFunction()) {
+        *result = "Error: " + function + " is not a function";
+        return false;
+    }
+
+    std::vector<v8::Local<v8::Value>> args;
+    args.reserve(jsonArgs.size());
+    for (const std::string& json : jsonArgs) {
+        v8::Local<v8::String> text;
+        v8::Local<v8::Value> arg;
+        if (!v8::String::NewFromUtf8(isolate_, json.data(), v8::NewStringType::kNormal, (int)json.size())
+                 .ToLocal(&text) ||
+            !v8::JSON::Parse(context, text).ToLocal(&arg)) {
+            return exceptionResult(tryCatch, result);
+        }
+        args.push_back(arg);
+    }
+    v8::Local<v8::Value> value;
+    if (!target.As<v8::Function>()
+             ->Call(context, v8::Undefined(isolate_), (int)args.size(), args.data())
+             .ToLocal(&value)) {
+        return exceptionResult(tryCatch, result);
+    }
+    return toResult(value, result);
+}
+
+size_t V8Engine::heapBytes() const {
+    v8::HeapStatistics heap;
+    isolate_->GetHeapStatistics(&heap);
+    return heap.used_heap_size();
+}
@@ -0,0 +1,46 @@
+#ifndef V8_ENGINE_H
+#define V8_ENGINE_H
+
+#include <memory>
+
+#include "js_engine.h"
+#include "v8.h"
+
+/**
+ * V8 backend, built only when libv8_monolith.a is present for the ABI
+ * (HAVE_V8). One isolate with one context. "Bytecode" is the script source
+ * followed by V8's code cache for it, since V8 cannot run a cache alone.
+ */
+class V8Engine : public JsEngine {
+public:
+    V8Engine() = default;
+    ~V8Engine() override { cleanup(); }
+    V8Engine(const V8Engine&) = delete;
+    V8Engine& operator=(const V8Engine&) = delete;
+
+    const char* name() const override { return "v8"; }
+    bool initialize() override;
+    bool isInitialized() const override { return isolate_ != nullptr && !context_.IsEmpty(); }
+    void cleanup() override;
+    bool reset() override;
+
+protected:
+    bool doEval(const std::string& source, std::string* result) override;
+    bool doCompile(const std::string& source, std::vector<uint8_t>* bytecode, std::string* error) override;
+    bool doLoadBytecode(const uint8_t* data, size_t length, std::string* result) override;
+    bool doCall(const std::string& function, const std::vector<std::string>& jsonArgs,
+                std::string* result) override;
+    size_t heapBytes() const override;
+
+private:
+    // Compile and run source, consuming cache if given
+    bool run(const std::string& source, const uint8_t* cache, size_t cacheLength, std::string* result);
+    bool toResult(v8::Local<v8::Value> value, std::string* result);
+    bool exceptionResult(const v8::TryCatch& tryCatch, std::string* result);
+
+    std::unique_ptr<v8::ArrayBuffer::Allocator> allocator_;
+    v8::Isolate* isolate_ = nullptr;
+    v8::Global<v8::Context> context_;
+};
+
+#endif // V8_ENGINE_H
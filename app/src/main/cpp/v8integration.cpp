@@ -1,11 +1,14 @@
 #include <jni.h>
+#include <cstring>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <vector>
 #include <android/log.h>
 
-// V8 includes (commented out until we have the actual V8 libraries)
-// #include "v8.h"
-// #include "libplatform/libplatform.h"
+#include "engine_benchmark.h"
+#include "js_engine.h"
+#include "jni_env.h"
 
 #define LOG_TAG "V8Test"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -18,48 +21,8 @@ extern "C" {
     bool bytetransfer_get_info(size_t* size, size_t* capacity, const char* buffer_name = nullptr);
 }
 
-// Mock V8 functionality for initial testing
-class MockV8Engine {
-private:
-    bool initialized;
-    
-public:
-    MockV8Engine() : initialized(false) {}
-    
-    bool initialize() {
-        LOGI("Initializing Mock V8 Engine");
-        initialized = true;
-        return true;
-    }
-    
-    std::string executeScript(const std::string& script) {
-        if (!initialized) {
-            return "Error: V8 not initialized";
-        }
-        
-        LOGI("Executing script: %s", script.c_str());
-        
-        // Mock execution with byte transfer
-        std::string result = "V8 Result: " + script;
-        
-        // Test byte transfer - write result to byte transfer system
-        if (bytetransfer_write_from_v8(reinterpret_cast<const uint8_t*>(result.c_str()), 
-                                      result.length(), "v8_output")) {
-            LOGI("Successfully wrote %zu bytes to byte transfer system", result.length());
-        } else {
-            LOGE("Failed to write to byte transfer system");
-        }
-        
-        return result;
-    }
-    
-    void cleanup() {
-        LOGI("Cleaning up Mock V8 Engine");
-        initialized = false;
-    }
-};
-
-static MockV8Engine* g_v8Engine = nullptr;
+// V8 when the library was built against it, otherwise the echoing mock
+static std::unique_ptr<JsEngine> g_v8Engine;
 
 extern "C" {
 
@@ -69,7 +32,8 @@ Java_com_visgupta_example_v8integrationandroidapp_V8Bridge_initializeV8(JNIEnv *
     LOGI("JNI: Initializing V8 Engine");
     
     if (g_v8Engine == nullptr) {
-        g_v8Engine = new MockV8Engine();
+        g_v8Engine = createJsEngine("v8");
+        LOGI("Using %s engine", jsEngineHasV8() ? "real V8" : "mock V8");
     }
     
     return g_v8Engine->initialize() ? JNI_TRUE : JNI_FALSE;
@@ -83,9 +47,15 @@ Java_com_visgupta_example_v8integrationandroidapp_V8Bridge_executeScript(JNIEnv
     }
     
     const char* scriptStr = env->GetStringUTFChars(script, nullptr);
-    std::string result = g_v8Engine->executeScript(std::string(scriptStr));
+    std::string result;
+    bool ok = g_v8Engine->eval(std::string(scriptStr), &result);
     env->ReleaseStringUTFChars(script, scriptStr);
     
+    // Mirror the result into the "v8_output" buffer
+    if (ok && !bytetransfer_write_from_v8(reinterpret_cast<const uint8_t*>(result.c_str()),
+                                          result.length(), "v8_output")) {
+        LOGE("Failed to write to byte transfer system");
+    }
     return env->NewStringUTF(result.c_str());
 }
 
@@ -96,9 +66,44 @@ Java_com_visgupta_example_v8integrationandroidapp_V8Bridge_cleanupV8(JNIEnv *env
     
     if (g_v8Engine != nullptr) {
         g_v8Engine->cleanup();
-        delete g_v8Engine;
-        g_v8Engine = nullptr;
+        g_v8Engine.reset();
+    }
+}
+
+// Call counts, timings and heap size of the V8 Bridge engine
+JNIEXPORT jstring JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_V8Bridge_nativeGetEngineStats(JNIEnv *env, jobject thiz) {
+    if (g_v8Engine == nullptr) {
+        return env->NewStringUTF("V8 not initialized");
     }
+    return env->NewStringUTF(g_v8Engine->stats().format(g_v8Engine->name()).c_str());
+}
+
+// Engine names accepted by nativeRunEngineBenchmark, comma separated
+JNIEXPORT jstring JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_V8Bridge_nativeListEngines(JNIEnv *env, jobject thiz) {
+    std::string names;
+    for (const std::string& name : availableJsEngines()) {
+        names += (names.empty() ? "" : ",") + name;
+    }
+    return env->NewStringUTF(names.c_str());
+}
+
+// Run the shared workloads on a fresh instance of the named engine
+JNIEXPORT jstring JNICALL
+Java_com_visgupta_example_v8integrationandroidapp_V8Bridge_nativeRunEngineBenchmark(JNIEnv *env, jobject thiz, jstring engineName, jint iterations) {
+    const char* nameStr = env->GetStringUTFChars(engineName, nullptr);
+    std::string name(nameStr);
+    env->ReleaseStringUTFChars(engineName, nameStr);
+    
+    std::unique_ptr<JsEngine> engine = createJsEngine(name);
+    if (!engine || !engine->initialize()) {
+        return env->NewStringUTF(("Error: engine '" + name + "' is not available").c_str());
+    }
+    std::string report = formatEngineBenchmark(name, runEngineBenchmark(*engine, iterations));
+    engine->cleanup();
+    LOGI("Engine benchmark (%s): %s", name.c_str(), report.substr(report.rfind('\n') + 1).c_str());
+    return env->NewStringUTF(report.c_str());
 }
 
 // Test function for basic data exchange
@@ -352,4 +357,25 @@ Java_com_visgupta_example_v8integrationandroidapp_V8Bridge_nativeRunV8ByteTransf
     return env->NewStringUTF(results.c_str());
 }
 
-}
\ No newline at end of file
+}
+
+bool registerV8BridgeNatives(JNIEnv *env) {
+    static const JNINativeMethod kMethods[] = {
+    JNI_NATIVE(V8Bridge, initializeV8, "()Z"),
+    JNI_NATIVE(V8Bridge, executeScript, "(Ljava/lang/String;)Ljava/lang/String;"),
+    JNI_NATIVE(V8Bridge, cleanupV8, "()V"),
+    JNI_NATIVE(V8Bridge, nativeGetEngineStats, "()Ljava/lang/String;"),
+    JNI_NATIVE(V8Bridge, nativeListEngines, "()Ljava/lang/String;"),
+    JNI_NATIVE(V8Bridge, nativeRunEngineBenchmark, "(Ljava/lang/String;I)Ljava/lang/String;"),
+    JNI_NATIVE(V8Bridge, testDataExchange, "(Ljava/lang/String;IZ)Ljava/lang/String;"),
+    JNI_NATIVE(V8Bridge, nativeTestByteTransfer, "([BLjava/lang/String;)Z"),
+    JNI_NATIVE(V8Bridge, nativeReadBytesFromTransfer, "(IILjava/lang/String;)[B"),
+    JNI_NATIVE(V8Bridge, nativeGetByteTransferInfo, "(Ljava/lang/String;)Ljava/lang/String;"),
+    JNI_NATIVE(V8Bridge, nativeTransferBytesToBuffer, "([BLjava/lang/String;)Z"),
+    JNI_NATIVE(V8Bridge, nativeReadBytesFromBuffer, "(IILjava/lang/String;)[B"),
+    JNI_NATIVE(V8Bridge, nativeGetBufferInfoFromV8, "(Ljava/lang/String;)Ljava/lang/String;"),
+    JNI_NATIVE(V8Bridge, nativeRunV8ByteTransferTests, "()Ljava/lang/String;"),
+    };
+    return jniRegisterNatives(env, "com/visgupta/example/v8integrationandroidapp/V8Bridge", kMethods,
+                              std::size(kMethods));
+}
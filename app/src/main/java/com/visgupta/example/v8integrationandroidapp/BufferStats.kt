@@ -0,0 +1,70 @@
+package com.visgupta.example.v8integrationandroidapp
+
+/**
+ * Snapshot of one buffer's native counters, parsed from the export line
+ * "in=.. out=.. w=.. r=.. cs=.. of=.. uf=.. hw=.. wl=p50,p90,p99,max rl=... name=<name>".
+ * Latencies are in nanoseconds and only cover the sampled operations.
+ */
+data class BufferStats(
+    val name: String,
+    val bytesIn: Long,
+    val bytesOut: Long,
+    val writes: Long,
+    val reads: Long,
+    val bytesConsumed: Long,
+    val overflows: Long,
+    val underflows: Long,
+    val highWater: Long,
+    val writeLatencyNanos: LatencyPercentiles,
+    val readLatencyNanos: LatencyPercentiles
+) {
+    data class LatencyPercentiles(val p50: Long, val p90: Long, val p99: Long, val max: Long) {
+        companion object {
+            val EMPTY = LatencyPercentiles(0, 0, 0, 0)
+
+            fun parse(value: String): LatencyPercentiles? {
+                val parts = value.split(',').map { it.toLongOrNull() ?: return null }
+                return if (parts.size == 4) LatencyPercentiles(parts[0], parts[1], parts[2], parts[3]) else null
+            }
+        }
+    }
+
+    val unreadBytes: Long
+        get() = bytesIn - bytesConsumed
+
+    override fun toString(): String {
+        return "BufferStats(name='$name', in=$bytesIn, out=$bytesOut, writes=$writes, reads=$reads, " +
+            "overflows=$overflows, underflows=$underflows, highWater=$highWater, " +
+            "writeP99=${writeLatencyNanos.p99}ns, readP99=${readLatencyNanos.p99}ns)"
+    }
+
+    companion object {
+        /**
+         * Parse one export line; null if it is malformed. The shared buffer
+         * has an empty name.
+         */
+        fun parse(line: String): BufferStats? {
+            val nameStart = line.indexOf("name=")
+            if (nameStart < 0) {
+                return null
+            }
+            val fields = line.substring(0, nameStart).trim().split(' ')
+                .filter { it.isNotEmpty() }
+                .associate { it.substringBefore('=') to it.substringAfter('=') }
+            fun count(key: String): Long? = fields[key]?.toLongOrNull()
+            return BufferStats(
+                name = line.substring(nameStart + "name=".length),
+                bytesIn = count("in") ?: return null,
+                bytesOut = count("out") ?: return null,
+                writes = count("w") ?: return null,
+                reads = count("r") ?: return null,
+                bytesConsumed = count("cs") ?: return null,
+                overflows = count("of") ?: return null,
+                underflows = count("uf") ?: return null,
+                highWater = count("hw") ?: return null,
+                writeLatencyNanos = fields["wl"]?.let { LatencyPercentiles.parse(it) } ?: return null,
+                readLatencyNanos = fields["rl"]?.let { LatencyPercentiles.parse(it) } ?: return null
+            )
+        }
+    }
+}
@@ -1,6 +1,12 @@
 package com.visgupta.example.v8integrationandroidapp
 
+import android.os.ParcelFileDescriptor
 import android.util.Log
+import dalvik.annotation.optimization.CriticalNative
+import dalvik.annotation.optimization.FastNative
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 
 class ByteTransferBridge {
     
@@ -15,17 +21,67 @@ class ByteTransferBridge {
                 Log.e(TAG, "Failed to load native library", e)
             }
         }
+        
+        // Primitive-only calls on an open handle; no JNIEnv, no thread state switch
+        @JvmStatic @CriticalNative private external fun nativeGetHandleCursors(handle: Int): Long
+        @JvmStatic @CriticalNative private external fun nativeCommitHandle(handle: Int, count: Int): Boolean
+        @JvmStatic @CriticalNative private external fun nativeConsumeHandle(handle: Int, count: Int): Boolean
+        @JvmStatic @CriticalNative private external fun nativeSetStatsSampling(every: Int)
     }
     
     private external fun nativeInitializeByteTransfer(bufferSize: Int): Boolean
-    private external fun nativeCreateNamedBuffer(name: String, size: Int): Boolean
+    private external fun nativeCreateNamedBuffer(name: String, size: Int, zeroed: Boolean): Boolean
     private external fun nativeWriteBytes(data: ByteArray): Boolean
     private external fun nativeWriteBytesToNamed(name: String, data: ByteArray): Boolean
     private external fun nativeReadBytes(length: Int, offset: Int): ByteArray?
     private external fun nativeReadBytesFromNamed(name: String, length: Int, offset: Int): ByteArray?
     private external fun nativeGetBufferInfo(name: String?): BufferInfo?
-    private external fun nativeClearBuffer(name: String?)
+    private external fun nativeClearBuffer(name: String?, wipe: Boolean)
     private external fun nativeCleanup()
+    private external fun nativeGetBufferPoolStats(): String
+    
+    // Handles resolved once per name; 0 means no such buffer
+    @FastNative private external fun nativeOpenBuffer(name: String?): Int
+    private external fun nativeWriteBytesToHandle(handle: Int, data: ByteArray): Boolean
+    private external fun nativeReadBytesFromHandle(handle: Int, length: Int, offset: Int): ByteArray?
+    
+    // Zero-copy direct views and cursors; a view pins its memory until unpinned
+    private external fun nativePinBuffer(name: String?): Long
+    private external fun nativeGetDirectBuffer(pin: Long): ByteBuffer?
+    private external fun nativeUnpinBuffer(pin: Long)
+    @FastNative private external fun nativeGetCursors(name: String?): Long
+    @FastNative private external fun nativeAdvanceWriteCursor(name: String?, count: Int): Boolean
+    @FastNative private external fun nativeAdvanceReadCursor(name: String?, count: Int): Boolean
+    
+    // Ring buffer mode for named buffers
+    private external fun nativeCreateRingBuffer(name: String, capacity: Int, multiProducer: Boolean): Boolean
+    @FastNative private external fun nativeRingWrite(name: String, data: ByteArray, tag: Int): Boolean
+    private external fun nativeRingWriteBatch(name: String, messages: Array<ByteArray>, tag: Int): Boolean
+    @FastNative private external fun nativeRingRead(name: String): ByteArray?
+    private external fun nativeRingReadBatch(name: String, maxMessages: Int): Array<ByteArray>?
+    
+    // Segmented buffers that grow instead of overflowing
+    private external fun nativeCreateSegmentedBuffer(name: String, segmentSize: Int, maxBytes: Long): Boolean
+    private external fun nativePinLinearView(name: String?): Long
+    
+    // Cross-process buffers in memfd/ashmem memory
+    private external fun nativeCreateSharedBuffer(name: String, capacity: Int): Boolean
+    private external fun nativeExportSharedBuffer(name: String): Int
+    private external fun nativeImportSharedBuffer(name: String, fd: Int): Boolean
+    
+    // File-backed buffers that survive process restarts
+    private external fun nativeOpenPersistentBuffer(name: String, path: String, capacity: Int): Boolean
+    private external fun nativeFlushBuffer(name: String?): Boolean
+    
+    // Blocking and descriptor wake-ups for consumers
+    private external fun nativeWaitForData(name: String?, minBytes: Int, timeoutMicros: Long): Boolean
+    private external fun nativeSetWakeThreshold(name: String?, bytes: Int, delayMicros: Int): Boolean
+    private external fun nativeGetNotificationFd(name: String?): Int
+    
+    // Per-buffer traffic counters and latency histograms
+    private external fun nativeGetBufferStats(name: String?): String?
+    private external fun nativeGetAllBufferStats(): String
+    private external fun nativeResetBufferStats(name: String?): Boolean
     
     private var isInitialized = false
     
@@ -67,13 +123,226 @@ class ByteTransferBridge {
         }
     }
     
-    fun createBuffer(name: String, size: Int): Boolean {
+    /**
+     * Create (or re-create) a named buffer. Memory comes from a recycling pool and is
+     * not cleared unless zeroed is set; re-creating a buffer with a similar size reuses it.
+     */
+    fun createBuffer(name: String, size: Int, zeroed: Boolean = false): Boolean {
         Log.i(TAG, "Creating named buffer '$name' with size $size")
-        val result = nativeCreateNamedBuffer(name, size)
+        val result = nativeCreateNamedBuffer(name, size, zeroed)
         Log.i(TAG, "Buffer '$name' creation: ${if (result) "SUCCESS" else "FAILED"}")
         return result
     }
     
+    /**
+     * Read and write positions of a buffer. Bytes in [readPosition, writePosition)
+     * are written but not yet consumed.
+     */
+    data class BufferCursors(val readPosition: Int, val writePosition: Int) {
+        val readable: Int get() = writePosition - readPosition
+    }
+    
+    /**
+     * Direct ByteBuffer over pinned native memory. The memory stays valid until
+     * close(), even if the buffer is recreated or cleanup() runs meanwhile; do not
+     * touch the buffer after closing. Use it with `use { }`.
+     */
+    inner class PinnedView internal constructor(val buffer: ByteBuffer, private var pin: Long) : AutoCloseable {
+        @Synchronized
+        override fun close() {
+            if (pin != 0L) {
+                nativeUnpinBuffer(pin)
+                pin = 0L
+            }
+        }
+    }
+    
+    private fun pinView(pin: Long, slice: (ByteBuffer) -> ByteBuffer? = { it }): PinnedView? {
+        if (pin == 0L) return null
+        val view = nativeGetDirectBuffer(pin)?.let(slice)
+        if (view == null) {
+            nativeUnpinBuffer(pin)
+            return null
+        }
+        return PinnedView(view.order(ByteOrder.nativeOrder()), pin)
+    }
+    
+    /**
+     * Pinned view over the whole native buffer memory (shared buffer if name is null).
+     * No bytes are copied.
+     */
+    fun getDirectBuffer(bufferName: String? = null): PinnedView? {
+        return pinView(nativePinBuffer(bufferName))
+    }
+    
+    fun getCursors(bufferName: String? = null): BufferCursors? {
+        val packed = nativeGetCursors(bufferName)
+        if (packed < 0) return null
+        return BufferCursors((packed ushr 32).toInt(), (packed and 0xFFFFFFFFL).toInt())
+    }
+    
+    /**
+     * Pinned view from the write cursor to capacity. Fill it, then commitWrite() the byte count.
+     */
+    fun writableView(bufferName: String? = null): PinnedView? {
+        return pinView(nativePinBuffer(bufferName)) { view ->
+            getCursors(bufferName)?.takeIf { it.writePosition <= view.capacity() }?.let { cursors ->
+                view.position(cursors.writePosition)
+                view.slice()
+            }
+        }
+    }
+    
+    fun commitWrite(bufferName: String? = null, count: Int): Boolean {
+        return nativeAdvanceWriteCursor(bufferName, count)
+    }
+    
+    /**
+     * Pinned view of the written but unconsumed bytes. Read it, then consumeRead() the byte count.
+     */
+    fun readableView(bufferName: String? = null): PinnedView? {
+        return pinView(nativePinBuffer(bufferName)) { view ->
+            getCursors(bufferName)?.takeIf { it.writePosition <= view.capacity() }?.let { cursors ->
+                view.limit(cursors.writePosition)
+                view.position(cursors.readPosition)
+                view.slice()
+            }
+        }
+    }
+    
+    fun consumeRead(bufferName: String? = null, count: Int): Boolean {
+        return nativeAdvanceReadCursor(bufferName, count)
+    }
+    
+    /**
+     * Create a named buffer that works as a lock-free message ring.
+     * Capacity is rounded up to a power of two; set multiProducer when more than
+     * one thread (or JS engine) writes to it. Exactly one thread may read.
+     */
+    fun createRingBuffer(name: String, capacity: Int, multiProducer: Boolean = false): Boolean {
+        Log.i(TAG, "Creating ring buffer '$name' with capacity $capacity (multiProducer=$multiProducer)")
+        return nativeCreateRingBuffer(name, capacity, multiProducer)
+    }
+    
+    /**
+     * Append one message to a ring buffer; false if the ring is full
+     */
+    fun ringWrite(bufferName: String, message: ByteArray, tag: Int = 0): Boolean {
+        return nativeRingWrite(bufferName, message, tag)
+    }
+    
+    /**
+     * Append several messages with a single commit; all or nothing
+     */
+    fun ringWriteBatch(bufferName: String, messages: Array<ByteArray>, tag: Int = 0): Boolean {
+        return nativeRingWriteBatch(bufferName, messages, tag)
+    }
+    
+    /**
+     * Take the next message from a ring buffer, or null if it is empty
+     */
+    fun ringRead(bufferName: String): ByteArray? {
+        return nativeRingRead(bufferName)
+    }
+    
+    /**
+     * Take up to maxMessages messages in one call
+     */
+    fun ringReadBatch(bufferName: String, maxMessages: Int = 256): List<ByteArray> {
+        return nativeRingReadBatch(bufferName, maxMessages)?.toList() ?: emptyList()
+    }
+    
+    /**
+     * Create a named buffer that grows by pooled segments instead of failing
+     * with an overflow. Use it when the output size is not known up front
+     * (JS results, HTTP bodies). maxBytes caps the unread bytes; 0 means no cap.
+     * Reads take stream offsets and consumeRead() frees segments behind them.
+     */
+    fun createSegmentedBuffer(name: String, segmentSize: Int = 64 * 1024, maxBytes: Long = 0): Boolean {
+        Log.i(TAG, "Creating segmented buffer '$name' with segment size $segmentSize")
+        return nativeCreateSegmentedBuffer(name, segmentSize, maxBytes)
+    }
+    
+    /**
+     * Pinned view of all unread bytes as one block. Linear buffers are viewed in
+     * place; segmented buffers are merged and copied, so the view stays valid
+     * after consumeRead() frees their segments.
+     */
+    fun linearView(bufferName: String? = null): PinnedView? {
+        return pinView(nativePinLinearView(bufferName))
+    }
+    
+    /**
+     * Create a named linear buffer in shared memory (memfd, or ashmem on old kernels).
+     * It behaves like createBuffer() and can also be exported to another process.
+     */
+    fun createSharedBuffer(name: String, capacity: Int): Boolean {
+        Log.i(TAG, "Creating shared buffer '$name' with capacity $capacity")
+        return nativeCreateSharedBuffer(name, capacity)
+    }
+    
+    /**
+     * Descriptor for a shared buffer, ready to put in a Parcel or Bundle.
+     * The caller owns the returned descriptor and should close it once sent.
+     */
+    fun exportSharedBuffer(name: String): ParcelFileDescriptor? {
+        val fd = nativeExportSharedBuffer(name)
+        return if (fd >= 0) ParcelFileDescriptor.adoptFd(fd) else null
+    }
+    
+    /**
+     * Map a buffer exported by another process under a local name. Both sides see
+     * the same bytes and cursors, so one can commitWrite() while the other consumeRead()s.
+     * The descriptor is duplicated natively; the caller may close it afterwards.
+     */
+    fun importSharedBuffer(name: String, descriptor: ParcelFileDescriptor): Boolean {
+        return nativeImportSharedBuffer(name, descriptor.fd)
+    }
+    
+    /**
+     * Open a named linear buffer backed by a memory-mapped file (e.g. under
+     * context.filesDir), creating it if needed. After a restart the existing
+     * bytes are mapped back without copying, with the cursors as of the last
+     * flushBuffer(); writes made after that flush are discarded.
+     */
+    fun openPersistentBuffer(name: String, file: File, capacity: Int): Boolean {
+        Log.i(TAG, "Opening persistent buffer '$name' at ${file.path}")
+        return nativeOpenPersistentBuffer(name, file.path, capacity)
+    }
+    
+    /**
+     * Durability point for a persistent buffer: msync the data, then the cursors
+     */
+    fun flushBuffer(bufferName: String? = null): Boolean = nativeFlushBuffer(bufferName)
+    
+    /**
+     * Block the calling thread until at least minBytes are unread, instead of
+     * polling getCursors(). Returns false on timeout; a negative timeout waits
+     * forever. Never call this on the main thread.
+     */
+    fun waitForData(bufferName: String? = null, minBytes: Int = 1, timeoutMicros: Long = -1): Boolean {
+        return nativeWaitForData(bufferName, minBytes, timeoutMicros)
+    }
+    
+    /**
+     * Batch wake-ups: readers are woken once `bytes` are unread or `delayMicros`
+     * after the first unreported write. 0 bytes wakes on every write; a
+     * nonzero threshold needs a nonzero delay, or this returns false.
+     */
+    fun setWakeThreshold(bufferName: String? = null, bytes: Int, delayMicros: Int = 1000): Boolean {
+        return nativeSetWakeThreshold(bufferName, bytes, delayMicros)
+    }
+    
+    /**
+     * Descriptor that becomes readable when data arrives, for
+     * MessageQueue.addOnFileDescriptorEventListener or an epoll loop. Read
+     * 8 bytes to reset it. Close the descriptor when done.
+     */
+    fun notificationDescriptor(bufferName: String? = null): ParcelFileDescriptor? {
+        val fd = nativeGetNotificationFd(bufferName)
+        return if (fd >= 0) ParcelFileDescriptor.adoptFd(fd) else null
+    }
+    
     fun writeToSharedBuffer(data: ByteArray): Boolean {
         if (!isInitialized) {
             Log.e(TAG, "Byte transfer system not initialized")
@@ -93,6 +362,34 @@ class ByteTransferBridge {
         return result
     }
     
+    /**
+     * Resolve a buffer name (null for the shared buffer) to a handle for
+     * writeToHandle()/readFromHandle(), which skip the name lookup and logging.
+     * The handle survives re-creating the buffer and is invalidated by cleanup().
+     * Returns 0 if the buffer does not exist.
+     */
+    fun openBuffer(bufferName: String? = null): Int = nativeOpenBuffer(bufferName)
+    
+    fun writeToHandle(handle: Int, data: ByteArray): Boolean = nativeWriteBytesToHandle(handle, data)
+    
+    fun readFromHandle(handle: Int, length: Int, offset: Int = 0): ByteArray? =
+        nativeReadBytesFromHandle(handle, length, offset)
+
+    /**
+     * Cursors of an open handle's buffer. Together with getDirectBuffer() this is
+     * the cheapest polling loop: these three calls skip the name lookup and, on
+     * Android 8.0+, the JNI transition entirely.
+     */
+    fun getCursorsForHandle(handle: Int): BufferCursors? {
+        val packed = nativeGetHandleCursors(handle)
+        if (packed < 0) return null
+        return BufferCursors((packed ushr 32).toInt(), (packed and 0xFFFFFFFFL).toInt())
+    }
+
+    fun commitWriteToHandle(handle: Int, count: Int): Boolean = nativeCommitHandle(handle, count)
+
+    fun consumeReadFromHandle(handle: Int, count: Int): Boolean = nativeConsumeHandle(handle, count)
+
     fun readFromSharedBuffer(length: Int, offset: Int = 0): ByteArray? {
         if (!isInitialized) {
             Log.e(TAG, "Byte transfer system not initialized")
@@ -118,11 +415,39 @@ class ByteTransferBridge {
         return info
     }
     
-    fun clearBuffer(bufferName: String? = null) {
+    /**
+     * Reset a buffer's cursors. The old bytes stay in memory unless wipe is set.
+     */
+    fun clearBuffer(bufferName: String? = null, wipe: Boolean = false) {
         Log.i(TAG, "Clearing buffer '${bufferName ?: "shared"}'")
-        nativeClearBuffer(bufferName)
+        nativeClearBuffer(bufferName, wipe)
     }
     
+    fun getBufferPoolStats(): String = nativeGetBufferPoolStats()
+    
+    /**
+     * Bytes, operations, overflow/underflow failures, unread high-water mark
+     * and sampled write/read latencies for one buffer, kept natively without
+     * any logging. Null if the buffer does not exist.
+     */
+    fun getBufferStats(bufferName: String? = null): BufferStats? =
+        nativeGetBufferStats(bufferName)?.let { BufferStats.parse(it) }
+    
+    /** Stats for every registered buffer; the shared buffer has an empty name. */
+    fun getAllBufferStats(): List<BufferStats> =
+        nativeGetAllBufferStats().lineSequence().mapNotNull { BufferStats.parse(it) }.toList()
+    
+    /** Raw export lines, one per buffer, for shipping to a log or metrics pipeline. */
+    fun exportBufferStats(): String = nativeGetAllBufferStats()
+    
+    fun resetBufferStats(bufferName: String? = null): Boolean = nativeResetBufferStats(bufferName)
+    
+    /**
+     * Time one buffer operation in `every` on each thread (rounded up to a
+     * power of two; default 16). Counters are always exact.
+     */
+    fun setStatsSampling(every: Int) = nativeSetStatsSampling(every)
+    
     fun runByteTransferTests(): Map<String, String> {
         val results = mutableMapOf<String, String>()
         
@@ -286,6 +286,17 @@ class CacheService(private val context: Context) {
         return@withContext null
     }
     
+    /**
+     * Drop cached bytecode but keep the source, e.g. when the engine no longer
+     * accepts it after a bytecode format change
+     */
+    suspend fun removeBytecode(url: String) = withContext(Dispatchers.IO) {
+        val entry = memoryCache[url] ?: return@withContext
+        File(bytecodeDir, "${entry.hash}.qbc").delete()
+        memoryCache[url] = entry.copy(bytecode = null)
+        Log.i(TAG, "Removed stale bytecode for: $url")
+    }
+    
     /**
      * Evict entry from cache
      */
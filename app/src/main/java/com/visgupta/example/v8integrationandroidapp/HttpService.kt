@@ -46,7 +46,8 @@ class HttpService {
         val body: String? = null,
         val timeout: Long = 30000,
         val redirect: String = "follow", // follow, error, manual
-        val credentials: String = "same-origin" // omit, same-origin, include
+        val credentials: String = "same-origin", // omit, same-origin, include
+        val cache: String = "default" // no-store when the native HTTP cache already handled the request
     )
 
     /**
@@ -59,9 +60,11 @@ class HttpService {
         cacheService: CacheService? = null
     ): HttpResponse = withContext(Dispatchers.IO) {
         
+        val cache = cacheService.takeIf { options.cache != "no-store" }
+        
         // Check cache first for GET requests
-        if (options.method == "GET" && cacheService != null) {
-            val cachedEntry = cacheService.getCachedEntry(url)
+        if (options.method == "GET" && cache != null) {
+            val cachedEntry = cache.getCachedEntry(url)
             if (cachedEntry != null && !cachedEntry.needsRevalidation()) {
                 Log.d(TAG, "Returning cached response for: $url")
                 return@withContext HttpResponse(
@@ -77,14 +80,14 @@ class HttpService {
             }
             
             // Check if we should do conditional request
-            val (shouldRevalidate, oldEntry) = cacheService.shouldRevalidate(url)
+            val (shouldRevalidate, oldEntry) = cache.shouldRevalidate(url)
             if (shouldRevalidate && oldEntry != null) {
                 Log.d(TAG, "Making conditional request for: $url")
-                return@withContext executeConditionalRequest(url, options, oldEntry, cacheService)
+                return@withContext executeConditionalRequest(url, options, oldEntry, cache)
             }
         }
         
-        return@withContext executeActualRequest(url, options, cacheService)
+        return@withContext executeActualRequest(url, options, cache)
     }
     
     /**
@@ -303,7 +306,8 @@ class HttpService {
                 body = if (json.has("body")) json.getString("body") else null,
                 timeout = json.optLong("timeout", 30000),
                 redirect = json.optString("redirect", "follow"),
-                credentials = json.optString("credentials", "same-origin")
+                credentials = json.optString("credentials", "same-origin"),
+                cache = json.optString("cache", "default")
             )
         } catch (e: Exception) {
             Log.w(TAG, "Failed to parse request options, using defaults", e)
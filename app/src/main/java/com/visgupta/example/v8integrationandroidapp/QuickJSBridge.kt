@@ -1,12 +1,14 @@
 package com.visgupta.example.v8integrationandroidapp
 
 import android.util.Log
+import dalvik.annotation.optimization.CriticalNative
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.runBlocking
 import kotlinx.coroutines.withContext
 import kotlinx.coroutines.withTimeout
+import java.io.File
 
 /**
  * Bridge class for QuickJS JavaScript engine integration
@@ -27,6 +29,9 @@ class QuickJSBridge(private val context: android.content.Context) {
                 Log.e(TAG, "Failed to load native library", e)
             }
         }
+
+        // Polled by the UI; primitive-only, so it skips the JNI transition
+        @JvmStatic @CriticalNative private external fun isInitialized(): Boolean
     }
 
     // Network service for remote JavaScript loading
@@ -54,7 +59,6 @@ class QuickJSBridge(private val context: android.content.Context) {
     private external fun initializeQuickJS(): Boolean
     private external fun executeScript(script: String): String
     private external fun cleanupQuickJS()
-    private external fun isInitialized(): Boolean
     private external fun resetContext(): Boolean
     
     // Bytecode compilation and execution methods
@@ -63,6 +67,12 @@ class QuickJSBridge(private val context: android.content.Context) {
     
     // HTTP polyfill native methods
     private external fun nativeHttpRequest(url: String, optionsJson: String): String
+    
+    // Native HTTP cache used by fetch()/XMLHttpRequest
+    private external fun nativeConfigureHttpCache(directory: String?, memoryBudgetBytes: Long, diskBudgetBytes: Long)
+    private external fun nativeGetHttpCacheStats(): String
+    private external fun nativeClearHttpCache()
+    private external fun nativeSetHttpTransport(mode: String, path: String?, profile: String?): Boolean
 
     // ByteTransfer integration methods (native)
     private external fun nativeTestByteTransfer(data: ByteArray, bufferName: String?): Boolean
@@ -94,6 +104,8 @@ class QuickJSBridge(private val context: android.content.Context) {
 
             if (!initialized) {
                 Log.e(TAG, "QuickJS initialization failed - native function returned false")
+            } else {
+                configureHttpCache()
             }
 
             return initialized
@@ -163,6 +175,19 @@ class QuickJSBridge(private val context: android.content.Context) {
         }
     }
 
+    /**
+     * Point the native HTTP cache at its disk tier (8MB memory, 32MB disk)
+     */
+    private fun configureHttpCache() {
+        try {
+            val httpCacheDir = File(context.cacheDir, "http_cache")
+            nativeConfigureHttpCache(httpCacheDir.absolutePath, 8L * 1024 * 1024, 32L * 1024 * 1024)
+        } catch (e: Exception) {
+            Log.w(TAG, "Native HTTP cache disk tier unavailable, using memory only", e)
+            nativeConfigureHttpCache(null, 8L * 1024 * 1024, 0)
+        }
+    }
+
     /**
      * Test various JavaScript operations specific to QuickJS features
      * @return Map of test results showcasing QuickJS capabilities
@@ -446,11 +471,44 @@ class QuickJSBridge(private val context: android.content.Context) {
         return cacheService.getCachedUrls()
     }
     
+    /**
+     * Get native HTTP cache statistics (fetch/XMLHttpRequest responses)
+     */
+    fun getHttpCacheStats(): String {
+        return nativeGetHttpCacheStats()
+    }
+    
+    /**
+     * Serve fetch()/XMLHttpRequest through HttpService (default)
+     */
+    fun useLiveHttp(): Boolean {
+        return nativeSetHttpTransport("live", null, null)
+    }
+    
+    /**
+     * Perform requests live and append every request/response pair to file,
+     * for later replay on device or with scripts/run_fetch_bench.sh
+     */
+    fun startHttpRecording(file: File): Boolean {
+        Log.i(TAG, "Recording HTTP exchanges to ${file.absolutePath}")
+        return nativeSetHttpTransport("record", file.absolutePath, null)
+    }
+    
+    /**
+     * Answer requests from a recording instead of the network.
+     * profile: none, recorded, wifi, 4g, fast-3g, slow-3g or "latencyMs:downKbps[:upKbps]"
+     */
+    fun startHttpReplay(file: File, profile: String = "none"): Boolean {
+        Log.i(TAG, "Replaying HTTP exchanges from ${file.absolutePath} ($profile)")
+        return nativeSetHttpTransport("replay", file.absolutePath, profile)
+    }
+    
     /**
      * Clear all cache
      */
     suspend fun clearCache() {
         cacheService.clearCache()
+        nativeClearHttpCache()
         Log.i(TAG, "Cache cleared")
     }
     
@@ -510,6 +568,48 @@ class QuickJSBridge(private val context: android.content.Context) {
     }
 
     private external fun nativeGetMemoryStats(): String
+
+    /**
+     * Profile the JavaScript functions run from now on: opcode counts,
+     * calls, self time and loop iterations. Native code is bypassed while
+     * profiling is enabled.
+     */
+    fun setProfiling(enabled: Boolean) {
+        if (initialized) {
+            nativeSetProfiling(enabled)
+        }
+    }
+
+    /**
+     * Get the profile report: functions by self time, then opcodes
+     */
+    fun getProfile(): String {
+        return if (initialized) {
+            nativeGetProfile()
+        } else {
+            "❌ QuickJS not initialized"
+        }
+    }
+
+    /**
+     * Get the profile as folded stacks ("outer;inner self_us" lines) for
+     * flamegraph.pl or speedscope
+     */
+    fun getProfileFoldedStacks(): String {
+        return if (initialized) nativeGetProfileFoldedStacks() else ""
+    }
+
+    /**
+     * Clear the profile
+     */
+    fun resetProfile() {
+        nativeResetProfile()
+    }
+
+    private external fun nativeSetProfiling(enabled: Boolean)
+    private external fun nativeGetProfile(): String
+    private external fun nativeGetProfileFoldedStacks(): String
+    private external fun nativeResetProfile()
     
     /**
      * Callback interface for remote JavaScript execution
@@ -563,24 +663,33 @@ class QuickJSBridge(private val context: android.content.Context) {
                     val result = executeBytecode(cachedBytecode)
                     val executionTime = System.currentTimeMillis() - executionStartTime
                     
-                    val executionResult = RemoteExecutionResult(
-                        url = url,
-                        fileName = networkService.getFileNameFromUrl(url),
-                        timestamp = System.currentTimeMillis(),
-                        success = !result.startsWith("Error:") && !result.startsWith("JavaScript Error:") && !result.startsWith("Bytecode Error:"),
-                        result = result,
-                        executionTimeMs = executionTime,
-                        contentLength = cachedBytecode.size
-                    )
+                    if (result.startsWith("Bytecode Error:")) {
+                        // Written by an older engine build (bytecode version mismatch):
+                        // drop it and fall through to the source path, which recompiles it
+                        Log.w(TAG, "Cached bytecode rejected for: $url ($result)")
+                        withContext(Dispatchers.IO) {
+                            cacheService.removeBytecode(url)
+                        }
+                    } else {
+                        val executionResult = RemoteExecutionResult(
+                            url = url,
+                            fileName = networkService.getFileNameFromUrl(url),
+                            timestamp = System.currentTimeMillis(),
+                            success = !result.startsWith("Error:") && !result.startsWith("JavaScript Error:") && !result.startsWith("Bytecode Error:"),
+                            result = result,
+                            executionTimeMs = executionTime,
+                            contentLength = cachedBytecode.size
+                        )
                     
-                    executionHistory.add(0, executionResult)
-                    if (executionHistory.size > 50) {
-                        executionHistory.removeAt(executionHistory.size - 1)
-                    }
+                        executionHistory.add(0, executionResult)
+                        if (executionHistory.size > 50) {
+                            executionHistory.removeAt(executionHistory.size - 1)
+                        }
                     
-                    Log.i(TAG, "✅ Executed cached bytecode for: $url (${cachedBytecode.size} bytes, ${executionTime}ms)")
-                    callback.onSuccess(executionResult)
-                    return@launch
+                        Log.i(TAG, "✅ Executed cached bytecode for: $url (${cachedBytecode.size} bytes, ${executionTime}ms)")
+                        callback.onSuccess(executionResult)
+                        return@launch
+                    }
                 }
                 
                 // Check for cached source code
@@ -28,6 +28,11 @@ class V8Bridge {
     private external fun cleanupV8()
     private external fun testDataExchange(input: String, number: Int, flag: Boolean): String
     
+    // Engine-neutral statistics and benchmarks (QuickJS, V8 when built in, mock)
+    private external fun nativeGetEngineStats(): String
+    private external fun nativeListEngines(): String
+    private external fun nativeRunEngineBenchmark(engine: String, iterations: Int): String
+    
     private var isInitialized = false
     
     /**
@@ -122,6 +127,27 @@ class V8Bridge {
         return result
     }
     
+    /**
+     * Eval/compile/call counts, average timings and heap size of this bridge's engine
+     */
+    fun getEngineStats(): String = nativeGetEngineStats()
+    
+    /**
+     * Engines runEngineBenchmark() accepts: "quickjs", "v8" when the library
+     * was built against V8, and "mock"
+     */
+    fun availableEngines(): List<String> = nativeListEngines().split(',').filter { it.isNotEmpty() }
+    
+    /**
+     * Run the shared native workloads on a fresh instance of the named engine.
+     * Returns a table ending in a "RESULT engine=..." line. Runs for a while;
+     * keep it off the main thread.
+     */
+    fun runEngineBenchmark(engine: String, iterations: Int = 20): String {
+        Log.i(TAG, "Benchmarking engine '$engine' with $iterations iterations")
+        return nativeRunEngineBenchmark(engine, iterations)
+    }
+    
     /**
      * Test various JavaScript operations
      * @return Map of test results
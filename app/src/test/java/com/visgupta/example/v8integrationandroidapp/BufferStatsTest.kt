@@ -0,0 +1,49 @@
+package com.visgupta.example.v8integrationandroidapp
+
+import org.junit.Test
+import org.junit.Assert.*
+
+/**
+ * Parsing of the native ByteTransfer stats export line
+ */
+class BufferStatsTest {
+
+    @Test
+    fun testParseExportLine() {
+        val line = "in=4096 out=1024 w=64 r=16 cs=1024 of=2 uf=1 hw=3072 " +
+            "wl=319,351,9215,851967 rl=63,71,103,4607 name=frames"
+        val stats = BufferStats.parse(line)
+
+        assertNotNull("Line should parse", stats)
+        stats!!
+        assertEquals("frames", stats.name)
+        assertEquals(4096L, stats.bytesIn)
+        assertEquals(1024L, stats.bytesOut)
+        assertEquals(64L, stats.writes)
+        assertEquals(16L, stats.reads)
+        assertEquals(2L, stats.overflows)
+        assertEquals(1L, stats.underflows)
+        assertEquals(3072L, stats.highWater)
+        assertEquals(3072L, stats.unreadBytes)
+        assertEquals(BufferStats.LatencyPercentiles(319, 351, 9215, 851967), stats.writeLatencyNanos)
+        assertEquals(4607L, stats.readLatencyNanos.max)
+    }
+
+    @Test
+    fun testNameMayContainSpacesOrBeEmpty() {
+        val fields = "in=0 out=0 w=0 r=0 cs=0 of=0 uf=0 hw=0 wl=0,0,0,0 rl=0,0,0,0 "
+
+        assertEquals("my buffer", BufferStats.parse(fields + "name=my buffer")?.name)
+        val shared = BufferStats.parse(fields + "name=")
+        assertEquals("", shared?.name)
+        assertEquals(BufferStats.LatencyPercentiles.EMPTY, shared?.writeLatencyNanos)
+    }
+
+    @Test
+    fun testMalformedLinesAreRejected() {
+        assertNull(BufferStats.parse(""))
+        assertNull(BufferStats.parse("in=1 out=2 name=x"))
+        assertNull(BufferStats.parse("in=1 out=2 w=1 r=1 cs=1 of=0 uf=0 hw=1 wl=1,2,3 rl=1,2,3,4 name=x"))
+        assertNull(BufferStats.parse("in=x out=2 w=1 r=1 cs=1 of=0 uf=0 hw=1 wl=1,2,3,4 rl=1,2,3,4 name=x"))
+    }
+}
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Deterministic fetch() benchmark on a plain Linux/macOS box
+# Builds the host fetch_bench tool and replays recorded HTTP exchanges
+# through the same polyfills, native cache and transport layer as the app.
+#
+# Usage:
+#   scripts/run_fetch_bench.sh [--profile 4g] [--iterations 20] [--cold-cache]
+#   scripts/run_fetch_bench.sh --record     # re-record against test-server/js_server.js
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(dirname "$SCRIPT_DIR")"
+NATIVE_DIR="$PROJECT_ROOT/app/src/main/cpp"
+BUILD_DIR="${BUILD_DIR:-$PROJECT_ROOT/app/build/host-native}"
+TEST_SERVER_DIR="$PROJECT_ROOT/test-server"
+SCRIPT="${FETCH_BENCH_SCRIPT:-$TEST_SERVER_DIR/fetch_bench.js}"
+FIXTURE="${FETCH_BENCH_FIXTURE:-$TEST_SERVER_DIR/fixtures/fetch_bench.jsonl}"
+
+echo "🔨 Building host fetch_bench..."
+cmake -S "$NATIVE_DIR" -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release >/dev/null
+cmake --build "$BUILD_DIR" --target fetch_bench -j"$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 4)" >/dev/null
+
+if [ "$1" == "--record" ]; then
+    shift
+    echo "🌐 Recording against test-server/js_server.js..."
+    (cd "$TEST_SERVER_DIR" && PORT=8080 HOST=127.0.0.1 node js_server.js >/dev/null 2>&1) &
+    SERVER_PID=$!
+    trap 'kill $SERVER_PID 2>/dev/null' EXIT
+    sleep 1
+    mkdir -p "$(dirname "$FIXTURE")"
+    rm -f "$FIXTURE"
+    "$BUILD_DIR/fetch_bench" --record "$FIXTURE" "$@" "$SCRIPT"
+    exit 0
+fi
+
+echo "⏱️  Replaying $(wc -l < "$FIXTURE" | tr -d ' ') recorded exchanges..."
+"$BUILD_DIR/fetch_bench" --replay "$FIXTURE" "$@" "$SCRIPT"
@@ -0,0 +1,126 @@
+#!/bin/bash
+
+# Upstream QuickJS regression tests and microbenchmarks on a plain Linux/macOS box
+# Builds the host qjs from app/src/main/cpp (the engine the app ships, with our
+# interpreter changes) and runs the tests/ directory of the upstream release.
+#
+# Usage:
+#   scripts/run_quickjs_tests.sh                  # tests/test_*.js and quickjs/tests/test_*.js
+#   scripts/run_quickjs_tests.sh --bench [name]   # tests/microbench.js, optionally one test
+#   scripts/run_quickjs_tests.sh --remote [runs]  # test-server scripts, us per run
+#   scripts/run_quickjs_tests.sh --pairs [file.js] # most executed opcode pairs
+#                                                  # (microbench and test-server scripts by default)
+#   scripts/run_quickjs_tests.sh --profile [file.js] # functions by self time and opcode counts
+#                                                  # (same default scripts)
+#   scripts/run_quickjs_tests.sh --jit [...]      # same with every function compiled by the
+#                                                  # baseline JIT at its first call (x86-64 only)
+#   scripts/run_quickjs_tests.sh --aot [...]      # same with the functions of the scripts compiled
+#                                                  # to C ahead of time (qjsaot)
+#   scripts/run_quickjs_tests.sh --gc [...]       # same with the cycles collected in the smallest
+#                                                  # incremental GC slices (JS_SetGCBudget) and the
+#                                                  # full GCs on helper threads (JS_SetGCThreads)
+#   scripts/run_quickjs_tests.sh --asan [--jit|--aot|--gc] [...]  # any of the above built with
+#                                                  # AddressSanitizer in $BUILD_DIR-asan
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_ROOT="$(dirname "$SCRIPT_DIR")"
+NATIVE_DIR="$PROJECT_ROOT/app/src/main/cpp"
+BUILD_DIR="${BUILD_DIR:-$PROJECT_ROOT/app/build/host-native}"
+UPSTREAM_DIR="$NATIVE_DIR/quickjs/quickjs-2025-04-26"
+QJS_TARGET=qjs
+QJS_STD=--std
+CMAKE_ARGS=(-DCMAKE_BUILD_TYPE=Release)
+
+if [ "$1" == "--asan" ]; then
+    shift
+    BUILD_DIR="$BUILD_DIR-asan"
+    CMAKE_ARGS=(-DCMAKE_BUILD_TYPE=RelWithDebInfo
+                "-DCMAKE_C_FLAGS=-fsanitize=address -fno-omit-frame-pointer"
+                "-DCMAKE_CXX_FLAGS=-fsanitize=address -fno-omit-frame-pointer"
+                -DCMAKE_EXE_LINKER_FLAGS=-fsanitize=address)
+fi
+
+if [ "$1" == "--jit" ]; then
+    shift
+    QJS_TARGET=qjs_jit
+elif [ "$1" == "--aot" ]; then
+    shift
+    # qjs_aot always loads std and os
+    QJS_TARGET=qjs_aot
+    QJS_STD=
+elif [ "$1" == "--gc" ]; then
+    shift
+    QJS_TARGET=qjs_gc
+fi
+QJS="$BUILD_DIR/$QJS_TARGET"
+
+if [ "$1" == "--pairs" ]; then
+    shift
+    echo "🔨 Building host qjs_trace..."
+    cmake -S "$NATIVE_DIR" -B "$BUILD_DIR" "${CMAKE_ARGS[@]}" >/dev/null
+    cmake --build "$BUILD_DIR" --target qjs_trace -j"$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 4)" >/dev/null
+    if [ $# -eq 0 ]; then
+        set -- "$UPSTREAM_DIR/tests/microbench.js" "$PROJECT_ROOT/test-server/remote_bench.js"
+    fi
+    for script in "$@"; do
+        echo "== $(basename "$script")"
+        # run from the build directory like --bench
+        script="$(cd "$(dirname "$script")" && pwd)/$(basename "$script")"
+        (cd "$BUILD_DIR" && ./qjs_trace --std "$script") | sed -n '/instructions executed/,$p'
+    done
+    exit 0
+fi
+
+if [ "$1" == "--profile" ]; then
+    shift
+    echo "🔨 Building host qjs_prof..."
+    cmake -S "$NATIVE_DIR" -B "$BUILD_DIR" "${CMAKE_ARGS[@]}" >/dev/null
+    cmake --build "$BUILD_DIR" --target qjs_prof -j"$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 4)" >/dev/null
+    if [ $# -eq 0 ]; then
+        set -- "$UPSTREAM_DIR/tests/microbench.js" "$PROJECT_ROOT/test-server/remote_bench.js"
+    fi
+    for script in "$@"; do
+        echo "== $(basename "$script")"
+        script="$(cd "$(dirname "$script")" && pwd)/$(basename "$script")"
+        (cd "$BUILD_DIR" && ./qjs_prof --std "$script") | sed -n '/ ms in .* functions, /,$p'
+    done
+    exit 0
+fi
+
+echo "🔨 Building host $QJS_TARGET..."
+cmake -S "$NATIVE_DIR" -B "$BUILD_DIR" "${CMAKE_ARGS[@]}" >/dev/null
+cmake --build "$BUILD_DIR" --target "$QJS_TARGET" -j"$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 4)" >/dev/null
+
+cd "$UPSTREAM_DIR"
+
+if [ "$1" == "--bench" ]; then
+    shift
+    # microbench.js saves microbench-new.txt to the working directory
+    cd "$BUILD_DIR"
+    "$QJS" $QJS_STD "$UPSTREAM_DIR/tests/microbench.js" "$@"
+    exit 0
+fi
+
+if [ "$1" == "--remote" ]; then
+    shift
+    "$QJS" $QJS_STD "$PROJECT_ROOT/test-server/remote_bench.js" "$@"
+    exit 0
+fi
+
+FAILED=0
+for test in test_closure test_language test_builtin test_loop test_bigint test_std \
+            "$NATIVE_DIR"/quickjs/tests/test_*.js; do
+    case "$test" in
+        *.js) script="$test" ;;
+        *) script="tests/$test.js" ;;
+    esac
+    if "$QJS" $QJS_STD "$script" >/dev/null; then
+        echo "✅ $(basename "$test" .js)"
+    else
+        echo "❌ $(basename "$test" .js)"
+        FAILED=1
+    fi
+done
+exit $FAILED
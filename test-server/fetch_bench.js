@@ -0,0 +1,50 @@
+// fetch()-heavy workload for the host benchmark (app/src/main/cpp/bench).
+// Record once against js_server.js, then replay with network profiles:
+//   ../scripts/run_fetch_bench.sh --profile 4g
+// Resolves once every request has completed so the benchmark times the
+// whole workload, including promise continuations.
+
+const BASE_URL = 'http://localhost:8080';
+
+async function fetchText(path) {
+    const response = await fetch(BASE_URL + path);
+    if (!response.ok) {
+        throw new Error(`${path}: HTTP ${response.status}`);
+    }
+    return response.text();
+}
+
+function xhrText(path) {
+    const xhr = new XMLHttpRequest();
+    xhr.open('GET', BASE_URL + path, false);
+    xhr.send(null);
+    return xhr.responseText;
+}
+
+(async function () {
+    // Discovery request, then every listed script
+    const listing = JSON.parse(await fetchText('/api/files'));
+    let bytes = 0;
+    for (const file of listing.files) {
+        const response = await fetch(file.url);
+        bytes += (await response.text()).length;
+    }
+
+    // Independent requests issued together, as a page load would
+    const scripts = await Promise.all([
+        fetchText('/simple_fetch_test.js'),
+        fetchText('/test_fetch_polyfill.js'),
+        fetchText('/test_cache_stats.js'),
+        fetchText('/test_bytecode_demo.js'),
+    ]);
+    for (const script of scripts) {
+        bytes += script.length;
+    }
+
+    bytes += xhrText('/').length;
+
+    // A repeated request exercises the cache (revalidated: js_server sends no-cache)
+    bytes += (await fetchText('/api/files')).length;
+
+    return bytes;
+})();
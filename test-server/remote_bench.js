@@ -0,0 +1,34 @@
+// Interpreter time of the scripts the app loads remotely, for comparing
+// engine changes on the host:
+//   ../scripts/run_quickjs_tests.sh --remote
+// Each script is evaluated repeatedly in the same context with console
+// output discarded; scripts that need the network are skipped.
+
+import * as std from 'std';
+
+const SCRIPTS = [
+    'test_remote_script.js',
+    'test_simple_return.js',
+    'test_bytecode_demo.js',
+    'test_cache_stats.js',
+];
+const RUNS = Number(scriptArgs[1] || 200);
+
+const dir = scriptArgs[0].replace(/[^/]*$/, '');
+globalThis.console = { log() {}, info() {}, warn() {}, error() {} };
+
+let total = 0;
+for (const name of SCRIPTS) {
+    // Each run in its own function scope so top-level const/let can repeat
+    const source = '(function () {\n' + std.loadFile(dir + name) + '\n})';
+    const body = std.evalScript(source);
+    body();
+    const begin = performance.now();
+    for (let i = 0; i < RUNS; i++) {
+        body();
+    }
+    const us = (performance.now() - begin) * 1000 / RUNS;
+    total += us;
+    std.out.printf('%-24s %10.1f us/run\n', name, us);
+}
+std.out.printf('RESULT remote_us_per_run=%.1f\n', total);